@@ -52,9 +52,11 @@ public:
     Bitmap& operator=(Bitmap&& other)
     {
         if (this != &other) {
-            kfree_sized(m_data, size_in_bytes());
+            if (m_is_owning)
+                kfree_sized(m_data, size_in_bytes());
             m_data = exchange(other.m_data, nullptr);
             m_size = exchange(other.m_size, 0);
+            m_is_owning = exchange(other.m_is_owning, false);
         }
         return *this;
     }
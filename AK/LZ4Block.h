@@ -0,0 +1,193 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/BuiltinWrappers.h>
+#include <AK/NumericLimits.h>
+#include <AK/Optional.h>
+#include <AK/Span.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+
+// An implementation of the LZ4 block format, see https://github.com/lz4/lz4/blob/dev/doc/lz4_Block_format.md
+//
+// Each sequence consists of a token (literal length in the high nibble, match length minus 4 in the low nibble, where
+// 15 means that more length bytes follow), the literals, and a 16-bit little endian match offset. The last sequence
+// only has literals. This doesn't know about the LZ4 frame format, and is meant for small blocks of data whose size
+// is known up front, like pages of memory.
+
+namespace AK {
+
+namespace Detail {
+
+static constexpr size_t lz4_min_match_length = 4;
+// The last 5 bytes of a block are always literals.
+static constexpr size_t lz4_last_literals_length = 5;
+// The last match must start at least 12 bytes before the end of the block.
+static constexpr size_t lz4_match_start_limit = 12;
+
+ALWAYS_INLINE u32 lz4_read_u32(u8 const* data)
+{
+    u32 value;
+    __builtin_memcpy(&value, data, sizeof(value));
+    return value;
+}
+
+ALWAYS_INLINE size_t lz4_hash(u32 value, size_t hash_bits)
+{
+    return (value * 2654435761u) >> (32 - hash_bits);
+}
+
+}
+
+// Compresses the input into a single LZ4 block. Returns the compressed size, or nothing if it doesn't fit into the output.
+// The hash table is scratch space for the compressor. Its size has to be a power of two, and the input can't be larger than 64 KiB.
+inline Optional<size_t> lz4_compress_block(ReadonlyBytes input, Bytes output, Span<u16> hash_table)
+{
+    using namespace Detail;
+
+    VERIFY(input.size() <= NumericLimits<u16>::max());
+    VERIFY(hash_table.size() >= 2 && is_power_of_two(hash_table.size()));
+    auto hash_bits = count_trailing_zeroes(hash_table.size());
+    __builtin_memset(hash_table.data(), 0, hash_table.size() * sizeof(u16));
+
+    size_t out = 0;
+
+    auto emit_extra_length = [&](size_t length) {
+        while (length >= 255) {
+            if (out >= output.size())
+                return false;
+            output[out++] = 255;
+            length -= 255;
+        }
+        if (out >= output.size())
+            return false;
+        output[out++] = length;
+        return true;
+    };
+
+    auto emit_sequence = [&](size_t literal_start, size_t literal_length, size_t match_offset, size_t match_length) {
+        if (out >= output.size())
+            return false;
+        size_t token_offset = out++;
+        u8 token = min<size_t>(literal_length, 15) << 4;
+        if (literal_length >= 15 && !emit_extra_length(literal_length - 15))
+            return false;
+        if (literal_length > output.size() - out)
+            return false;
+        __builtin_memcpy(output.offset_pointer(out), input.offset_pointer(literal_start), literal_length);
+        out += literal_length;
+
+        if (match_length != 0) {
+            if (output.size() - out < 2)
+                return false;
+            output[out++] = match_offset & 0xff;
+            output[out++] = match_offset >> 8;
+            auto extra_match_length = match_length - lz4_min_match_length;
+            token |= min<size_t>(extra_match_length, 15);
+            if (extra_match_length >= 15 && !emit_extra_length(extra_match_length - 15))
+                return false;
+        }
+
+        output[token_offset] = token;
+        return true;
+    };
+
+    size_t in = 0;
+    size_t anchor = 0;
+    if (input.size() > lz4_match_start_limit) {
+        auto match_end_limit = input.size() - lz4_last_literals_length;
+        while (in + lz4_match_start_limit <= input.size()) {
+            auto value = lz4_read_u32(input.offset_pointer(in));
+            auto& slot = hash_table[lz4_hash(value, hash_bits)];
+            size_t candidate = slot;
+            slot = in;
+            if (candidate >= in || lz4_read_u32(input.offset_pointer(candidate)) != value) {
+                ++in;
+                continue;
+            }
+
+            size_t match_length = lz4_min_match_length;
+            while (in + match_length < match_end_limit && input[candidate + match_length] == input[in + match_length])
+                ++match_length;
+
+            if (!emit_sequence(anchor, in - anchor, in - candidate, match_length))
+                return {};
+            in += match_length;
+            anchor = in;
+        }
+    }
+
+    if (!emit_sequence(anchor, input.size() - anchor, 0, 0))
+        return {};
+    return out;
+}
+
+// Decompresses a single LZ4 block. Returns the decompressed size, or nothing if the block is malformed or doesn't fit into the output.
+inline Optional<size_t> lz4_decompress_block(ReadonlyBytes input, Bytes output)
+{
+    using namespace Detail;
+
+    size_t in = 0;
+    size_t out = 0;
+
+    auto read_extra_length = [&](size_t& length) {
+        u8 byte;
+        do {
+            if (in >= input.size())
+                return false;
+            byte = input[in++];
+            length += byte;
+        } while (byte == 255);
+        return true;
+    };
+
+    while (in < input.size()) {
+        u8 token = input[in++];
+
+        size_t literal_length = token >> 4;
+        if (literal_length == 15 && !read_extra_length(literal_length))
+            return {};
+        if (literal_length > input.size() - in || literal_length > output.size() - out)
+            return {};
+        __builtin_memcpy(output.offset_pointer(out), input.offset_pointer(in), literal_length);
+        in += literal_length;
+        out += literal_length;
+
+        // The last sequence doesn't have a match.
+        if (in == input.size())
+            return out;
+
+        if (input.size() - in < 2)
+            return {};
+        size_t match_offset = input[in] | (input[in + 1] << 8);
+        in += 2;
+        if (match_offset == 0 || match_offset > out)
+            return {};
+
+        size_t match_length = token & 0xf;
+        if (match_length == 15 && !read_extra_length(match_length))
+            return {};
+        match_length += lz4_min_match_length;
+        if (match_length > output.size() - out)
+            return {};
+
+        // NOTE: The match may overlap with the bytes we're writing, so this has to go byte by byte.
+        for (size_t i = 0; i < match_length; ++i, ++out)
+            output[out] = output[out - match_offset];
+    }
+
+    // A block always ends with a sequence of literals, so an empty block is malformed.
+    return {};
+}
+
+}
+
+#if USING_AK_GLOBALLY
+using AK::lz4_compress_block;
+using AK::lz4_decompress_block;
+#endif
@@ -99,33 +99,42 @@ ALWAYS_INLINE int print_hex(PutChFunc putch, CharType*& bufptr, T number, bool u
     return field_width;
 }
 
+// Writes the digits of number backwards from end, two at a time, and returns a pointer to the first one.
+ALWAYS_INLINE char* write_decimal_digits_backwards(u64 number, char* end)
+{
+    constexpr char const* digit_pairs = "0001020304050607080910111213141516171819"
+                                        "2021222324252627282930313233343536373839"
+                                        "4041424344454647484950515253545556575859"
+                                        "6061626364656667686970717273747576777879"
+                                        "8081828384858687888990919293949596979899";
+
+    while (number >= 100) {
+        auto pair = (number % 100) * 2;
+        number /= 100;
+        *--end = digit_pairs[pair + 1];
+        *--end = digit_pairs[pair];
+    }
+    if (number >= 10) {
+        *--end = digit_pairs[number * 2 + 1];
+        *--end = digit_pairs[number * 2];
+    } else {
+        *--end = static_cast<char>('0' + number);
+    }
+    return end;
+}
+
 template<typename PutChFunc, typename CharType>
 ALWAYS_INLINE int print_decimal(PutChFunc putch, CharType*& bufptr, u64 number, bool sign, bool always_sign, bool left_pad, bool zero_pad, u32 field_width, bool has_precision, u32 precision)
 {
-    u64 divisor = 10000000000000000000LLU;
-    char ch;
-    char padding = 1;
-    char buf[21];
-    char* p = buf;
+    char buf[20];
+    char* const end = buf + sizeof(buf);
+    char* p = end;
 
-    if (!(has_precision && precision == 0 && number == 0)) {
-        for (;;) {
-            ch = '0' + (number / divisor);
-            number %= divisor;
-            if (ch != '0')
-                padding = 0;
-            if (!padding || divisor == 1) {
-                *(p++) = ch;
-                if (precision > 0)
-                    precision--;
-            }
-            if (divisor == 1)
-                break;
-            divisor /= 10;
-        }
-    }
+    if (!(has_precision && precision == 0 && number == 0))
+        p = write_decimal_digits_backwards(number, end);
 
-    size_t numlen = p - buf;
+    size_t numlen = end - p;
+    precision = precision > numlen ? precision - numlen : 0;
 
     if (!field_width || field_width < (numlen + has_precision * precision + (sign || always_sign)))
         field_width = numlen + has_precision * precision + (sign || always_sign);
@@ -151,7 +160,7 @@ ALWAYS_INLINE int print_decimal(PutChFunc putch, CharType*& bufptr, u64 number,
     }
 
     for (unsigned i = 0; i < numlen; ++i) {
-        putch(bufptr, buf[i]);
+        putch(bufptr, p[i]);
     }
 
     if (left_pad) {
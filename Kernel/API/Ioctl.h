@@ -133,6 +133,8 @@ enum IOCtlNumber {
     KCOV_SETBUFSIZE,
     KCOV_ENABLE,
     KCOV_DISABLE,
+    PROFILE_IOCTL_SET_RING_SIZE,
+    PROFILE_IOCTL_GET_BUFFER_SIZE,
     SOUNDCARD_IOCTL_SET_SAMPLE_RATE,
     SOUNDCARD_IOCTL_GET_SAMPLE_RATE,
     STORAGE_DEVICE_GET_SIZE,
@@ -202,3 +204,5 @@ enum IOCtlNumber {
 #define VIRGL_IOCTL_TRANSFER_DATA VIRGL_IOCTL_TRANSFER_DATA
 #define KDSETMODE KDSETMODE
 #define KDGETMODE KDGETMODE
+#define PROFILE_IOCTL_SET_RING_SIZE PROFILE_IOCTL_SET_RING_SIZE
+#define PROFILE_IOCTL_GET_BUFFER_SIZE PROFILE_IOCTL_GET_BUFFER_SIZE
@@ -51,6 +51,7 @@ extern "C" {
 #define FUTEX_WAKE_OP 5
 #define FUTEX_WAIT_BITSET 9
 #define FUTEX_WAKE_BITSET 10
+#define FUTEX_WAITV 16
 
 #define FUTEX_CLOCK_REALTIME (1 << 8)
 #define FUTEX_PRIVATE_FLAG (1 << 9)
@@ -58,6 +59,15 @@ extern "C" {
 
 #define FUTEX_BITSET_MATCH_ANY 0xffffffff
 
+#define FUTEX_WAITV_MAX 128
+
+struct futex_waitv {
+    uint64_t val;
+    uint64_t uaddr;
+    uint32_t flags;
+    uint32_t __reserved;
+};
+
 #ifdef __cplusplus
 }
 #endif
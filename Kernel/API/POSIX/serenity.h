@@ -33,6 +33,7 @@ enum {
     PERF_EVENT_SYSCALL = 16384,
     PERF_EVENT_SIGNPOST = 32768,
     PERF_EVENT_FILESYSTEM = 65536,
+    PERF_EVENT_LOCK_CONTENTION = 131072,
 };
 
 #define PERF_EVENT_MASK_ALL (~0ull)
@@ -39,6 +39,8 @@ extern "C" {
 #define MADV_WILLNEED 0x4
 #define MADV_SEQUENTIAL 0x5
 #define MADV_RANDOM 0x6
+#define MADV_MERGEABLE 0x7
+#define MADV_UNMERGEABLE 0x8
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/posix_madvise.html
 #define POSIX_MADV_NORMAL MADV_NORMAL
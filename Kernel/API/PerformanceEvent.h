@@ -0,0 +1,194 @@
+/*
+ * Copyright (c) 2020, Andreas Kling <kling@serenityos.org>
+ * Copyright (c) 2023, Jakub Berkop <jakub.berkop@gmail.com>
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+#ifdef KERNEL
+#    include <Kernel/UnixTypes.h>
+#else
+#    include <sys/types.h>
+#endif
+
+namespace Kernel {
+
+struct [[gnu::packed]] MallocPerformanceEvent {
+    size_t size;
+    FlatPtr ptr;
+};
+
+struct [[gnu::packed]] FreePerformanceEvent {
+    size_t size;
+    FlatPtr ptr;
+};
+
+struct [[gnu::packed]] MmapPerformanceEvent {
+    size_t size;
+    FlatPtr ptr;
+    char name[64];
+};
+
+struct [[gnu::packed]] MunmapPerformanceEvent {
+    size_t size;
+    FlatPtr ptr;
+};
+
+struct [[gnu::packed]] ProcessCreatePerformanceEvent {
+    pid_t parent_pid;
+    char executable[64];
+};
+
+struct [[gnu::packed]] ProcessExecPerformanceEvent {
+    char executable[64];
+};
+
+struct [[gnu::packed]] ThreadCreatePerformanceEvent {
+    pid_t parent_tid;
+};
+
+struct [[gnu::packed]] ContextSwitchPerformanceEvent {
+    pid_t next_pid;
+    u32 next_tid;
+};
+
+struct [[gnu::packed]] KMallocPerformanceEvent {
+    size_t size;
+    FlatPtr ptr;
+};
+
+struct [[gnu::packed]] KFreePerformanceEvent {
+    size_t size;
+    FlatPtr ptr;
+};
+
+struct [[gnu::packed]] SignpostPerformanceEvent {
+    FlatPtr arg1;
+    FlatPtr arg2;
+};
+
+struct [[gnu::packed]] LockContentionPerformanceEvent {
+    FlatPtr lock;
+    u64 wait_time;
+};
+
+struct [[gnu::packed]] ReadPerformanceEvent {
+    int fd;
+    size_t size;
+    size_t filename_index;
+    size_t start_timestamp;
+    bool success;
+};
+
+enum class FilesystemEventType : u8 {
+    Open,
+    Close,
+    Readv,
+    Read,
+    Pread
+};
+
+struct [[gnu::packed]] OpenEventData {
+    int dirfd;
+    size_t filename_index;
+    int options;
+    u64 mode;
+};
+
+struct [[gnu::packed]] CloseEventData {
+    int fd;
+    size_t filename_index;
+};
+
+struct [[gnu::packed]] ReadvEventData {
+    int fd;
+    size_t filename_index;
+    // struct iovec* iov; // TODO: Implement
+    // int iov_count; // TODO: Implement
+};
+
+struct [[gnu::packed]] ReadEventData {
+    int fd;
+    size_t filename_index;
+};
+
+struct [[gnu::packed]] PreadEventData {
+    int fd;
+    size_t filename_index;
+    FlatPtr buffer_ptr;
+    size_t size;
+    off_t offset;
+};
+
+// FIXME: This is a hack to make the compiler pack this struct correctly.
+struct [[gnu::packed]] PackedErrorOr {
+    bool is_error;
+    FlatPtr value;
+};
+
+struct [[gnu::packed]] FilesystemEvent {
+    FilesystemEventType type;
+    u64 durationNs;
+    PackedErrorOr result;
+
+    union {
+        OpenEventData open;
+        CloseEventData close;
+        ReadvEventData readv;
+        ReadEventData read;
+        PreadEventData pread;
+    } data;
+};
+
+// NOTE: Outside the kernel, AK/kmalloc.h defines kmalloc to be malloc, which would clash with the union members below.
+#pragma push_macro("kmalloc")
+#undef kmalloc
+
+struct [[gnu::packed]] PerformanceEvent {
+    u32 type { 0 };
+    u8 stack_size { 0 };
+    u32 pid { 0 };
+    u32 tid { 0 };
+    u64 timestamp;
+    u32 lost_samples;
+    union {
+        MallocPerformanceEvent malloc;
+        FreePerformanceEvent free;
+        MmapPerformanceEvent mmap;
+        MunmapPerformanceEvent munmap;
+        ProcessCreatePerformanceEvent process_create;
+        ProcessExecPerformanceEvent process_exec;
+        ThreadCreatePerformanceEvent thread_create;
+        ContextSwitchPerformanceEvent context_switch;
+        KMallocPerformanceEvent kmalloc;
+        KFreePerformanceEvent kfree;
+        SignpostPerformanceEvent signpost;
+        FilesystemEvent filesystem;
+        LockContentionPerformanceEvent lock_contention;
+    } data;
+    static constexpr size_t max_stack_frame_count = 64;
+    FlatPtr stack[max_stack_frame_count];
+};
+
+#pragma pop_macro("kmalloc")
+
+// While profiling all processes, events can be streamed to userspace through /dev/profile instead of
+// being collected in one big buffer. Every processor has its own ring of events, which starts with
+// this header. The kernel only ever advances `head`, and the consumer only ever advances `tail`.
+// Events that don't fit into a full ring are dropped and counted in `lost_events`.
+struct PerformanceEventRingHeader {
+    u64 head;
+    u64 tail;
+    u64 lost_events;
+    u32 capacity;
+    u32 processor;
+    u32 processor_count;
+    u32 events_offset;
+    u64 ring_size;
+};
+
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// /sys/kernel/process_statistics contains the same information as /sys/kernel/processes, but in a fixed
+// binary layout that is cheap to generate and to parse:
+//
+//   ProcessStatisticsHeader
+//   u32 pid of every process that went away (removed_process_count of them), padded to 8 bytes
+//   For every process (process_count of them):
+//       ProcessStatisticsEntry
+//       The executable path, the TTY name and the pledged promises (not null-terminated), padded to 8 bytes
+//       ThreadStatisticsEntry for every thread (thread_count of them)
+//
+// An open file description remembers the generation of the last snapshot it has been given. Whenever it
+// is refreshed (by seeking back to offset 0), it only gets the processes that changed since then, and the
+// pids of the ones that went away. If the `Full` flag is set, the snapshot contains all processes instead.
+
+struct ProcessStatisticsHeader {
+    static constexpr u32 expected_magic = 0x53545350; // "PSTS"
+    static constexpr u32 expected_version = 1;
+
+    enum Flags : u32 {
+        Full = 1 << 0,
+    };
+
+    u32 magic;
+    u32 version;
+    u32 flags;
+    u32 header_size;
+    u64 generation;
+    u64 since_generation;
+    u32 process_count;
+    u32 removed_process_count;
+    u64 total_time;
+    u64 total_time_kernel;
+};
+static_assert(sizeof(ProcessStatisticsHeader) % 8 == 0);
+
+enum class ProcessStatisticsVeilState : u8 {
+    NotApplicable,
+    None,
+    Dropped,
+    Locked,
+};
+
+struct ProcessStatisticsEntry {
+    u32 pid;
+    u32 pgid;
+    u32 pgp;
+    u32 sid;
+    u32 uid;
+    u32 gid;
+    u32 ppid;
+    u8 is_kernel;
+    u8 is_dumpable;
+    ProcessStatisticsVeilState veil;
+    u8 reserved;
+    i64 creation_time_ns;
+    u64 amount_virtual;
+    u64 amount_resident;
+    u64 amount_dirty_private;
+    u64 amount_clean_inode;
+    u64 amount_shared;
+    u64 amount_purgeable_volatile;
+    u64 amount_purgeable_nonvolatile;
+    char name[32];
+    u16 executable_length;
+    u16 tty_length;
+    u16 pledge_length;
+    u16 reserved2;
+    u32 thread_count;
+    // The size of this entry including its strings and threads, so unknown parts can be skipped.
+    u32 entry_size;
+};
+static_assert(sizeof(ProcessStatisticsEntry) % 8 == 0);
+
+struct ThreadStatisticsEntry {
+    u32 tid;
+    u32 times_scheduled;
+    u32 cpu;
+    u32 priority;
+    u32 syscall_count;
+    u32 inode_faults;
+    u32 zero_faults;
+    u32 cow_faults;
+    u64 time_user;
+    u64 time_kernel;
+    u64 file_read_bytes;
+    u64 file_write_bytes;
+    u64 unix_socket_read_bytes;
+    u64 unix_socket_write_bytes;
+    u64 ipv4_socket_read_bytes;
+    u64 ipv4_socket_write_bytes;
+    char state[32];
+    char name[64];
+};
+static_assert(sizeof(ThreadStatisticsEntry) % 8 == 0);
+
+}
@@ -0,0 +1,23 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+
+namespace Kernel {
+
+// Tells which of the calling process's threads each processor is running right now, or 0 if it's running some other
+// process. Userspace maps this page with sys$map_running_threads_page(), so that a thread waiting for a lock can keep
+// spinning for as long as the owner of the lock is on a processor. Every process gets its own page.
+struct RunningThreadsPage {
+    static constexpr size_t max_processor_count = 64;
+
+    volatile u32 processor_count;
+    volatile i32 running_thread_ids[max_processor_count];
+};
+
+}
@@ -125,6 +125,7 @@ enum class NeedsBigProcessLock {
     S(listen, NeedsBigProcessLock::No)                     \
     S(lseek, NeedsBigProcessLock::No)                      \
     S(madvise, NeedsBigProcessLock::No)                    \
+    S(map_running_threads_page, NeedsBigProcessLock::No)   \
     S(map_time_page, NeedsBigProcessLock::No)              \
     S(mkdir, NeedsBigProcessLock::No)                      \
     S(mknod, NeedsBigProcessLock::No)                      \
@@ -21,9 +21,28 @@ inline bool time_page_supports(clockid_t clock_id)
     return clock_id == CLOCK_REALTIME_COARSE || clock_id == CLOCK_MONOTONIC_COARSE;
 }
 
+// These clocks can only be read from the time page while its counter_multiplier is non-zero.
+inline bool time_page_supports_with_counter(clockid_t clock_id)
+{
+    return clock_id == CLOCK_REALTIME || clock_id == CLOCK_MONOTONIC || clock_id == CLOCK_MONOTONIC_RAW;
+}
+
 struct TimePage {
+    static constexpr u32 counter_shift = 32;
+
+    // The precise clocks in `clocks` are as of when the counter (the TSC on x86_64) read `counter_base`.
+    // To get the current time, add the number of nanoseconds since then to them.
+    u64 counter_ticks_to_nanoseconds(u64 ticks) const
+    {
+        return static_cast<u64>((static_cast<unsigned __int128>(ticks) * counter_multiplier) >> counter_shift);
+    }
+
     volatile u32 update1;
     struct timespec clocks[CLOCK_ID_COUNT];
+    u64 counter_base;
+    // Zero if there is no counter that userspace can read, if it doesn't tick at a constant rate, or if it isn't in sync
+    // on all processors. Userspace has to use the syscall for the precise clocks then.
+    u64 counter_multiplier;
     volatile u32 update2;
 };
 
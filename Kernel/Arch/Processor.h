@@ -63,7 +63,8 @@ public:
 
     static bool is_smp_enabled();
     static void smp_enable();
-    static u32 smp_wake_n_idle_processors(u32 wake_count);
+    // Wakes up to wake_count idle processors out of the ones in cpu_mask.
+    static u32 smp_wake_n_idle_processors(u32 wake_count, u32 cpu_mask = 0xffffffff);
 
     static void flush_tlb_local(VirtualAddress vaddr, size_t page_count);
     static void flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
@@ -144,6 +145,9 @@ public:
     void idle_begin() const;
     void idle_end() const;
     u64 time_spent_idle() const;
+
+    u64 tlb_shootdowns() const { return m_tlb_shootdowns; }
+    u64 tlb_flushed_pages() const { return m_tlb_flushed_pages; }
     ALWAYS_INLINE static u64 read_cpu_counter();
 
     void check_invoke_scheduler();
@@ -182,6 +186,9 @@ protected:
     u8 m_physical_address_bit_width;
     u8 m_virtual_address_bit_width;
 
+    u64 m_tlb_shootdowns { 0 };
+    u64 m_tlb_flushed_pages { 0 };
+
 private:
     void* m_processor_specific_data[static_cast<size_t>(ProcessorSpecificDataID::__Count)];
     Thread* m_idle_thread;
@@ -146,6 +146,10 @@ public:
     bool is_pat() const { TODO_AARCH64(); }
     void set_pat(bool) { }
 
+    // FIXME: We always set the access flag, as access flag faults aren't handled yet.
+    bool is_accessed() const { return false; }
+    void set_accessed(bool) { }
+
     bool is_null() const { return m_raw == 0; }
     void clear() { m_raw = 0; }
 
@@ -145,9 +145,10 @@ u32 ProcessorBase<T>::clear_critical()
 }
 
 template<typename T>
-u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count)
+u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count, u32 cpu_mask)
 {
     (void)wake_count;
+    (void)cpu_mask;
     // FIXME: Actually wake up other cores when SMP is supported for aarch64.
     return 0;
 }
@@ -25,6 +25,7 @@
 #include <Kernel/Devices/Generic/FullDevice.h>
 #include <Kernel/Devices/Generic/MemoryDevice.h>
 #include <Kernel/Devices/Generic/NullDevice.h>
+#include <Kernel/Devices/Generic/ProfileDevice.h>
 #include <Kernel/Devices/Generic/RandomDevice.h>
 #include <Kernel/Devices/Generic/SelfTTYDevice.h>
 #include <Kernel/Devices/Generic/ZeroDevice.h>
@@ -44,7 +45,9 @@
 #include <Kernel/Heap/kmalloc.h>
 #include <Kernel/KSyms.h>
 #include <Kernel/Library/Panic.h>
+#include <Kernel/Memory/CompressedPageStore.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/SamePageMerger.h>
 #include <Kernel/Net/NetworkTask.h>
 #include <Kernel/Net/NetworkingManagement.h>
 #include <Kernel/Prekernel/Prekernel.h>
@@ -54,6 +57,7 @@
 #include <Kernel/Tasks/Process.h>
 #include <Kernel/Tasks/Scheduler.h>
 #include <Kernel/Tasks/SyncTask.h>
+#include <Kernel/Tasks/SyscallStatistics.h>
 #include <Kernel/Tasks/WorkQueue.h>
 #include <Kernel/Time/TimeManagement.h>
 #include <Kernel/kstdio.h>
@@ -242,6 +246,7 @@ extern "C" [[noreturn]] UNMAP_AFTER_INIT void init([[maybe_unused]] BootInfo con
 
     CommandLine::initialize();
     Memory::MemoryManager::initialize(0);
+    Memory::CompressedPageStore::initialize();
 
 #if ARCH(AARCH64)
     auto firmware_version = RPi::Mailbox::the().query_firmware_version();
@@ -360,6 +365,7 @@ void init_stage2(void*)
         // exhausted
         APIC::the().boot_aps();
     }
+    TimeManagement::the().check_tsc_synchronization_for_time_page();
 #endif
 
     // Initialize the PCI Bus as early as possible, for early boot (PCI based) serial logging
@@ -390,6 +396,8 @@ void init_stage2(void*)
 
     SyncTask::spawn();
     FinalizerTask::spawn();
+    Memory::SamePageMerger::initialize();
+    SyscallStatistics::initialize();
 
     auto boot_profiling = kernel_command_line().is_boot_profiling_enabled();
 
@@ -410,6 +418,7 @@ void init_stage2(void*)
     (void)MemoryDevice::must_create().leak_ref();
     (void)ZeroDevice::must_create().leak_ref();
     (void)FullDevice::must_create().leak_ref();
+    (void)ProfileDevice::must_create().leak_ref();
     (void)RandomDevice::must_create().leak_ref();
     (void)SelfTTYDevice::must_create().leak_ref();
     PTYMultiplexer::initialize();
@@ -81,7 +81,7 @@ u32 ProcessorBase<T>::clear_critical()
 }
 
 template<typename T>
-u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32)
+u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32, u32)
 {
     // FIXME: Actually wake up other cores when SMP is supported for riscv64.
     return 0;
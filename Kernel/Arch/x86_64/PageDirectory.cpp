@@ -52,8 +52,9 @@ void activate_kernel_page_directory(PageDirectory const& pgd)
 
 void activate_page_directory(PageDirectory const& pgd, Thread* current_thread)
 {
+    InterruptDisabler disabler;
     current_thread->regs().cr3 = pgd.cr3();
-    write_cr3(pgd.cr3());
+    Processor::current().activate_cr3(pgd.cr3());
 }
 
 UNMAP_AFTER_INIT NonnullLockRefPtr<PageDirectory> PageDirectory::must_create_kernel_page_directory()
@@ -120,6 +121,8 @@ ErrorOr<NonnullLockRefPtr<PageDirectory>> PageDirectory::try_create_for_userspac
         MM.unquickmap_page();
     }
 
+    directory->m_pcid = Processor::allocate_pcid();
+
     register_page_directory(directory);
     return directory;
 }
@@ -144,6 +147,7 @@ PageDirectory::~PageDirectory()
     if (is_cr3_initialized()) {
         deregister_page_directory(this);
     }
+    Processor::deallocate_pcid(m_pcid);
 }
 
 }
@@ -100,6 +100,7 @@ public:
         UserSupervisor = 1 << 2,
         WriteThrough = 1 << 3,
         CacheDisabled = 1 << 4,
+        Accessed = 1 << 5,
         PAT = 1 << 7,
         Global = 1 << 8,
         NoExecute = 0x8000000000000000ULL,
@@ -108,6 +109,9 @@ public:
     bool is_present() const { return (raw() & Present) == Present; }
     void set_present(bool b) { set_bit(Present, b); }
 
+    bool is_accessed() const { return (raw() & Accessed) == Accessed; }
+    void set_accessed(bool b) { set_bit(Accessed, b); }
+
     bool is_user_allowed() const { return (raw() & UserSupervisor) == UserSupervisor; }
     void set_user_allowed(bool b) { set_bit(UserSupervisor, b); }
 
@@ -172,9 +176,11 @@ public:
 
     FlatPtr cr3() const
     {
-        return m_pml4t->paddr().get();
+        return m_pml4t->paddr().get() | m_pcid;
     }
 
+    u16 pcid() const { return m_pcid; }
+
     bool is_cr3_initialized() const
     {
         return m_pml4t;
@@ -197,6 +203,7 @@ private:
     RefPtr<PhysicalPage> m_directory_table;
     RefPtr<PhysicalPage> m_directory_pages[512];
     RecursiveSpinlock<LockRank::None> m_lock {};
+    u16 m_pcid { 0 };
 };
 
 void activate_kernel_page_directory(PageDirectory const& pgd);
@@ -37,6 +37,20 @@ namespace Kernel {
 
 READONLY_AFTER_INIT static ProcessorContainer s_processors {};
 READONLY_AFTER_INIT static bool volatile s_smp_enabled;
+READONLY_AFTER_INIT static bool s_pcid_enabled;
+
+// Bumped every time a PCID is handed out to a new page directory.
+static Array<Atomic<u32>, PCID_COUNT> s_pcid_generations;
+// The processors that may still have TLB entries tagged with a given PCID.
+static Array<Atomic<u64>, PCID_COUNT> s_pcid_processor_masks;
+static Spinlock<LockRank::None> s_pcid_allocation_lock {};
+static Array<u64, PCID_COUNT / 64> s_pcid_allocation_bitmap {};
+
+static constexpr FlatPtr CR3_NO_FLUSH = 1ull << 63;
+
+// Invalidating more pages than this one by one is slower than dropping the whole
+// (non-global) TLB of the current address space.
+static constexpr size_t TLB_FULL_FLUSH_THRESHOLD = 32;
 
 static Atomic<ProcessorMessage*> s_message_pool;
 Atomic<u32> Processor::s_idle_cpu_mask { 0 };
@@ -506,6 +520,19 @@ UNMAP_AFTER_INIT void Processor::cpu_setup()
         write_cr4(read_cr4() | 0x80);
     }
 
+    // NOTE: PCIDs are only safe to use if kernel mappings are global, as they have to
+    //       stay coherent across all address spaces. The decision is made once on the
+    //       BSP, and all APs have to follow it.
+    if (id() == 0)
+        s_pcid_enabled = has_feature(CPUFeature::PGE) && has_feature(CPUFeature::PCID);
+    m_pcid_generations.fill(0);
+    if (s_pcid_enabled) {
+        VERIFY(has_feature(CPUFeature::PCID));
+        // Turn on CR4.PCIDE, CR3 must not contain a PCID at this point.
+        VERIFY((read_cr3() & CR3_PCID_MASK) == 0);
+        write_cr4(read_cr4() | 0x20000);
+    }
+
     if (has_feature(CPUFeature::NX)) {
         // Turn on IA32_EFER.NXE
         MSR ia32_efer(MSR_IA32_EFER);
@@ -949,6 +976,14 @@ void ProcessorBase<T>::exit_trap(TrapFrame& trap)
 template<typename T>
 void ProcessorBase<T>::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 {
+    Processor::current().m_tlb_flushed_pages += page_count;
+
+    if (page_count > TLB_FULL_FLUSH_THRESHOLD && Memory::is_user_range(vaddr, page_count * PAGE_SIZE)) {
+        // Kernel mappings are global, so this only throws away the current address space's translations.
+        write_cr3(read_cr3());
+        return;
+    }
+
     auto ptr = vaddr.as_ptr();
     while (page_count > 0) {
         // clang-format off
@@ -965,16 +1000,143 @@ void ProcessorBase<T>::flush_tlb_local(VirtualAddress vaddr, size_t page_count)
 template<typename T>
 void ProcessorBase<T>::flush_entire_tlb_local()
 {
-    write_cr3(read_cr3());
+    auto cr4 = read_cr4();
+    if (cr4 & 0x80) {
+        // Toggling CR4.PGE also throws away global translations (and those of all PCIDs).
+        asm volatile("mov %%rax, %%cr4" ::"a"(cr4 & ~0x80ul)
+                     : "memory");
+        asm volatile("mov %%rax, %%cr4" ::"a"(cr4)
+                     : "memory");
+    } else {
+        write_cr3(read_cr3());
+    }
+}
+
+static bool user_tlb_flush_needs_broadcast(Memory::PageDirectory const* page_directory)
+{
+    if (auto pcid = page_directory->cr3() & CR3_PCID_MASK; pcid != 0) {
+        // Other processors keep translations for this address space around even
+        // after switching away from it, so we have to ask all that might have some.
+        auto other_processors = s_pcid_processor_masks[pcid].load() & ~(1ull << Processor::current_id());
+        return other_processors != 0;
+    }
+    // The page directory may belong to another process (e.g. when its pages are reclaimed
+    // or merged), which could be active on any other processor, no matter how many threads
+    // the current process has.
+    if ((read_cr3() & ~CR3_PCID_MASK) != (page_directory->cr3() & ~CR3_PCID_MASK))
+        return true;
+    return Process::current().thread_count() > 1;
 }
 
 template<typename T>
 void ProcessorBase<T>::flush_tlb(Memory::PageDirectory const* page_directory, VirtualAddress vaddr, size_t page_count)
 {
-    if (s_smp_enabled && (!Memory::is_user_address(vaddr) || Process::current().thread_count() > 1))
+    if (s_smp_enabled && (!Memory::is_user_address(vaddr) || user_tlb_flush_needs_broadcast(page_directory)))
         Processor::smp_broadcast_flush_tlb(page_directory, vaddr, page_count);
     else
-        flush_tlb_local(vaddr, page_count);
+        Processor::current().flush_tlb_local_for_page_directory(page_directory, vaddr, page_count);
+}
+
+bool Processor::has_pcid_support()
+{
+    return s_pcid_enabled;
+}
+
+u16 Processor::allocate_pcid()
+{
+    if (!s_pcid_enabled)
+        return 0;
+
+    SpinlockLocker locker(s_pcid_allocation_lock);
+    for (size_t word_index = 0; word_index < s_pcid_allocation_bitmap.size(); word_index++) {
+        auto& word = s_pcid_allocation_bitmap[word_index];
+        // PCID 0 is reserved for the kernel.
+        auto free_bits = ~word & (word_index == 0 ? ~1ull : ~0ull);
+        if (free_bits == 0)
+            continue;
+        auto bit = count_trailing_zeroes(free_bits);
+        word |= 1ull << bit;
+        u16 pcid = word_index * 64 + bit;
+
+        // Any processor that still has translations tagged with this PCID from its
+        // previous owner will notice the new generation and flush them before use.
+        auto generation = s_pcid_generations[pcid].load() + 1;
+        if (generation == 0)
+            generation = 1;
+        s_pcid_generations[pcid].store(generation);
+        s_pcid_processor_masks[pcid].store(0);
+        return pcid;
+    }
+    // We ran out of PCIDs, this address space will simply get flushed on every switch.
+    return 0;
+}
+
+void Processor::deallocate_pcid(u16 pcid)
+{
+    if (pcid == 0)
+        return;
+    VERIFY(pcid < PCID_COUNT);
+    SpinlockLocker locker(s_pcid_allocation_lock);
+    auto& word = s_pcid_allocation_bitmap[pcid / 64];
+    VERIFY(word & (1ull << (pcid % 64)));
+    word &= ~(1ull << (pcid % 64));
+}
+
+void Processor::activate_cr3(FlatPtr cr3)
+{
+    auto pcid = cr3 & CR3_PCID_MASK;
+    if (pcid == 0) {
+        write_cr3(cr3);
+        return;
+    }
+
+    s_pcid_processor_masks[pcid].fetch_or(1ull << id());
+    auto generation = s_pcid_generations[pcid].load();
+    if (m_pcid_generations[pcid] == generation) {
+        // Our TLB entries for this address space are still valid, keep them.
+        write_cr3(cr3 | CR3_NO_FLUSH);
+        return;
+    }
+    m_pcid_generations[pcid] = generation;
+    write_cr3(cr3);
+}
+
+void Processor::invalidate_inactive_pcid(u16 pcid, VirtualAddress vaddr, size_t page_count)
+{
+    if (pcid == 0) {
+        // Without a PCID, these translations were already thrown away when we switched away.
+        return;
+    }
+
+    if (has_feature(CPUFeature::INVPCID) && page_count <= TLB_FULL_FLUSH_THRESHOLD) {
+        m_tlb_flushed_pages += page_count;
+        for (size_t i = 0; i < page_count; i++) {
+            struct [[gnu::packed]] {
+                u64 pcid;
+                u64 address;
+            } descriptor { pcid, vaddr.offset(i * PAGE_SIZE).get() };
+            // Type 0: Individual-address invalidation
+            asm volatile("invpcid %0, %1" ::"m"(descriptor), "r"(0ul)
+                         : "memory");
+        }
+        return;
+    }
+
+    // Forget everything for this PCID, we'll flush it the next time we switch to it.
+    m_pcid_generations[pcid] = 0;
+    s_pcid_processor_masks[pcid].fetch_and(~(1ull << id()));
+}
+
+void Processor::flush_tlb_local_for_page_directory(Memory::PageDirectory const* page_directory, VirtualAddress vaddr, size_t page_count)
+{
+    if (Memory::is_user_address(vaddr) && read_cr3() != page_directory->cr3()) {
+        // This processor isn't using this page directory right now, so only its PCID
+        // (if it has one) can hold stale translations.
+        dbgln_if(SMP_DEBUG, "SMP[{}]: Page directory of {} pages at {} isn't active", id(), page_count, vaddr);
+        invalidate_inactive_pcid(page_directory->cr3() & CR3_PCID_MASK, vaddr, page_count);
+        return;
+    }
+    flush_tlb_local(vaddr, page_count);
 }
 
 void Processor::smp_return_to_pool(ProcessorMessage& msg)
@@ -1017,7 +1179,7 @@ ProcessorMessage& Processor::smp_get_from_pool()
 }
 
 template<typename T>
-u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count)
+u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count, u32 cpu_mask)
 {
     VERIFY_INTERRUPTS_DISABLED();
     VERIFY(wake_count > 0);
@@ -1036,7 +1198,7 @@ u32 ProcessorBase<T>::smp_wake_n_idle_processors(u32 wake_count)
     auto& apic = APIC::the();
     while (did_wake_count < wake_count) {
         // Try to get a set of idle CPUs and flip them to busy
-        u32 idle_mask = Processor::s_idle_cpu_mask.load(AK::MemoryOrder::memory_order_relaxed) & ~(1u << current_id);
+        u32 idle_mask = Processor::s_idle_cpu_mask.load(AK::MemoryOrder::memory_order_relaxed) & cpu_mask & ~(1u << current_id);
         u32 idle_count = popcount(idle_mask);
         if (idle_count == 0)
             break; // No (more) idle processor available
@@ -1139,13 +1301,8 @@ bool Processor::smp_process_pending_messages()
                 if (Memory::is_user_address(VirtualAddress(msg->flush_tlb.ptr))) {
                     // We assume that we don't cross into kernel land!
                     VERIFY(Memory::is_user_range(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count * PAGE_SIZE));
-                    if (read_cr3() != msg->flush_tlb.page_directory->cr3()) {
-                        // This processor isn't using this page directory right now, we can ignore this request
-                        dbgln_if(SMP_DEBUG, "SMP[{}]: No need to flush {} pages at {}", current_id(), msg->flush_tlb.page_count, VirtualAddress(msg->flush_tlb.ptr));
-                        break;
-                    }
                 }
-                flush_tlb_local(VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
+                flush_tlb_local_for_page_directory(msg->flush_tlb.page_directory, VirtualAddress(msg->flush_tlb.ptr), msg->flush_tlb.page_count);
                 break;
             }
 
@@ -1281,9 +1438,10 @@ void Processor::smp_broadcast_flush_tlb(Memory::PageDirectory const* page_direct
     msg.flush_tlb.page_directory = page_directory;
     msg.flush_tlb.ptr = vaddr.as_ptr();
     msg.flush_tlb.page_count = page_count;
+    Processor::current().m_tlb_shootdowns++;
     smp_broadcast_message(msg);
     // While the other processors handle this request, we'll flush ours
-    flush_tlb_local(vaddr, page_count);
+    Processor::current().flush_tlb_local_for_page_directory(page_directory, vaddr, page_count);
     // Now wait until everybody is done as well
     smp_broadcast_wait_sync(msg);
 }
@@ -1393,7 +1551,7 @@ extern "C" void enter_thread_context(Thread* from_thread, Thread* to_thread)
     Processor::set_thread_specific_data(to_thread->thread_specific_data());
 
     if (from_regs.cr3 != to_regs.cr3)
-        write_cr3(to_regs.cr3);
+        processor.activate_cr3(to_regs.cr3);
 
     to_thread->set_cpu(processor.id());
 
@@ -1739,7 +1897,16 @@ void ProcessorBase<T>::idle_end() const
 template<typename T>
 void ProcessorBase<T>::wait_for_interrupt() const
 {
-    asm("hlt");
+    // If another processor woke us up (see smp_wake_n_idle_processors) before we got here, its IPI
+    // has already been handled, and we might not get another interrupt for a long time if our timer
+    // tick is stopped. Because sti only takes effect after the next instruction, nothing can come in
+    // between checking whether we're still idle and halting.
+    cli();
+    if (!(Processor::s_idle_cpu_mask.load(AK::MemoryOrder::memory_order_relaxed) & (1u << m_cpu))) {
+        sti();
+        return;
+    }
+    asm volatile("sti; hlt" ::: "memory");
 }
 
 }
@@ -52,6 +52,13 @@ class ProcessorBase;
 constexpr size_t MAX_CPU_COUNT = 64;
 using ProcessorContainer = Array<Processor*, MAX_CPU_COUNT>;
 
+// Process context identifiers tag TLB entries with the address space they belong to,
+// so switching between address spaces doesn't have to throw away the whole TLB.
+// PCID 0 is used by the kernel page directory, and by every page directory that
+// couldn't get a PCID of its own.
+constexpr size_t PCID_COUNT = 1024;
+constexpr FlatPtr CR3_PCID_MASK = 0xfff;
+
 extern "C" void context_first_init(Thread* from_thread, Thread* to_thread, [[maybe_unused]] TrapFrame* trap);
 
 // If this fails to compile because ProcessorBase was not found, you are including this header directly.
@@ -78,6 +85,10 @@ private:
 
     Atomic<ProcessorMessageEntry*> m_message_queue;
 
+    // The generation of each PCID this processor last flushed its TLB entries for.
+    // A mismatch with the global generation means the entries may be stale.
+    Array<u32, PCID_COUNT> m_pcid_generations {};
+
     void gdt_init();
     void write_raw_gdt_entry(u16 selector, u32 low, u32 high);
     void write_gdt_entry(u16 selector, Descriptor& descriptor);
@@ -92,6 +103,8 @@ private:
     static void smp_broadcast_wait_sync(ProcessorMessage& msg);
     static void smp_broadcast_halt();
 
+    void invalidate_inactive_pcid(u16 pcid, VirtualAddress, size_t page_count);
+
     void cpu_detect();
     void cpu_setup();
 
@@ -153,6 +166,12 @@ public:
 
     static void smp_unicast(u32 cpu, Function<void()>, bool async);
     static void smp_broadcast_flush_tlb(Memory::PageDirectory const*, VirtualAddress, size_t);
+
+    static bool has_pcid_support();
+    static u16 allocate_pcid();
+    static void deallocate_pcid(u16);
+    void activate_cr3(FlatPtr cr3);
+    void flush_tlb_local_for_page_directory(Memory::PageDirectory const*, VirtualAddress, size_t page_count);
 };
 
 template<typename T>
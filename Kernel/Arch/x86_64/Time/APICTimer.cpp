@@ -4,6 +4,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/NumericLimits.h>
 #include <Kernel/Arch/x86_64/Interrupts/APIC.h>
 #include <Kernel/Arch/x86_64/Time/APICTimer.h>
 #include <Kernel/Library/Panic.h>
@@ -141,6 +142,12 @@ void APICTimer::disable_local_timer()
     APIC::the().setup_local_timer(0, APIC::TimerMode::OneShot, false);
 }
 
+void APICTimer::enable_local_one_shot_timer(size_t ticks)
+{
+    u64 count = static_cast<u64>(m_timer_period) * ticks;
+    APIC::the().setup_local_timer(static_cast<u32>(min<u64>(count, NumericLimits<u32>::max())), APIC::TimerMode::OneShot, true);
+}
+
 size_t APICTimer::ticks_per_second() const
 {
     return m_frequency;
@@ -34,6 +34,8 @@ public:
     void will_be_destroyed() override { HardwareTimer<GenericInterruptHandler>::will_be_destroyed(); }
     void enable_local_timer();
     void disable_local_timer();
+    // Replaces the periodic interrupt of this processor with a single one after the given number of ticks.
+    void enable_local_one_shot_timer(size_t ticks);
 
 private:
     explicit APICTimer(u8, Function<void(RegisterState const&)>);
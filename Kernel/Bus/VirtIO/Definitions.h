@@ -27,6 +27,7 @@ namespace Kernel::VirtIO {
 #define DEVICE_STATUS_FAILED (1 << 7)
 
 #define VIRTIO_F_INDIRECT_DESC ((u64)1 << 28)
+#define VIRTIO_F_EVENT_IDX ((u64)1 << 29)
 #define VIRTIO_F_VERSION_1 ((u64)1 << 32)
 #define VIRTIO_F_RING_PACKED ((u64)1 << 34)
 #define VIRTIO_F_IN_ORDER ((u64)1 << 35)
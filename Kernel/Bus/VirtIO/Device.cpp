@@ -52,10 +52,8 @@ ErrorOr<void> Device::accept_device_features(u64 device_features, u64 accepted_f
         accepted_features &= ~(VIRTIO_F_RING_PACKED);
     }
 
-    // TODO: implement indirect descriptors to allow queue_size buffers instead of buffers totalling (PAGE_SIZE * queue_size) bytes
-    if (is_feature_set(device_features, VIRTIO_F_INDIRECT_DESC)) {
-        // accepted_features |= VIRTIO_F_INDIRECT_DESC;
-    }
+    // NOTE: Indirect descriptors (VIRTIO_F_INDIRECT_DESC) and event indices (VIRTIO_F_EVENT_IDX) need support
+    //       from the device's driver, so they are only accepted if the driver asked for them.
 
     if (is_feature_set(device_features, VIRTIO_F_IN_ORDER)) {
         accepted_features |= VIRTIO_F_IN_ORDER;
@@ -82,6 +80,8 @@ ErrorOr<void> Device::setup_queue(u16 queue_index)
 {
     auto queue = TRY(m_transport_entity->setup_queue({}, queue_index));
     dbgln_if(VIRTIO_DEBUG, "{}: Queue[{}] configured with size: {}", m_class_name, queue_index, queue->size());
+    if (m_did_accept_features && is_feature_set(m_accepted_features, VIRTIO_F_EVENT_IDX))
+        queue->enable_event_index();
 
     TRY(m_queues.try_append(move(queue)));
     return {};
@@ -144,13 +144,16 @@ bool Device::handle_irq(Badge<TransportInterruptHandler>)
     }
     if (isr_type & QUEUE_INTERRUPT) {
         dbgln_if(VIRTIO_DEBUG, "{}: VirtIO Queue interrupt!", class_name());
+        // NOTE: All queues share the same interrupt, so more than one of them might have been updated.
+        bool handled_any_queue = false;
         for (size_t i = 0; i < m_queues.size(); i++) {
             if (get_queue(i).new_data_available()) {
                 handle_queue_update(i);
-                return true;
+                handled_any_queue = true;
             }
         }
-        dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
+        if (!handled_any_queue)
+            dbgln_if(VIRTIO_DEBUG, "{}: Got queue interrupt but all queues are up to date!", class_name());
     }
     return true;
 }
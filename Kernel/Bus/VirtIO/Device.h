@@ -38,6 +38,8 @@ protected:
     ErrorOr<void> setup_queues(u16 requested_queue_count = 0);
     void finish_init();
 
+    u16 queue_count() const { return m_queue_count; }
+
     Queue& get_queue(u16 queue_index)
     {
         VERIFY(queue_index < m_queue_count);
@@ -11,10 +11,7 @@ namespace Kernel::VirtIO {
 
 ErrorOr<NonnullOwnPtr<Queue>> Queue::try_create(u16 queue_size, u16 notify_offset)
 {
-    size_t size_of_descriptors = sizeof(QueueDescriptor) * queue_size;
-    size_t size_of_driver = sizeof(QueueDriver) + queue_size * sizeof(u16);
-    size_t size_of_device = sizeof(QueueDevice) + queue_size * sizeof(QueueDeviceItem);
-    auto queue_region_size = TRY(Memory::page_round_up(size_of_descriptors + size_of_driver + size_of_device));
+    auto queue_region_size = TRY(Memory::page_round_up(device_area_offset(queue_size) + size_of_device(queue_size)));
     OwnPtr<Memory::Region> queue_region;
     if (queue_region_size <= PAGE_SIZE)
         queue_region = TRY(MM.allocate_kernel_region(queue_region_size, "VirtIO Queue"sv, Memory::Region::Access::ReadWrite));
@@ -29,14 +26,11 @@ Queue::Queue(NonnullOwnPtr<Memory::Region> queue_region, u16 queue_size, u16 not
     , m_free_buffers(queue_size)
     , m_queue_region(move(queue_region))
 {
-    size_t size_of_descriptors = sizeof(QueueDescriptor) * queue_size;
-    size_t size_of_driver = sizeof(QueueDriver) + queue_size * sizeof(u16);
-    // TODO: ensure alignment!!!
     u8* ptr = m_queue_region->vaddr().as_ptr();
     memset(ptr, 0, m_queue_region->size());
     m_descriptors = reinterpret_cast<QueueDescriptor*>(ptr);
-    m_driver = reinterpret_cast<QueueDriver*>(ptr + size_of_descriptors);
-    m_device = reinterpret_cast<QueueDevice*>(ptr + size_of_descriptors + size_of_driver);
+    m_driver = reinterpret_cast<QueueDriver*>(ptr + size_of_descriptors(queue_size));
+    m_device = reinterpret_cast<QueueDevice*>(ptr + device_area_offset(queue_size));
 
     for (auto i = 0; i + 1 < queue_size; i++)
         m_descriptors[i].next = i + 1; // link all the descriptors in a line
@@ -50,6 +44,10 @@ void Queue::enable_interrupts()
 {
     SpinlockLocker lock(m_lock);
     m_driver->flags = 0;
+    // Ask for an interrupt as soon as the device uses the next buffer.
+    if (m_uses_event_index)
+        used_event() = m_used_tail;
+    full_memory_barrier();
 }
 
 void Queue::disable_interrupts()
@@ -129,9 +127,18 @@ Optional<u16> Queue::take_free_slot()
     return {};
 }
 
-bool Queue::should_notify() const
+bool Queue::should_notify()
 {
     VERIFY(m_lock.is_locked());
+    if (m_uses_event_index) {
+        // Only notify the device if it asked to be notified about one of the buffers that were made available
+        // since we last checked. Otherwise it's still busy working through the queue, and will see them anyway.
+        full_memory_barrier();
+        u16 new_index = m_driver_index_shadow;
+        u16 old_index = exchange(m_driver_index_at_last_notification, new_index);
+        u16 event_index = available_event();
+        return static_cast<u16>(new_index - event_index - 1) < static_cast<u16>(new_index - old_index);
+    }
     auto device_flags = m_device->flags;
     return !(device_flags & VIRTQ_USED_F_NO_NOTIFY);
 }
@@ -171,6 +178,28 @@ bool QueueChain::add_buffer_to_chain(PhysicalAddress buffer_start, size_t buffer
     return true;
 }
 
+bool QueueChain::add_indirect_table_to_chain(PhysicalAddress table_start, size_t descriptor_count)
+{
+    VERIFY(m_queue.lock().is_locked());
+    // The driver must not chain an indirect descriptor to any other descriptor.
+    VERIFY(is_empty());
+    VERIFY(descriptor_count > 0);
+
+    auto descriptor_index = m_queue.take_free_slot();
+    if (!descriptor_index.has_value())
+        return false;
+
+    m_start_of_chain_index = descriptor_index.value();
+    m_end_of_chain_index = descriptor_index.value();
+    m_chain_length = 1;
+
+    m_queue.m_descriptors[descriptor_index.value()].address = static_cast<u64>(table_start.get());
+    m_queue.m_descriptors[descriptor_index.value()].flags = VIRTQ_DESC_F_INDIRECT;
+    m_queue.m_descriptors[descriptor_index.value()].length = static_cast<u32>(descriptor_count * sizeof(Queue::QueueDescriptor));
+
+    return true;
+}
+
 void QueueChain::submit_to_queue()
 {
     VERIFY(m_queue.lock().is_locked());
@@ -28,6 +28,13 @@ enum class BufferType {
 
 class Queue {
 public:
+    struct [[gnu::packed]] QueueDescriptor {
+        u64 address;
+        u32 length;
+        u16 flags;
+        u16 next;
+    };
+
     static ErrorOr<NonnullOwnPtr<Queue>> try_create(u16 queue_size, u16 notify_offset);
 
     ~Queue();
@@ -37,6 +44,10 @@ public:
     void enable_interrupts();
     void disable_interrupts();
 
+    // With event indices, the driver and the device tell each other how far the other side has to get
+    // before they want to be notified, instead of turning notifications on and off.
+    void enable_event_index() { m_uses_event_index = true; }
+
     PhysicalAddress descriptor_area() const { return to_physical(m_descriptors); }
     PhysicalAddress driver_area() const { return to_physical(m_driver); }
     PhysicalAddress device_area() const { return to_physical(m_device); }
@@ -49,7 +60,7 @@ public:
 
     Spinlock<LockRank::None>& lock() { return m_lock; }
 
-    bool should_notify() const;
+    bool should_notify();
 
     u16 size() const { return m_queue_size; }
 
@@ -58,18 +69,21 @@ private:
 
     void reclaim_buffer_chain(u16 chain_start_index, u16 chain_end_index, size_t length_of_chain);
 
+    static size_t size_of_descriptors(u16 queue_size) { return sizeof(QueueDescriptor) * queue_size; }
+    // NOTE: The driver area ends with the used event index, and the device area with the available event index.
+    static size_t size_of_driver(u16 queue_size) { return sizeof(QueueDriver) + (queue_size + 1) * sizeof(u16); }
+    static size_t size_of_device(u16 queue_size) { return sizeof(QueueDevice) + queue_size * sizeof(QueueDeviceItem) + sizeof(u16); }
+    // The device area has to be 4-byte aligned.
+    static size_t device_area_offset(u16 queue_size) { return align_up_to(size_of_descriptors(queue_size) + size_of_driver(queue_size), 4); }
+
+    u16 volatile& used_event() { return *reinterpret_cast<u16 volatile*>(&m_driver->rings[m_queue_size]); }
+    u16 volatile& available_event() const { return *reinterpret_cast<u16 volatile*>(&m_device->rings[m_queue_size]); }
+
     PhysicalAddress to_physical(void const* ptr) const
     {
         auto offset = FlatPtr(ptr) - m_queue_region->vaddr().get();
         return m_queue_region->physical_page(0)->paddr().offset(offset);
     }
-    struct [[gnu::packed]] QueueDescriptor {
-        u64 address;
-        u32 length;
-        u16 flags;
-        u16 next;
-    };
-
     struct [[gnu::packed]] QueueDriver {
         u16 flags;
         u16 index;
@@ -93,6 +107,8 @@ private:
     u16 m_free_head { 0 };
     u16 m_used_tail { 0 };
     u16 m_driver_index_shadow { 0 };
+    u16 m_driver_index_at_last_notification { 0 };
+    bool m_uses_event_index { false };
 
     QueueDescriptor* m_descriptors { nullptr };
     QueueDriver* m_driver { nullptr };
@@ -155,6 +171,9 @@ public:
     [[nodiscard]] bool is_empty() const { return m_chain_length == 0; }
     [[nodiscard]] size_t length() const { return m_chain_length; }
     bool add_buffer_to_chain(PhysicalAddress buffer_start, size_t buffer_length, BufferType buffer_type);
+    // Lets a single descriptor in the queue point to a whole table of descriptors (which has to stay put until
+    // the device is done with it). This only works if VIRTIO_F_INDIRECT_DESC was negotiated.
+    bool add_indirect_table_to_chain(PhysicalAddress table_start, size_t descriptor_count);
     void submit_to_queue();
     void release_buffer_slots_to_queue();
 
@@ -41,6 +41,8 @@ AsyncDeviceRequest::~AsyncDeviceRequest()
 
 void AsyncDeviceRequest::request_finished()
 {
+    will_finish();
+
     if (m_parent_request)
         m_parent_request->sub_request_finished(*this);
 
@@ -57,6 +59,9 @@ auto AsyncDeviceRequest::wait(Duration* timeout) -> RequestWaitResult
     auto request_result = get_request_result();
     if (is_completed_result(request_result))
         return { request_result, Thread::BlockResult::NotBlocked };
+    // Make sure we aren't waiting on a request that's being held back in the queue.
+    if (request_result == Pending)
+        m_device.flush_queued_requests();
     auto wait_result = m_queue.wait_on(Thread::BlockTimeout(false, timeout), name());
     return { get_request_result(), wait_result };
 }
@@ -74,11 +79,10 @@ void AsyncDeviceRequest::add_sub_request(NonnullLockRefPtr<AsyncDeviceRequest> s
     VERIFY(sub_request->m_parent_request == nullptr);
     sub_request->m_parent_request = this;
 
+    // NOTE: The sub-request sits in the queue of its own device, which starts it when it gets to it.
     SpinlockLocker lock(m_lock);
     VERIFY(!is_completed_result(m_result));
     m_sub_requests_pending.append(sub_request);
-    if (m_result == Started)
-        sub_request->do_start(move(lock));
 }
 
 void AsyncDeviceRequest::sub_request_finished(AsyncDeviceRequest& sub_request)
@@ -126,6 +130,13 @@ void AsyncDeviceRequest::sub_request_finished(AsyncDeviceRequest& sub_request)
         request_finished();
 }
 
+void AsyncDeviceRequest::mark_as_started_by_other_request()
+{
+    SpinlockLocker lock(m_lock);
+    VERIFY(m_result == Pending);
+    m_result = Started;
+}
+
 void AsyncDeviceRequest::complete(RequestResult result)
 {
     VERIFY(result == Success || result == Failure || result == MemoryFault);
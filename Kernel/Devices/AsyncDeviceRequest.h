@@ -74,6 +74,9 @@ public:
 
     void complete(RequestResult result);
 
+    IntrusiveListNode<AsyncDeviceRequest, LockRefPtr<AsyncDeviceRequest>> m_in_flight_list_node;
+    using InFlightList = IntrusiveList<&AsyncDeviceRequest::m_in_flight_list_node>;
+
     void set_private(void* priv)
     {
         VERIFY(!m_private || !priv);
@@ -134,6 +137,12 @@ protected:
 
     RequestResult get_request_result() const;
 
+    // A request that was merged into another one is started along with it, and completed by it.
+    void mark_as_started_by_other_request();
+
+    // Called once the request has completed, right before anyone waiting on it is woken up.
+    virtual void will_finish() { }
+
 private:
     void sub_request_finished(AsyncDeviceRequest&);
     void request_finished();
@@ -4,11 +4,17 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <Kernel/Debug.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/DeviceIdentifiers/BlockDevicesDirectory.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
+// Reads usually have someone waiting on them, while writes are mostly written back in the background.
+static constexpr Duration read_deadline = Duration::from_milliseconds(500);
+static constexpr Duration write_deadline = Duration::from_seconds(5);
+
 AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestType request_type, u64 block_index, u32 block_count, UserOrKernelBuffer const& buffer, size_t buffer_size)
     : AsyncDeviceRequest(block_device)
     , m_block_device(static_cast<BlockDevice&>(block_device))
@@ -17,14 +23,83 @@ AsyncBlockDeviceRequest::AsyncBlockDeviceRequest(Device& block_device, RequestTy
     , m_block_count(block_count)
     , m_buffer(buffer)
     , m_buffer_size(buffer_size)
+    , m_deadline(TimeManagement::the().monotonic_time() + (request_type == Read ? read_deadline : write_deadline))
+    , m_own_block_index(block_index)
+    , m_own_block_count(block_count)
+    , m_own_buffer(buffer)
+{
+}
+
+bool AsyncBlockDeviceRequest::can_be_merged() const
 {
+    if (is_merged() || m_block_count == 0)
+        return false;
+    return m_buffer.is_kernel_buffer() && m_buffer_size == m_block_count * block_size();
+}
+
+void AsyncBlockDeviceRequest::merge(Badge<BlockDevice>, MergedRequests&& requests, ByteBuffer&& merge_buffer, u64 block_index, u32 block_count)
+{
+    VERIFY(!is_merged());
+    VERIFY(!requests.is_empty());
+    VERIFY(merge_buffer.size() == block_count * block_size());
+    VERIFY(block_index <= m_own_block_index && m_own_block_index + m_own_block_count <= block_index + block_count);
+
+    for (auto& request : requests)
+        request->mark_as_started_by_other_request();
+
+    m_merged_requests = move(requests);
+    m_merge_buffer = move(merge_buffer);
+    m_block_index = block_index;
+    m_block_count = block_count;
+    m_buffer = UserOrKernelBuffer::for_kernel_buffer(m_merge_buffer.data());
+    m_buffer_size = m_merge_buffer.size();
+}
+
+template<typename Callback>
+ErrorOr<void> AsyncBlockDeviceRequest::for_each_merged_part(Callback callback)
+{
+    auto offset_in_merge_buffer = [&](u64 block_index) {
+        return m_merge_buffer.data() + (block_index - m_block_index) * block_size();
+    };
+    TRY(callback(m_own_buffer, offset_in_merge_buffer(m_own_block_index), m_own_block_count * block_size()));
+    for (auto& request : m_merged_requests)
+        TRY(callback(request->m_own_buffer, offset_in_merge_buffer(request->m_own_block_index), request->m_own_block_count * block_size()));
+    return {};
 }
 
 void AsyncBlockDeviceRequest::start()
 {
+    if (is_merged() && m_request_type == Write) {
+        auto result = for_each_merged_part([](UserOrKernelBuffer const& buffer, u8* merged_data, size_t size) {
+            return buffer.read(merged_data, size);
+        });
+        if (result.is_error()) {
+            complete(MemoryFault);
+            return;
+        }
+    }
     m_block_device.start_request(*this);
 }
 
+void AsyncBlockDeviceRequest::will_finish()
+{
+    if (!is_merged())
+        return;
+
+    auto result = get_request_result();
+    if (result == Success && m_request_type == Read) {
+        auto copy_result = for_each_merged_part([](UserOrKernelBuffer& buffer, u8 const* merged_data, size_t size) {
+            return buffer.write(merged_data, size);
+        });
+        if (copy_result.is_error())
+            result = MemoryFault;
+    }
+
+    // Everyone who got merged into us shares our fate.
+    for (auto& request : m_merged_requests)
+        request->complete(result);
+}
+
 BlockDevice::~BlockDevice() = default;
 
 void BlockDevice::after_inserting_add_symlink_to_device_identifier_directory()
@@ -61,6 +136,151 @@ void BlockDevice::before_will_be_destroyed_remove_from_device_identifier_directo
     });
 }
 
+void BlockDevice::plug()
+{
+    m_plug_count.fetch_add(1);
+    m_request_queue_statistics.with([](auto& statistics) { ++statistics.plugs; });
+}
+
+void BlockDevice::unplug()
+{
+    auto previous_plug_count = m_plug_count.fetch_sub(1);
+    VERIFY(previous_plug_count > 0);
+    if (previous_plug_count == 1)
+        flush_queued_requests();
+}
+
+auto BlockDevice::request_queue_statistics() const -> RequestQueueStatistics
+{
+    return m_request_queue_statistics.with([](auto& statistics) { return statistics; });
+}
+
+void BlockDevice::did_queue_request(AsyncDeviceRequest&)
+{
+    m_request_queue_statistics.with([](auto& statistics) {
+        ++statistics.queued_requests;
+        ++statistics.queue_depth;
+        statistics.max_queue_depth = max(statistics.max_queue_depth, statistics.queue_depth);
+    });
+}
+
+AsyncBlockDeviceRequest& BlockDevice::pick_next_queued_request(RequestQueue& queue)
+{
+    auto& first_request = static_cast<AsyncBlockDeviceRequest&>(*queue.first());
+    if (!is_rotational())
+        return first_request;
+
+    // Deadline scheduling: sweep across the disk in one direction, picking up requests in the order
+    // of their position so that the heads don't have to go back and forth, and start over at the lowest
+    // block when we reach the end. A request that has been waiting past its deadline goes first though.
+    auto now = TimeManagement::the().monotonic_time();
+    AsyncBlockDeviceRequest* expired_request = nullptr;
+    AsyncBlockDeviceRequest* next_in_sweep = nullptr;
+    AsyncBlockDeviceRequest* lowest_request = nullptr;
+    for (auto& queued_request : queue) {
+        auto& request = static_cast<AsyncBlockDeviceRequest&>(*queued_request);
+        if (request.deadline() <= now && (!expired_request || request.deadline() < expired_request->deadline()))
+            expired_request = &request;
+        if (request.block_index() >= m_next_block_index && (!next_in_sweep || request.block_index() < next_in_sweep->block_index()))
+            next_in_sweep = &request;
+        if (!lowest_request || request.block_index() < lowest_request->block_index())
+            lowest_request = &request;
+    }
+
+    if (expired_request) {
+        m_request_queue_statistics.with([](auto& statistics) { ++statistics.expired_deadlines; });
+        return *expired_request;
+    }
+    if (next_in_sweep)
+        return *next_in_sweep;
+    return *lowest_request;
+}
+
+static LockRefPtr<AsyncDeviceRequest> take_from_queue(Device::RequestQueue& queue, AsyncDeviceRequest& request)
+{
+    for (auto it = queue.begin(); it != queue.end(); ++it) {
+        if ((*it).ptr() != &request)
+            continue;
+        auto queued_request = *it;
+        queue.remove(it);
+        return queued_request;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void BlockDevice::merge_neighbours_into(AsyncBlockDeviceRequest& request, RequestQueue& queue)
+{
+    if (!request.can_be_merged())
+        return;
+
+    // First find everything that lines up with the request on either side, without taking anything out
+    // of the queue yet, as we might not be able to allocate the bounce buffer for the merged request.
+    u64 first_block_index = request.block_index();
+    u64 end_block_index = request.end_block_index();
+    Vector<AsyncBlockDeviceRequest*, AsyncBlockDeviceRequest::max_merged_requests> neighbours;
+    size_t front_merges = 0;
+    size_t back_merges = 0;
+    for (bool found_neighbour = true; found_neighbour && neighbours.size() < AsyncBlockDeviceRequest::max_merged_requests;) {
+        found_neighbour = false;
+        for (auto& queued_request : queue) {
+            auto& candidate = static_cast<AsyncBlockDeviceRequest&>(*queued_request);
+            if (candidate.request_type() != request.request_type() || !candidate.can_be_merged())
+                continue;
+            if (end_block_index - first_block_index + candidate.block_count() > max_blocks_per_request())
+                continue;
+            if (candidate.block_index() == end_block_index) {
+                end_block_index = candidate.end_block_index();
+                ++back_merges;
+            } else if (candidate.end_block_index() == first_block_index) {
+                first_block_index = candidate.block_index();
+                ++front_merges;
+            } else {
+                continue;
+            }
+            neighbours.unchecked_append(&candidate);
+            found_neighbour = true;
+            break;
+        }
+    }
+    if (neighbours.is_empty())
+        return;
+
+    auto block_count = static_cast<u32>(end_block_index - first_block_index);
+    auto merge_buffer_or_error = ByteBuffer::create_uninitialized(block_count * block_size());
+    if (merge_buffer_or_error.is_error()) {
+        dbgln_if(BLOCK_DEVICE_QUEUE_DEBUG, "BlockDevice: Couldn't allocate a buffer for merging {} requests, dispatching them one by one", neighbours.size() + 1);
+        return;
+    }
+
+    AsyncBlockDeviceRequest::MergedRequests merged_requests;
+    for (auto* neighbour : neighbours) {
+        merged_requests.unchecked_append(NonnullLockRefPtr<AsyncBlockDeviceRequest>(*neighbour));
+        (void)take_from_queue(queue, *neighbour);
+    }
+    dbgln_if(BLOCK_DEVICE_QUEUE_DEBUG, "BlockDevice: Merged {} requests into blocks {}-{}", merged_requests.size() + 1, first_block_index, end_block_index - 1);
+    request.merge({}, move(merged_requests), merge_buffer_or_error.release_value(), first_block_index, block_count);
+
+    m_request_queue_statistics.with([&](auto& statistics) {
+        statistics.front_merges += front_merges;
+        statistics.back_merges += back_merges;
+    });
+}
+
+LockRefPtr<AsyncDeviceRequest> BlockDevice::take_next_queued_request(RequestQueue& queue)
+{
+    auto& next_request = pick_next_queued_request(queue);
+    auto request = take_from_queue(queue, next_request);
+    merge_neighbours_into(next_request, queue);
+    m_next_block_index = next_request.end_block_index();
+
+    m_request_queue_statistics.with([&](auto& statistics) {
+        ++statistics.dispatched_requests;
+        auto taken_requests = static_cast<u32>(1 + next_request.merged_request_count());
+        statistics.queue_depth -= min(statistics.queue_depth, taken_requests);
+    });
+    return request;
+}
+
 bool BlockDevice::read_block(u64 index, UserOrKernelBuffer& buffer)
 {
     auto read_request_or_error = try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Read, index, 1, buffer, m_block_size);
@@ -6,9 +6,14 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
+#include <AK/ByteBuffer.h>
 #include <AK/IntegralMath.h>
+#include <AK/Time.h>
+#include <AK/Vector.h>
 #include <Kernel/Devices/Device.h>
 #include <Kernel/Library/LockWeakable.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 
 namespace Kernel {
 
@@ -27,6 +32,32 @@ public:
 
     virtual void start_request(AsyncBlockDeviceRequest&) = 0;
 
+    // Spinning disks get their requests sorted by position (see take_next_queued_request()).
+    virtual bool is_rotational() const { return false; }
+
+    // How many blocks the driver can transfer with a single request. Contiguous requests
+    // are only merged as long as they stay within this limit.
+    virtual u32 max_blocks_per_request() const { return max<u32>(PAGE_SIZE >> m_block_size_log, 1); }
+
+    // While a device is plugged, new requests are staged in its queue instead of being started,
+    // so that a whole batch of them can be merged and ordered before the driver sees any of them.
+    // Waiting on a request that's still queued starts it anyway if the device is idle.
+    // Devices that forward their requests to another device plug that one instead.
+    virtual void plug();
+    virtual void unplug();
+
+    struct RequestQueueStatistics {
+        u64 queued_requests { 0 };
+        u64 dispatched_requests { 0 };
+        u64 front_merges { 0 };
+        u64 back_merges { 0 };
+        u64 expired_deadlines { 0 };
+        u64 plugs { 0 };
+        u32 queue_depth { 0 };
+        u32 max_queue_depth { 0 };
+    };
+    RequestQueueStatistics request_queue_statistics() const;
+
 protected:
     BlockDevice(MajorNumber major, MinorNumber minor, size_t block_size = PAGE_SIZE)
         : Device(major, minor)
@@ -44,13 +75,26 @@ protected:
     virtual void after_inserting_add_symlink_to_device_identifier_directory() override final;
     virtual void before_will_be_destroyed_remove_symlink_from_device_identifier_directory() override final;
 
+    // ^Device
+    virtual bool is_holding_queued_requests() const override { return m_plug_count.load() > 0; }
+    virtual void did_queue_request(AsyncDeviceRequest&) override;
+    virtual LockRefPtr<AsyncDeviceRequest> take_next_queued_request(RequestQueue&) override;
+
 private:
+    AsyncBlockDeviceRequest& pick_next_queued_request(RequestQueue&);
+    void merge_neighbours_into(AsyncBlockDeviceRequest&, RequestQueue&);
+
     // FIXME: These methods will be eventually removed after all nodes in /sys/dev/block/ are symlinks
     virtual void after_inserting_add_to_device_identifier_directory() override final;
     virtual void before_will_be_destroyed_remove_from_device_identifier_directory() override final;
 
     size_t m_block_size { 0 };
     u8 m_block_size_log { 0 };
+
+    Atomic<u32> m_plug_count { 0 };
+    // Where the last dispatched request ended, so that the next one can continue from there.
+    u64 m_next_block_index { 0 };
+    SpinlockProtected<RequestQueueStatistics, LockRank::None> m_request_queue_statistics {};
 };
 
 class AsyncBlockDeviceRequest final : public AsyncDeviceRequest {
@@ -62,6 +106,8 @@ public:
     AsyncBlockDeviceRequest(Device& block_device, RequestType request_type,
         u64 block_index, u32 block_count, UserOrKernelBuffer const& buffer, size_t buffer_size);
 
+    // NOTE: Once neighbouring requests have been merged into this one, these describe the whole
+    //       merged range, and the buffer is a bounce buffer holding the data of all of them.
     RequestType request_type() const { return m_request_type; }
     u64 block_index() const { return m_block_index; }
     u32 block_count() const { return m_block_count; }
@@ -70,6 +116,19 @@ public:
     UserOrKernelBuffer const& buffer() const { return m_buffer; }
     size_t buffer_size() const { return m_buffer_size; }
 
+    u64 end_block_index() const { return m_block_index + m_block_count; }
+    MonotonicTime deadline() const { return m_deadline; }
+
+    // Only requests into kernel buffers are merged, as the merged data is copied
+    // around when the request completes, which may be in any process' context.
+    bool can_be_merged() const;
+    bool is_merged() const { return !m_merged_requests.is_empty(); }
+    size_t merged_request_count() const { return m_merged_requests.size(); }
+
+    static constexpr size_t max_merged_requests = 16;
+    using MergedRequests = Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>, max_merged_requests>;
+    void merge(Badge<BlockDevice>, MergedRequests&&, ByteBuffer&& merge_buffer, u64 block_index, u32 block_count);
+
     virtual void start() override;
     virtual StringView name() const override
     {
@@ -83,13 +142,28 @@ public:
         }
     }
 
+protected:
+    virtual void will_finish() override;
+
 private:
+    template<typename Callback>
+    ErrorOr<void> for_each_merged_part(Callback);
+
     BlockDevice& m_block_device;
     const RequestType m_request_type;
-    const u64 m_block_index;
-    const u32 m_block_count;
+    u64 m_block_index { 0 };
+    u32 m_block_count { 0 };
     UserOrKernelBuffer m_buffer;
-    const size_t m_buffer_size;
+    size_t m_buffer_size { 0 };
+    MonotonicTime const m_deadline;
+
+    // What this request asked for itself, before anything was merged into it.
+    const u64 m_own_block_index;
+    const u32 m_own_block_count;
+    UserOrKernelBuffer m_own_buffer;
+
+    MergedRequests m_merged_requests;
+    ByteBuffer m_merge_buffer;
 };
 
 }
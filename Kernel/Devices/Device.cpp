@@ -72,15 +72,50 @@ ErrorOr<NonnullRefPtr<OpenFileDescription>> Device::open(int options)
 void Device::process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const& completed_request)
 {
     SpinlockLocker lock(m_requests_lock);
-    VERIFY(!m_requests.is_empty());
-    VERIFY(m_requests.first().ptr() == &completed_request);
-    m_requests.remove(m_requests.begin());
-    if (!m_requests.is_empty()) {
-        auto* next_request = m_requests.first().ptr();
-        next_request->do_start(move(lock));
+    // NOTE: Requests that were started without going through the queue (or that were carried
+    //       along by another request) don't make room for the next one.
+    auto& request = const_cast<AsyncDeviceRequest&>(completed_request);
+    if (m_requests_in_flight.contains(request)) {
+        m_requests_in_flight.remove(request);
+        --m_requests_in_flight_count;
+        if (!is_holding_queued_requests())
+            start_queued_requests(move(lock));
     }
 
     evaluate_block_conditions();
 }
 
+void Device::flush_queued_requests()
+{
+    SpinlockLocker lock(m_requests_lock);
+    start_queued_requests(move(lock));
+}
+
+void Device::start_queued_requests(SpinlockLocker<Spinlock<LockRank::None>>&& lock)
+{
+    VERIFY(m_requests_lock.is_locked());
+    while (!m_requests.is_empty() && m_requests_in_flight_count < max_requests_in_flight()) {
+        auto next_request = take_next_queued_request(m_requests);
+        VERIFY(next_request);
+        m_requests_in_flight.append(*next_request);
+        ++m_requests_in_flight_count;
+        next_request->do_start(move(lock));
+        if (lock.have_lock()) {
+            // The request had already been completed, so it never got started.
+            m_requests_in_flight.remove(*next_request);
+            --m_requests_in_flight_count;
+            continue;
+        }
+        // Starting the request dropped the lock, so take it again before looking for more.
+        lock.lock();
+    }
+}
+
+LockRefPtr<AsyncDeviceRequest> Device::take_next_queued_request(RequestQueue& queue)
+{
+    auto request = queue.first();
+    queue.remove(queue.begin());
+    return request;
+}
+
 }
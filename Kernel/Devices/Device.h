@@ -51,18 +51,28 @@ public:
     virtual bool is_openable_by_jailed_processes() const { return false; }
     void process_next_queued_request(Badge<AsyncDeviceRequest>, AsyncDeviceRequest const&);
 
+    using RequestQueue = DoublyLinkedList<LockRefPtr<AsyncDeviceRequest>>;
+
     template<typename AsyncRequestType, typename... Args>
     ErrorOr<NonnullLockRefPtr<AsyncRequestType>> try_make_request(Args&&... args)
     {
         auto request = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) AsyncRequestType(*this, forward<Args>(args)...)));
         SpinlockLocker lock(m_requests_lock);
-        bool was_empty = m_requests.is_empty();
-        TRY(m_requests.try_append(request));
-        if (was_empty)
+        if (forwards_requests()) {
+            // The device we forward to does the queueing, so there's no point in waiting here.
             request->do_start(move(lock));
+            return request;
+        }
+        TRY(m_requests.try_append(request));
+        did_queue_request(*request);
+        if (!is_holding_queued_requests())
+            start_queued_requests(move(lock));
         return request;
     }
 
+    // Starts queued requests if the device has room for them, even if requests are being held back.
+    void flush_queued_requests();
+
 protected:
     Device(MajorNumber major, MinorNumber minor);
 
@@ -77,6 +87,19 @@ protected:
     virtual void after_inserting_add_to_device_identifier_directory() = 0;
     virtual void before_will_be_destroyed_remove_from_device_identifier_directory() = 0;
 
+    // Devices that pass their requests on to another device (like disk partitions) start them right away.
+    virtual bool forwards_requests() const { return false; }
+
+    // Requests are started one at a time, unless the device can work on several at once. Subclasses can
+    // decide which of the queued requests goes next, and hold requests back for a while so that there's
+    // more to choose from.
+    virtual size_t max_requests_in_flight() const { return 1; }
+    virtual bool is_holding_queued_requests() const { return false; }
+    virtual void did_queue_request(AsyncDeviceRequest&) { }
+    virtual LockRefPtr<AsyncDeviceRequest> take_next_queued_request(RequestQueue&);
+
+    void start_queued_requests(SpinlockLocker<Spinlock<LockRank::None>>&&);
+
 private:
     MajorNumber const m_major { 0 };
     MinorNumber const m_minor { 0 };
@@ -84,7 +107,9 @@ private:
     State m_state { State::Normal };
 
     Spinlock<LockRank::None> m_requests_lock {};
-    DoublyLinkedList<LockRefPtr<AsyncDeviceRequest>> m_requests;
+    RequestQueue m_requests;
+    AsyncDeviceRequest::InFlightList m_requests_in_flight;
+    size_t m_requests_in_flight_count { 0 };
 
 protected:
     // FIXME: This pointer will be eventually removed after all nodes in /sys/dev/block/ and
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/API/Ioctl.h>
+#include <Kernel/Devices/DeviceManagement.h>
+#include <Kernel/Devices/Generic/ProfileDevice.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/PerformanceEventBuffer.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT NonnullLockRefPtr<ProfileDevice> ProfileDevice::must_create()
+{
+    auto profile_device_or_error = DeviceManagement::try_create_device<ProfileDevice>();
+    // FIXME: Find a way to propagate errors
+    VERIFY(!profile_device_or_error.is_error());
+    return profile_device_or_error.release_value();
+}
+
+UNMAP_AFTER_INIT ProfileDevice::ProfileDevice()
+    : CharacterDevice(31, 0)
+{
+}
+
+ProfileDevice::~ProfileDevice() = default;
+
+ErrorOr<void> ProfileDevice::ioctl(OpenFileDescription&, unsigned request, Userspace<void*> arg)
+{
+    if (!Process::current().credentials()->is_superuser())
+        return EPERM;
+
+    switch (request) {
+    case PROFILE_IOCTL_SET_RING_SIZE: {
+        auto event_buffer = TRY(PerformanceEventBuffer::try_create_with_per_processor_rings(static_cast<size_t>(arg.ptr())));
+
+        // Whatever buffer we replace gets freed once we've let go of the lock.
+        OwnPtr<PerformanceEventBuffer> previous_event_buffer;
+        SpinlockLocker lock(g_profiling_lock);
+        if (g_profiling_all_threads)
+            return EBUSY;
+        previous_event_buffer = adopt_own_if_nonnull(g_global_perf_events);
+        g_global_perf_events = event_buffer.leak_ptr();
+        return {};
+    }
+    case PROFILE_IOCTL_GET_BUFFER_SIZE: {
+        size_t size = 0;
+        {
+            SpinlockLocker lock(g_profiling_lock);
+            if (!g_global_perf_events || !g_global_perf_events->is_streaming())
+                return ENOBUFS;
+            size = g_global_perf_events->size();
+        }
+        return copy_to_user(static_ptr_cast<size_t*>(arg), &size);
+    }
+    default:
+        return EINVAL;
+    }
+}
+
+ErrorOr<NonnullLockRefPtr<Memory::VMObject>> ProfileDevice::vmobject_for_mmap(Process& process, Memory::VirtualRange const&, u64&, bool shared)
+{
+    if (!process.credentials()->is_superuser())
+        return EPERM;
+    // The consumer has to be able to tell us how far along it is.
+    if (!shared)
+        return EINVAL;
+
+    SpinlockLocker lock(g_profiling_lock);
+    if (!g_global_perf_events || !g_global_perf_events->is_streaming())
+        return ENOBUFS;
+    return g_global_perf_events->vmobject();
+}
+
+}
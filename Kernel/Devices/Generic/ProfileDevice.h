@@ -0,0 +1,36 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/Devices/CharacterDevice.h>
+
+namespace Kernel {
+
+// /dev/profile lets a (super-user) consumer stream the events of whole-system profiling
+// through per-processor rings, instead of reading them from /sys/kernel/profile once
+// profiling has stopped. See PerformanceEventRingHeader for how the rings work.
+class ProfileDevice final : public CharacterDevice {
+    friend class DeviceManagement;
+
+public:
+    static NonnullLockRefPtr<ProfileDevice> must_create();
+    virtual ~ProfileDevice() override;
+
+    virtual ErrorOr<NonnullLockRefPtr<Memory::VMObject>> vmobject_for_mmap(Process&, Memory::VirtualRange const&, u64& offset, bool shared) override;
+
+private:
+    ProfileDevice();
+
+    virtual StringView class_name() const override { return "ProfileDevice"sv; }
+    virtual bool can_read(OpenFileDescription const&, u64) const override { return true; }
+    virtual bool can_write(OpenFileDescription const&, u64) const override { return false; }
+    virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override { return EINVAL; }
+    virtual ErrorOr<size_t> write(OpenFileDescription&, u64, UserOrKernelBuffer const&, size_t) override { return EINVAL; }
+    virtual ErrorOr<void> ioctl(OpenFileDescription&, unsigned request, Userspace<void*> arg) override;
+};
+
+}
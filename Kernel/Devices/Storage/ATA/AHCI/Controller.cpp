@@ -93,6 +93,20 @@ void AHCIController::start_request(ATADevice const& device, AsyncBlockDeviceRequ
     port->start_request(request);
 }
 
+size_t AHCIController::max_requests_in_flight(ATADevice const& device) const
+{
+    auto port = m_ports[device.ata_address().port];
+    VERIFY(port);
+    return port->command_queue_depth();
+}
+
+Optional<u32> AHCIController::max_blocks_per_request(ATADevice const& device) const
+{
+    auto port = m_ports[device.ata_address().port];
+    VERIFY(port);
+    return port->max_blocks_per_command();
+}
+
 void AHCIController::complete_current_request(AsyncDeviceRequest::RequestResult)
 {
     VERIFY_NOT_REACHED();
@@ -35,6 +35,8 @@ public:
     virtual ErrorOr<void> shutdown() override;
     virtual size_t devices_count() const override;
     virtual void start_request(ATADevice const&, AsyncBlockDeviceRequest&) override;
+    virtual size_t max_requests_in_flight(ATADevice const&) const override;
+    virtual Optional<u32> max_blocks_per_request(ATADevice const&) const override;
     virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
 
     void handle_interrupt_for_port(Badge<AHCIInterruptHandler>, u32 port_index) const;
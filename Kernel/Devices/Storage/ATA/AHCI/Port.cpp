@@ -15,7 +15,6 @@
 #include <Kernel/Devices/Storage/StorageManagement.h>
 #include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Memory/MemoryManager.h>
-#include <Kernel/Memory/ScatterGatherList.h>
 #include <Kernel/Memory/TypedMapping.h>
 #include <Kernel/Tasks/WorkQueue.h>
 
@@ -38,14 +37,9 @@ ErrorOr<void> AHCIPort::allocate_resources_and_initialize_ports()
 
     m_fis_receive_page = TRY(MM.allocate_physical_page());
 
-    for (size_t index = 0; index < 1; index++) {
-        auto dma_page = TRY(MM.allocate_physical_page());
-        m_dma_buffers.append(move(dma_page));
-    }
-    for (size_t index = 0; index < 1; index++) {
-        auto command_table_page = TRY(MM.allocate_physical_page());
-        m_command_table_pages.append(move(command_table_page));
-    }
+    // NOTE: The rest of the command slots are only set up once we know that there's a device
+    //       that can queue commands attached to this port.
+    TRY(allocate_command_slots(1));
 
     m_command_list_region = TRY(MM.allocate_dma_buffer_page("AHCI Port Command List"sv, Memory::Region::Access::ReadWrite, m_command_list_page));
 
@@ -55,8 +49,21 @@ ErrorOr<void> AHCIPort::allocate_resources_and_initialize_ports()
     return {};
 }
 
+ErrorOr<void> AHCIPort::allocate_command_slots(size_t count)
+{
+    VERIFY(count <= m_command_slots.size());
+    for (size_t index = request_slot_count(); index < count; index++) {
+        auto& slot = m_command_slots[index];
+        if (!slot.command_table_region)
+            slot.command_table_region = TRY(MM.allocate_dma_buffer_page("AHCI Command Table"sv, Memory::Region::Access::ReadWrite, slot.command_table_page));
+        TRY(allocate_request_slots(index + 1, "AHCI DMA Buffer"sv));
+    }
+    return {};
+}
+
 UNMAP_AFTER_INIT AHCIPort::AHCIPort(AHCIController const& controller, NonnullRefPtr<Memory::PhysicalPage> identify_buffer_page, AHCI::HBADefinedCapabilities hba_capabilities, volatile AHCI::PortRegisters& registers, u32 port_index)
-    : m_port_index(port_index)
+    : BlockRequestSlots(dma_pages_per_command)
+    , m_port_index(port_index)
     , m_hba_capabilities(hba_capabilities)
     , m_identify_buffer_page(move(identify_buffer_page))
     , m_port_registers(registers)
@@ -84,22 +91,17 @@ void AHCIPort::handle_interrupt()
             m_connected_device->prepare_for_unplug();
             StorageManagement::the().remove_device(*m_connected_device);
             auto work_item_creation_result = g_io_work->try_queue([this]() {
+                fail_outstanding_requests();
                 m_connected_device.clear();
             });
-            if (work_item_creation_result.is_error()) {
-                auto current_request = m_current_request;
-                m_current_request.clear();
-                current_request->complete(AsyncDeviceRequest::OutOfMemory);
-            }
+            if (work_item_creation_result.is_error())
+                fail_outstanding_requests();
         } else {
             auto work_item_creation_result = g_io_work->try_queue([this]() {
-                reset();
+                reset_after_error();
             });
-            if (work_item_creation_result.is_error()) {
-                auto current_request = m_current_request;
-                m_current_request.clear();
-                current_request->complete(AsyncDeviceRequest::OutOfMemory);
-            }
+            if (work_item_creation_result.is_error())
+                fail_outstanding_requests();
         }
         return;
     }
@@ -110,66 +112,33 @@ void AHCIPort::handle_interrupt()
         // We need to defer the reset, because we can receive interrupts when
         // resetting the device.
         auto work_item_creation_result = g_io_work->try_queue([this]() {
-            reset();
+            reset_after_error();
         });
-        if (work_item_creation_result.is_error()) {
-            auto current_request = m_current_request;
-            m_current_request.clear();
-            current_request->complete(AsyncDeviceRequest::OutOfMemory);
-        }
+        if (work_item_creation_result.is_error())
+            fail_outstanding_requests();
         return;
     }
     if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::IF) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::TFE) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::HBD) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::HBF)) {
         auto work_item_creation_result = g_io_work->try_queue([this]() {
             recover_from_fatal_error();
         });
-        if (work_item_creation_result.is_error()) {
-            auto current_request = m_current_request;
-            m_current_request.clear();
-            current_request->complete(AsyncDeviceRequest::OutOfMemory);
-        }
+        if (work_item_creation_result.is_error())
+            fail_outstanding_requests();
         return;
     }
-    if (m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR) || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS)) {
-        m_wait_for_completion = false;
-
-        // Now schedule reading/writing the buffer as soon as we leave the irq handler.
-        // This is important so that we can safely access the buffers, which could
-        // trigger page faults
-        if (!m_current_request) {
-            dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled, probably identify request", representative_port_index());
-        } else {
-            auto work_item_creation_result = g_io_work->try_queue([this]() {
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request handled", representative_port_index());
-                MutexLocker locker(m_lock);
-                VERIFY(m_current_request);
-                VERIFY(m_current_scatter_list);
-                if (!m_connected_device) {
-                    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                    complete_current_request(AsyncDeviceRequest::Failure);
-                    return;
-                }
-                if (m_current_request->request_type() == AsyncBlockDeviceRequest::Read) {
-                    if (auto result = m_current_request->write_to_buffer(m_current_request->buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * m_current_request->block_count()); result.is_error()) {
-                        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure, memory fault occurred when reading in data.", representative_port_index());
-                        m_current_scatter_list = nullptr;
-                        complete_current_request(AsyncDeviceRequest::MemoryFault);
-                        return;
-                    }
-                }
-                m_current_scatter_list = nullptr;
-                dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request success", representative_port_index());
-                complete_current_request(AsyncDeviceRequest::Success);
-            });
-            if (work_item_creation_result.is_error()) {
-                auto current_request = m_current_request;
-                m_current_request.clear();
-                current_request->complete(AsyncDeviceRequest::OutOfMemory);
-            }
-        }
-    }
 
+    // With native command queuing, the device tells us about finished commands with a Set Device Bits FIS,
+    // otherwise with a Device to Host Register FIS.
+    bool commands_may_have_finished = m_interrupt_status.is_set(AHCI::PortInterruptFlag::SDB)
+        || m_interrupt_status.is_set(AHCI::PortInterruptFlag::DHR)
+        || m_interrupt_status.is_set(AHCI::PortInterruptFlag::PS);
+
+    // NOTE: Clear the interrupt status before looking at which commands finished, so that we don't miss
+    //       the interrupt of a command finishing in between.
     m_interrupt_status.clear();
+
+    if (commands_may_have_finished)
+        complete_finished_commands();
 }
 
 bool AHCIPort::is_interrupts_enabled() const
@@ -179,19 +148,36 @@ bool AHCIPort::is_interrupts_enabled() const
 
 void AHCIPort::recover_from_fatal_error()
 {
-    MutexLocker locker(m_lock);
-    SpinlockLocker lock(m_hard_lock);
-    LockRefPtr<AHCIController> controller = m_parent_controller.strong_ref();
-    if (!controller) {
-        dmesgln("AHCI Port {}: fatal error, controller not available", representative_port_index());
-        return;
+    {
+        MutexLocker locker(m_lock);
+        SpinlockLocker lock(m_hard_lock);
+        m_accepting_commands = false;
+        LockRefPtr<AHCIController> controller = m_parent_controller.strong_ref();
+        if (!controller) {
+            dmesgln("AHCI Port {}: fatal error, controller not available", representative_port_index());
+        } else {
+            dmesgln("{}: AHCI Port {} fatal error, shutting down!", controller->device_identifier().address(), representative_port_index());
+            dmesgln("{}: AHCI Port {} fatal error, SError {}", controller->device_identifier().address(), representative_port_index(), (u32)m_port_registers.serr);
+            stop_command_list_processing();
+            stop_fis_receiving();
+            m_interrupt_enable.clear();
+        }
     }
+    fail_outstanding_requests();
+}
 
-    dmesgln("{}: AHCI Port {} fatal error, shutting down!", controller->device_identifier().address(), representative_port_index());
-    dmesgln("{}: AHCI Port {} fatal error, SError {}", controller->device_identifier().address(), representative_port_index(), (u32)m_port_registers.serr);
-    stop_command_list_processing();
-    stop_fis_receiving();
-    m_interrupt_enable.clear();
+void AHCIPort::reset_after_error()
+{
+    // Whatever the device was working on is lost with the reset. Make sure nothing new gets issued
+    // until we're done, so that we don't mistake new commands for the lost ones.
+    {
+        SpinlockLocker lock(m_hard_lock);
+        m_accepting_commands = false;
+    }
+    fail_outstanding_requests();
+    reset();
+    SpinlockLocker lock(m_hard_lock);
+    m_accepting_commands = true;
 }
 
 bool AHCIPort::reset()
@@ -256,6 +242,7 @@ bool AHCIPort::initialize()
     size_t logical_sector_size = 512;
     size_t physical_sector_size = 512;
     u64 max_addressable_sector = 0;
+    bool is_rotational = true;
 
     if (identify_device()) {
         auto identify_block = Memory::map_typed<ATAIdentifyBlock>(m_identify_buffer_page->paddr()).release_value_but_fixme_should_propagate_errors();
@@ -275,6 +262,21 @@ bool AHCIPort::initialize()
         } else {
             max_addressable_sector = identify_block->max_28_bit_addressable_logical_sector;
         }
+        // Word 217 reports 1 for solid state devices.
+        is_rotational = identify_block->nominal_media_rotation_rate != 1;
+
+        // Word 76 bit 8 tells us whether the device supports native command queuing, and word 75 how many
+        // commands it can queue up.
+        size_t command_queue_depth = 1;
+        if (m_hba_capabilities.native_command_queuing_supported && !is_atapi_attached() && (identify_block->serial_ata_capabilities & (1 << 8)))
+            command_queue_depth = min<size_t>((identify_block->queue_depth & 0x1f) + 1, m_hba_capabilities.max_command_list_entries_count);
+        if (auto result = allocate_command_slots(command_queue_depth); result.is_error())
+            dmesgln("AHCI Port {}: Couldn't allocate {} command slots: {}", representative_port_index(), command_queue_depth, result.error());
+        m_command_queue_depth = min(command_queue_depth, request_slot_count());
+        set_usable_request_slot_count(m_command_queue_depth);
+        m_uses_native_command_queuing = m_command_queue_depth > 1;
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Command queue depth {}, NCQ {}", representative_port_index(), m_command_queue_depth, m_uses_native_command_queuing);
+
         if (is_atapi_attached()) {
             m_port_registers.cmd = m_port_registers.cmd | (1 << 24);
         }
@@ -288,7 +290,7 @@ bool AHCIPort::initialize()
                 dmesgln("AHCI Port {}: Device found, but parent controller is not available, abort.", representative_port_index());
                 return false;
             }
-            m_connected_device = ATADiskDevice::create(*controller, { m_port_index, 0 }, 0, logical_sector_size, max_addressable_sector);
+            m_connected_device = ATADiskDevice::create(*controller, { m_port_index, 0 }, 0, logical_sector_size, max_addressable_sector, is_rotational);
         } else {
             dbgln("AHCI Port {}: Ignoring ATAPI devices as we don't support them.", representative_port_index());
         }
@@ -411,72 +413,58 @@ void AHCIPort::set_sleep_state() const
     m_port_registers.cmd = (m_port_registers.cmd & 0x0ffffff) | (0b1000 << 28);
 }
 
-size_t AHCIPort::calculate_descriptors_count(size_t block_count) const
+u32 AHCIPort::max_blocks_per_command() const
 {
     VERIFY(m_connected_device);
-    size_t needed_dma_regions_count = Memory::page_round_up((block_count * m_connected_device->block_size())).value() / PAGE_SIZE;
-    VERIFY(needed_dma_regions_count <= m_dma_buffers.size());
-    return needed_dma_regions_count;
-}
-
-Optional<AsyncDeviceRequest::RequestResult> AHCIPort::prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request)
-{
-    VERIFY(m_lock.is_locked());
-    VERIFY(request.block_count() > 0);
-
-    Vector<NonnullRefPtr<Memory::PhysicalPage>> allocated_dma_regions;
-    for (size_t index = 0; index < calculate_descriptors_count(request.block_count()); index++) {
-        allocated_dma_regions.append(m_dma_buffers.at(index));
-    }
-
-    m_current_scatter_list = Memory::ScatterGatherList::try_create(request, allocated_dma_regions.span(), m_connected_device->block_size(), "AHCI Scattered DMA"sv).release_value_but_fixme_should_propagate_errors();
-    if (!m_current_scatter_list)
-        return AsyncDeviceRequest::Failure;
-    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
-        if (auto result = request.read_from_buffer(request.buffer(), m_current_scatter_list->dma_region().as_ptr(), m_connected_device->block_size() * request.block_count()); result.is_error()) {
-            return AsyncDeviceRequest::MemoryFault;
-        }
-    }
-    return {};
+    return dma_pages_per_command * PAGE_SIZE / m_connected_device->block_size();
 }
 
 void AHCIPort::start_request(AsyncBlockDeviceRequest& request)
 {
-    MutexLocker locker(m_lock);
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request start", representative_port_index());
-    VERIFY(!m_current_request);
-    VERIFY(!m_current_scatter_list);
-
-    m_current_request = request;
+    start_request_in_slot(request);
+}
 
-    auto result = prepare_and_set_scatter_list(request);
-    if (result.has_value()) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(result.value());
+void AHCIPort::complete_finished_commands()
+{
+    u32 finished_commands;
+    {
+        SpinlockLocker lock(m_hard_lock);
+        u32 active_commands = m_port_registers.ci;
+        if (m_uses_native_command_queuing)
+            active_commands |= m_port_registers.sact;
+        finished_commands = m_issued_commands & ~active_commands;
+        m_issued_commands &= ~finished_commands;
+    }
+    if (finished_commands == 0) {
+        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Interrupt without finished commands, probably identify request", representative_port_index());
         return;
     }
 
-    auto success = access_device(request.request_type(), request.block_index(), request.block_count());
-    if (!success) {
-        dbgln_if(AHCI_DEBUG, "AHCI Port {}: Request failure.", representative_port_index());
-        locker.unlock();
-        complete_current_request(AsyncDeviceRequest::Failure);
-        return;
+    // NOTE: With native command queuing, the device finishes commands in whatever order suits it best,
+    //       so every request is completed as soon as its own command is done.
+    for (u8 slot_index = 0; finished_commands != 0; slot_index++, finished_commands >>= 1) {
+        if (finished_commands & 1)
+            finish_request_slot(slot_index, AsyncDeviceRequest::Success);
     }
 }
 
-void AHCIPort::complete_current_request(AsyncDeviceRequest::RequestResult result)
+void AHCIPort::fail_outstanding_requests()
 {
-    VERIFY(m_current_request);
-    auto current_request = m_current_request;
-    m_current_request.clear();
-    current_request->complete(result);
+    u32 outstanding_commands;
+    {
+        SpinlockLocker lock(m_hard_lock);
+        outstanding_commands = exchange(m_issued_commands, 0);
+    }
+    for (u8 slot_index = 0; outstanding_commands != 0; slot_index++, outstanding_commands >>= 1) {
+        if (outstanding_commands & 1)
+            finish_request_slot(slot_index, AsyncDeviceRequest::Failure);
+    }
 }
 
 bool AHCIPort::spin_until_ready() const
 {
-    VERIFY(m_lock.is_locked());
+    VERIFY(m_lock.is_locked() || m_hard_lock.is_locked());
     size_t spin = 0;
     dbgln_if(AHCI_DEBUG, "AHCI Port {}: Spinning until ready.", representative_port_index());
     while ((m_port_registers.tfd & (ATA_SR_BSY | ATA_SR_DRQ)) && spin <= 100) {
@@ -490,59 +478,58 @@ bool AHCIPort::spin_until_ready() const
     return true;
 }
 
-bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64 lba, u8 block_count)
+bool AHCIPort::submit_request_slot(size_t slot_index)
 {
-    VERIFY(m_connected_device);
-    VERIFY(is_operable());
-    VERIFY(m_lock.is_locked());
-    VERIFY(m_current_scatter_list);
     SpinlockLocker lock(m_hard_lock);
+    if (!m_accepting_commands || !m_connected_device || !is_operable())
+        return false;
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count);
-    if (!spin_until_ready())
+    auto& slot = m_command_slots[slot_index];
+    auto& request = request_in_slot(slot_index);
+    auto const& dma_pages = request_slot_buffer_pages(slot_index);
+    auto direction = request.request_type();
+    u64 lba = request.block_index();
+    u32 block_count = request.block_count();
+
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} in slot {}", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, slot_index);
+
+    // NOTE: Without native command queuing, the device has to be done with one command before it takes the next.
+    if (!m_uses_native_command_queuing && !spin_until_ready())
         return false;
 
-    auto unused_command_header = try_to_find_unused_command_header();
-    VERIFY(unused_command_header.has_value());
+    size_t data_transfer_count = (block_count * m_connected_device->block_size());
+    size_t scatter_entries_count = Memory::page_round_up(data_transfer_count).value() / PAGE_SIZE;
+    VERIFY(scatter_entries_count <= dma_pages.size());
+
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()]->paddr().get();
-    command_list_entries[unused_command_header.value()].ctbau = 0;
-    command_list_entries[unused_command_header.value()].prdbc = 0;
-    command_list_entries[unused_command_header.value()].prdtl = m_current_scatter_list->scatters_count();
+    command_list_entries[slot_index].ctba = slot.command_table_page->paddr().get();
+    command_list_entries[slot_index].ctbau = 0;
+    command_list_entries[slot_index].prdbc = 0;
+    command_list_entries[slot_index].prdtl = scatter_entries_count;
 
     // Note: we must set the correct Dword count in this register. Real hardware
     // AHCI controllers do care about this field! QEMU doesn't care if we don't
     // set the correct CFL field in this register, real hardware will set an
     // handshake error bit in PxSERR register if CFL is incorrect.
-    command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
-
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[unused_command_header.value()].ctba, (u32)command_list_entries[unused_command_header.value()].ctbau, (u32)command_list_entries[unused_command_header.value()].prdbc, (u16)command_list_entries[unused_command_header.value()].prdtl, (u16)command_list_entries[unused_command_header.value()].attributes);
+    command_list_entries[slot_index].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P | (is_atapi_attached() ? AHCI::CommandHeaderAttributes::A : 0) | (direction == AsyncBlockDeviceRequest::RequestType::Write ? AHCI::CommandHeaderAttributes::W : 0);
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()]->paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table"sv, Memory::Region::Access::ReadWrite, Memory::Region::Cacheable::No).release_value();
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: CLE: ctba={:#08x}, ctbau={:#08x}, prdbc={:#08x}, prdtl={:#04x}, attributes={:#04x}", representative_port_index(), (u32)command_list_entries[slot_index].ctba, (u32)command_list_entries[slot_index].ctbau, (u32)command_list_entries[slot_index].prdbc, (u16)command_list_entries[slot_index].prdtl, (u16)command_list_entries[slot_index].attributes);
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Allocated command table at {}", representative_port_index(), command_table_region->vaddr());
+    auto& command_table = *(volatile AHCI::CommandTable*)slot.command_table_region->vaddr().as_ptr();
 
     memset(const_cast<u8*>(command_table.command_fis), 0, 64);
 
-    size_t scatter_entry_index = 0;
-    size_t data_transfer_count = (block_count * m_connected_device->block_size());
-    for (auto scatter_page : m_current_scatter_list->vmobject().physical_pages()) {
-        VERIFY(data_transfer_count != 0);
-        VERIFY(scatter_page);
+    for (size_t scatter_entry_index = 0; scatter_entry_index < scatter_entries_count; scatter_entry_index++) {
+        auto& scatter_page = dma_pages[scatter_entry_index];
         dbgln_if(AHCI_DEBUG, "AHCI Port {}: Add a transfer scatter entry @ {}", representative_port_index(), scatter_page->paddr());
+        size_t byte_count = min(data_transfer_count, PAGE_SIZE);
         command_table.descriptors[scatter_entry_index].base_high = 0;
         command_table.descriptors[scatter_entry_index].base_low = scatter_page->paddr().get();
-        if (data_transfer_count <= PAGE_SIZE) {
-            command_table.descriptors[scatter_entry_index].byte_count = data_transfer_count - 1;
-            data_transfer_count = 0;
-        } else {
-            command_table.descriptors[scatter_entry_index].byte_count = PAGE_SIZE - 1;
-            data_transfer_count -= PAGE_SIZE;
-        }
-        scatter_entry_index++;
+        command_table.descriptors[scatter_entry_index].byte_count = byte_count - 1;
+        data_transfer_count -= byte_count;
     }
-    command_table.descriptors[scatter_entry_index].byte_count = (PAGE_SIZE - 1) | (1 << 31);
+    VERIFY(data_transfer_count == 0);
+    command_table.descriptors[scatter_entries_count - 1].byte_count = command_table.descriptors[scatter_entries_count - 1].byte_count | (1u << 31);
 
     memset(const_cast<u8*>(command_table.atapi_command), 0, 32);
 
@@ -551,6 +538,11 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     if (is_atapi_attached()) {
         fis.command = ATA_CMD_PACKET;
         TODO();
+    } else if (m_uses_native_command_queuing) {
+        if (direction == AsyncBlockDeviceRequest::RequestType::Write)
+            fis.command = ATA_CMD_WRITE_FPDMA_QUEUED;
+        else
+            fis.command = ATA_CMD_READ_FPDMA_QUEUED;
     } else {
         if (direction == AsyncBlockDeviceRequest::RequestType::Write)
             fis.command = ATA_CMD_WRITE_DMA_EXT;
@@ -569,17 +561,23 @@ bool AHCIPort::access_device(AsyncBlockDeviceRequest::RequestType direction, u64
     fis.lba_low[0] = lba & 0xff;
     fis.lba_low[1] = (lba >> 8) & 0xff;
     fis.lba_low[2] = (lba >> 16) & 0xff;
-    fis.count = (block_count);
-
-    // The below loop waits until the port is no longer busy before issuing a new command
-    if (!spin_until_ready())
-        return false;
+    if (m_uses_native_command_queuing) {
+        // Queued commands carry the block count in the features register, and their tag in the count register.
+        fis.features_low = block_count & 0xff;
+        fis.features_high = (block_count >> 8) & 0xff;
+        fis.count = slot_index << 3;
+    } else {
+        fis.count = block_count;
+    }
 
     full_memory_barrier();
-    mark_command_header_ready_to_process(unused_command_header.value());
+    m_issued_commands |= 1u << slot_index;
+    if (m_uses_native_command_queuing)
+        m_port_registers.sact = 1u << slot_index;
+    m_port_registers.ci = 1u << slot_index;
     full_memory_barrier();
 
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} @ {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, m_dma_buffers[0]->paddr());
+    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Do a {}, lba {}, block count {} in slot {}, ended", representative_port_index(), direction == AsyncBlockDeviceRequest::RequestType::Write ? "write" : "read", lba, block_count, slot_index);
     return true;
 }
 
@@ -596,8 +594,10 @@ bool AHCIPort::identify_device()
 
     auto unused_command_header = try_to_find_unused_command_header();
     VERIFY(unused_command_header.has_value());
+    VERIFY(unused_command_header.value() < request_slot_count());
+    auto& slot = m_command_slots[unused_command_header.value()];
     auto* command_list_entries = (volatile AHCI::CommandHeader*)m_command_list_region->vaddr().as_ptr();
-    command_list_entries[unused_command_header.value()].ctba = m_command_table_pages[unused_command_header.value()]->paddr().get();
+    command_list_entries[unused_command_header.value()].ctba = slot.command_table_page->paddr().get();
     command_list_entries[unused_command_header.value()].ctbau = 0;
     command_list_entries[unused_command_header.value()].prdbc = 512;
     command_list_entries[unused_command_header.value()].prdtl = 1;
@@ -606,8 +606,7 @@ bool AHCIPort::identify_device()
     // QEMU doesn't care if we don't set the correct CFL field in this register, real hardware will set an handshake error bit in PxSERR register.
     command_list_entries[unused_command_header.value()].attributes = (size_t)FIS::DwordCount::RegisterHostToDevice | AHCI::CommandHeaderAttributes::P;
 
-    auto command_table_region = MM.allocate_kernel_region(m_command_table_pages[unused_command_header.value()]->paddr().page_base(), Memory::page_round_up(sizeof(AHCI::CommandTable)).value(), "AHCI Command Table"sv, Memory::Region::Access::ReadWrite).release_value();
-    auto& command_table = *(volatile AHCI::CommandTable*)command_table_region->vaddr().as_ptr();
+    auto& command_table = *(volatile AHCI::CommandTable*)slot.command_table_region->vaddr().as_ptr();
     memset(const_cast<u8*>(command_table.command_fis), 0, 64);
     command_table.descriptors[0].base_high = 0;
     command_table.descriptors[0].base_low = m_identify_buffer_page->paddr().get();
@@ -704,17 +703,6 @@ void AHCIPort::start_command_list_processing() const
     m_port_registers.cmd = m_port_registers.cmd | 1;
 }
 
-void AHCIPort::mark_command_header_ready_to_process(u8 command_header_index) const
-{
-    VERIFY(m_lock.is_locked());
-    VERIFY(m_hard_lock.is_locked());
-    VERIFY(is_operable());
-    VERIFY(!m_wait_for_completion);
-    m_wait_for_completion = true;
-    dbgln_if(AHCI_DEBUG, "AHCI Port {}: Marking command header at index {} as ready to process.", representative_port_index(), command_header_index);
-    m_port_registers.ci = 1 << command_header_index;
-}
-
 void AHCIPort::stop_command_list_processing() const
 {
     VERIFY(m_lock.is_locked());
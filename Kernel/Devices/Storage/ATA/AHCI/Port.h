@@ -6,9 +6,11 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <Kernel/Devices/Device.h>
+#include <Kernel/Devices/Storage/BlockRequestSlots.h>
 #include <Kernel/Devices/Storage/ATA/AHCI/Definitions.h>
 #include <Kernel/Devices/Storage/ATA/AHCI/InterruptHandler.h>
 #include <Kernel/Devices/Storage/ATA/ATADevice.h>
@@ -33,7 +35,8 @@ class AsyncBlockDeviceRequest;
 class AHCIInterruptHandler;
 class AHCIPort
     : public AtomicRefCounted<AHCIPort>
-    , public LockWeakable<AHCIPort> {
+    , public LockWeakable<AHCIPort>
+    , public BlockRequestSlots {
     friend class AHCIController;
 
 public:
@@ -46,6 +49,10 @@ public:
 
     LockRefPtr<StorageDevice> connected_device() const { return m_connected_device; }
 
+    // With native command queuing, the device can work on a command in every slot at the same time.
+    size_t command_queue_depth() const { return m_command_queue_depth; }
+    u32 max_blocks_per_command() const;
+
     bool reset();
     bool initialize_without_reset();
     void handle_interrupt();
@@ -66,15 +73,20 @@ private:
     bool initiate_sata_reset();
     void rebase();
     void recover_from_fatal_error();
+    void reset_after_error();
     bool shutdown();
     ALWAYS_INLINE void spin_up() const;
     ALWAYS_INLINE void power_on() const;
 
     void start_request(AsyncBlockDeviceRequest&);
-    void complete_current_request(AsyncDeviceRequest::RequestResult);
-    bool access_device(AsyncBlockDeviceRequest::RequestType, u64 lba, u8 block_count);
-    size_t calculate_descriptors_count(size_t block_count) const;
-    [[nodiscard]] Optional<AsyncDeviceRequest::RequestResult> prepare_and_set_scatter_list(AsyncBlockDeviceRequest& request);
+    void complete_finished_commands();
+    void fail_outstanding_requests();
+
+    // ^BlockRequestSlots
+    virtual StringView request_slots_owner_name() const override { return "AHCIPort"sv; }
+    virtual bool submit_request_slot(size_t slot_index) override;
+
+    ErrorOr<void> allocate_command_slots(size_t count);
 
     ALWAYS_INLINE bool is_interrupts_enabled() const;
 
@@ -83,7 +95,6 @@ private:
     bool identify_device();
 
     ALWAYS_INLINE void start_command_list_processing() const;
-    ALWAYS_INLINE void mark_command_header_ready_to_process(u8 command_header_index) const;
     ALWAYS_INLINE void stop_command_list_processing() const;
 
     ALWAYS_INLINE void start_fis_receiving() const;
@@ -103,14 +114,24 @@ private:
     // Data members
 
     EntropySource m_entropy_source;
-    LockRefPtr<AsyncBlockDeviceRequest> m_current_request;
     Spinlock<LockRank::None> m_hard_lock {};
     Mutex m_lock { "AHCIPort"sv };
 
-    mutable bool m_wait_for_completion { false };
+    // Every command slot has its own command table and request slot (with its DMA buffer), so that
+    // commands can be prepared and completed independently of each other.
+    static constexpr size_t dma_pages_per_command = 4;
+    struct CommandSlot {
+        RefPtr<Memory::PhysicalPage> command_table_page;
+        OwnPtr<Memory::Region> command_table_region;
+    };
+    Array<CommandSlot, 32> m_command_slots;
+    size_t m_command_queue_depth { 1 };
+    bool m_uses_native_command_queuing { false };
+    // Cleared while the port is being recovered, so that no new commands are issued in the meantime.
+    bool m_accepting_commands { true };
+    // The slots whose command has been handed to the HBA and hasn't been completed yet.
+    u32 m_issued_commands { 0 };
 
-    Vector<NonnullRefPtr<Memory::PhysicalPage>> m_dma_buffers;
-    Vector<NonnullRefPtr<Memory::PhysicalPage>> m_command_table_pages;
     RefPtr<Memory::PhysicalPage> m_command_list_page;
     OwnPtr<Memory::Region> m_command_list_region;
     RefPtr<Memory::PhysicalPage> m_fis_receive_page;
@@ -130,7 +151,6 @@ private:
     AHCI::PortInterruptStatusBitField m_interrupt_status;
     AHCI::PortInterruptEnableBitField m_interrupt_enable;
 
-    LockRefPtr<Memory::ScatterGatherList> m_current_scatter_list;
     bool m_disabled_by_firmware { false };
 };
 }
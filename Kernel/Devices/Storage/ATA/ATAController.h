@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Optional.h>
 #include <AK/OwnPtr.h>
 #include <AK/Types.h>
 #include <Kernel/Devices/BlockDevice.h>
@@ -23,6 +24,11 @@ class ATAController
 public:
     virtual void start_request(ATADevice const&, AsyncBlockDeviceRequest&) = 0;
 
+    // Controllers that can have the device work on several commands at once (like AHCI with
+    // native command queuing) let more than one request in flight.
+    virtual size_t max_requests_in_flight(ATADevice const&) const { return 1; }
+    virtual Optional<u32> max_blocks_per_request(ATADevice const&) const { return {}; }
+
 protected:
     ATAController();
 };
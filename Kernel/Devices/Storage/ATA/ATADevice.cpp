@@ -16,11 +16,12 @@ static StorageDevice::LUNAddress convert_ata_address_to_lun_address(ATAControlle
     return StorageDevice::LUNAddress { controller.controller_id(), ata_address.port, ata_address.subport };
 }
 
-ATADevice::ATADevice(ATAController const& controller, ATADevice::Address ata_address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block)
+ATADevice::ATADevice(ATAController const& controller, ATADevice::Address ata_address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block, bool is_rotational)
     : StorageDevice(convert_ata_address_to_lun_address(controller, ata_address), controller.hardware_relative_controller_id(), logical_sector_size, max_addressable_block)
     , m_controller(controller)
     , m_ata_address(ata_address)
     , m_capabilities(capabilities)
+    , m_is_rotational(is_rotational)
 {
 }
 
@@ -33,4 +34,20 @@ void ATADevice::start_request(AsyncBlockDeviceRequest& request)
     controller->start_request(*this, request);
 }
 
+size_t ATADevice::max_requests_in_flight() const
+{
+    auto controller = m_controller.strong_ref();
+    if (!controller)
+        return 1;
+    return controller->max_requests_in_flight(*this);
+}
+
+u32 ATADevice::max_blocks_per_request() const
+{
+    auto controller = m_controller.strong_ref();
+    if (!controller)
+        return StorageDevice::max_blocks_per_request();
+    return controller->max_blocks_per_request(*this).value_or_lazy_evaluated([this] { return StorageDevice::max_blocks_per_request(); });
+}
+
 }
@@ -31,16 +31,22 @@ public:
 
     // ^BlockDevice
     virtual void start_request(AsyncBlockDeviceRequest&) override;
+    virtual bool is_rotational() const override { return m_is_rotational; }
+    virtual u32 max_blocks_per_request() const override;
 
     u16 ata_capabilites() const { return m_capabilities; }
     Address const& ata_address() const { return m_ata_address; }
 
 protected:
-    ATADevice(ATAController const&, Address, u16, u16, u64);
+    // ^Device
+    virtual size_t max_requests_in_flight() const override;
+
+    ATADevice(ATAController const&, Address, u16, u16, u64, bool is_rotational);
 
     LockWeakPtr<ATAController> m_controller;
     const Address m_ata_address;
     const u16 m_capabilities;
+    bool const m_is_rotational { true };
 };
 
 }
@@ -12,16 +12,16 @@
 
 namespace Kernel {
 
-NonnullLockRefPtr<ATADiskDevice> ATADiskDevice::create(ATAController const& controller, ATADevice::Address ata_address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block)
+NonnullLockRefPtr<ATADiskDevice> ATADiskDevice::create(ATAController const& controller, ATADevice::Address ata_address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block, bool is_rotational)
 {
-    auto disk_device_or_error = DeviceManagement::try_create_device<ATADiskDevice>(controller, ata_address, capabilities, logical_sector_size, max_addressable_block);
+    auto disk_device_or_error = DeviceManagement::try_create_device<ATADiskDevice>(controller, ata_address, capabilities, logical_sector_size, max_addressable_block, is_rotational);
     // FIXME: Find a way to propagate errors
     VERIFY(!disk_device_or_error.is_error());
     return disk_device_or_error.release_value();
 }
 
-ATADiskDevice::ATADiskDevice(ATAController const& controller, ATADevice::Address ata_address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block)
-    : ATADevice(controller, ata_address, capabilities, logical_sector_size, max_addressable_block)
+ATADiskDevice::ATADiskDevice(ATAController const& controller, ATADevice::Address ata_address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block, bool is_rotational)
+    : ATADevice(controller, ata_address, capabilities, logical_sector_size, max_addressable_block, is_rotational)
 {
 }
 
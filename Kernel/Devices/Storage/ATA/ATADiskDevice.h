@@ -18,14 +18,14 @@ class ATADiskDevice final : public ATADevice {
     friend class DeviceManagement;
 
 public:
-    static NonnullLockRefPtr<ATADiskDevice> create(ATAController const&, ATADevice::Address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block);
+    static NonnullLockRefPtr<ATADiskDevice> create(ATAController const&, ATADevice::Address, u16 capabilities, u16 logical_sector_size, u64 max_addressable_block, bool is_rotational);
     virtual ~ATADiskDevice() override;
 
     // ^StorageDevice
     virtual CommandSet command_set() const override { return CommandSet::ATA; }
 
 private:
-    ATADiskDevice(ATAController const&, Address, u16, u16, u64);
+    ATADiskDevice(ATAController const&, Address, u16, u16, u64, bool);
 
     // ^DiskDevice
     virtual StringView class_name() const override;
@@ -95,7 +95,9 @@ ErrorOr<void> ATAPort::detect_connected_devices()
             max_addressable_block = identify_block.user_addressable_logical_sectors_count;
         // FIXME: Don't assume all drives will have logical sector size of 512 bytes.
         ATADevice::Address address = { m_port_index, static_cast<u8>(device_index) };
-        m_ata_devices.append(ATADiskDevice::create(m_parent_ata_controller, address, capabilities, 512, max_addressable_block));
+        // A rotation rate of 1 means there's nothing spinning in there. Old drives don't report it at all.
+        bool is_rotational = identify_block.nominal_media_rotation_rate != 1;
+        m_ata_devices.append(ATADiskDevice::create(m_parent_ata_controller, address, capabilities, 512, max_addressable_block, is_rotational));
     }
     return {};
 }
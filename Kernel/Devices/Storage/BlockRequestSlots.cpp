@@ -0,0 +1,139 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/Devices/Storage/BlockRequestSlots.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Tasks/WorkQueue.h>
+
+namespace Kernel {
+
+ErrorOr<void> BlockRequestSlots::allocate_request_slots(size_t count, StringView buffer_name)
+{
+    TRY(m_slots.try_ensure_capacity(count));
+    while (m_slots.size() < count) {
+        Slot slot;
+        slot.buffer_region = TRY(MM.allocate_dma_buffer_pages(request_slot_buffer_size(), buffer_name, Memory::Region::Access::ReadWrite, slot.buffer_pages));
+        m_slots.unchecked_append(move(slot));
+        m_usable_slot_count = m_slots.size();
+    }
+    return {};
+}
+
+void BlockRequestSlots::set_usable_request_slot_count(size_t count)
+{
+    VERIFY(count > 0 && count <= m_slots.size());
+    m_usable_slot_count = count;
+}
+
+void BlockRequestSlots::start_request_in_slot(AsyncBlockDeviceRequest& request)
+{
+    // Copying the data out of a userspace buffer might page fault, and we might have been called from
+    // a context that can't handle that (like when the previous request completed), so defer it.
+    if (request.request_type() == AsyncBlockDeviceRequest::Write && !request.buffer().is_kernel_buffer()) {
+        auto work_item_creation_result = g_io_work->try_queue([this, request = NonnullLockRefPtr<AsyncBlockDeviceRequest>(request)]() mutable {
+            issue_request(*request);
+        });
+        if (work_item_creation_result.is_error())
+            request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+    issue_request(request);
+}
+
+void BlockRequestSlots::issue_request(AsyncBlockDeviceRequest& request)
+{
+    size_t transfer_size = request.block_count() * request.block_size();
+    if (request.block_count() == 0 || transfer_size > request_slot_buffer_size()) {
+        dbgln("{}: Can't transfer {} blocks at once", request_slots_owner_name(), request.block_count());
+        request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+
+    auto slot_index = take_free_slot(request);
+    if (!slot_index.has_value()) {
+        // NOTE: This shouldn't happen, as the device never has more requests in flight than we have slots.
+        dbgln("{}: No free request slot", request_slots_owner_name());
+        request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+
+    if (request.request_type() == AsyncBlockDeviceRequest::Write) {
+        if (auto result = request.read_from_buffer(request.buffer(), m_slots[slot_index.value()].buffer_region->vaddr().as_ptr(), transfer_size); result.is_error()) {
+            release_slot(slot_index.value());
+            request.complete(AsyncDeviceRequest::MemoryFault);
+            return;
+        }
+    }
+
+    if (!submit_request_slot(slot_index.value())) {
+        dbgln("{}: Couldn't submit request in slot {}", request_slots_owner_name(), slot_index.value());
+        release_slot(slot_index.value());
+        request.complete(AsyncDeviceRequest::Failure);
+    }
+}
+
+Optional<size_t> BlockRequestSlots::take_free_slot(AsyncBlockDeviceRequest& request)
+{
+    SpinlockLocker lock(m_slots_lock);
+    Optional<size_t> free_slot_index;
+    for (size_t index = 0; index < m_usable_slot_count; index++) {
+        if (m_slots[index].request)
+            continue;
+        if (is_preferred_request_slot(index)) {
+            free_slot_index = index;
+            break;
+        }
+        if (!free_slot_index.has_value())
+            free_slot_index = index;
+    }
+    if (free_slot_index.has_value())
+        m_slots[free_slot_index.value()].request = request;
+    return free_slot_index;
+}
+
+void BlockRequestSlots::release_slot(size_t slot_index)
+{
+    SpinlockLocker lock(m_slots_lock);
+    m_slots[slot_index].request.clear();
+}
+
+AsyncBlockDeviceRequest& BlockRequestSlots::request_in_slot(size_t slot_index)
+{
+    SpinlockLocker lock(m_slots_lock);
+    VERIFY(m_slots[slot_index].request);
+    return *m_slots[slot_index].request;
+}
+
+void BlockRequestSlots::finish_request_slot(size_t slot_index, AsyncDeviceRequest::RequestResult result)
+{
+    auto& slot = m_slots[slot_index];
+    LockRefPtr<AsyncBlockDeviceRequest> request;
+    {
+        SpinlockLocker lock(m_slots_lock);
+        request = slot.request;
+    }
+    VERIFY(request);
+
+    if (result == AsyncDeviceRequest::Success && request->request_type() == AsyncBlockDeviceRequest::Read) {
+        if (!request->buffer().is_kernel_buffer() && Processor::current_in_irq()) {
+            // Writing to a userspace buffer might page fault, so that has to wait until we've left the IRQ handler.
+            auto work_item_creation_result = g_io_work->try_queue([this, slot_index]() {
+                finish_request_slot(slot_index, AsyncDeviceRequest::Success);
+            });
+            if (!work_item_creation_result.is_error())
+                return;
+            result = AsyncDeviceRequest::Failure;
+        } else if (auto copy_result = request->write_to_buffer(request->buffer(), slot.buffer_region->vaddr().as_ptr(), request->block_size() * request->block_count()); copy_result.is_error()) {
+            result = AsyncDeviceRequest::MemoryFault;
+        }
+    }
+
+    release_slot(slot_index);
+    request->complete(result);
+}
+
+}
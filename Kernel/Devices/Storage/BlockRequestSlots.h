@@ -0,0 +1,75 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Noncopyable.h>
+#include <AK/Optional.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Devices/BlockDevice.h>
+#include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/PhysicalPage.h>
+#include <Kernel/Memory/Region.h>
+
+namespace Kernel {
+
+// Keeps track of the requests that a storage device works on at the same time.
+//
+// Every request slot has its own DMA buffer. The data of a write is copied into it before the slot is
+// submitted to the device, and the data of a read is copied out of it once the driver finishes the slot.
+// As copying from or to a userspace buffer might page fault, that is deferred to the I/O work queue if
+// we're in a context that can't handle it.
+class BlockRequestSlots {
+    AK_MAKE_NONCOPYABLE(BlockRequestSlots);
+    AK_MAKE_NONMOVABLE(BlockRequestSlots);
+
+public:
+    size_t request_slot_count() const { return m_slots.size(); }
+    size_t request_slot_buffer_size() const { return m_buffer_pages_per_slot * PAGE_SIZE; }
+
+protected:
+    explicit BlockRequestSlots(size_t buffer_pages_per_slot)
+        : m_buffer_pages_per_slot(buffer_pages_per_slot)
+    {
+    }
+    virtual ~BlockRequestSlots() = default;
+
+    // Adds slots until there are `count` of them. All slots are used for requests, unless limited below.
+    ErrorOr<void> allocate_request_slots(size_t count, StringView buffer_name);
+    void set_usable_request_slot_count(size_t count);
+
+    void start_request_in_slot(AsyncBlockDeviceRequest&);
+    void finish_request_slot(size_t slot_index, AsyncDeviceRequest::RequestResult);
+
+    AsyncBlockDeviceRequest& request_in_slot(size_t slot_index);
+    Vector<NonnullRefPtr<Memory::PhysicalPage>> const& request_slot_buffer_pages(size_t slot_index) const { return m_slots[slot_index].buffer_pages; }
+
+    virtual StringView request_slots_owner_name() const = 0;
+    // Free slots that this returns true for are taken before any others.
+    virtual bool is_preferred_request_slot(size_t) const { return true; }
+    // Hands the request in the slot over to the device. If this returns false, the request fails.
+    virtual bool submit_request_slot(size_t slot_index) = 0;
+
+private:
+    struct Slot {
+        Vector<NonnullRefPtr<Memory::PhysicalPage>> buffer_pages;
+        OwnPtr<Memory::Region> buffer_region;
+        LockRefPtr<AsyncBlockDeviceRequest> request;
+    };
+
+    void issue_request(AsyncBlockDeviceRequest&);
+    Optional<size_t> take_free_slot(AsyncBlockDeviceRequest&);
+    void release_slot(size_t slot_index);
+
+    size_t const m_buffer_pages_per_slot;
+    size_t m_usable_slot_count { 0 };
+    Vector<Slot> m_slots;
+    Spinlock<LockRank::None> m_slots_lock {};
+};
+
+}
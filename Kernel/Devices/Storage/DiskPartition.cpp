@@ -36,13 +36,32 @@ Partition::DiskPartitionMetadata const& DiskPartition::metadata() const
 void DiskPartition::start_request(AsyncBlockDeviceRequest& request)
 {
     auto device = m_device.strong_ref();
-    if (!device)
+    if (!device) {
         request.complete(AsyncBlockDeviceRequest::RequestResult::Failure);
+        return;
+    }
+    // NOTE: Keep the device plugged until the sub-request knows about its parent, so that it can't
+    //       be started (and completed) before then.
+    device->plug();
     auto sub_request_or_error = device->try_make_request<AsyncBlockDeviceRequest>(request.request_type(),
         request.block_index() + m_metadata.start_block(), request.block_count(), request.buffer(), request.buffer_size());
     if (sub_request_or_error.is_error())
         TODO();
     request.add_sub_request(sub_request_or_error.release_value());
+    device->unplug();
+}
+
+void DiskPartition::plug()
+{
+    // Our requests go straight on to the device, so that's where they have to be held back.
+    if (auto device = m_device.strong_ref())
+        device->plug();
+}
+
+void DiskPartition::unplug()
+{
+    if (auto device = m_device.strong_ref())
+        device->unplug();
 }
 
 ErrorOr<size_t> DiskPartition::read(OpenFileDescription& fd, u64 offset, UserOrKernelBuffer& outbuf, size_t len)
@@ -21,6 +21,8 @@ public:
     virtual ~DiskPartition();
 
     virtual void start_request(AsyncBlockDeviceRequest&) override;
+    virtual void plug() override;
+    virtual void unplug() override;
 
     // ^BlockDevice
     virtual ErrorOr<size_t> read(OpenFileDescription&, u64, UserOrKernelBuffer&, size_t) override;
@@ -34,6 +36,9 @@ private:
     DiskPartition(BlockDevice&, MinorNumber, Partition::DiskPartitionMetadata);
     virtual StringView class_name() const override;
 
+    // ^Device
+    virtual bool forwards_requests() const override { return true; }
+
     LockWeakPtr<BlockDevice> m_device;
     Partition::DiskPartitionMetadata m_metadata;
 };
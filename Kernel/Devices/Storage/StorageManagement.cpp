@@ -20,6 +20,7 @@
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/Bus/PCI/Access.h>
 #include <Kernel/Bus/PCI/Controller/VolumeManagementDevice.h>
+#include <Kernel/Bus/PCI/IDs.h>
 #include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/Devices/DeviceManagement.h>
 #include <Kernel/Devices/Storage/ATA/AHCI/Controller.h>
@@ -28,6 +29,7 @@
 #include <Kernel/Devices/Storage/SD/PCISDHostController.h>
 #include <Kernel/Devices/Storage/SD/SDHostController.h>
 #include <Kernel/Devices/Storage/StorageManagement.h>
+#include <Kernel/Devices/Storage/VirtIO/VirtIOBlockController.h>
 #include <Kernel/FileSystem/Ext2FS/FileSystem.h>
 #include <Kernel/FileSystem/VirtualFileSystem.h>
 #include <Kernel/Library/Panic.h>
@@ -45,6 +47,7 @@ static Atomic<u32> s_controller_id;
 static Atomic<u32> s_relative_ata_controller_id;
 static Atomic<u32> s_relative_nvme_controller_id;
 static Atomic<u32> s_relative_sd_controller_id;
+static Atomic<u32> s_relative_virtio_controller_id;
 
 static constexpr StringView partition_uuid_prefix = "PARTUUID:"sv;
 
@@ -55,6 +58,7 @@ static constexpr StringView ata_device_prefix = "ata"sv;
 static constexpr StringView nvme_device_prefix = "nvme"sv;
 static constexpr StringView logical_unit_number_device_prefix = "lun"sv;
 static constexpr StringView sd_device_prefix = "sd"sv;
+static constexpr StringView virtio_device_prefix = "virtio"sv;
 
 UNMAP_AFTER_INIT StorageManagement::StorageManagement()
 {
@@ -81,6 +85,13 @@ u32 StorageManagement::generate_relative_sd_controller_id(Badge<SDHostController
     return controller_id;
 }
 
+u32 StorageManagement::generate_relative_virtio_controller_id(Badge<VirtIOBlockController>)
+{
+    auto controller_id = s_relative_virtio_controller_id.load();
+    s_relative_virtio_controller_id++;
+    return controller_id;
+}
+
 void StorageManagement::add_device(StorageDevice& device)
 {
     m_storage_devices.append(device);
@@ -158,7 +169,21 @@ UNMAP_AFTER_INIT void StorageManagement::enumerate_pci_controllers(bool force_pi
             }
         };
 
+        auto const& handle_virtio_device = [&](PCI::DeviceIdentifier const& device_identifier) {
+            if (device_identifier.hardware_id().device_id != PCI::DeviceID::VirtIOBlockDevice || kernel_command_line().disable_virtio())
+                return;
+            if (auto controller_or_error = VirtIOBlockController::initialize(device_identifier); !controller_or_error.is_error())
+                m_controllers.append(controller_or_error.release_value());
+            else
+                dmesgln("Unable to initialize VirtIO block device: {}", controller_or_error.error());
+        };
+
         MUST(PCI::enumerate([&](PCI::DeviceIdentifier const& device_identifier) -> void {
+            // NOTE: VirtIO block devices claim to be SCSI controllers, so look at them first.
+            if (device_identifier.hardware_id().vendor_id == PCI::VendorID::VirtIO) {
+                handle_virtio_device(device_identifier);
+                return;
+            }
             auto class_code = device_identifier.class_code();
             if (class_code == PCI::ClassID::MassStorage) {
                 handle_mass_storage_device(device_identifier);
@@ -340,6 +365,13 @@ UNMAP_AFTER_INIT void StorageManagement::determine_sd_boot_device()
     });
 }
 
+UNMAP_AFTER_INIT void StorageManagement::determine_virtio_boot_device()
+{
+    determine_hardware_relative_boot_device(virtio_device_prefix, [](StorageDevice const& device) -> bool {
+        return device.command_set() == StorageDevice::CommandSet::VirtIO;
+    });
+}
+
 UNMAP_AFTER_INIT void StorageManagement::determine_block_boot_device()
 {
     VERIFY(m_boot_argument.starts_with(block_device_prefix));
@@ -409,6 +441,11 @@ UNMAP_AFTER_INIT bool StorageManagement::determine_boot_device(StringView boot_a
         determine_sd_boot_device();
         return m_boot_block_device;
     }
+
+    if (m_boot_argument.starts_with(virtio_device_prefix)) {
+        determine_virtio_boot_device();
+        return m_boot_block_device;
+    }
     PANIC("StorageManagement: Invalid root boot parameter.");
 }
 
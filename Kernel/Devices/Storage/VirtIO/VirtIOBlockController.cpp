@@ -0,0 +1,251 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/Bus/VirtIO/Transport/PCIe/TransportLink.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Devices/Storage/StorageManagement.h>
+#include <Kernel/Devices/Storage/VirtIO/VirtIOBlockController.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT ErrorOr<NonnullRefPtr<VirtIOBlockController>> VirtIOBlockController::initialize(PCI::DeviceIdentifier const& device_identifier)
+{
+    auto pci_transport_link = TRY(VirtIO::PCIeTransportLink::create(device_identifier));
+    auto controller = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) VirtIOBlockController(move(pci_transport_link), StorageManagement::generate_relative_virtio_controller_id({}))));
+    TRY(controller->initialize_virtio_resources());
+    return controller;
+}
+
+UNMAP_AFTER_INIT VirtIOBlockController::VirtIOBlockController(NonnullOwnPtr<VirtIO::TransportEntity> transport_entity, u32 hardware_relative_controller_id)
+    : StorageController(hardware_relative_controller_id)
+    , VirtIO::Device(move(transport_entity))
+    , BlockRequestSlots(data_pages_per_request)
+{
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIOBlockController::initialize_virtio_resources()
+{
+    TRY(VirtIO::Device::initialize_virtio_resources());
+    auto const* cfg = TRY(transport_entity().get_config(VirtIO::ConfigurationType::Device));
+    TRY(negotiate_features([&](u64 supported_features) {
+        u64 negotiated = 0;
+        if (is_feature_set(supported_features, VIRTIO_BLK_F_RO))
+            negotiated |= VIRTIO_BLK_F_RO;
+        if (is_feature_set(supported_features, VIRTIO_BLK_F_BLK_SIZE))
+            negotiated |= VIRTIO_BLK_F_BLK_SIZE;
+        if (is_feature_set(supported_features, VIRTIO_BLK_F_MQ))
+            negotiated |= VIRTIO_BLK_F_MQ;
+        if (is_feature_set(supported_features, VIRTIO_F_INDIRECT_DESC))
+            negotiated |= VIRTIO_F_INDIRECT_DESC;
+        if (is_feature_set(supported_features, VIRTIO_F_EVENT_IDX))
+            negotiated |= VIRTIO_F_EVENT_IDX;
+        return negotiated;
+    }));
+    m_is_read_only = is_feature_accepted(VIRTIO_BLK_F_RO);
+    m_uses_indirect_descriptors = is_feature_accepted(VIRTIO_F_INDIRECT_DESC);
+
+    u16 queue_count = 1;
+    transport_entity().read_config_atomic([&]() {
+        m_capacity_in_sectors = transport_entity().config_read32(*cfg, 0x0) | (static_cast<u64>(transport_entity().config_read32(*cfg, 0x4)) << 32);
+        if (is_feature_accepted(VIRTIO_BLK_F_BLK_SIZE))
+            m_block_size = transport_entity().config_read32(*cfg, 0x14);
+        if (is_feature_accepted(VIRTIO_BLK_F_MQ))
+            queue_count = transport_entity().config_read16(*cfg, 0x22);
+    });
+
+    if (m_block_size < 512 || m_block_size > PAGE_SIZE || !is_power_of_two(m_block_size)) {
+        dmesgln("{}: Unsupported block size {}, using 512 bytes instead", class_name(), m_block_size);
+        m_block_size = 512;
+    }
+
+    // There's no point in having more queues than processors, as every processor only submits to its own queue.
+    queue_count = clamp<u16>(queue_count, 1, Processor::count());
+    TRY(setup_queues(queue_count));
+    TRY(allocate_request_slots());
+    finish_init();
+
+    dmesgln("{}: {} sectors, {} bytes per block, {} queues, {} request slots{}{}", class_name(), m_capacity_in_sectors, m_block_size, queue_count, m_request_slots.size(),
+        m_uses_indirect_descriptors ? ", indirect descriptors"sv : ""sv, m_is_read_only ? ", read-only"sv : ""sv);
+
+    m_device = TRY(VirtIOBlockDevice::try_create(*this, m_block_size, m_capacity_in_sectors * 512 / m_block_size));
+    return {};
+}
+
+UNMAP_AFTER_INIT ErrorOr<void> VirtIOBlockController::allocate_request_slots()
+{
+    // Without indirect descriptors, every request takes a descriptor for its header, one for every data page
+    // and one for its status.
+    size_t descriptors_per_request = m_uses_indirect_descriptors ? 1 : data_pages_per_request + 2;
+    for (u16 queue_index = 0; queue_index < queue_count(); queue_index++) {
+        size_t slot_count = min(get_queue(queue_index).size() / descriptors_per_request, max_slots_per_queue);
+        if (slot_count == 0)
+            return Error::from_errno(ENOSPC);
+        for (size_t index = 0; index < slot_count; index++) {
+            RequestSlot slot;
+            slot.queue_index = queue_index;
+            slot.control_region = TRY(MM.allocate_dma_buffer_page("VirtIO Block Request"sv, Memory::Region::Access::ReadWrite, slot.control_page));
+            TRY(m_request_slots.try_append(move(slot)));
+        }
+    }
+    return BlockRequestSlots::allocate_request_slots(m_request_slots.size(), "VirtIO Block Data"sv);
+}
+
+LockRefPtr<StorageDevice> VirtIOBlockController::device(u32 index) const
+{
+    VERIFY(index == 0);
+    return m_device;
+}
+
+ErrorOr<void> VirtIOBlockController::reset()
+{
+    return Error::from_errno(ENOTIMPL);
+}
+
+ErrorOr<void> VirtIOBlockController::shutdown()
+{
+    return Error::from_errno(ENOTIMPL);
+}
+
+void VirtIOBlockController::complete_current_request(AsyncDeviceRequest::RequestResult)
+{
+    VERIFY_NOT_REACHED();
+}
+
+ErrorOr<void> VirtIOBlockController::handle_device_config_change()
+{
+    // FIXME: The capacity changes when the disk is resized on the host, which we don't support yet.
+    dbgln("{}: Ignoring device configuration change", class_name());
+    return {};
+}
+
+u32 VirtIOBlockController::max_blocks_per_request() const
+{
+    return data_pages_per_request * PAGE_SIZE / m_block_size;
+}
+
+void VirtIOBlockController::start_request(Badge<VirtIOBlockDevice>, AsyncBlockDeviceRequest& request)
+{
+    if (m_is_read_only && request.request_type() == AsyncBlockDeviceRequest::Write) {
+        request.complete(AsyncDeviceRequest::Failure);
+        return;
+    }
+    start_request_in_slot(request);
+}
+
+bool VirtIOBlockController::is_preferred_request_slot(size_t slot_index) const
+{
+    // Prefer a slot that belongs to this processor's queue, but take any if they're all in use.
+    return m_request_slots[slot_index].queue_index == Processor::current_id() % queue_count();
+}
+
+bool VirtIOBlockController::submit_request_slot(size_t slot_index)
+{
+    auto& slot = m_request_slots[slot_index];
+    auto& request = request_in_slot(slot_index);
+    auto const& data_pages = request_slot_buffer_pages(slot_index);
+    size_t transfer_size = request.block_count() * request.block_size();
+    bool is_write = request.request_type() == AsyncBlockDeviceRequest::Write;
+
+    auto& header = *reinterpret_cast<RequestHeader*>(slot.control_region->vaddr().as_ptr());
+    header.type = is_write ? VIRTIO_BLK_T_OUT : VIRTIO_BLK_T_IN;
+    header.reserved = 0;
+    // NOTE: Sectors are always 512 bytes, no matter what the block size is.
+    header.sector = request.block_index() * (m_block_size / 512);
+    *slot.control_region->vaddr().offset(status_offset).as_ptr() = 0xff;
+
+    auto control_address = slot.control_page->paddr();
+    auto data_buffer_type = is_write ? VirtIO::BufferType::DeviceReadable : VirtIO::BufferType::DeviceWritable;
+    size_t data_page_count = ceil_div(transfer_size, static_cast<size_t>(PAGE_SIZE));
+
+    auto& queue = get_queue(slot.queue_index);
+    SpinlockLocker lock(queue.lock());
+    VirtIO::QueueChain chain(queue);
+    if (m_uses_indirect_descriptors) {
+        auto* table = reinterpret_cast<VirtIO::Queue::QueueDescriptor*>(slot.control_region->vaddr().offset(indirect_table_offset).as_ptr());
+        size_t descriptor_count = 0;
+        auto add_descriptor = [&](PhysicalAddress address, size_t length, VirtIO::BufferType buffer_type) {
+            table[descriptor_count] = { address.get(), static_cast<u32>(length), static_cast<u16>(buffer_type), static_cast<u16>(descriptor_count + 1) };
+            if (descriptor_count > 0)
+                table[descriptor_count - 1].flags |= VIRTQ_DESC_F_NEXT;
+            descriptor_count++;
+        };
+        add_descriptor(control_address, sizeof(RequestHeader), VirtIO::BufferType::DeviceReadable);
+        for (size_t page_index = 0; page_index < data_page_count; page_index++)
+            add_descriptor(data_pages[page_index]->paddr(), min(transfer_size - page_index * PAGE_SIZE, PAGE_SIZE), data_buffer_type);
+        add_descriptor(control_address.offset(status_offset), 1, VirtIO::BufferType::DeviceWritable);
+        VERIFY(indirect_table_offset + descriptor_count * sizeof(VirtIO::Queue::QueueDescriptor) <= PAGE_SIZE);
+        if (!chain.add_indirect_table_to_chain(control_address.offset(indirect_table_offset), descriptor_count))
+            return false;
+    } else {
+        bool did_add_all_buffers = chain.add_buffer_to_chain(control_address, sizeof(RequestHeader), VirtIO::BufferType::DeviceReadable);
+        for (size_t page_index = 0; did_add_all_buffers && page_index < data_page_count; page_index++)
+            did_add_all_buffers = chain.add_buffer_to_chain(data_pages[page_index]->paddr(), min(transfer_size - page_index * PAGE_SIZE, PAGE_SIZE), data_buffer_type);
+        if (did_add_all_buffers)
+            did_add_all_buffers = chain.add_buffer_to_chain(control_address.offset(status_offset), 1, VirtIO::BufferType::DeviceWritable);
+        if (!did_add_all_buffers) {
+            chain.release_buffer_slots_to_queue();
+            return false;
+        }
+    }
+
+    dbgln_if(VIRTIO_DEBUG, "{}: Submitting {} of {} blocks at {} in slot {} to queue {}", class_name(), is_write ? "write"sv : "read"sv, request.block_count(), request.block_index(), slot_index, slot.queue_index);
+    supply_chain_and_notify(slot.queue_index, chain);
+    return true;
+}
+
+void VirtIOBlockController::handle_queue_update(u16 queue_index)
+{
+    auto& queue = get_queue(queue_index);
+    Vector<size_t, max_slots_per_queue> finished_slots;
+
+    // NOTE: We don't need to hear about every single request that finishes while we're already looking at the
+    //       queue, so interrupts stay off until we've caught up with the device.
+    for (;;) {
+        queue.disable_interrupts();
+        {
+            SpinlockLocker lock(queue.lock());
+            size_t used;
+            for (auto chain = queue.pop_used_buffer_chain(used); !chain.is_empty(); chain = queue.pop_used_buffer_chain(used)) {
+                Optional<PhysicalAddress> first_buffer_address;
+                chain.for_each([&](PhysicalAddress address, size_t) {
+                    if (!first_buffer_address.has_value())
+                        first_buffer_address = address;
+                });
+                chain.release_buffer_slots_to_queue();
+
+                // Both the request header and the indirect descriptor table are in the slot's control page.
+                for (size_t index = 0; index < m_request_slots.size(); index++) {
+                    auto& slot = m_request_slots[index];
+                    if (slot.queue_index == queue_index && slot.control_page->paddr() == first_buffer_address->page_base()) {
+                        finished_slots.append(index);
+                        break;
+                    }
+                }
+            }
+        }
+        queue.enable_interrupts();
+        // The device might have used another buffer right before we turned interrupts back on.
+        if (!queue.new_data_available())
+            break;
+    }
+
+    for (auto slot_index : finished_slots)
+        finish_slot(slot_index);
+}
+
+void VirtIOBlockController::finish_slot(size_t slot_index)
+{
+    auto& slot = m_request_slots[slot_index];
+    u8 status = *slot.control_region->vaddr().offset(status_offset).as_ptr();
+    if (status != VIRTIO_BLK_S_OK)
+        dbgln("{}: Request at block {} failed with status {}", class_name(), request_in_slot(slot_index).block_index(), status);
+    finish_request_slot(slot_index, status == VIRTIO_BLK_S_OK ? AsyncDeviceRequest::Success : AsyncDeviceRequest::Failure);
+}
+
+}
@@ -0,0 +1,108 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <Kernel/Bus/PCI/Device.h>
+#include <Kernel/Bus/VirtIO/Device.h>
+#include <Kernel/Devices/Storage/BlockRequestSlots.h>
+#include <Kernel/Devices/Storage/StorageController.h>
+#include <Kernel/Devices/Storage/VirtIO/VirtIOBlockDevice.h>
+#include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
+
+namespace Kernel {
+
+#define VIRTIO_BLK_F_RO (1 << 5)
+#define VIRTIO_BLK_F_BLK_SIZE (1 << 6)
+#define VIRTIO_BLK_F_MQ (1 << 12)
+
+#define VIRTIO_BLK_T_IN 0
+#define VIRTIO_BLK_T_OUT 1
+
+#define VIRTIO_BLK_S_OK 0
+#define VIRTIO_BLK_S_IOERR 1
+#define VIRTIO_BLK_S_UNSUPP 2
+
+// A virtio-blk device is a single disk, so this "controller" only ever has one device attached.
+//
+// Requests are spread over up to one virtqueue per processor, so processors don't have to fight over
+// a single queue. Every request goes through a request slot, which the device sees through a single
+// indirect descriptor (if supported), so that a queue with N descriptors can hold N requests instead
+// of N / 3.
+class VirtIOBlockController final
+    : public StorageController
+    , public VirtIO::Device
+    , public BlockRequestSlots {
+public:
+    static ErrorOr<NonnullRefPtr<VirtIOBlockController>> initialize(PCI::DeviceIdentifier const&);
+    virtual ~VirtIOBlockController() override = default;
+
+    // ^StorageController
+    virtual LockRefPtr<StorageDevice> device(u32 index) const override;
+    virtual size_t devices_count() const override { return m_device ? 1 : 0; }
+
+    void start_request(Badge<VirtIOBlockDevice>, AsyncBlockDeviceRequest&);
+    size_t max_requests_in_flight() const { return request_slot_count(); }
+    u32 max_blocks_per_request() const;
+
+protected:
+    // ^StorageController
+    virtual ErrorOr<void> reset() override;
+    virtual ErrorOr<void> shutdown() override;
+    virtual void complete_current_request(AsyncDeviceRequest::RequestResult) override;
+
+private:
+    static constexpr size_t data_pages_per_request = 4;
+    static constexpr size_t max_slots_per_queue = 32;
+
+    struct [[gnu::packed]] RequestHeader {
+        u32 type;
+        u32 reserved;
+        u64 sector;
+    };
+
+    // Where things live within a request slot's control page.
+    static constexpr size_t status_offset = sizeof(RequestHeader);
+    static constexpr size_t indirect_table_offset = 64;
+
+    // What we need for a request slot on top of its data buffer.
+    struct RequestSlot {
+        u16 queue_index { 0 };
+        // Holds the request header, the status byte and the indirect descriptor table.
+        RefPtr<Memory::PhysicalPage> control_page;
+        OwnPtr<Memory::Region> control_region;
+    };
+
+    VirtIOBlockController(NonnullOwnPtr<VirtIO::TransportEntity>, u32 hardware_relative_controller_id);
+
+    // ^VirtIO::Device
+    virtual ErrorOr<void> initialize_virtio_resources() override;
+    virtual StringView class_name() const override { return "VirtIOBlockController"sv; }
+    virtual ErrorOr<void> handle_device_config_change() override;
+    virtual void handle_queue_update(u16 queue_index) override;
+
+    // ^BlockRequestSlots
+    virtual StringView request_slots_owner_name() const override { return class_name(); }
+    virtual bool is_preferred_request_slot(size_t slot_index) const override;
+    virtual bool submit_request_slot(size_t slot_index) override;
+
+    ErrorOr<void> allocate_request_slots();
+    void finish_slot(size_t slot_index);
+
+    LockRefPtr<VirtIOBlockDevice> m_device;
+
+    u64 m_capacity_in_sectors { 0 };
+    u32 m_block_size { 512 };
+    bool m_is_read_only { false };
+    bool m_uses_indirect_descriptors { false };
+
+    Vector<RequestSlot> m_request_slots;
+};
+
+}
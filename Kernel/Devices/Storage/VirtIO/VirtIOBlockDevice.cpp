@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Devices/DeviceManagement.h>
+#include <Kernel/Devices/Storage/VirtIO/VirtIOBlockController.h>
+#include <Kernel/Devices/Storage/VirtIO/VirtIOBlockDevice.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT ErrorOr<NonnullLockRefPtr<VirtIOBlockDevice>> VirtIOBlockDevice::try_create(VirtIOBlockController& controller, size_t block_size, u64 max_addressable_block)
+{
+    return TRY(DeviceManagement::try_create_device<VirtIOBlockDevice>(StorageDevice::LUNAddress { controller.controller_id(), 0, 0 }, controller.hardware_relative_controller_id(), controller, block_size, max_addressable_block));
+}
+
+UNMAP_AFTER_INIT VirtIOBlockDevice::VirtIOBlockDevice(LUNAddress logical_unit_number_address, u32 hardware_relative_controller_id, VirtIOBlockController& controller, size_t block_size, u64 max_addressable_block)
+    : StorageDevice(logical_unit_number_address, hardware_relative_controller_id, block_size, max_addressable_block)
+    , m_controller(controller)
+{
+}
+
+void VirtIOBlockDevice::start_request(AsyncBlockDeviceRequest& request)
+{
+    m_controller.start_request({}, request);
+}
+
+u32 VirtIOBlockDevice::max_blocks_per_request() const
+{
+    return m_controller.max_blocks_per_request();
+}
+
+size_t VirtIOBlockDevice::max_requests_in_flight() const
+{
+    return m_controller.max_requests_in_flight();
+}
+
+}
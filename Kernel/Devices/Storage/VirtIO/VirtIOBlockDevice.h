@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <Kernel/Devices/Storage/StorageDevice.h>
+#include <Kernel/Library/LockRefPtr.h>
+#include <Kernel/Library/LockWeakPtr.h>
+
+namespace Kernel {
+
+class VirtIOBlockController;
+class VirtIOBlockDevice final : public StorageDevice {
+    friend class DeviceManagement;
+
+public:
+    static ErrorOr<NonnullLockRefPtr<VirtIOBlockDevice>> try_create(VirtIOBlockController&, size_t block_size, u64 max_addressable_block);
+
+    // ^StorageDevice
+    virtual CommandSet command_set() const override { return CommandSet::VirtIO; }
+
+    // ^BlockDevice
+    virtual void start_request(AsyncBlockDeviceRequest&) override;
+    virtual u32 max_blocks_per_request() const override;
+
+protected:
+    // ^Device
+    virtual size_t max_requests_in_flight() const override;
+
+private:
+    VirtIOBlockDevice(LUNAddress, u32 hardware_relative_controller_id, VirtIOBlockController&, size_t block_size, u64 max_addressable_block);
+
+    // NOTE: The controller owns us, so it outlives us.
+    VirtIOBlockController& m_controller;
+};
+
+}
@@ -6,6 +6,7 @@
 
 #include <AK/IntrusiveList.h>
 #include <Kernel/Debug.h>
+#include <Kernel/Devices/BlockDevice.h>
 #include <Kernel/FileSystem/BlockBasedFileSystem.h>
 #include <Kernel/Tasks/Process.h>
 
@@ -199,10 +200,19 @@ ErrorOr<void> BlockBasedFileSystem::raw_write(BlockIndex index, UserOrKernelBuff
 
 ErrorOr<void> BlockBasedFileSystem::raw_read_blocks(BlockIndex index, size_t count, UserOrKernelBuffer& buffer)
 {
+    // Ask for all remaining blocks at once, so the device gets to see requests that are as large as it allows.
+    // Devices cap the size of a single read, so we may have to ask several times.
     auto current = buffer;
-    for (auto block = index.value(); block < (index.value() + count); block++) {
-        TRY(raw_read(BlockIndex { block }, current));
-        current = current.offset(device_block_size());
+    u64 offset = index.value() * m_device_block_size;
+    size_t remaining = count * m_device_block_size;
+    while (remaining > 0) {
+        auto nread = TRY(file_description().read(current, offset, remaining));
+        if (nread == 0)
+            return EIO;
+        VERIFY(nread <= remaining);
+        current = current.offset(nread);
+        offset += nread;
+        remaining -= nread;
     }
     return {};
 }
@@ -288,18 +298,79 @@ void BlockBasedFileSystem::flush_specific_block_if_needed(BlockIndex index)
     });
 }
 
+size_t BlockBasedFileSystem::write_back_dirty_entries(DiskCache& cache)
+{
+    size_t count = 0;
+    cache.for_each_dirty_entry([&](CacheEntry& entry) {
+        auto base_offset = entry.block_index.value() * logical_block_size();
+        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
+        [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, logical_block_size());
+        ++count;
+    });
+    return count;
+}
+
+size_t BlockBasedFileSystem::write_back_dirty_entries_in_batches(BlockDevice& device, DiskCache& cache)
+{
+    // NOTE: We queue up a whole batch of blocks on the plugged device before waiting for any of them,
+    //       so that the device gets to merge adjacent blocks into larger requests.
+    static constexpr size_t max_requests_per_batch = 256;
+
+    Vector<NonnullLockRefPtr<AsyncBlockDeviceRequest>> requests;
+    if (requests.try_ensure_capacity(max_requests_per_batch).is_error())
+        return write_back_dirty_entries(cache);
+
+    auto wait_for_batch = [&] {
+        device.unplug();
+        for (auto& request : requests) {
+            // The cache entry must not change while it's being written, so keep waiting until the request is done.
+            for (;;) {
+                auto result = request->wait().request_result();
+                if (result == AsyncDeviceRequest::Pending || result == AsyncDeviceRequest::Started)
+                    continue;
+                if (result != AsyncDeviceRequest::Success)
+                    dbgln("{}: Failed to write back block {}", class_name(), request->block_index());
+                break;
+            }
+        }
+        requests.clear_with_capacity();
+    };
+
+    auto blocks_per_entry = logical_block_size() / device.block_size();
+    size_t count = 0;
+    device.plug();
+    cache.for_each_dirty_entry([&](CacheEntry& entry) {
+        auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
+        auto request_or_error = device.try_make_request<AsyncBlockDeviceRequest>(AsyncBlockDeviceRequest::Write,
+            entry.block_index.value() * blocks_per_entry, blocks_per_entry, entry_data_buffer, logical_block_size());
+        if (request_or_error.is_error()) {
+            // Writing synchronously still works while the device is plugged, as waiting on a queued request starts it.
+            [[maybe_unused]] auto rc = file_description().write(entry.block_index.value() * logical_block_size(), entry_data_buffer, logical_block_size());
+        } else {
+            requests.unchecked_append(request_or_error.release_value());
+        }
+        ++count;
+
+        if (requests.size() == max_requests_per_batch) {
+            wait_for_batch();
+            device.plug();
+        }
+    });
+    wait_for_batch();
+    return count;
+}
+
 void BlockBasedFileSystem::flush_writes_impl()
 {
     size_t count = 0;
     m_cache.with_exclusive([&](auto& cache) {
         if (!cache->is_dirty())
             return;
-        cache->for_each_dirty_entry([&](CacheEntry& entry) {
-            auto base_offset = entry.block_index.value() * logical_block_size();
-            auto entry_data_buffer = UserOrKernelBuffer::for_kernel_buffer(entry.data);
-            [[maybe_unused]] auto rc = file_description().write(base_offset, entry_data_buffer, logical_block_size());
-            ++count;
-        });
+        auto& file = file_description().file();
+        if (file.is_block_device() && logical_block_size() % static_cast<BlockDevice&>(file).block_size() == 0)
+            count = write_back_dirty_entries_in_batches(static_cast<BlockDevice&>(file), *cache);
+        else
+            count = write_back_dirty_entries(*cache);
         cache->mark_all_clean();
         dbgln("{}: Flushed {} blocks to disk", class_name(), count);
     });
@@ -45,6 +45,8 @@ protected:
 
 private:
     void flush_specific_block_if_needed(BlockIndex index);
+    size_t write_back_dirty_entries(DiskCache&);
+    size_t write_back_dirty_entries_in_batches(BlockDevice&, DiskCache&);
 
     mutable MutexProtected<OwnPtr<DiskCache>> m_cache;
 };
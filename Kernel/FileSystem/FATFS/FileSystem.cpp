@@ -68,7 +68,16 @@ ErrorOr<void> FATFS::initialize_while_locked()
     u32 root_directory_sectors = ((boot_record()->root_directory_entry_count * sizeof(FATEntry)) + (m_device_block_size - 1)) / m_device_block_size;
     m_first_data_sector = boot_record()->reserved_sector_count + (boot_record()->fat_count * boot_record()->sectors_per_fat) + root_directory_sectors;
 
+    // The number of data clusters is limited both by the size of the volume and by the size of the FAT.
+    u32 entries_per_fat = boot_record()->sectors_per_fat * (m_device_block_size / sizeof(u32));
+    if (boot_record()->sectors_per_cluster == 0 || boot_record()->sector_count <= m_first_data_sector || entries_per_fat <= first_data_cluster) {
+        dbgln("FATFS: Invalid volume geometry");
+        return EINVAL;
+    }
+    m_data_cluster_count = min((boot_record()->sector_count - m_first_data_sector) / boot_record()->sectors_per_cluster, entries_per_fat - first_data_cluster);
+
     TRY(BlockBasedFileSystem::initialize_while_locked());
+    TRY(build_free_cluster_bitmap());
 
     FATEntry root_entry {};
 
@@ -91,6 +100,88 @@ BlockBasedFileSystem::BlockIndex FATFS::first_block_of_cluster(u32 cluster) cons
     return ((cluster - first_data_cluster) * boot_record()->sectors_per_cluster) + m_first_data_sector;
 }
 
+ErrorOr<Vector<FATFS::ClusterRun>> FATFS::compute_cluster_chain(u32 first_cluster)
+{
+    dbgln_if(FAT_DEBUG, "FATFS: Computing cluster chain starting at cluster {}", first_cluster);
+
+    Vector<ClusterRun> runs;
+    if (first_cluster == free_cluster)
+        return runs;
+
+    auto fat_sector = TRY(KBuffer::try_create_with_size("FATFS: FAT read buffer"sv, m_device_block_size));
+    auto fat_sector_buffer = UserOrKernelBuffer::for_kernel_buffer(fat_sector->data());
+    Optional<u32> loaded_fat_sector_index;
+
+    u32 cluster = first_cluster;
+    // A chain can't be longer than the number of clusters there are, so anything longer has to contain a loop.
+    for (u32 chain_length = 0; cluster < FATInode::no_more_clusters; ++chain_length) {
+        if (!is_data_cluster(cluster) || chain_length >= m_data_cluster_count) {
+            dbgln("FATFS: Cluster chain starting at cluster {} is corrupted", first_cluster);
+            return EIO;
+        }
+
+        if (!runs.is_empty() && runs.last().first_cluster + runs.last().cluster_count == cluster)
+            ++runs.last().cluster_count;
+        else
+            TRY(runs.try_append({ cluster, 1 }));
+
+        // Consecutive clusters usually have their FAT entries in the same sector, so only read it when it changes.
+        u32 fat_offset = cluster * sizeof(u32);
+        u32 fat_sector_index = boot_record()->reserved_sector_count + (fat_offset / m_device_block_size);
+        u32 entry_offset = fat_offset % m_device_block_size;
+        if (!loaded_fat_sector_index.has_value() || loaded_fat_sector_index.value() != fat_sector_index) {
+            TRY(raw_read(fat_sector_index, fat_sector_buffer));
+            loaded_fat_sector_index = fat_sector_index;
+        }
+
+        cluster = *reinterpret_cast<u32*>(&fat_sector->data()[entry_offset]);
+        cluster &= FATInode::cluster_number_mask;
+    }
+
+    dbgln_if(FAT_DEBUG, "FATFS: Cluster chain starting at cluster {} consists of {} runs", first_cluster, runs.size());
+    return runs;
+}
+
+ErrorOr<void> FATFS::build_free_cluster_bitmap()
+{
+    m_free_cluster_bitmap = TRY(Bitmap::create(m_data_cluster_count, false));
+    m_free_cluster_count = 0;
+
+    size_t entries_per_sector = m_device_block_size / sizeof(u32);
+    size_t fat_sector_count = ceil_div((first_data_cluster + m_data_cluster_count) * sizeof(u32), m_device_block_size);
+    auto fat_buffer = TRY(KBuffer::try_create_with_size("FATFS: FAT scan buffer"sv, max_blocks_per_transfer * m_device_block_size));
+
+    u32 cluster = 0;
+    for (size_t sector = 0; sector < fat_sector_count; sector += max_blocks_per_transfer) {
+        size_t sectors_to_read = min(max_blocks_per_transfer, fat_sector_count - sector);
+        auto fat_buffer_buffer = UserOrKernelBuffer::for_kernel_buffer(fat_buffer->data());
+        TRY(raw_read_blocks(boot_record()->reserved_sector_count + sector, sectors_to_read, fat_buffer_buffer));
+
+        auto const* entries = reinterpret_cast<u32 const*>(fat_buffer->data());
+        for (size_t i = 0; i < sectors_to_read * entries_per_sector; ++i, ++cluster) {
+            if (!is_data_cluster(cluster))
+                continue;
+            if ((entries[i] & FATInode::cluster_number_mask) == free_cluster) {
+                m_free_cluster_bitmap.set(cluster - first_data_cluster, true);
+                ++m_free_cluster_count;
+            }
+        }
+    }
+
+    dbgln_if(FAT_DEBUG, "FATFS: {} of {} clusters are free", m_free_cluster_count, m_data_cluster_count);
+    return {};
+}
+
+unsigned FATFS::total_block_count() const
+{
+    return boot_record()->sector_count;
+}
+
+unsigned FATFS::free_block_count() const
+{
+    return m_free_cluster_count * boot_record()->sectors_per_cluster;
+}
+
 u8 FATFS::internal_file_type_to_directory_entry_type(DirectoryEntryView const& entry) const
 {
     FATAttributes attrib = static_cast<FATAttributes>(entry.file_type);
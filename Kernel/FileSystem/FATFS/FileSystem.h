@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Bitmap.h>
 #include <AK/OwnPtr.h>
 #include <AK/RefPtr.h>
 #include <AK/Types.h>
@@ -28,6 +29,9 @@ public:
     virtual Inode& root_inode() override;
     virtual u8 internal_file_type_to_directory_entry_type(DirectoryEntryView const& entry) const override;
 
+    virtual unsigned total_block_count() const override;
+    virtual unsigned free_block_count() const override;
+
 private:
     virtual ErrorOr<void> initialize_while_locked() override;
     virtual bool is_initialized_while_locked() override;
@@ -41,14 +45,34 @@ private:
     static constexpr u8 signature_2 = 0x29;
 
     static constexpr u32 first_data_cluster = 2;
+    static constexpr u32 free_cluster = 0;
+
+    // Contiguous reads are split into transfers of at most this many blocks.
+    static constexpr size_t max_blocks_per_transfer = 128;
+
+    // A run of clusters that directly follow each other on disk.
+    struct ClusterRun {
+        u32 first_cluster { 0 };
+        u32 cluster_count { 0 };
+    };
 
     FAT32BootRecord const* boot_record() const { return reinterpret_cast<FAT32BootRecord const*>(m_boot_record->data()); }
 
     BlockBasedFileSystem::BlockIndex first_block_of_cluster(u32 cluster) const;
+    size_t cluster_size() const { return boot_record()->sectors_per_cluster * m_device_block_size; }
+    bool is_data_cluster(u32 cluster) const { return cluster >= first_data_cluster && cluster - first_data_cluster < m_data_cluster_count; }
+
+    ErrorOr<Vector<ClusterRun>> compute_cluster_chain(u32 first_cluster);
+    ErrorOr<void> build_free_cluster_bitmap();
 
     OwnPtr<KBuffer> m_boot_record {};
     RefPtr<FATInode> m_root_inode;
     u32 m_first_data_sector { 0 };
+    u32 m_data_cluster_count { 0 };
+
+    // A set bit means that the cluster (counting from first_data_cluster) is free.
+    Bitmap m_free_cluster_bitmap;
+    u32 m_free_cluster_count { 0 };
 };
 
 }
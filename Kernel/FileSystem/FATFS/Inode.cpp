@@ -7,7 +7,6 @@
 #include <AK/Time.h>
 #include <Kernel/Debug.h>
 #include <Kernel/FileSystem/FATFS/Inode.h>
-#include <Kernel/Library/KBufferBuilder.h>
 
 namespace Kernel {
 
@@ -42,64 +41,88 @@ FATInode::FATInode(FATFS& fs, FATEntry entry, NonnullOwnPtr<KString> filename)
     };
 }
 
-ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> FATInode::compute_block_list()
+ErrorOr<void> FATInode::ensure_cluster_chain()
 {
     VERIFY(m_inode_lock.is_locked());
 
-    dbgln_if(FAT_DEBUG, "FATFS: computing block list for inode {}", index());
+    MutexLocker locker(m_cluster_chain_lock);
+    if (m_has_cluster_runs)
+        return {};
 
-    u32 cluster = first_cluster();
+    auto cluster = first_cluster();
+    // Directories refer to the root directory as cluster 0 in their ".." entry.
+    if (cluster == FATFS::free_cluster && has_flag(m_entry.attributes, FATAttributes::Directory))
+        cluster = fs().boot_record()->root_directory_cluster;
 
-    Vector<BlockBasedFileSystem::BlockIndex> block_list;
-
-    auto fat_sector = TRY(KBuffer::try_create_with_size("FATFS: FAT read buffer"sv, fs().m_device_block_size));
-    auto fat_sector_buffer = UserOrKernelBuffer::for_kernel_buffer(fat_sector->data());
-
-    while (cluster < no_more_clusters) {
-        dbgln_if(FAT_DEBUG, "FATFS: Appending cluster {} to inode {}'s cluster chain", cluster, index());
-
-        BlockBasedFileSystem::BlockIndex first_block = fs().first_block_of_cluster(cluster);
-        for (u8 i = 0; i < fs().boot_record()->sectors_per_cluster; i++)
-            block_list.append(BlockBasedFileSystem::BlockIndex { first_block.value() + i });
-
-        u32 fat_offset = cluster * sizeof(u32);
-        u32 fat_sector_index = fs().boot_record()->reserved_sector_count + (fat_offset / fs().m_device_block_size);
-        u32 entry_offset = fat_offset % fs().m_device_block_size;
+    m_cluster_runs = TRY(fs().compute_cluster_chain(cluster));
+    m_has_cluster_runs = true;
+    return {};
+}
 
-        TRY(fs().raw_read(fat_sector_index, fat_sector_buffer));
+ErrorOr<size_t> FATInode::read_from_cluster_chain(u64 offset, size_t size, UserOrKernelBuffer& buffer)
+{
+    VERIFY(m_inode_lock.is_locked());
+    TRY(ensure_cluster_chain());
+
+    size_t block_size = fs().m_device_block_size;
+    size_t cluster_size = fs().cluster_size();
+    size_t max_transfer_blocks = min(FATFS::max_blocks_per_transfer, ceil_div(static_cast<size_t>(offset % block_size) + size, block_size));
+    OwnPtr<KBuffer> transfer_buffer;
+
+    size_t nread = 0;
+    u64 run_offset = 0;
+    for (auto const& run : m_cluster_runs) {
+        if (nread == size)
+            break;
+        u64 run_size = static_cast<u64>(run.cluster_count) * cluster_size;
+        if (offset + nread >= run_offset + run_size) {
+            run_offset += run_size;
+            continue;
+        }
 
-        cluster = *reinterpret_cast<u32*>(&fat_sector->data()[entry_offset]);
-        cluster &= cluster_number_mask;
+        // Everything up to the end of this run is contiguous on disk, so it can be read in as few transfers as possible.
+        while (nread < size && offset + nread < run_offset + run_size) {
+            u64 offset_in_run = offset + nread - run_offset;
+            size_t offset_in_block = offset_in_run % block_size;
+            size_t to_read = min<u64>(min(size - nread, max_transfer_blocks * block_size - offset_in_block), run_size - offset_in_run);
+            auto first_block = fs().first_block_of_cluster(run.first_cluster).value() + offset_in_run / block_size;
+            auto block_count = ceil_div(offset_in_block + to_read, block_size);
+
+            dbgln_if(FAT_DEBUG, "FATFS: Reading {} blocks starting at block {} for inode {}", block_count, first_block, index());
+
+            if (!transfer_buffer)
+                transfer_buffer = TRY(KBuffer::try_create_with_size("FATFS: Transfer buffer"sv, max_transfer_blocks * block_size));
+            auto transfer_buffer_buffer = UserOrKernelBuffer::for_kernel_buffer(transfer_buffer->data());
+            TRY(fs().raw_read_blocks(first_block, block_count, transfer_buffer_buffer));
+            TRY(buffer.write(transfer_buffer->data() + offset_in_block, nread, to_read));
+            nread += to_read;
+        }
+        run_offset += run_size;
     }
 
-    return block_list;
+    return nread;
 }
 
 ErrorOr<NonnullOwnPtr<KBuffer>> FATInode::read_block_list()
 {
     VERIFY(m_inode_lock.is_locked());
 
-    dbgln_if(FAT_DEBUG, "FATFS: reading block list for inode {} ({} blocks)", index(), m_block_list.size());
+    TRY(ensure_cluster_chain());
 
-    if (m_block_list.is_empty())
-        m_block_list = TRY(compute_block_list());
+    size_t cluster_count = 0;
+    for (auto const& run : m_cluster_runs)
+        cluster_count += run.cluster_count;
 
-    auto builder = TRY(KBufferBuilder::try_create());
+    dbgln_if(FAT_DEBUG, "FATFS: reading block list for inode {} ({} clusters in {} runs)", index(), cluster_count, m_cluster_runs.size());
 
-    u8 buffer[512];
-    VERIFY(fs().m_device_block_size <= sizeof(buffer));
-    auto buf = UserOrKernelBuffer::for_kernel_buffer(buffer);
+    if (cluster_count == 0)
+        return EIO;
 
-    for (BlockBasedFileSystem::BlockIndex block : m_block_list) {
-        dbgln_if(FAT_DEBUG, "FATFS: reading block: {}", block);
-        TRY(fs().raw_read(block, buf));
-        TRY(builder.append((char const*)buffer, fs().m_device_block_size));
-    }
-
-    auto blocks = builder.build();
-    if (!blocks)
-        return ENOMEM;
-    return blocks.release_nonnull();
+    auto blocks = TRY(KBuffer::try_create_with_size("FATFS: Block list"sv, cluster_count * fs().cluster_size()));
+    auto blocks_buffer = UserOrKernelBuffer::for_kernel_buffer(blocks->data());
+    auto nread = TRY(read_from_cluster_chain(0, blocks->size(), blocks_buffer));
+    VERIFY(nread == blocks->size());
+    return blocks;
 }
 
 ErrorOr<void> FATInode::replace_child(StringView, Inode&)
@@ -205,11 +228,8 @@ ErrorOr<size_t> FATInode::read_bytes_locked(off_t offset, size_t size, UserOrKer
     if (offset >= m_metadata.size)
         return 0;
 
-    // FIXME: Read only the needed blocks instead of the whole file
-    auto blocks = TRY(const_cast<FATInode&>(*this).read_block_list());
-    TRY(buffer.write(blocks->data() + offset, min(size, m_block_list.size() * fs().m_device_block_size - offset)));
-
-    return min(size, m_block_list.size() * fs().m_device_block_size - offset);
+    size = min<u64>(size, m_metadata.size - offset);
+    return const_cast<FATInode&>(*this).read_from_cluster_chain(offset, size, buffer);
 }
 
 InodeMetadata FATInode::metadata() const
@@ -45,7 +45,8 @@ private:
     static ErrorOr<NonnullOwnPtr<KString>> compute_filename(FATEntry&, Vector<FATLongFileNameEntry> const& = {});
     static StringView byte_terminated_string(StringView, u8);
 
-    ErrorOr<Vector<BlockBasedFileSystem::BlockIndex>> compute_block_list();
+    ErrorOr<void> ensure_cluster_chain();
+    ErrorOr<size_t> read_from_cluster_chain(u64 offset, size_t size, UserOrKernelBuffer&);
     ErrorOr<NonnullOwnPtr<KBuffer>> read_block_list();
     ErrorOr<RefPtr<FATInode>> traverse(Function<ErrorOr<bool>(RefPtr<FATInode>)> callback);
     u32 first_cluster() const;
@@ -65,7 +66,11 @@ private:
     virtual ErrorOr<void> chown(UserID, GroupID) override;
     virtual ErrorOr<void> flush_metadata() override;
 
-    Vector<BlockBasedFileSystem::BlockIndex> m_block_list;
+    // The cluster chain is only looked up once, and kept around as a list of contiguous runs.
+    // Reads only hold the inode lock in shared mode, so this has a lock of its own.
+    Mutex m_cluster_chain_lock { "FATInode cluster chain"sv };
+    Vector<FATFS::ClusterRun> m_cluster_runs;
+    bool m_has_cluster_runs { false };
     FATEntry m_entry;
     NonnullOwnPtr<KString> m_filename;
     InodeMetadata m_metadata;
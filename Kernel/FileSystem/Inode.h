@@ -93,6 +93,12 @@ public:
     ErrorOr<void> set_shared_vmobject(Memory::SharedInodeVMObject&);
     LockRefPtr<Memory::SharedInodeVMObject> shared_vmobject() const;
 
+    // Inodes that keep their contents in physical pages can hand those pages to their shared VMObject
+    // directly, so shared mappings don't need a copy and never have to be synced back.
+    // A null page means that the page lies past the end of the file, and faulting on it raises SIGBUS.
+    virtual bool shares_pages_with_vmobject() const { return false; }
+    virtual ErrorOr<RefPtr<Memory::PhysicalPage>> page_for_shared_vmobject(size_t) { return RefPtr<Memory::PhysicalPage> {}; }
+
     static void sync_all();
     void sync();
 
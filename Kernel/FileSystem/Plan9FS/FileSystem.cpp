@@ -104,10 +104,11 @@ bool Plan9FS::Blocker::unblock(u16 tag)
         SpinlockLocker lock(m_lock);
         if (m_did_unblock)
             return false;
-        m_did_unblock = true;
-
+        // Other requests may be in flight, so this might be somebody else's reply.
         if (m_completion->tag != tag)
             return false;
+        m_did_unblock = true;
+
         if (!m_completion->result.is_error())
             m_message = move(*m_completion->message);
     }
@@ -184,7 +185,46 @@ bool Plan9FS::is_complete(ReceiveCompletion const& completion)
     return true;
 }
 
-ErrorOr<void> Plan9FS::post_message(Plan9FSMessage& message, LockRefPtr<ReceiveCompletion> completion)
+ErrorOr<u16> Plan9FS::allocate_tag_while_locked()
+{
+    VERIFY(m_lock.is_locked());
+    // Tags are only reused once the reply to the request that had them has come in.
+    for (size_t attempt = 0; attempt < Plan9FSMessage::no_tag; ++attempt) {
+        u16 tag = m_next_tag;
+        m_next_tag = (m_next_tag + 1) % Plan9FSMessage::no_tag;
+        if (!m_completions.contains(tag))
+            return tag;
+    }
+    return EAGAIN;
+}
+
+ErrorOr<NonnullLockRefPtr<Plan9FS::ReceiveCompletion>> Plan9FS::post_message(Plan9FSMessage& message)
+{
+    LockRefPtr<ReceiveCompletion> completion;
+    {
+        // Save the completion record *before* we send the message. This
+        // ensures that it exists when the thread reads the response.
+        // Even if nobody is going to wait for the reply, the record has
+        // to stay around until it arrives, so that its tag isn't reused.
+        MutexLocker locker(m_lock);
+        u16 tag = Plan9FSMessage::no_tag;
+        if (message.type() != Plan9FSMessage::Type::Tversion)
+            tag = TRY(allocate_tag_while_locked());
+        completion = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) ReceiveCompletion(tag)));
+        TRY(m_completions.try_set(tag, *completion));
+        message.set_tag(tag);
+    }
+
+    auto send_result = send_message(message);
+    if (send_result.is_error()) {
+        MutexLocker locker(m_lock);
+        m_completions.remove(completion->tag);
+        return send_result.release_error();
+    }
+    return completion.release_nonnull();
+}
+
+ErrorOr<void> Plan9FS::send_message(Plan9FSMessage& message)
 {
     auto const& buffer = message.build();
     u8 const* data = buffer.data();
@@ -193,17 +233,6 @@ ErrorOr<void> Plan9FS::post_message(Plan9FSMessage& message, LockRefPtr<ReceiveC
 
     MutexLocker locker(m_send_lock);
 
-    if (completion) {
-        // Save the completion record *before* we send the message. This
-        // ensures that it exists when the thread reads the response
-        MutexLocker locker(m_lock);
-        auto tag = completion->tag;
-        m_completions.set(tag, completion.release_nonnull());
-        // TODO: What if there is a collision? Do we need to wait until
-        // the existing record with the tag completes before queueing
-        // this one?
-    }
-
     while (size > 0) {
         if (!description.can_write()) {
             auto unblock_flags = Thread::FileBlocker::BlockFlags::None;
@@ -274,15 +303,19 @@ ErrorOr<void> Plan9FS::read_and_dispatch_one_message()
 
 ErrorOr<void> Plan9FS::post_message_and_explicitly_ignore_reply(Plan9FSMessage& message)
 {
-    return post_message(message, {});
+    TRY(post_message(message));
+    return {};
 }
 
 ErrorOr<void> Plan9FS::post_message_and_wait_for_a_reply(Plan9FSMessage& message)
+{
+    auto completion = TRY(post_message(message));
+    return wait_for_reply(message, move(completion));
+}
+
+ErrorOr<void> Plan9FS::wait_for_reply(Plan9FSMessage& message, NonnullLockRefPtr<ReceiveCompletion> completion)
 {
     auto request_type = message.type();
-    auto tag = message.tag();
-    auto completion = adopt_lock_ref(*new ReceiveCompletion(tag));
-    TRY(post_message(message, completion));
     if (Thread::current()->block<Plan9FS::Blocker>({}, *this, message, completion).was_interrupted())
         return EINTR;
 
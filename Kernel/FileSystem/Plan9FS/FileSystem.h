@@ -28,9 +28,14 @@ public:
 
     virtual Inode& root_inode() override;
 
-    u16 allocate_tag() { return m_next_tag++; }
     u32 allocate_fid() { return m_next_fid++; }
 
+    // We ask for this much, but the server might only agree to less.
+    static constexpr size_t preferred_max_message_size = 128 * KiB;
+    // Large reads and writes are split into requests of at most one message each. This many
+    // of them are sent off before waiting for the first reply.
+    static constexpr size_t max_requests_in_flight_per_transfer = 8;
+
     enum class ProtocolVersion {
         v9P2000,
         v9P2000u,
@@ -113,7 +118,10 @@ private:
     virtual StringView class_name() const override { return "Plan9FS"sv; }
 
     bool is_complete(ReceiveCompletion const&);
-    ErrorOr<void> post_message(Plan9FSMessage&, LockRefPtr<ReceiveCompletion>);
+    ErrorOr<u16> allocate_tag_while_locked();
+    ErrorOr<NonnullLockRefPtr<ReceiveCompletion>> post_message(Plan9FSMessage&);
+    ErrorOr<void> wait_for_reply(Plan9FSMessage&, NonnullLockRefPtr<ReceiveCompletion>);
+    ErrorOr<void> send_message(Plan9FSMessage&);
     ErrorOr<void> do_read(u8* buffer, size_t);
     ErrorOr<void> read_and_dispatch_one_message();
     ErrorOr<void> post_message_and_wait_for_a_reply(Plan9FSMessage&);
@@ -126,11 +134,11 @@ private:
     void ensure_thread();
 
     RefPtr<Plan9FSInode> m_root_inode;
-    Atomic<u16> m_next_tag { (u16)-1 };
+    u16 m_next_tag { 0 };
     Atomic<u32> m_next_fid { 1 };
 
     ProtocolVersion m_remote_protocol_version { ProtocolVersion::v9P2000 };
-    size_t m_max_message_size { 4 * KiB };
+    size_t m_max_message_size { preferred_max_message_size };
 
     Mutex m_send_lock { "Plan9FS send"sv };
     Plan9FSBlockerSet m_completion_blocker;
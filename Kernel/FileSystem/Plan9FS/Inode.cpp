@@ -4,8 +4,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/FileSystem/Plan9FS/Inode.h>
 #include <Kernel/Tasks/Process.h>
+#include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
 
@@ -68,31 +70,62 @@ ErrorOr<size_t> Plan9FSInode::read_bytes_locked(off_t offset, size_t size, UserO
 {
     TRY(const_cast<Plan9FSInode&>(*this).ensure_open_for_mode(O_RDONLY));
 
-    size = fs().adjust_buffer_size(size);
+    if (size == 0)
+        return 0;
 
-    Plan9FSMessage message { fs(), Plan9FSMessage::Type::Treadlink };
-    StringView data;
-
-    // Try readlink first.
-    bool readlink_succeeded = false;
-    if (fs().m_remote_protocol_version >= Plan9FS::ProtocolVersion::v9P2000L && offset == 0) {
+    // Symlinks are read with readlink. The metadata is usually cached already, so looking at it is cheaper
+    // than trying readlink on every file first.
+    if (fs().m_remote_protocol_version >= Plan9FS::ProtocolVersion::v9P2000L && offset == 0 && metadata().is_symlink()) {
+        Plan9FSMessage message { fs(), Plan9FSMessage::Type::Treadlink };
         message << fid();
         if (auto result = fs().post_message_and_wait_for_a_reply(message); !result.is_error()) {
-            readlink_succeeded = true;
+            StringView data;
             message >> data;
+            size_t nread = min(data.length(), fs().adjust_buffer_size(size));
+            TRY(buffer.write(data.characters_without_null_termination(), nread));
+            return nread;
         }
     }
 
-    if (!readlink_succeeded) {
-        message = Plan9FSMessage { fs(), Plan9FSMessage::Type::Tread };
-        message << fid() << (u64)offset << (u32)size;
-        TRY(fs().post_message_and_wait_for_a_reply(message));
-        data = message.read_data();
+    // Send off one Tread for every message-sized chunk before waiting for any of the replies,
+    // so that a large read only takes about as long as a single round trip.
+    size_t chunk_size = fs().adjust_buffer_size(size);
+    Vector<PendingRequest, Plan9FS::max_requests_in_flight_per_transfer> requests;
+    for (size_t chunk_offset = 0; chunk_offset < size && requests.size() < Plan9FS::max_requests_in_flight_per_transfer; chunk_offset += chunk_size) {
+        auto request = [&]() -> ErrorOr<PendingRequest> {
+            auto message = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Plan9FSMessage { fs(), Plan9FSMessage::Type::Tread }));
+            size_t request_size = min(chunk_size, size - chunk_offset);
+            *message << fid() << (u64)(offset + chunk_offset) << (u32)request_size;
+            auto completion = TRY(fs().post_message(*message));
+            return PendingRequest { move(message), move(completion), request_size };
+        }();
+        if (request.is_error()) {
+            if (requests.is_empty())
+                return request.release_error();
+            break;
+        }
+        requests.unchecked_append(request.release_value());
     }
 
-    // Guard against the server returning more data than requested.
-    size_t nread = min(data.length(), size);
-    TRY(buffer.write(data.characters_without_null_termination(), nread));
+    size_t nread = 0;
+    for (auto& request : requests) {
+        auto result = fs().wait_for_reply(*request.message, request.completion);
+        if (result.is_error()) {
+            if (nread == 0)
+                return result.release_error();
+            break;
+        }
+
+        // Guard against the server returning more data than requested.
+        StringView data = request.message->read_data();
+        size_t chunk_nread = min(data.length(), request.size);
+        TRY(buffer.write(data.characters_without_null_termination(), nread, chunk_nread));
+        nread += chunk_nread;
+
+        // We've hit the end of the file, so there is nothing for us in the replies to the remaining requests.
+        if (chunk_nread < request.size)
+            break;
+    }
     return nread;
 }
 
@@ -105,22 +138,65 @@ ErrorOr<void> Plan9FSInode::replace_child(StringView, Inode&)
 ErrorOr<size_t> Plan9FSInode::write_bytes_locked(off_t offset, size_t size, UserOrKernelBuffer const& data, OpenFileDescription*)
 {
     TRY(ensure_open_for_mode(O_WRONLY));
-    size = fs().adjust_buffer_size(size);
 
-    auto data_copy = TRY(data.try_copy_into_kstring(size)); // FIXME: this seems ugly
+    if (size == 0)
+        return 0;
+
+    // The size and modification time are going to change, even if only some of the requests go through.
+    ScopeGuard invalidate_metadata = [&] { invalidate_cached_metadata(); };
+
+    // Like reads, large writes are split into several Twrite requests that are all in flight at once.
+    size_t chunk_size = fs().adjust_buffer_size(size);
+    Vector<PendingRequest, Plan9FS::max_requests_in_flight_per_transfer> requests;
+    for (size_t chunk_offset = 0; chunk_offset < size && requests.size() < Plan9FS::max_requests_in_flight_per_transfer; chunk_offset += chunk_size) {
+        auto request = [&]() -> ErrorOr<PendingRequest> {
+            size_t request_size = min(chunk_size, size - chunk_offset);
+            auto data_copy = TRY(data.offset(chunk_offset).try_copy_into_kstring(request_size)); // FIXME: this seems ugly
+            auto message = TRY(adopt_nonnull_own_or_enomem(new (nothrow) Plan9FSMessage { fs(), Plan9FSMessage::Type::Twrite }));
+            *message << fid() << (u64)(offset + chunk_offset);
+            TRY(message->append_data(data_copy->view()));
+            auto completion = TRY(fs().post_message(*message));
+            return PendingRequest { move(message), move(completion), request_size };
+        }();
+        if (request.is_error()) {
+            if (requests.is_empty())
+                return request.release_error();
+            break;
+        }
+        requests.unchecked_append(request.release_value());
+    }
 
-    Plan9FSMessage message { fs(), Plan9FSMessage::Type::Twrite };
-    message << fid() << (u64)offset;
-    TRY(message.append_data(data_copy->view()));
-    TRY(fs().post_message_and_wait_for_a_reply(message));
+    size_t nwritten = 0;
+    for (auto& request : requests) {
+        auto result = fs().wait_for_reply(*request.message, request.completion);
+        if (result.is_error()) {
+            if (nwritten == 0)
+                return result.release_error();
+            break;
+        }
 
-    u32 nwritten;
-    message >> nwritten;
+        u32 chunk_nwritten;
+        *request.message >> chunk_nwritten;
+        nwritten += min<size_t>(chunk_nwritten, request.size);
+
+        // Whatever comes after a short write would leave a hole, so don't report it as written.
+        if (chunk_nwritten < request.size)
+            break;
+    }
     return nwritten;
 }
 
 InodeMetadata Plan9FSInode::metadata() const
 {
+    auto now = TimeManagement::the().monotonic_time();
+    auto cached_metadata = m_cached_metadata.with([&](auto& cached) -> Optional<InodeMetadata> {
+        if (cached.has_value() && cached->expires_at > now)
+            return cached->metadata;
+        return {};
+    });
+    if (cached_metadata.has_value())
+        return cached_metadata.release_value();
+
     InodeMetadata metadata;
     metadata.inode = identifier();
 
@@ -171,9 +247,57 @@ InodeMetadata Plan9FSInode::metadata() const
         metadata.block_count = blocks;
     }
 
+    m_cached_metadata.with([&](auto& cached) {
+        cached = CachedMetadata { metadata, now + cache_timeout };
+    });
     return metadata;
 }
 
+void Plan9FSInode::invalidate_cached_metadata() const
+{
+    m_cached_metadata.with([](auto& cached) {
+        cached.clear();
+    });
+}
+
+RefPtr<Plan9FSInode> Plan9FSInode::cached_child(StringView name)
+{
+    auto now = TimeManagement::the().monotonic_time();
+    return m_cached_children.with([&](auto& children) -> RefPtr<Plan9FSInode> {
+        auto it = children.find(name);
+        if (it == children.end())
+            return nullptr;
+        if (it->value.expires_at > now) {
+            if (auto child = it->value.inode.strong_ref())
+                return *child;
+        }
+        children.remove(it);
+        return nullptr;
+    });
+}
+
+void Plan9FSInode::cache_child(StringView name, Plan9FSInode& child)
+{
+    auto cache_entry_name = KString::try_create(name);
+    if (cache_entry_name.is_error())
+        return;
+    auto weak_child = child.try_make_weak_ptr<Plan9FSInode>();
+    if (weak_child.is_error())
+        return;
+    auto now = TimeManagement::the().monotonic_time();
+    m_cached_children.with([&](auto& children) {
+        if (children.size() >= max_cached_children) {
+            children.remove_all_matching([&](auto&, auto& cached) {
+                return cached.expires_at <= now || !cached.inode.strong_ref();
+            });
+            if (children.size() >= max_cached_children)
+                children.clear();
+        }
+        // Not being able to remember the child isn't a problem, we'll just have to walk to it again.
+        (void)children.try_set(cache_entry_name.release_value(), CachedChild { weak_child.release_value(), now + cache_timeout });
+    });
+}
+
 ErrorOr<void> Plan9FSInode::flush_metadata()
 {
     // Do nothing.
@@ -247,11 +371,16 @@ ErrorOr<void> Plan9FSInode::traverse_as_directory(Function<ErrorOr<void>(FileSys
 
 ErrorOr<NonnullRefPtr<Inode>> Plan9FSInode::lookup(StringView name)
 {
+    if (auto child = cached_child(name))
+        return child.release_nonnull();
+
     u32 newfid = fs().allocate_fid();
     Plan9FSMessage message { fs(), Plan9FSMessage::Type::Twalk };
     message << fid() << newfid << (u16)1 << name;
     TRY(fs().post_message_and_wait_for_a_reply(message));
-    return TRY(Plan9FSInode::try_create(fs(), newfid));
+    auto child = TRY(Plan9FSInode::try_create(fs(), newfid));
+    cache_child(name, *child);
+    return child;
 }
 
 ErrorOr<NonnullRefPtr<Inode>> Plan9FSInode::create_child(StringView, mode_t, dev_t, UserID, GroupID)
@@ -297,6 +426,7 @@ ErrorOr<void> Plan9FSInode::truncate(u64 new_size)
         u64 mtime_sec = 0;
         u64 mtime_nsec = 0;
         message << fid() << (u64)valid << mode << uid << gid << new_size << atime_sec << atime_nsec << mtime_sec << mtime_nsec;
+        invalidate_cached_metadata();
         return fs().post_message_and_wait_for_a_reply(message);
     }
 
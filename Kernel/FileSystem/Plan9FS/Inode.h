@@ -7,10 +7,15 @@
 #pragma once
 
 #include <AK/Atomic.h>
+#include <AK/HashMap.h>
+#include <AK/Time.h>
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/Plan9FS/FileSystem.h>
 #include <Kernel/FileSystem/Plan9FS/Message.h>
 #include <Kernel/Library/KBufferBuilder.h>
+#include <Kernel/Library/KString.h>
+#include <Kernel/Library/LockWeakPtr.h>
+#include <Kernel/Locking/SpinlockProtected.h>
 
 namespace Kernel {
 
@@ -80,6 +85,36 @@ private:
     int m_open_mode { 0 };
     ErrorOr<void> ensure_open_for_mode(int mode);
 
+    // A request that has been sent off as part of a larger read or write.
+    struct PendingRequest {
+        NonnullOwnPtr<Plan9FSMessage> message;
+        NonnullLockRefPtr<Plan9FS::ReceiveCompletion> completion;
+        size_t size { 0 };
+    };
+
+    // Attributes and the results of walks are remembered for a little while, so that stat()ing
+    // the same file or resolving the same path over and over doesn't need a round trip every time.
+    // Anything we change ourselves invalidates the cache right away. Changes made by somebody else
+    // show up once the cached entries have expired.
+    static constexpr Duration cache_timeout = Duration::from_seconds(1);
+    static constexpr size_t max_cached_children = 256;
+
+    struct CachedMetadata {
+        InodeMetadata metadata;
+        MonotonicTime expires_at;
+    };
+    struct CachedChild {
+        LockWeakPtr<Plan9FSInode> inode;
+        MonotonicTime expires_at;
+    };
+
+    void invalidate_cached_metadata() const;
+    RefPtr<Plan9FSInode> cached_child(StringView name);
+    void cache_child(StringView name, Plan9FSInode&);
+
+    mutable SpinlockProtected<Optional<CachedMetadata>, LockRank::None> m_cached_metadata {};
+    SpinlockProtected<HashMap<NonnullOwnPtr<KString>, CachedChild>, LockRank::None> m_cached_children {};
+
     Plan9FS& fs() { return reinterpret_cast<Plan9FS&>(Inode::fs()); }
     Plan9FS& fs() const
     {
@@ -90,14 +90,14 @@ StringView Plan9FSMessage::Decoder::read_data()
     return data;
 }
 
-Plan9FSMessage::Plan9FSMessage(Plan9FS& fs, Type type)
+Plan9FSMessage::Plan9FSMessage(Plan9FS&, Type type)
     : m_builder(KBufferBuilder::try_create().release_value()) // FIXME: Don't assume KBufferBuilder allocation success.
-    , m_tag(fs.allocate_tag())
     , m_type(type)
     , m_have_been_built(false)
 {
     u32 size_placeholder = 0;
-    *this << size_placeholder << (u8)type << m_tag;
+    u16 tag_placeholder = no_tag;
+    *this << size_placeholder << (u8)type << tag_placeholder;
 }
 
 Plan9FSMessage::Plan9FSMessage(NonnullOwnPtr<KBuffer>&& buffer)
@@ -159,6 +159,8 @@ KBuffer const& Plan9FSMessage::build()
     new (&m_built.decoder) Decoder({ m_built.buffer->data(), m_built.buffer->size() });
     u32* size = reinterpret_cast<u32*>(m_built.buffer->data());
     *size = m_built.buffer->size();
+    // The tag follows the size and the type, and isn't necessarily aligned.
+    memcpy(m_built.buffer->data() + sizeof(u32) + sizeof(u8), &m_tag, sizeof(m_tag));
     return *m_built.buffer;
 }
 
@@ -154,6 +154,14 @@ public:
     Type type() const { return m_type; }
     u16 tag() const { return m_tag; }
 
+    // The tag is only assigned once the message gets posted, as it must not collide
+    // with the tag of any other request that is still waiting for its reply.
+    void set_tag(u16 tag)
+    {
+        VERIFY(!m_have_been_built);
+        m_tag = tag;
+    }
+
     Plan9FSMessage(Plan9FS&, Type);
     Plan9FSMessage(NonnullOwnPtr<KBuffer>&&);
     ~Plan9FSMessage();
@@ -163,6 +171,9 @@ public:
 
     static constexpr size_t max_header_size = 24;
 
+    // Tversion is the only message that uses NOTAG; it's never handed out to anything else.
+    static constexpr u16 no_tag = 0xffff;
+
 private:
     template<typename N>
     Plan9FSMessage& append_number(N number)
@@ -181,7 +192,7 @@ private:
         } m_built;
     };
 
-    u16 m_tag { 0 };
+    u16 m_tag { no_tag };
     Type m_type { 0 };
     bool m_have_been_built { false };
 };
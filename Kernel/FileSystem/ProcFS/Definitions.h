@@ -47,6 +47,7 @@ constexpr segmented_process_directory_entry process_cwd_symlink_entry = { "cwd"s
 constexpr segmented_process_directory_entry process_perf_events_entry = { "perf_events"sv, DT_REG, 0, 6 };
 constexpr segmented_process_directory_entry process_vm_entry = { "vm"sv, DT_REG, 0, 7 };
 constexpr segmented_process_directory_entry process_cmdline_entry = { "cmdline"sv, DT_REG, 0, 8 };
+constexpr segmented_process_directory_entry process_syscall_statistics_entry = { "syscall_statistics"sv, DT_REG, 0, 9 };
 constexpr segmented_process_directory_entry main_process_directory_entries[] = {
     process_fd_directory_entry,
     process_stacks_directory_entry,
@@ -59,6 +60,7 @@ constexpr segmented_process_directory_entry main_process_directory_entries[] = {
     process_perf_events_entry,
     process_vm_entry,
     process_cmdline_entry,
+    process_syscall_statistics_entry,
 };
 
 }
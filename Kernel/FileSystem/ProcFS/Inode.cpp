@@ -326,6 +326,8 @@ ErrorOr<void> ProcFSInode::try_fetch_process_property_data(NonnullRefPtr<Process
         return process->procfs_get_virtual_memory_stats(builder);
     case process_cmdline_entry.property:
         return process->procfs_get_command_line(builder);
+    case process_syscall_statistics_entry.property:
+        return process->procfs_get_syscall_statistics(builder);
     default:
         VERIFY_NOT_REACHED();
     }
@@ -7,6 +7,7 @@
 #include <AK/JsonArraySerializer.h>
 #include <AK/JsonObjectSerializer.h>
 #include <AK/JsonValue.h>
+#include <Kernel/API/SyscallString.h>
 #include <Kernel/Devices/TTY/TTY.h>
 #include <Kernel/FileSystem/Custody.h>
 #include <Kernel/FileSystem/ProcFS/Inode.h>
@@ -327,6 +328,8 @@ ErrorOr<void> Process::procfs_get_virtual_memory_stats(KBufferBuilder& builder)
                     pagemap_builder.append('N');
                 else if (page->is_shared_zero_page() || page->is_lazy_committed_page())
                     pagemap_builder.append('Z');
+                else if (page->is_compressed_page())
+                    pagemap_builder.append('C');
                 else
                     pagemap_builder.append('P');
             }
@@ -354,6 +357,29 @@ ErrorOr<void> Process::procfs_get_command_line(KBufferBuilder& builder) const
     return {};
 }
 
+ErrorOr<void> Process::procfs_get_syscall_statistics(KBufferBuilder& builder) const
+{
+    auto array = TRY(JsonArraySerializer<>::try_create(builder));
+    if (auto const* counters = syscall_counters(); counters && SyscallStatistics::is_initialized()) {
+        auto time_scale = SyscallStatistics::the().time_scale();
+        for (size_t function = 0; function < Syscall::Function::__Count; ++function) {
+            auto const& syscall = counters->syscalls[function];
+            auto calls = syscall.calls.load(AK::MemoryOrder::memory_order_relaxed);
+            if (calls == 0)
+                continue;
+            auto obj = TRY(array.add_object());
+            TRY(obj.add("name"sv, Syscall::to_string(static_cast<Syscall::Function>(function))));
+            TRY(obj.add("number"sv, function));
+            TRY(obj.add("calls"sv, calls));
+            TRY(obj.add("errors"sv, syscall.errors.load(AK::MemoryOrder::memory_order_relaxed)));
+            TRY(obj.add("total_time_ns"sv, time_scale.to_nanoseconds(syscall.total_time.load(AK::MemoryOrder::memory_order_relaxed))));
+            TRY(obj.finish());
+        }
+    }
+    TRY(array.finish());
+    return {};
+}
+
 mode_t Process::binary_link_required_mode() const
 {
     if (!executable())
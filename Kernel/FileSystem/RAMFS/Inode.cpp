@@ -5,7 +5,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
 #include <Kernel/FileSystem/RAMFS/Inode.h>
+#include <Kernel/Interrupts/InterruptDisabler.h>
+#include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Tasks/Process.h>
 
 namespace Kernel {
@@ -89,38 +92,35 @@ ErrorOr<void> RAMFSInode::replace_child(StringView name, Inode& new_child)
     return {};
 }
 
-ErrorOr<NonnullOwnPtr<RAMFSInode::DataBlock>> RAMFSInode::DataBlock::create()
-{
-    auto data_block_buffer_vmobject = TRY(Memory::AnonymousVMObject::try_create_with_size(DataBlock::block_size, AllocationStrategy::AllocateNow));
-    return TRY(adopt_nonnull_own_or_enomem(new (nothrow) DataBlock(move(data_block_buffer_vmobject))));
-}
-
-ErrorOr<void> RAMFSInode::ensure_allocated_blocks(size_t offset, size_t io_size)
+ErrorOr<void> RAMFSInode::ensure_allocated_pages(size_t offset, size_t io_size)
 {
     VERIFY(m_inode_lock.is_locked());
-    size_t block_start_index = offset / DataBlock::block_size;
-    size_t block_last_index = ((offset + io_size) / DataBlock::block_size) + (((offset + io_size) % DataBlock::block_size) == 0 ? 0 : 1);
-    VERIFY(block_start_index <= block_last_index);
-
-    size_t original_size = m_blocks.size();
-    Vector<size_t> allocated_block_indices;
-    ArmedScopeGuard clean_allocated_blocks_on_failure([&] {
-        for (auto index : allocated_block_indices)
-            m_blocks[index].clear();
-        MUST(m_blocks.try_resize(original_size));
-    });
-
-    if (m_blocks.size() < (block_last_index))
-        TRY(m_blocks.try_resize(block_last_index));
-
-    for (size_t block_index = block_start_index; block_index < block_last_index; block_index++) {
-        if (!m_blocks[block_index]) {
-            TRY(allocated_block_indices.try_append(block_index));
-            m_blocks[block_index] = TRY(DataBlock::create());
+    size_t first_page_index = offset / PAGE_SIZE;
+    size_t end_page_index = ceil_div(offset + io_size, static_cast<size_t>(PAGE_SIZE));
+    VERIFY(first_page_index <= end_page_index);
+
+    return m_pages.with_exclusive([&](auto& pages) -> ErrorOr<void> {
+        size_t original_page_count = pages.size();
+        Vector<size_t> allocated_page_indices;
+        ArmedScopeGuard clean_allocated_pages_on_failure([&] {
+            for (auto index : allocated_page_indices)
+                pages[index] = nullptr;
+            if (pages.size() > original_page_count)
+                pages.shrink(original_page_count);
+        });
+
+        if (pages.size() < end_page_index)
+            TRY(pages.try_resize(end_page_index));
+
+        for (size_t page_index = first_page_index; page_index < end_page_index; page_index++) {
+            if (!pages[page_index]) {
+                TRY(allocated_page_indices.try_append(page_index));
+                pages[page_index] = TRY(MM.allocate_physical_page(Memory::MemoryManager::ShouldZeroFill::Yes));
+            }
         }
-    }
-    clean_allocated_blocks_on_failure.disarm();
-    return {};
+        clean_allocated_pages_on_failure.disarm();
+        return {};
+    });
 }
 
 ErrorOr<size_t> RAMFSInode::read_bytes_from_content_space(size_t offset, size_t io_size, UserOrKernelBuffer& buffer) const
@@ -129,8 +129,7 @@ ErrorOr<size_t> RAMFSInode::read_bytes_from_content_space(size_t offset, size_t
     VERIFY(m_metadata.size >= 0);
     if (offset >= static_cast<size_t>(m_metadata.size))
         return 0;
-    auto mapping_region = TRY(MM.allocate_kernel_region(DataBlock::block_size, "RAMFSInode Mapping Region"sv, Memory::Region::Access::Read, AllocationStrategy::Reserve));
-    return const_cast<RAMFSInode&>(*this).do_io_on_content_space(*mapping_region, offset, io_size, buffer, false);
+    return const_cast<RAMFSInode&>(*this).do_io_on_content_space(offset, io_size, buffer, false);
 }
 
 ErrorOr<size_t> RAMFSInode::read_bytes_locked(off_t offset, size_t size, UserOrKernelBuffer& buffer, OpenFileDescription*) const
@@ -143,8 +142,7 @@ ErrorOr<size_t> RAMFSInode::read_bytes_locked(off_t offset, size_t size, UserOrK
 ErrorOr<size_t> RAMFSInode::write_bytes_to_content_space(size_t offset, size_t io_size, UserOrKernelBuffer const& buffer)
 {
     VERIFY(m_inode_lock.is_locked());
-    auto mapping_region = TRY(MM.allocate_kernel_region(DataBlock::block_size, "RAMFSInode Mapping Region"sv, Memory::Region::Access::Write, AllocationStrategy::Reserve));
-    return do_io_on_content_space(*mapping_region, offset, io_size, const_cast<UserOrKernelBuffer&>(buffer), true);
+    return do_io_on_content_space(offset, io_size, const_cast<UserOrKernelBuffer&>(buffer), true);
 }
 
 ErrorOr<size_t> RAMFSInode::write_bytes_locked(off_t offset, size_t size, UserOrKernelBuffer const& buffer, OpenFileDescription*)
@@ -153,7 +151,7 @@ ErrorOr<size_t> RAMFSInode::write_bytes_locked(off_t offset, size_t size, UserOr
     VERIFY(!is_directory());
     VERIFY(offset >= 0);
 
-    TRY(ensure_allocated_blocks(offset, size));
+    TRY(ensure_allocated_pages(offset, size));
     auto nwritten = TRY(write_bytes_to_content_space(offset, size, buffer));
 
     off_t old_size = m_metadata.size;
@@ -169,7 +167,7 @@ ErrorOr<size_t> RAMFSInode::write_bytes_locked(off_t offset, size_t size, UserOr
     return nwritten;
 }
 
-ErrorOr<size_t> RAMFSInode::do_io_on_content_space(Memory::Region& mapping_region, size_t offset, size_t io_size, UserOrKernelBuffer& buffer, bool write)
+ErrorOr<size_t> RAMFSInode::do_io_on_content_space(size_t offset, size_t io_size, UserOrKernelBuffer& buffer, bool write)
 {
     VERIFY(m_inode_lock.is_locked());
     size_t remaining_bytes = 0;
@@ -185,53 +183,103 @@ ErrorOr<size_t> RAMFSInode::do_io_on_content_space(Memory::Region& mapping_regio
     VERIFY(remaining_bytes != 0);
 
     UserOrKernelBuffer current_buffer = buffer.offset(0);
-    auto block_start_index = offset / DataBlock::block_size;
-    auto offset_in_block = offset % DataBlock::block_size;
-    u64 block_index = block_start_index;
+    size_t page_index = offset / PAGE_SIZE;
+    size_t offset_in_page = offset % PAGE_SIZE;
     size_t nio = 0;
     while (remaining_bytes > 0) {
-        size_t current_io_size = min(DataBlock::block_size - offset_in_block, remaining_bytes);
-        auto& block = m_blocks[block_index];
-        if (!block && !write) {
-            // Note: If the block does not exist then it's just a gap in the file,
+        // Map as many of the pages that follow as we need at once, up to the next hole.
+        // NOTE: The page list must not be locked while we copy, as that may fault on a shared mapping of this file.
+        Vector<NonnullRefPtr<Memory::PhysicalPage>, max_pages_per_mapping> pages;
+        m_pages.with_shared([&](auto const& file_pages) {
+            while (pages.size() < max_pages_per_mapping
+                && pages.size() * PAGE_SIZE < offset_in_page + remaining_bytes
+                && page_index + pages.size() < file_pages.size()
+                && file_pages[page_index + pages.size()]) {
+                pages.unchecked_append(*file_pages[page_index + pages.size()]);
+            }
+        });
+
+        if (pages.is_empty()) {
+            // Note: If the page does not exist then it's just a hole in the file,
             // so the buffer should be placed with zeroes in that section.
+            if (write)
+                return Error::from_errno(EIO);
+            size_t current_io_size = min(PAGE_SIZE - offset_in_page, remaining_bytes);
             TRY(current_buffer.memset(0, 0, current_io_size));
-            remaining_bytes -= current_io_size;
             current_buffer = current_buffer.offset(current_io_size);
             nio += current_io_size;
-            block_index++;
-            // Note: Clear offset_in_block to zero to ensure that if we started from a middle of
-            // a block, then next writes are just going to happen from the start of each block until the end.
-            offset_in_block = 0;
+            remaining_bytes -= current_io_size;
+            page_index++;
+            offset_in_page = 0;
             continue;
-        } else if (!block) {
-            return Error::from_errno(EIO);
         }
 
-        NonnullLockRefPtr<Memory::AnonymousVMObject> block_vmobject = block->vmobject();
-        mapping_region.set_vmobject(block_vmobject);
-        mapping_region.remap();
+        size_t current_io_size = min(pages.size() * PAGE_SIZE - offset_in_page, remaining_bytes);
+        auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_physical_pages(pages.span()));
+        auto mapping_region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, pages.size() * PAGE_SIZE, "RAMFSInode Mapping Region"sv, write ? Memory::Region::Access::Write : Memory::Region::Access::Read));
         if (write)
-            TRY(current_buffer.read(mapping_region.vaddr().offset(offset_in_block).as_ptr(), 0, current_io_size));
+            TRY(current_buffer.read(mapping_region->vaddr().offset(offset_in_page).as_ptr(), 0, current_io_size));
         else
-            TRY(current_buffer.write(mapping_region.vaddr().offset(offset_in_block).as_ptr(), 0, current_io_size));
+            TRY(current_buffer.write(mapping_region->vaddr().offset(offset_in_page).as_ptr(), 0, current_io_size));
         current_buffer = current_buffer.offset(current_io_size);
         nio += current_io_size;
         remaining_bytes -= current_io_size;
-        block_index++;
-        // Note: Clear offset_in_block to zero to ensure that if we started from a middle of
-        // a block, then next writes are just going to happen from the start of each block until the end.
-        offset_in_block = 0;
+        page_index += pages.size();
+        // Note: Clear offset_in_page to zero to ensure that if we started from a middle of
+        // a page, then next I/O is just going to happen from the start of each page until the end.
+        offset_in_page = 0;
     }
     VERIFY(nio <= io_size);
     return nio;
 }
 
-ErrorOr<void> RAMFSInode::truncate_to_block_index(size_t block_index)
+void RAMFSInode::truncate_to_page_count(size_t page_count)
 {
     VERIFY(m_inode_lock.is_locked());
-    TRY(m_blocks.try_resize(block_index));
-    return {};
+    bool did_drop_pages = m_pages.with_exclusive([&](auto& pages) {
+        if (page_count >= pages.size())
+            return false;
+        pages.shrink(page_count);
+        return true;
+    });
+    if (!did_drop_pages)
+        return;
+
+    // Shared mappings must not keep the pages we just dropped, or they'd lose track of the
+    // file if it grows again later.
+    if (auto vmobject = shared_vmobject())
+        vmobject->release_pages_starting_at(page_count);
+}
+
+ErrorOr<RefPtr<Memory::PhysicalPage>> RAMFSInode::page_for_shared_vmobject(size_t page_index)
+{
+    VERIFY(!is_directory());
+
+    // NOTE: We might be faulting while this thread reads from this very file into a mapping of it, with the inode
+    //       lock already held shared. Upgrading it to fill in a hole would deadlock, so holes are filled in under
+    //       the lock of the page list alone.
+    MutexLocker locker(m_inode_lock, Mutex::Mode::Shared);
+    // There is nothing to map past the end of the file.
+    if (page_index * PAGE_SIZE >= static_cast<u64>(m_metadata.size))
+        return RefPtr<Memory::PhysicalPage> {};
+
+    auto page = m_pages.with_shared([&](auto const& pages) -> RefPtr<Memory::PhysicalPage> {
+        if (page_index < pages.size())
+            return pages[page_index];
+        return nullptr;
+    });
+    if (page)
+        return page;
+
+    // Fill in the hole, so that writes through the mapping end up in the file.
+    // Someone else may have gotten to it in the meantime, in which case we map their page.
+    return m_pages.with_exclusive([&](auto& pages) -> ErrorOr<RefPtr<Memory::PhysicalPage>> {
+        if (pages.size() <= page_index)
+            TRY(pages.try_resize(page_index + 1));
+        if (!pages[page_index])
+            pages[page_index] = TRY(MM.allocate_physical_page(Memory::MemoryManager::ShouldZeroFill::Yes));
+        return pages[page_index];
+    });
 }
 
 ErrorOr<NonnullRefPtr<Inode>> RAMFSInode::lookup(StringView name)
@@ -364,18 +412,21 @@ ErrorOr<void> RAMFSInode::truncate(u64 size)
     MutexLocker locker(m_inode_lock);
     VERIFY(!is_directory());
 
-    u64 block_index = size / DataBlock::block_size + ((size % DataBlock::block_size == 0) ? 0 : 1);
-    TRY(truncate_to_block_index(block_index));
-
-    u64 last_possible_block_index = size / DataBlock::block_size;
-    if ((size % DataBlock::block_size != 0) && m_blocks[last_possible_block_index]) {
-        auto mapping_region = TRY(MM.allocate_kernel_region(DataBlock::block_size, "RAMFSInode Mapping Region"sv, Memory::Region::Access::Write, AllocationStrategy::Reserve));
-        VERIFY(m_blocks[last_possible_block_index]);
-        NonnullLockRefPtr<Memory::AnonymousVMObject> block_vmobject = m_blocks[last_possible_block_index]->vmobject();
-        mapping_region->set_vmobject(block_vmobject);
-        mapping_region->remap();
-        memset(mapping_region->vaddr().offset(size % DataBlock::block_size).as_ptr(), 0, DataBlock::block_size - (size % DataBlock::block_size));
+    // Zero out the rest of the last page, so that nothing reappears if the file grows again.
+    u64 last_page_index = size / PAGE_SIZE;
+    auto last_page_or_null = m_pages.with_shared([&](auto const& pages) -> RefPtr<Memory::PhysicalPage> {
+        if (last_page_index < pages.size())
+            return pages[last_page_index];
+        return nullptr;
+    });
+    if ((size % PAGE_SIZE != 0) && last_page_or_null) {
+        NonnullRefPtr<Memory::PhysicalPage> last_page = last_page_or_null.release_nonnull();
+        auto vmobject = TRY(Memory::AnonymousVMObject::try_create_with_physical_pages({ &last_page, 1 }));
+        auto mapping_region = TRY(MM.allocate_kernel_region_with_vmobject(*vmobject, PAGE_SIZE, "RAMFSInode Mapping Region"sv, Memory::Region::Access::Write));
+        memset(mapping_region->vaddr().offset(size % PAGE_SIZE).as_ptr(), 0, PAGE_SIZE - (size % PAGE_SIZE));
     }
+
+    truncate_to_page_count(ceil_div(size, static_cast<u64>(PAGE_SIZE)));
     m_metadata.size = size;
     set_metadata_dirty(true);
     return {};
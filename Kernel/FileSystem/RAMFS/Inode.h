@@ -10,7 +10,9 @@
 #include <Kernel/FileSystem/Inode.h>
 #include <Kernel/FileSystem/RAMFS/FileSystem.h>
 #include <Kernel/Forward.h>
+#include <Kernel/Locking/MutexProtected.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/PhysicalPage.h>
 
 namespace Kernel {
 
@@ -36,6 +38,8 @@ public:
     virtual ErrorOr<void> chown(UserID, GroupID) override;
     virtual ErrorOr<void> truncate(u64) override;
     virtual ErrorOr<void> update_timestamps(Optional<UnixDateTime> atime, Optional<UnixDateTime> ctime, Optional<UnixDateTime> mtime) override;
+    virtual bool shares_pages_with_vmobject() const override { return true; }
+    virtual ErrorOr<RefPtr<Memory::PhysicalPage>> page_for_shared_vmobject(size_t page_index) override;
 
 private:
     RAMFSInode(RAMFS& fs, InodeMetadata const& metadata, LockWeakPtr<RAMFSInode> parent);
@@ -47,7 +51,7 @@ private:
     virtual ErrorOr<size_t> read_bytes_locked(off_t, size_t, UserOrKernelBuffer& buffer, OpenFileDescription*) const override;
     virtual ErrorOr<size_t> write_bytes_locked(off_t, size_t, UserOrKernelBuffer const& buffer, OpenFileDescription*) override;
 
-    ErrorOr<size_t> do_io_on_content_space(Memory::Region& mapping_region, size_t offset, size_t io_size, UserOrKernelBuffer& buffer, bool write);
+    ErrorOr<size_t> do_io_on_content_space(size_t offset, size_t io_size, UserOrKernelBuffer& buffer, bool write);
 
     struct Child {
         NonnullOwnPtr<KString> name;
@@ -61,34 +65,21 @@ private:
     InodeMetadata m_metadata;
     LockWeakPtr<RAMFSInode> m_parent;
 
-    ErrorOr<void> ensure_allocated_blocks(size_t offset, size_t io_size);
-    ErrorOr<void> truncate_to_block_index(size_t block_index);
+    ErrorOr<void> ensure_allocated_pages(size_t offset, size_t io_size);
+    void truncate_to_page_count(size_t page_count);
     ErrorOr<size_t> read_bytes_from_content_space(size_t offset, size_t io_size, UserOrKernelBuffer& buffer) const;
     ErrorOr<size_t> write_bytes_to_content_space(size_t offset, size_t io_size, UserOrKernelBuffer const& buffer);
 
-    struct DataBlock {
-    public:
-        using List = Vector<OwnPtr<DataBlock>>;
-
-        static ErrorOr<NonnullOwnPtr<DataBlock>> create();
-
-        constexpr static size_t block_size = 128 * KiB;
-
-        Memory::AnonymousVMObject& vmobject() { return *m_content_buffer_vmobject; }
-        Memory::AnonymousVMObject const& vmobject() const { return *m_content_buffer_vmobject; }
-
-    private:
-        explicit DataBlock(NonnullLockRefPtr<Memory::AnonymousVMObject> content_buffer_vmobject)
-            : m_content_buffer_vmobject(move(content_buffer_vmobject))
-        {
-        }
-
-        NonnullLockRefPtr<Memory::AnonymousVMObject> m_content_buffer_vmobject;
-    };
+    // Reads and writes map this many pages into the kernel at once.
+    static constexpr size_t max_pages_per_mapping = 32;
 
     bool const m_root_directory_inode { false };
 
-    DataBlock::List m_blocks;
+    // The contents of the file, one physical page at a time. Holes in the file don't have a page.
+    // These very pages are handed to our shared VMObject, so shared mappings see the file itself.
+    // NOTE: This has a lock of its own, so a fault on a shared mapping can fill in a hole while the faulting thread
+    //       already holds m_inode_lock shared (e.g. when reading from this file into a mapping of it).
+    MutexProtected<Vector<RefPtr<Memory::PhysicalPage>>> m_pages;
     Child::List m_children;
 };
 
@@ -4,9 +4,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/JsonObjectSerializer.h>
 #include <Kernel/Bus/PCI/API.h>
 #include <Kernel/Bus/PCI/Access.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Devices/Storage/DeviceAttribute.h>
+#include <Kernel/Library/KBufferBuilder.h>
 #include <Kernel/Sections.h>
 
 namespace Kernel {
@@ -20,6 +22,10 @@ StringView StorageDeviceAttributeSysFSComponent::name() const
         return "sector_size"sv;
     case Type::CommandSet:
         return "command_set"sv;
+    case Type::Rotational:
+        return "rotational"sv;
+    case Type::QueueStatistics:
+        return "queue_statistics"sv;
     default:
         VERIFY_NOT_REACHED();
     }
@@ -49,6 +55,27 @@ ErrorOr<size_t> StorageDeviceAttributeSysFSComponent::read_bytes(off_t offset, s
     return nread;
 }
 
+static ErrorOr<NonnullOwnPtr<KBuffer>> try_to_generate_queue_statistics(StorageDevice const& device)
+{
+    auto statistics = device.request_queue_statistics();
+    auto builder = TRY(KBufferBuilder::try_create());
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("queue_depth"sv, statistics.queue_depth));
+    TRY(json.add("max_queue_depth"sv, statistics.max_queue_depth));
+    TRY(json.add("queued_requests"sv, statistics.queued_requests));
+    TRY(json.add("dispatched_requests"sv, statistics.dispatched_requests));
+    TRY(json.add("front_merges"sv, statistics.front_merges));
+    TRY(json.add("back_merges"sv, statistics.back_merges));
+    TRY(json.add("expired_deadlines"sv, statistics.expired_deadlines));
+    TRY(json.add("plugs"sv, statistics.plugs));
+    TRY(json.add("max_blocks_per_request"sv, device.max_blocks_per_request()));
+    TRY(json.finish());
+    auto buffer = builder.build();
+    if (!buffer)
+        return Error::from_errno(ENOMEM);
+    return buffer.release_nonnull();
+}
+
 ErrorOr<NonnullOwnPtr<KBuffer>> StorageDeviceAttributeSysFSComponent::try_to_generate_buffer() const
 {
     OwnPtr<KString> value;
@@ -62,6 +89,11 @@ ErrorOr<NonnullOwnPtr<KBuffer>> StorageDeviceAttributeSysFSComponent::try_to_gen
     case Type::CommandSet:
         value = TRY(KString::formatted("{}", m_device->command_set_to_string_view()));
         break;
+    case Type::Rotational:
+        value = TRY(KString::formatted("{}", m_device->is_rotational() ? 1 : 0));
+        break;
+    case Type::QueueStatistics:
+        return try_to_generate_queue_statistics(*m_device);
     default:
         VERIFY_NOT_REACHED();
     }
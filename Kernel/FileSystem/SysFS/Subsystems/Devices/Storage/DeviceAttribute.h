@@ -18,6 +18,8 @@ public:
         EndLBA,
         SectorSize,
         CommandSet,
+        Rotational,
+        QueueStatistics,
     };
 
 public:
@@ -0,0 +1,27 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Configuration/BooleanVariable.h>
+
+namespace Kernel {
+
+class SysFSLockContentionProfiling final : public SysFSSystemBooleanVariable {
+public:
+    virtual StringView name() const override { return "lock_contention_profiling"sv; }
+    static NonnullRefPtr<SysFSLockContentionProfiling> must_create(SysFSDirectory const&);
+
+private:
+    virtual bool value() const override;
+    virtual void set_value(bool new_value) override;
+
+    explicit SysFSLockContentionProfiling(SysFSDirectory const&);
+};
+
+}
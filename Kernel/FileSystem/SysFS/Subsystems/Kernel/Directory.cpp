@@ -17,12 +17,15 @@
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Interrupts.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Jails.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Keymap.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/LockContention.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Log.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/MemoryStatus.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Network/Directory.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/PowerStateSwitch.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/ProcessStatistics.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Processes.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Profile.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/SyscallStatistics.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/SystemStatistics.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/Uptime.h>
 
@@ -35,7 +38,9 @@ UNMAP_AFTER_INIT NonnullRefPtr<SysFSGlobalKernelStatsDirectory> SysFSGlobalKerne
         list.append(SysFSDiskUsage::must_create(*global_kernel_stats_directory));
         list.append(SysFSMemoryStatus::must_create(*global_kernel_stats_directory));
         list.append(SysFSSystemStatistics::must_create(*global_kernel_stats_directory));
+        list.append(SysFSSyscallStatistics::must_create(*global_kernel_stats_directory));
         list.append(SysFSOverallProcesses::must_create(*global_kernel_stats_directory));
+        list.append(SysFSProcessStatistics::must_create(*global_kernel_stats_directory));
         list.append(SysFSCPUInformation::must_create(*global_kernel_stats_directory));
         list.append(SysFSKernelLog::must_create(*global_kernel_stats_directory));
         list.append(SysFSInterrupts::must_create(*global_kernel_stats_directory));
@@ -44,6 +49,7 @@ UNMAP_AFTER_INIT NonnullRefPtr<SysFSGlobalKernelStatsDirectory> SysFSGlobalKerne
         list.append(SysFSProfile::must_create(*global_kernel_stats_directory));
         list.append(SysFSPowerStateSwitchNode::must_create(*global_kernel_stats_directory));
         list.append(SysFSJails::must_create(*global_kernel_stats_directory));
+        list.append(SysFSLockContention::must_create(*global_kernel_stats_directory));
 
         list.append(SysFSGlobalNetworkStatsDirectory::must_create(*global_kernel_stats_directory));
         list.append(SysFSKernelConfigurationDirectory::must_create(*global_kernel_stats_directory));
@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/LockContention.h>
+#include <Kernel/Locking/LockContention.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSLockContention::SysFSLockContention(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSLockContention> SysFSLockContention::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSLockContention(parent_directory)).release_nonnull();
+}
+
+static StringView to_string(LockContentionType type)
+{
+    switch (type) {
+    case LockContentionType::Spinlock:
+        return "spinlock"sv;
+    case LockContentionType::RecursiveSpinlock:
+        return "recursive_spinlock"sv;
+    case LockContentionType::Mutex:
+        return "mutex"sv;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+ErrorOr<void> SysFSLockContention::try_generate(KBufferBuilder& builder)
+{
+    auto current_process_credentials = Process::current().credentials();
+    bool show_kernel_addresses = current_process_credentials->is_superuser();
+
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    TRY(json.add("enabled"sv, LockContention::is_enabled()));
+    TRY(json.add("dropped_contentions"sv, LockContention::dropped_contentions()));
+    auto array = TRY(json.add_array("call_sites"sv));
+    for (auto const& call_site : LockContention::call_sites()) {
+        auto address = call_site.address.load(AK::MemoryOrder::memory_order_acquire);
+        if (address == 0)
+            continue;
+        auto object = TRY(array.add_object());
+        TRY(object.add("address"sv, show_kernel_addresses ? address : static_cast<FlatPtr>(0xdeadc0de)));
+        TRY(object.add("type"sv, to_string(call_site.type)));
+        TRY(object.add("lock"sv, show_kernel_addresses ? call_site.lock : static_cast<FlatPtr>(0xdeadc0de)));
+        TRY(object.add("lock_name"sv, StringView { call_site.lock_name, strnlen(call_site.lock_name, sizeof(call_site.lock_name)) }));
+#if LOCK_DEBUG
+        TRY(object.add("file"sv, call_site.file));
+        TRY(object.add("function"sv, call_site.function));
+        TRY(object.add("line"sv, call_site.line));
+#endif
+        TRY(object.add("contentions"sv, call_site.contentions.load(AK::MemoryOrder::memory_order_relaxed)));
+        TRY(object.add("total_wait_time"sv, call_site.total_wait_time.load(AK::MemoryOrder::memory_order_relaxed)));
+        TRY(object.add("max_wait_time"sv, call_site.max_wait_time.load(AK::MemoryOrder::memory_order_relaxed)));
+        TRY(object.finish());
+    }
+    TRY(array.finish());
+    TRY(json.finish());
+    return {};
+}
+
+}
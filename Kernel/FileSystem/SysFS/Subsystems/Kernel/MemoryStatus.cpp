@@ -6,7 +6,9 @@
 
 #include <AK/JsonObjectSerializer.h>
 #include <Kernel/FileSystem/SysFS/Subsystems/Kernel/MemoryStatus.h>
+#include <Kernel/Memory/CompressedPageStore.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/SamePageMerger.h>
 #include <Kernel/Sections.h>
 
 namespace Kernel {
@@ -27,6 +29,8 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     get_kmalloc_stats(stats);
 
     auto system_memory = MM.get_system_memory_info();
+    auto compressed_pages = Memory::CompressedPageStore::the().statistics();
+    auto merged_pages = Memory::SamePageMerger::the().statistics();
 
     auto json = TRY(JsonObjectSerializer<>::try_create(builder));
     TRY(json.add("kmalloc_allocated"sv, stats.bytes_allocated));
@@ -37,6 +41,20 @@ ErrorOr<void> SysFSMemoryStatus::try_generate(KBufferBuilder& builder)
     TRY(json.add("physical_uncommitted"sv, system_memory.physical_pages_uncommitted));
     TRY(json.add("kmalloc_call_count"sv, stats.kmalloc_call_count));
     TRY(json.add("kfree_call_count"sv, stats.kfree_call_count));
+    TRY(json.add("compressed_pages"sv, compressed_pages.stored_pages));
+    TRY(json.add("compressed_zero_pages"sv, compressed_pages.zero_pages));
+    TRY(json.add("compressed_bytes"sv, compressed_pages.compressed_bytes));
+    TRY(json.add("compressed_pool_pages"sv, compressed_pages.pool_pages));
+    TRY(json.add("compressions"sv, compressed_pages.compressions));
+    TRY(json.add("decompressions"sv, compressed_pages.decompressions));
+    TRY(json.add("incompressible_pages"sv, compressed_pages.incompressible_pages));
+    TRY(json.add("compressed_reserved_pages"sv, compressed_pages.reserved_pages));
+    TRY(json.add("merged_shared_pages"sv, merged_pages.shared_pages));
+    TRY(json.add("merged_sharing_pages"sv, merged_pages.sharing_pages));
+    TRY(json.add("merged_zero_pages"sv, merged_pages.merged_zero_pages));
+    TRY(json.add("merged_pages"sv, merged_pages.merged_pages));
+    TRY(json.add("merge_scanned_pages"sv, merged_pages.scanned_pages));
+    TRY(json.add("merge_full_scans"sv, merged_pages.full_scans));
     TRY(json.finish());
     return {};
 }
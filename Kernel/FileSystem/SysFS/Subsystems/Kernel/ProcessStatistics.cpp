@@ -0,0 +1,276 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Try.h>
+#include <Kernel/API/ProcessStatistics.h>
+#include <Kernel/Devices/TTY/TTY.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/ProcessStatistics.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Scheduler.h>
+
+namespace Kernel {
+
+struct SysFSProcessStatisticsData : public SysFSInodeData {
+    u64 generation { 0 };
+};
+
+UNMAP_AFTER_INIT SysFSProcessStatistics::SysFSProcessStatistics(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSProcessStatistics> SysFSProcessStatistics::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSProcessStatistics(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSProcessStatistics::refresh_data(OpenFileDescription& description) const
+{
+    MutexLocker lock(m_refresh_lock);
+    auto& cached_data = description.data();
+    if (!cached_data) {
+        cached_data = adopt_own_if_nonnull(new (nothrow) SysFSProcessStatisticsData);
+        if (!cached_data)
+            return ENOMEM;
+    }
+    auto& typed_cached_data = static_cast<SysFSProcessStatisticsData&>(*cached_data);
+
+    auto builder = TRY(KBufferBuilder::try_create());
+    auto generation = TRY(const_cast<SysFSProcessStatistics&>(*this).try_generate_snapshot(builder, typed_cached_data.generation));
+    typed_cached_data.buffer = builder.build();
+    if (!typed_cached_data.buffer)
+        return ENOMEM;
+    typed_cached_data.generation = generation;
+    return {};
+}
+
+ErrorOr<void> SysFSProcessStatistics::try_generate(KBufferBuilder& builder)
+{
+    (void)TRY(try_generate_snapshot(builder, 0));
+    return {};
+}
+
+template<size_t Size>
+static void copy_to_fixed_buffer(char (&buffer)[Size], StringView string)
+{
+    auto length = min(string.length(), Size - 1);
+    memcpy(buffer, string.characters_without_null_termination(), length);
+    memset(buffer + length, 0, Size - length);
+}
+
+static u64 fingerprint(ReadonlyBytes bytes)
+{
+    // FNV-1a
+    u64 hash = 0xcbf29ce484222325;
+    for (auto byte : bytes)
+        hash = (hash ^ byte) * 0x100000001b3;
+    return hash;
+}
+
+static ErrorOr<void> append_padding(Vector<u8>& buffer)
+{
+    while (buffer.size() % 8)
+        TRY(buffer.try_append(0));
+    return {};
+}
+
+ErrorOr<void> SysFSProcessStatistics::try_serialize_process(Process const& process)
+{
+    m_entry_buffer.clear_with_capacity();
+
+    ProcessStatisticsEntry entry {};
+    entry.pid = process.pid().value();
+    if (auto tty = process.tty())
+        entry.pgid = tty->pgid().value();
+    entry.pgp = process.pgid().value();
+    entry.sid = process.sid().value();
+    auto credentials = process.credentials();
+    entry.uid = credentials->uid().value();
+    entry.gid = credentials->gid().value();
+    entry.ppid = process.ppid().value();
+    entry.is_kernel = process.is_kernel_process();
+    entry.is_dumpable = process.is_dumpable();
+    entry.creation_time_ns = process.creation_time().nanoseconds_since_epoch();
+    process.name().with([&](auto& process_name) { copy_to_fixed_buffer(entry.name, process_name.representable_view()); });
+
+    TRY(process.address_space().with([&](auto& space) -> ErrorOr<void> {
+        entry.amount_virtual = space->amount_virtual();
+        entry.amount_resident = space->amount_resident();
+        entry.amount_dirty_private = space->amount_dirty_private();
+        entry.amount_clean_inode = TRY(space->amount_clean_inode());
+        entry.amount_shared = space->amount_shared();
+        entry.amount_purgeable_volatile = space->amount_purgeable_volatile();
+        entry.amount_purgeable_nonvolatile = space->amount_purgeable_nonvolatile();
+        return {};
+    }));
+
+    StringBuilder pledge_builder;
+    entry.veil = ProcessStatisticsVeilState::NotApplicable;
+    if (process.is_user_process()) {
+#define __ENUMERATE_PLEDGE_PROMISE(promise)    \
+    if (process.has_promised(Pledge::promise)) \
+        TRY(pledge_builder.try_append(#promise " "sv));
+        ENUMERATE_PLEDGE_PROMISES
+#undef __ENUMERATE_PLEDGE_PROMISE
+
+        switch (process.veil_state()) {
+        case VeilState::None:
+            entry.veil = ProcessStatisticsVeilState::None;
+            break;
+        case VeilState::Dropped:
+            entry.veil = ProcessStatisticsVeilState::Dropped;
+            break;
+        case VeilState::Locked:
+        case VeilState::LockedInherited:
+            // Note: Just like /sys/kernel/processes, we don't reveal who locked the veil.
+            entry.veil = ProcessStatisticsVeilState::Locked;
+            break;
+        }
+    }
+
+    OwnPtr<KString> executable;
+    if (process.executable())
+        executable = TRY(process.executable()->try_serialize_absolute_path());
+    OwnPtr<KString> tty_name;
+    if (process.tty())
+        tty_name = TRY(process.tty()->pseudo_name());
+
+    auto executable_view = executable ? executable->view() : ""sv;
+    auto tty_view = tty_name ? tty_name->view() : ""sv;
+    auto pledge_view = pledge_builder.string_view();
+    entry.executable_length = min(executable_view.length(), NumericLimits<u16>::max());
+    entry.tty_length = min(tty_view.length(), NumericLimits<u16>::max());
+    entry.pledge_length = min(pledge_view.length(), NumericLimits<u16>::max());
+
+    // The entry header goes in last, once we know how many threads there are.
+    TRY(m_entry_buffer.try_resize(sizeof(entry)));
+    TRY(m_entry_buffer.try_append(reinterpret_cast<u8 const*>(executable_view.characters_without_null_termination()), entry.executable_length));
+    TRY(m_entry_buffer.try_append(reinterpret_cast<u8 const*>(tty_view.characters_without_null_termination()), entry.tty_length));
+    TRY(m_entry_buffer.try_append(reinterpret_cast<u8 const*>(pledge_view.characters_without_null_termination()), entry.pledge_length));
+    TRY(append_padding(m_entry_buffer));
+
+    TRY(process.try_for_each_thread([&](Thread const& thread) -> ErrorOr<void> {
+        SpinlockLocker locker(thread.get_lock());
+        ThreadStatisticsEntry thread_entry {};
+        thread_entry.tid = thread.tid().value();
+        thread_entry.times_scheduled = thread.times_scheduled();
+        thread_entry.cpu = thread.cpu();
+        thread_entry.priority = thread.priority();
+        thread_entry.syscall_count = thread.syscall_count();
+        thread_entry.inode_faults = thread.inode_faults();
+        thread_entry.zero_faults = thread.zero_faults();
+        thread_entry.cow_faults = thread.cow_faults();
+        thread_entry.time_user = thread.time_in_user();
+        thread_entry.time_kernel = thread.time_in_kernel();
+        thread_entry.file_read_bytes = thread.file_read_bytes();
+        thread_entry.file_write_bytes = thread.file_write_bytes();
+        thread_entry.unix_socket_read_bytes = thread.unix_socket_read_bytes();
+        thread_entry.unix_socket_write_bytes = thread.unix_socket_write_bytes();
+        thread_entry.ipv4_socket_read_bytes = thread.ipv4_socket_read_bytes();
+        thread_entry.ipv4_socket_write_bytes = thread.ipv4_socket_write_bytes();
+        copy_to_fixed_buffer(thread_entry.state, thread.state_string());
+        thread.name().with([&](auto& thread_name) { copy_to_fixed_buffer(thread_entry.name, thread_name.representable_view()); });
+        TRY(m_entry_buffer.try_append(reinterpret_cast<u8 const*>(&thread_entry), sizeof(thread_entry)));
+        ++entry.thread_count;
+        return {};
+    }));
+
+    entry.entry_size = m_entry_buffer.size();
+    memcpy(m_entry_buffer.data(), &entry, sizeof(entry));
+    return {};
+}
+
+ErrorOr<u64> SysFSProcessStatistics::try_generate_snapshot(KBufferBuilder& builder, u64 since_generation)
+{
+    VERIFY(m_refresh_lock.is_locked());
+
+    // Jailed processes only get to see part of the system, so they don't take part in keeping track of changes.
+    bool is_jailed = Process::current().jail().with([](auto const& my_jail) { return my_jail != nullptr; });
+
+    auto generation = ++m_generation;
+    bool full = is_jailed || since_generation == 0 || since_generation >= generation || since_generation < m_forgotten_removal_generation;
+
+    ProcessStatisticsHeader header {};
+    header.magic = ProcessStatisticsHeader::expected_magic;
+    header.version = ProcessStatisticsHeader::expected_version;
+    header.flags = full ? ProcessStatisticsHeader::Full : 0;
+    header.header_size = sizeof(header);
+    header.generation = generation;
+    header.since_generation = full ? 0 : since_generation;
+    auto total_time_scheduled = Scheduler::get_total_time_scheduled();
+    header.total_time = total_time_scheduled.total;
+    header.total_time_kernel = total_time_scheduled.total_kernel;
+
+    // The processes go into their own buffer, as we only know which processes went away once we've seen them all.
+    auto process_builder = TRY(KBufferBuilder::try_create());
+    auto add_process = [&](Process& process) -> ErrorOr<void> {
+        TRY(try_serialize_process(process));
+
+        if (is_jailed) {
+            ++header.process_count;
+            return process_builder.append_bytes(m_entry_buffer.span());
+        }
+
+        auto new_fingerprint = fingerprint(m_entry_buffer.span());
+        if (!m_process_states.contains(process.pid()))
+            TRY(m_process_states.try_set(process.pid(), {}));
+        auto& state = m_process_states.find(process.pid())->value;
+        if (state.changed_in_generation == 0 || state.removed_in_generation != 0 || state.fingerprint != new_fingerprint) {
+            state.fingerprint = new_fingerprint;
+            state.changed_in_generation = generation;
+            state.removed_in_generation = 0;
+        }
+        state.seen_in_generation = generation;
+
+        if (!full && state.changed_in_generation <= since_generation)
+            return {};
+        ++header.process_count;
+        return process_builder.append_bytes(m_entry_buffer.span());
+    };
+
+    // FIXME: Do we actually want to expose the colonel process in a Jail environment?
+    TRY(add_process(*Scheduler::colonel()));
+    TRY(Process::for_each_in_same_jail([&](Process& process) -> ErrorOr<void> {
+        return add_process(process);
+    }));
+
+    Vector<u32> removed_pids;
+    if (!is_jailed) {
+        Vector<ProcessID> forgotten_pids;
+        for (auto& it : m_process_states) {
+            auto& state = it.value;
+            if (state.seen_in_generation != generation && state.removed_in_generation == 0)
+                state.removed_in_generation = generation;
+            if (state.removed_in_generation == 0)
+                continue;
+            if (state.removed_in_generation + removed_process_generations_to_keep < generation) {
+                TRY(forgotten_pids.try_append(it.key));
+                m_forgotten_removal_generation = max(m_forgotten_removal_generation, state.removed_in_generation);
+                continue;
+            }
+            if (!full && state.removed_in_generation > since_generation)
+                TRY(removed_pids.try_append(it.key.value()));
+        }
+        for (auto pid : forgotten_pids)
+            m_process_states.remove(pid);
+    }
+    header.removed_process_count = removed_pids.size();
+
+    TRY(builder.append_bytes({ &header, sizeof(header) }));
+    TRY(builder.append_bytes({ removed_pids.data(), removed_pids.size() * sizeof(u32) }));
+    if (removed_pids.size() % 2) {
+        Array<u8, sizeof(u32)> padding {};
+        TRY(builder.append_bytes(padding));
+    }
+    if (auto processes = process_builder.build())
+        TRY(builder.append_bytes(processes->bytes()));
+    else
+        return ENOMEM;
+    return generation;
+}
+
+}
@@ -0,0 +1,56 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/HashMap.h>
+#include <AK/RefPtr.h>
+#include <AK/Types.h>
+#include <AK/Vector.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/GlobalInformation.h>
+#include <Kernel/Library/KBufferBuilder.h>
+#include <Kernel/Library/UserOrKernelBuffer.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel {
+
+// The binary counterpart of SysFSOverallProcesses, see Kernel/API/ProcessStatistics.h for the format.
+class SysFSProcessStatistics final : public SysFSGlobalInformation {
+public:
+    virtual StringView name() const override { return "process_statistics"sv; }
+
+    static NonnullRefPtr<SysFSProcessStatistics> must_create(SysFSDirectory const& parent_directory);
+
+private:
+    explicit SysFSProcessStatistics(SysFSDirectory const& parent_directory);
+    virtual ErrorOr<void> refresh_data(OpenFileDescription&) const override;
+    virtual ErrorOr<void> try_generate(KBufferBuilder& builder) override;
+
+    virtual bool is_readable_by_jailed_processes() const override { return true; }
+
+    struct ProcessState {
+        u64 fingerprint { 0 };
+        u64 changed_in_generation { 0 };
+        u64 seen_in_generation { 0 };
+        u64 removed_in_generation { 0 };
+    };
+
+    // Returns the generation of the new snapshot.
+    ErrorOr<u64> try_generate_snapshot(KBufferBuilder&, u64 since_generation);
+    ErrorOr<void> try_serialize_process(Process const&);
+
+    // We forget about processes that went away after this many snapshots, readers that
+    // have fallen behind any further get a full snapshot instead.
+    static constexpr u64 removed_process_generations_to_keep = 1024;
+
+    // All of these are protected by m_refresh_lock.
+    HashMap<ProcessID, ProcessState> m_process_states;
+    u64 m_generation { 0 };
+    u64 m_forgotten_removal_generation { 0 };
+    Vector<u8> m_entry_buffer;
+};
+
+}
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObjectSerializer.h>
+#include <Kernel/API/SyscallString.h>
+#include <Kernel/FileSystem/SysFS/Subsystems/Kernel/SyscallStatistics.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/SyscallStatistics.h>
+
+namespace Kernel {
+
+UNMAP_AFTER_INIT SysFSSyscallStatistics::SysFSSyscallStatistics(SysFSDirectory const& parent_directory)
+    : SysFSGlobalInformation(parent_directory)
+{
+}
+
+UNMAP_AFTER_INIT NonnullRefPtr<SysFSSyscallStatistics> SysFSSyscallStatistics::must_create(SysFSDirectory const& parent_directory)
+{
+    return adopt_ref_if_nonnull(new (nothrow) SysFSSyscallStatistics(parent_directory)).release_nonnull();
+}
+
+ErrorOr<void> SysFSSyscallStatistics::try_generate(KBufferBuilder& builder)
+{
+    if (!SyscallStatistics::is_initialized())
+        return ENOTSUP;
+
+    auto& statistics = SyscallStatistics::the();
+    auto counters = TRY(adopt_nonnull_own_or_enomem(new (nothrow) SyscallStatistics::CounterArray));
+    statistics.sum_counters(*counters);
+    auto time_scale = statistics.time_scale();
+
+    auto json = TRY(JsonObjectSerializer<>::try_create(builder));
+    auto bucket_limits = TRY(json.add_array("histogram_bucket_limits_ns"sv));
+    for (size_t bucket = 0; bucket < SyscallStatistics::histogram_bucket_count - 1; ++bucket)
+        TRY(bucket_limits.add(time_scale.to_nanoseconds(SyscallStatistics::histogram_bucket_limit(bucket))));
+    TRY(bucket_limits.finish());
+
+    auto syscalls = TRY(json.add_array("syscalls"sv));
+    for (size_t function = 0; function < Syscall::Function::__Count; ++function) {
+        auto const& syscall = (*counters)[function];
+        if (syscall.calls == 0)
+            continue;
+        auto obj = TRY(syscalls.add_object());
+        TRY(obj.add("name"sv, Syscall::to_string(static_cast<Syscall::Function>(function))));
+        TRY(obj.add("number"sv, function));
+        TRY(obj.add("calls"sv, syscall.calls));
+        TRY(obj.add("errors"sv, syscall.errors));
+        TRY(obj.add("total_time_ns"sv, time_scale.to_nanoseconds(syscall.total_time)));
+        TRY(obj.add("max_time_ns"sv, time_scale.to_nanoseconds(syscall.max_time)));
+        auto histogram = TRY(obj.add_array("histogram"sv));
+        for (auto count : syscall.histogram)
+            TRY(histogram.add(count));
+        TRY(histogram.finish());
+        TRY(obj.finish());
+    }
+    TRY(syscalls.finish());
+    TRY(json.finish());
+    return {};
+}
+
+}
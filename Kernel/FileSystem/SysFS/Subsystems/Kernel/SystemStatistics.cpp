@@ -9,6 +9,7 @@
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/Scheduler.h>
 #include <Kernel/Time/TimeManagement.h>
+#include <Kernel/Time/TimerQueue.h>
 
 namespace Kernel {
 
@@ -30,10 +31,24 @@ ErrorOr<void> SysFSSystemStatistics::try_generate(KBufferBuilder& builder)
     TRY(json.add("kernel_time"sv, total_time_scheduled.total_kernel));
     TRY(json.add("user_time"sv, total_time_scheduled.total - total_time_scheduled.total_kernel));
     u64 idle_time = 0;
+    u64 tlb_shootdowns = 0;
+    u64 tlb_flushed_pages = 0;
     Processor::for_each([&](Processor& processor) {
         idle_time += processor.time_spent_idle();
+        tlb_shootdowns += processor.tlb_shootdowns();
+        tlb_flushed_pages += processor.tlb_flushed_pages();
     });
     TRY(json.add("idle_time"sv, idle_time));
+    TRY(json.add("tlb_shootdowns"sv, tlb_shootdowns));
+    TRY(json.add("tlb_flushed_pages"sv, tlb_flushed_pages));
+    auto tick_statistics = TimeManagement::the().tick_statistics();
+    TRY(json.add("timer_ticks"sv, tick_statistics.timer_ticks));
+    TRY(json.add("tickless_idle_periods"sv, tick_statistics.tickless_idle_periods));
+    auto timer_statistics = TimerQueue::the().statistics();
+    TRY(json.add("queued_timers"sv, timer_statistics.queued_timers));
+    TRY(json.add("added_timers"sv, timer_statistics.added_timers));
+    TRY(json.add("fired_timers"sv, timer_statistics.fired_timers));
+    TRY(json.add("cascaded_timers"sv, timer_statistics.cascaded_timers));
     TRY(json.finish());
     return {};
 }
@@ -0,0 +1,99 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/HashFunctions.h>
+#include <Kernel/Library/StdLib.h>
+#include <Kernel/Locking/LockContention.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+Atomic<bool> LockContention::s_enabled { false };
+Atomic<u64> LockContention::s_dropped_contentions { 0 };
+
+static constexpr size_t call_site_count = 1024;
+static constexpr size_t max_probe_count = 16;
+static Array<LockContention::CallSite, call_site_count> s_call_sites;
+
+void LockContention::set_enabled(bool enabled)
+{
+    if (enabled && !is_enabled()) {
+        // Start out with a clean slate. Nobody records anything while we're disabled, so this is fine.
+        for (auto& call_site : s_call_sites) {
+            call_site.contentions.store(0, AK::MemoryOrder::memory_order_relaxed);
+            call_site.total_wait_time.store(0, AK::MemoryOrder::memory_order_relaxed);
+            call_site.max_wait_time.store(0, AK::MemoryOrder::memory_order_relaxed);
+            call_site.address.store(0, AK::MemoryOrder::memory_order_release);
+        }
+        s_dropped_contentions.store(0, AK::MemoryOrder::memory_order_relaxed);
+    }
+    s_enabled.store(enabled, AK::MemoryOrder::memory_order_release);
+}
+
+u64 LockContention::current_time()
+{
+    return TimeManagement::scheduler_current_time();
+}
+
+static LockContention::CallSite* find_or_claim_call_site(FlatPtr address, bool& claimed)
+{
+    claimed = false;
+    auto index = ptr_hash(address) % call_site_count;
+    for (size_t i = 0; i < max_probe_count; ++i) {
+        auto& call_site = s_call_sites[(index + i) % call_site_count];
+        auto current_address = call_site.address.load(AK::MemoryOrder::memory_order_acquire);
+        if (current_address == address)
+            return &call_site;
+        if (current_address != 0)
+            continue;
+        FlatPtr expected = 0;
+        if (call_site.address.compare_exchange_strong(expected, address, AK::MemoryOrder::memory_order_acq_rel)) {
+            claimed = true;
+            return &call_site;
+        }
+        if (expected == address)
+            return &call_site;
+    }
+    return nullptr;
+}
+
+void LockContention::record(LockContentionType type, void const* lock, StringView lock_name, FlatPtr call_site_address, [[maybe_unused]] LockLocation const& location, u64 wait_time)
+{
+    bool claimed = false;
+    auto* call_site = find_or_claim_call_site(call_site_address, claimed);
+    if (!call_site) {
+        s_dropped_contentions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        return;
+    }
+
+    if (claimed) {
+        // NOTE: Whoever reads this concurrently might see a half-written name, which is fine for statistics.
+        call_site->type = type;
+        call_site->lock = bit_cast<FlatPtr>(lock);
+        auto name_length = min(lock_name.length(), sizeof(call_site->lock_name) - 1);
+        memcpy(call_site->lock_name, lock_name.characters_without_null_termination(), name_length);
+        call_site->lock_name[name_length] = '\0';
+#if LOCK_DEBUG
+        call_site->file = location.filename();
+        call_site->function = location.function_name();
+        call_site->line = location.line_number();
+#endif
+    }
+
+    call_site->contentions.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+    call_site->total_wait_time.fetch_add(wait_time, AK::MemoryOrder::memory_order_relaxed);
+    auto max_wait_time = call_site->max_wait_time.load(AK::MemoryOrder::memory_order_relaxed);
+    while (wait_time > max_wait_time && !call_site->max_wait_time.compare_exchange_strong(max_wait_time, wait_time, AK::MemoryOrder::memory_order_relaxed))
+        ;
+}
+
+ReadonlySpan<LockContention::CallSite> LockContention::call_sites()
+{
+    return s_call_sites.span();
+}
+
+}
@@ -0,0 +1,62 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <AK/Span.h>
+#include <AK/StringView.h>
+#include <AK/Types.h>
+#include <Kernel/Locking/LockLocation.h>
+
+namespace Kernel {
+
+enum class LockContentionType : u8 {
+    Spinlock,
+    RecursiveSpinlock,
+    Mutex,
+};
+
+// Keeps track of how often, and for how long, we had to wait for a lock, per call site that acquired it.
+// This is off by default, and is turned on through /sys/kernel/conf/lock_contention_profiling. The results
+// can be read from /sys/kernel/lock_contention.
+//
+// Nothing is recorded when a lock is acquired without waiting, so the cost of keeping track of things is
+// only paid by those that have to wait anyway. Recording doesn't allocate or take any locks itself.
+class LockContention {
+public:
+    struct CallSite {
+        Atomic<FlatPtr> address { 0 };
+        LockContentionType type { LockContentionType::Spinlock };
+        FlatPtr lock { 0 };
+        char lock_name[32] {};
+#if LOCK_DEBUG
+        StringView file;
+        StringView function;
+        u32 line { 0 };
+#endif
+        Atomic<u64> contentions { 0 };
+        Atomic<u64> total_wait_time { 0 };
+        Atomic<u64> max_wait_time { 0 };
+    };
+
+    [[nodiscard]] ALWAYS_INLINE static bool is_enabled() { return s_enabled.load(AK::MemoryOrder::memory_order_relaxed); }
+    static void set_enabled(bool);
+
+    // The wait times are in the same unit as the time threads spend being scheduled.
+    static u64 current_time();
+    static void record(LockContentionType, void const* lock, StringView lock_name, FlatPtr call_site, LockLocation const&, u64 wait_time);
+
+    // Only call sites that have been claimed (i.e. have an address) are in use.
+    static ReadonlySpan<CallSite> call_sites();
+    static u64 dropped_contentions() { return s_dropped_contentions.load(AK::MemoryOrder::memory_order_relaxed); }
+
+private:
+    static Atomic<bool> s_enabled;
+    static Atomic<u64> s_dropped_contentions;
+};
+
+}
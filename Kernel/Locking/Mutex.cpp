@@ -7,16 +7,18 @@
 
 #include <Kernel/Debug.h>
 #include <Kernel/KSyms.h>
+#include <Kernel/Locking/LockContention.h>
 #include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/Mutex.h>
 #include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Tasks/PerformanceManager.h>
 #include <Kernel/Tasks/Thread.h>
 
 extern bool g_in_early_boot;
 
 namespace Kernel {
 
-void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
+void Mutex::lock(Mode mode, LockLocation const& location)
 {
     // NOTE: This may be called from an interrupt handler (not an IRQ handler)
     // and also from within critical sections!
@@ -60,7 +62,7 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
     case Mode::Exclusive: {
         VERIFY(m_holder);
         if (m_holder != bit_cast<uintptr_t>(current_thread)) {
-            block(*current_thread, mode, lock, 1);
+            block(*current_thread, mode, lock, 1, bit_cast<FlatPtr>(__builtin_return_address(0)), location);
             did_block = true;
             // If we blocked then m_mode should have been updated to what we requested
             VERIFY(m_mode == mode);
@@ -106,7 +108,7 @@ void Mutex::lock(Mode mode, [[maybe_unused]] LockLocation const& location)
             // and is asking to upgrade the lock to be exclusive without first releasing the shared lock. We have no
             // allocation-free way to detect such a scenario, so if you suspect that this is the cause of your deadlock,
             // try turning on LOCK_SHARED_UPGRADE_DEBUG.
-            block(*current_thread, mode, lock, 1);
+            block(*current_thread, mode, lock, 1, bit_cast<FlatPtr>(__builtin_return_address(0)), location);
             did_block = true;
             VERIFY(m_mode == mode);
         }
@@ -207,7 +209,7 @@ void Mutex::unlock()
     }
 }
 
-void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<LockRank::None>>& lock, u32 requested_locks)
+void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<LockRank::None>>& lock, u32 requested_locks, FlatPtr call_site, LockLocation const& location)
 {
     if constexpr (LOCK_IN_CRITICAL_DEBUG) {
         // There are no interrupts enabled in early boot.
@@ -227,7 +229,14 @@ void Mutex::block(Thread& current_thread, Mode mode, SpinlockLocker<Spinlock<Loc
     });
 
     dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) waiting...", this, m_name);
+    bool is_profiling_contention = LockContention::is_enabled();
+    u64 start_time = is_profiling_contention ? LockContention::current_time() : 0;
     current_thread.block(*this, lock, requested_locks);
+    if (is_profiling_contention) {
+        auto wait_time = LockContention::current_time() - start_time;
+        LockContention::record(LockContentionType::Mutex, this, m_name, call_site, location, wait_time);
+        PerformanceManager::add_lock_contention_event(current_thread, bit_cast<FlatPtr>(this), wait_time);
+    }
     dbgln_if(LOCK_TRACE_DEBUG, "Mutex::lock @ {} ({}) waited", this, m_name);
 
     m_blocked_thread_lists.with([&](auto& lists) {
@@ -326,7 +335,7 @@ auto Mutex::force_unlock_exclusive_if_locked(u32& lock_count_to_restore) -> Mode
     return current_mode;
 }
 
-void Mutex::restore_exclusive_lock(u32 lock_count, [[maybe_unused]] LockLocation const& location)
+void Mutex::restore_exclusive_lock(u32 lock_count, LockLocation const& location)
 {
     VERIFY(m_behavior == MutexBehavior::BigLock);
     VERIFY(lock_count > 0);
@@ -337,7 +346,7 @@ void Mutex::restore_exclusive_lock(u32 lock_count, [[maybe_unused]] LockLocation
     SpinlockLocker lock(m_lock);
     [[maybe_unused]] auto previous_mode = m_mode;
     if (m_mode == Mode::Exclusive && m_holder != bit_cast<uintptr_t>(current_thread)) {
-        block(*current_thread, Mode::Exclusive, lock, lock_count);
+        block(*current_thread, Mode::Exclusive, lock, lock_count, bit_cast<FlatPtr>(__builtin_return_address(0)), location);
         did_block = true;
         // If we blocked then m_mode should have been updated to what we requested
         VERIFY(m_mode == Mode::Exclusive);
@@ -83,7 +83,7 @@ private:
     using BigLockBlockedThreadList = IntrusiveList<&Thread::m_big_lock_blocked_threads_list_node>;
 
     // FIXME: Allow any lock rank.
-    void block(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&, u32);
+    void block(Thread&, Mode, SpinlockLocker<Spinlock<LockRank::None>>&, u32, FlatPtr call_site, LockLocation const&);
     void unblock_waiters(Mode);
 
     StringView m_name;
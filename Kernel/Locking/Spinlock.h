@@ -9,6 +9,8 @@
 #include <AK/Atomic.h>
 #include <AK/Types.h>
 #include <Kernel/Arch/Processor.h>
+#include <Kernel/Locking/LockContention.h>
+#include <Kernel/Locking/LockLocation.h>
 #include <Kernel/Locking/LockRank.h>
 
 namespace Kernel {
@@ -21,13 +23,13 @@ class Spinlock {
 public:
     Spinlock() = default;
 
-    InterruptsState lock()
+    InterruptsState lock(LockLocation const& location = LockLocation::current())
     {
         InterruptsState previous_interrupts_state = Processor::interrupts_state();
         Processor::enter_critical();
         Processor::disable_interrupts();
-        while (m_lock.exchange(1, AK::memory_order_acquire) != 0)
-            Processor::wait_check();
+        if (m_lock.exchange(1, AK::memory_order_acquire) != 0) [[unlikely]]
+            wait_for_lock(location);
         track_lock_acquire(m_rank);
         return previous_interrupts_state;
     }
@@ -53,6 +55,19 @@ public:
     }
 
 private:
+    // NOTE: This is out of line so that our return address tells us who is waiting for the lock.
+    NEVER_INLINE void wait_for_lock(LockLocation const& location)
+    {
+        auto call_site = bit_cast<FlatPtr>(__builtin_return_address(0));
+        bool is_profiling_contention = LockContention::is_enabled();
+        u64 start_time = is_profiling_contention ? LockContention::current_time() : 0;
+        do {
+            Processor::wait_check();
+        } while (m_lock.exchange(1, AK::memory_order_acquire) != 0);
+        if (is_profiling_contention)
+            LockContention::record(LockContentionType::Spinlock, this, {}, call_site, location, LockContention::current_time() - start_time);
+    }
+
     Atomic<u8> m_lock { 0 };
     static constexpr LockRank const m_rank { Rank };
 };
@@ -65,7 +80,7 @@ class RecursiveSpinlock {
 public:
     RecursiveSpinlock() = default;
 
-    InterruptsState lock()
+    InterruptsState lock(LockLocation const& location = LockLocation::current())
     {
         InterruptsState previous_interrupts_state = Processor::interrupts_state();
         Processor::disable_interrupts();
@@ -73,18 +88,34 @@ public:
         auto& proc = Processor::current();
         FlatPtr cpu = FlatPtr(&proc);
         FlatPtr expected = 0;
-        while (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel)) {
-            if (expected == cpu)
-                break;
-            Processor::wait_check();
-            expected = 0;
-        }
+        if (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel) && expected != cpu) [[unlikely]]
+            wait_for_lock(cpu, location);
         if (m_recursions == 0)
             track_lock_acquire(m_rank);
         m_recursions++;
         return previous_interrupts_state;
     }
 
+    // Like lock(), but gives up instead of spinning if another processor is holding the lock.
+    bool try_lock(InterruptsState& previous_interrupts_state)
+    {
+        previous_interrupts_state = Processor::interrupts_state();
+        Processor::disable_interrupts();
+        Processor::enter_critical();
+        auto& proc = Processor::current();
+        FlatPtr cpu = FlatPtr(&proc);
+        FlatPtr expected = 0;
+        if (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel) && expected != cpu) {
+            Processor::leave_critical();
+            Processor::restore_interrupts_state(previous_interrupts_state);
+            return false;
+        }
+        if (m_recursions == 0)
+            track_lock_acquire(m_rank);
+        m_recursions++;
+        return true;
+    }
+
     void unlock(InterruptsState previous_interrupts_state)
     {
         VERIFY_INTERRUPTS_DISABLED();
@@ -115,6 +146,21 @@ public:
     }
 
 private:
+    // NOTE: This is out of line so that our return address tells us who is waiting for the lock.
+    NEVER_INLINE void wait_for_lock(FlatPtr cpu, LockLocation const& location)
+    {
+        auto call_site = bit_cast<FlatPtr>(__builtin_return_address(0));
+        bool is_profiling_contention = LockContention::is_enabled();
+        u64 start_time = is_profiling_contention ? LockContention::current_time() : 0;
+        FlatPtr expected;
+        do {
+            Processor::wait_check();
+            expected = 0;
+        } while (!m_lock.compare_exchange_strong(expected, cpu, AK::memory_order_acq_rel));
+        if (is_profiling_contention)
+            LockContention::record(LockContentionType::RecursiveSpinlock, this, {}, call_site, location, LockContention::current_time() - start_time);
+    }
+
     Atomic<FlatPtr> m_lock { 0 };
     u32 m_recursions { 0 };
     static constexpr LockRank const m_rank { Rank };
@@ -128,11 +174,11 @@ public:
     SpinlockLocker() = delete;
     SpinlockLocker& operator=(SpinlockLocker&&) = delete;
 
-    SpinlockLocker(LockType& lock)
+    SpinlockLocker(LockType& lock, LockLocation const& location = LockLocation::current())
         : m_lock(&lock)
     {
         VERIFY(m_lock);
-        m_previous_interrupts_state = m_lock->lock();
+        m_previous_interrupts_state = m_lock->lock(location);
         m_have_lock = true;
     }
 
@@ -153,11 +199,11 @@ public:
         }
     }
 
-    ALWAYS_INLINE void lock()
+    ALWAYS_INLINE void lock(LockLocation const& location = LockLocation::current())
     {
         VERIFY(m_lock);
         VERIFY(!m_have_lock);
-        m_previous_interrupts_state = m_lock->lock();
+        m_previous_interrupts_state = m_lock->lock(location);
         m_have_lock = true;
     }
 
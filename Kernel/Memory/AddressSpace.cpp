@@ -12,6 +12,7 @@
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/InodeVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/TLBFlushBatch.h>
 #include <Kernel/Security/Random.h>
 #include <Kernel/Tasks/PerformanceManager.h>
 #include <Kernel/Tasks/PowerStateSwitchTask.h>
@@ -73,18 +74,22 @@ ErrorOr<void> AddressSpace::unmap_mmap_range(VirtualAddress addr, size_t size)
         if (old_region->is_immutable())
             return EPERM;
 
+        TLBFlushBatch tlb_flush_batch(page_directory());
+
         // Remove the old region from our regions tree, since were going to add another region
         // with the exact same start address.
         auto region = take_region(*old_region);
-        region->unmap();
+        tlb_flush_batch.add(region->range());
+        region->unmap(ShouldFlushTLB::No);
 
         auto new_regions = TRY(try_split_region_around_range(*region, range_to_unmap));
 
         // And finally we map the new region(s) using our page directory (they were just allocated and don't have one).
+        // The old region's range gets flushed once we're done, which covers the new regions as well.
         for (auto* new_region : new_regions) {
             // TODO: Ideally we should do this in a way that can be rolled back on failure, as failing here
             // leaves the caller in an undefined state.
-            TRY(new_region->map(page_directory()));
+            TRY(new_region->map(page_directory(), ShouldFlushTLB::No));
         }
 
         PerformanceManager::add_unmap_perf_event(Process::current(), range_to_unmap);
@@ -108,17 +113,21 @@ ErrorOr<void> AddressSpace::unmap_mmap_range(VirtualAddress addr, size_t size)
 
     Vector<Region*, 2> new_regions;
 
+    // Invalidate the TLB once for all affected regions, instead of once per region.
+    TLBFlushBatch tlb_flush_batch(page_directory());
+
     for (auto* old_region : regions) {
         // If it's a full match we can remove the entire old region.
         if (old_region->range().intersect(range_to_unmap).size() == old_region->size()) {
-            deallocate_region(*old_region);
+            tlb_flush_batch.unmap_and_release(take_region(*old_region));
             continue;
         }
 
         // Remove the old region from our regions tree, since were going to add another region
         // with the exact same start address.
         auto region = take_region(*old_region);
-        region->unmap();
+        tlb_flush_batch.add(region->range());
+        region->unmap(ShouldFlushTLB::No);
 
         // Otherwise, split the regions and collect them for future mapping.
         auto split_regions = TRY(try_split_region_around_range(*region, range_to_unmap));
@@ -129,7 +138,7 @@ ErrorOr<void> AddressSpace::unmap_mmap_range(VirtualAddress addr, size_t size)
     for (auto* new_region : new_regions) {
         // TODO: Ideally we should do this in a way that can be rolled back on failure, as failing here
         // leaves the caller in an undefined state.
-        TRY(new_region->map(page_directory()));
+        TRY(new_region->map(page_directory(), ShouldFlushTLB::No));
     }
 
     PerformanceManager::add_unmap_perf_event(Process::current(), range_to_unmap);
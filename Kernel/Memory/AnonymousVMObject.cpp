@@ -4,12 +4,15 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/ScopeGuard.h>
+#include <Kernel/Arch/PageDirectory.h>
 #include <Kernel/Arch/SafeMem.h>
 #include <Kernel/Arch/SmapDisabler.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PhysicalPage.h>
+#include <Kernel/Memory/SamePageMerger.h>
 #include <Kernel/Tasks/Process.h>
 
 namespace Kernel::Memory {
@@ -37,8 +40,12 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
             ++new_cow_pages_needed;
     }
 
-    if (new_cow_pages_needed == 0)
-        return TRY(try_create_with_size(size(), AllocationStrategy::None));
+    if (new_cow_pages_needed == 0) {
+        auto clone = TRY(try_create_with_size(size(), AllocationStrategy::None));
+        if (m_mergeable)
+            TRY(clone->set_mergeable(true));
+        return clone;
+    }
 
     dbgln_if(COMMIT_DEBUG, "Cloning {:p}, need {} committed cow pages", this, new_cow_pages_needed);
 
@@ -54,6 +61,14 @@ ErrorOr<NonnullLockRefPtr<VMObject>> AnonymousVMObject::try_clone()
     auto new_physical_pages = TRY(this->try_clone_physical_pages());
     auto clone = TRY(try_create_with_shared_cow(*this, *new_shared_committed_cow_pages, move(new_physical_pages)));
 
+    // Compressed pages are never modified, so the clone can simply share them with us.
+    TRY(clone->m_compressed_pages.try_ensure_capacity(m_compressed_pages.size()));
+    for (auto& it : m_compressed_pages)
+        TRY(clone->m_compressed_pages.try_set(it.key, it.value));
+
+    if (m_mergeable)
+        TRY(clone->set_mergeable(true));
+
     // Both original and clone become COW. So create a COW map for ourselves
     // or reset all pages to be copied again if we were previously cloned
     TRY(ensure_or_reset_cow_map());
@@ -142,6 +157,8 @@ ErrorOr<NonnullLockRefPtr<AnonymousVMObject>> AnonymousVMObject::try_create_with
 AnonymousVMObject::AnonymousVMObject(FixedArray<RefPtr<PhysicalPage>>&& new_physical_pages, AllocationStrategy strategy, Optional<CommittedPhysicalPageSet> committed_pages)
     : VMObject(move(new_physical_pages))
     , m_unused_committed_pages(move(committed_pages))
+    , m_compressible(true)
+    , m_committed(strategy != AllocationStrategy::None)
 {
     if (strategy == AllocationStrategy::AllocateNow) {
         // Allocate all pages right now. We know we can get all because we committed the amount needed
@@ -172,6 +189,8 @@ AnonymousVMObject::AnonymousVMObject(LockWeakPtr<AnonymousVMObject> other, Nonnu
     , m_cow_parent(move(other))
     , m_shared_committed_cow_pages(move(shared_committed_cow_pages))
     , m_purgeable(m_cow_parent.strong_ref()->m_purgeable)
+    , m_compressible(m_cow_parent.strong_ref()->m_compressible)
+    , m_committed(m_cow_parent.strong_ref()->m_committed)
 {
 }
 
@@ -200,10 +219,14 @@ size_t AnonymousVMObject::purge()
         VERIFY(page);
         if (page->is_shared_zero_page())
             continue;
+        // Compressed pages don't occupy a physical page of their own.
+        bool was_compressed = page->is_compressed_page();
         page = MM.shared_zero_page();
-        ++total_pages_purged;
+        if (!was_compressed)
+            ++total_pages_purged;
     }
 
+    m_compressed_pages.clear();
     m_was_purged = true;
 
     for_each_region([](Region& region) {
@@ -340,6 +363,8 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
             m_shared_committed_cow_pages->uncommit_one();
             if (m_shared_committed_cow_pages->is_empty())
                 m_shared_committed_cow_pages = nullptr;
+        } else if (m_merged_committed_pages.has_value() && !m_merged_committed_pages->is_empty()) {
+            m_merged_committed_pages->uncommit_one();
         }
         return PageFaultResponse::Continue;
     }
@@ -348,6 +373,9 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     if (m_shared_committed_cow_pages) {
         dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a committed COW page and it's time to COW!");
         page = m_shared_committed_cow_pages->take_one();
+    } else if (m_merged_committed_pages.has_value() && !m_merged_committed_pages->is_empty()) {
+        dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a committed merged page and it's time to COW!");
+        page = m_merged_committed_pages->take_one();
     } else {
         dbgln_if(PAGE_FAULT_DEBUG, "    >> It's a COW page and it's time to COW!");
         auto page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
@@ -380,6 +408,269 @@ PageFaultResponse AnonymousVMObject::handle_cow_fault(size_t page_index, Virtual
     return PageFaultResponse::Continue;
 }
 
+bool AnonymousVMObject::find_page_directory_for_scanning(PageDirectory*& page_directory, AllowSharedRegions allow_shared_regions)
+{
+    VERIFY(m_lock.is_locked_by_current_processor());
+
+    // We only deal with memory that is mapped into a single userspace address space, to keep this simple.
+    page_directory = nullptr;
+    bool can_scan = true;
+    for_each_region([&](Region& region) {
+        if (!region.is_user() || (region.is_shared() && allow_shared_regions == AllowSharedRegions::No)) {
+            can_scan = false;
+            return;
+        }
+        auto* region_page_directory = region.page_directory({});
+        if (!region_page_directory)
+            return;
+        if (page_directory && page_directory != region_page_directory)
+            can_scan = false;
+        page_directory = region_page_directory;
+    });
+    return can_scan;
+}
+
+size_t AnonymousVMObject::compress_cold_pages(size_t page_count_to_reclaim)
+{
+    if (!m_compressible || page_count() == 0)
+        return 0;
+
+    // NOTE: A compressed page goes back to the system, and bringing it back in takes a page from wherever we can
+    //       find one. That's fine for overcommitted memory, where faulting in a page could always fail, but it would
+    //       break the promise that faulting in committed memory never fails. Keeping a page committed for every
+    //       compressed page wouldn't free up anything, so we leave committed memory alone.
+    if (m_committed)
+        return 0;
+
+    // NOTE: We get here while someone is trying to allocate memory, and they might be holding the locks of
+    //       VMObjects or page directories (possibly including ours) while doing so. To avoid deadlocks, we
+    //       simply skip over anything that we can't lock right away.
+    if (m_lock.is_locked_by_current_processor())
+        return 0;
+    InterruptsState previous_interrupts_state;
+    if (!m_lock.try_lock(previous_interrupts_state))
+        return 0;
+    ScopeGuard unlock_vmobject = [&] { m_lock.unlock(previous_interrupts_state); };
+
+    // Volatile memory is purged instead.
+    if (is_volatile())
+        return 0;
+
+    PageDirectory* page_directory = nullptr;
+    if (!find_page_directory_for_scanning(page_directory, AllowSharedRegions::Yes))
+        return 0;
+
+    InterruptsState previous_page_directory_interrupts_state;
+    if (page_directory) {
+        if (page_directory->get_lock().is_locked_by_current_processor())
+            return 0;
+        if (!page_directory->get_lock().try_lock(previous_page_directory_interrupts_state))
+            return 0;
+    }
+    ScopeGuard unlock_page_directory = [&] {
+        if (page_directory)
+            page_directory->get_lock().unlock(previous_page_directory_interrupts_state);
+    };
+
+    size_t reclaimed_page_count = 0;
+    for (size_t scanned_page_count = 0; scanned_page_count < page_count() && reclaimed_page_count < page_count_to_reclaim; ++scanned_page_count) {
+        auto page_index = m_compression_scan_index;
+        m_compression_scan_index = (m_compression_scan_index + 1) % page_count();
+
+        auto& page_slot = m_physical_pages[page_index];
+        if (!page_slot || page_slot->is_shared_zero_page() || page_slot->is_lazy_committed_page() || page_slot->is_compressed_page())
+            continue;
+        // If anyone else is holding on to this page (like a COW sibling, or the kernel), we leave it alone.
+        if (page_slot->ref_count() != 1)
+            continue;
+
+        bool was_accessed = false;
+        for_each_region([&](Region& region) {
+            if (region.is_mapped() && region.test_and_clear_accessed({}, page_index))
+                was_accessed = true;
+        });
+        if (was_accessed)
+            continue;
+
+        // Make sure nobody can modify the page anymore while we're compressing it.
+        for_each_region([&](Region& region) {
+            if (region.is_mapped())
+                region.unmap_vmobject_page({}, page_index);
+        });
+
+        // NOTE: Once the store has taken the page, we can't back out anymore, so make sure we have room for it first.
+        RefPtr<PhysicalPage> page = page_slot;
+        auto result = [&]() -> ErrorOr<void> {
+            TRY(m_compressed_pages.try_ensure_capacity(m_compressed_pages.size() + 1));
+            auto compressed_page = TRY(CompressedPageStore::the().try_compress(page));
+            MUST(m_compressed_pages.try_set(page_index, move(compressed_page)));
+            return {};
+        }();
+
+        if (result.is_error()) {
+            for_each_region([&](Region& region) {
+                if (region.is_mapped())
+                    region.restore_vmobject_page({}, page_index, *page_slot);
+            });
+            dbgln_if(COMPRESSED_PAGE_STORE_DEBUG, "Unable to compress page {} of {:p}: {}", page_index, this, result.error());
+            // If the store is full, there's no point in trying any other pages.
+            if (result.error().code() == ENOSPC)
+                break;
+            continue;
+        }
+
+        page_slot = MM.compressed_page();
+
+        // If the store didn't keep the page for itself, it goes back to the system once we let go of it.
+        if (page)
+            ++reclaimed_page_count;
+    }
+
+    return reclaimed_page_count;
+}
+
+PageFaultResponse AnonymousVMObject::handle_compressed_fault(size_t page_index)
+{
+    // NOTE: We have to allocate before taking our lock, as the allocation may need to compress some pages first.
+    auto page_or_error = CompressedPageStore::the().allocate_page_for_decompression();
+    if (page_or_error.is_error()) {
+        dmesgln("MM: handle_compressed_fault was unable to allocate a physical page");
+        return PageFaultResponse::OutOfMemory;
+    }
+    auto page = page_or_error.release_value();
+
+    SpinlockLocker lock(m_lock);
+
+    auto& page_slot = physical_pages()[page_index];
+    if (!page_slot->is_compressed_page()) {
+        dbgln_if(PAGE_FAULT_DEBUG, "    >> Compressed page was brought back in by someone else");
+        return PageFaultResponse::Continue;
+    }
+
+    auto compressed_page = m_compressed_pages.take(page_index);
+    VERIFY(compressed_page.has_value());
+    if (auto result = CompressedPageStore::the().decompress(*compressed_page.value(), *page); result.is_error()) {
+        dmesgln("MM: handle_compressed_fault was unable to decompress page: {}", result.error());
+        return PageFaultResponse::ShouldCrash;
+    }
+
+    dbgln_if(PAGE_FAULT_DEBUG, "      >> DECOMPRESSED {} ({} bytes)", page->paddr(), compressed_page.value()->compressed_size());
+    page_slot = move(page);
+    return PageFaultResponse::Continue;
+}
+
+void AnonymousVMObject::discard_compressed_page(size_t page_index)
+{
+    VERIFY(m_lock.is_locked_by_current_processor());
+    m_compressed_pages.remove(page_index);
+}
+
+ErrorOr<void> AnonymousVMObject::set_mergeable(bool mergeable)
+{
+    // Only plain anonymous memory can be merged. Purgeable memory gives up its COW map when it's made
+    // volatile, so we can't keep its merged pages from being written to.
+    if (!m_compressible || is_purgeable())
+        return EINVAL;
+
+    SpinlockLocker locker(m_lock);
+    if (mergeable && m_merge_checksums.is_empty())
+        m_merge_checksums = TRY(FixedArray<u32>::create(page_count()));
+    m_mergeable = mergeable;
+    return {};
+}
+
+size_t AnonymousVMObject::merge_identical_pages(size_t page_count_to_scan)
+{
+    auto& merger = SamePageMerger::the();
+
+    SpinlockLocker locker(m_lock);
+    if (!m_mergeable || page_count() == 0)
+        return 0;
+
+    // NOTE: While we share committed COW pages with a clone, a COW fault can't tell whether it is
+    //       breaking up a merged page or one shared with the clone, so we leave such memory alone.
+    if (m_shared_committed_cow_pages && m_shared_committed_cow_pages->is_empty())
+        m_shared_committed_cow_pages = nullptr;
+    if (m_shared_committed_cow_pages)
+        return 0;
+
+    PageDirectory* page_directory = nullptr;
+    if (!find_page_directory_for_scanning(page_directory, AllowSharedRegions::No) || !page_directory)
+        return 0;
+
+    // NOTE: Mapping a region takes the page directory lock before our lock, so we can't wait for it here.
+    InterruptsState previous_page_directory_interrupts_state;
+    if (!page_directory->get_lock().try_lock(previous_page_directory_interrupts_state))
+        return 0;
+    ScopeGuard unlock_page_directory = [&] {
+        page_directory->get_lock().unlock(previous_page_directory_interrupts_state);
+    };
+
+    auto update_mappings = [&](size_t page_index) {
+        for_each_region([&](Region& region) {
+            region.update_vmobject_page({}, page_index);
+        });
+    };
+
+    size_t scanned_page_count = 0;
+    for (; scanned_page_count < min(page_count_to_scan, page_count()); ++scanned_page_count) {
+        auto page_index = m_merge_scan_index;
+        m_merge_scan_index = (m_merge_scan_index + 1) % page_count();
+
+        auto& page_slot = m_physical_pages[page_index];
+        if (!page_slot || page_slot->is_shared_zero_page() || page_slot->is_lazy_committed_page() || page_slot->is_compressed_page())
+            continue;
+        // Pages that are already shared (with a COW sibling, or because they have been merged before) are left alone.
+        if (page_slot->ref_count() != 1)
+            continue;
+
+        // Pages that keep changing aren't worth merging, so wait until a page looks the same twice in a row.
+        auto checksum = merger.checksum_page(*page_slot);
+        bool is_stable = m_merge_checksums[page_index] == checksum.value;
+        m_merge_checksums[page_index] = checksum.value;
+        if (!is_stable || !merger.is_merge_candidate({}, checksum))
+            continue;
+
+        // Make sure nobody can modify the page behind our back while we're comparing it to other pages.
+        // If we don't end up merging it, the next write to it will simply make it writable again.
+        if (set_should_cow(page_index, true).is_error())
+            break;
+        update_mappings(page_index);
+
+        auto merged_page = merger.merge_page({}, *page_slot, checksum);
+        if (!merged_page || merged_page == page_slot)
+            continue;
+
+        // If this is committed memory, the page we're giving up stays committed, so that writing to it can't fail.
+        Optional<CommittedPhysicalPageSet> commitment;
+        if (m_unused_committed_pages.has_value()) {
+            auto commitment_or_error = MM.commit_physical_pages(1);
+            if (commitment_or_error.is_error())
+                break;
+            commitment = commitment_or_error.release_value();
+        }
+
+        dbgln_if(SAME_PAGE_MERGER_DEBUG, "Merged page {} of {:p} ({} -> {})", page_index, this, page_slot->paddr(), merged_page->paddr());
+        if (merged_page->is_shared_zero_page()) {
+            // Writes to the shared zero page are handled by zero faults instead, which allocate from our committed pages.
+            MUST(set_should_cow(page_index, false));
+            if (commitment.has_value()) {
+                m_unused_committed_pages->add(commitment.release_value());
+                merged_page = MM.lazy_committed_page();
+            }
+        } else if (commitment.has_value()) {
+            if (m_merged_committed_pages.has_value())
+                m_merged_committed_pages->add(commitment.release_value());
+            else
+                m_merged_committed_pages = commitment.release_value();
+        }
+        page_slot = merged_page.release_nonnull();
+        update_mappings(page_index);
+    }
+
+    return scanned_page_count;
+}
+
 AnonymousVMObject::SharedCommittedCowPages::SharedCommittedCowPages(CommittedPhysicalPageSet&& committed_pages)
     : m_committed_pages(move(committed_pages))
 {
@@ -6,7 +6,9 @@
 
 #pragma once
 
+#include <AK/HashMap.h>
 #include <Kernel/Memory/AllocationStrategy.h>
+#include <Kernel/Memory/CompressedPageStore.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PageFaultResponse.h>
 #include <Kernel/Memory/PhysicalAddress.h>
@@ -38,6 +40,19 @@ public:
 
     size_t purge();
 
+    // Moves pages that haven't been accessed since the last time we looked at them into the
+    // CompressedPageStore. Returns the number of physical pages given back to the system.
+    size_t compress_cold_pages(size_t page_count_to_reclaim);
+    PageFaultResponse handle_compressed_fault(size_t page_index);
+    void discard_compressed_page(size_t page_index);
+
+    bool is_mergeable() const { return m_mergeable; }
+    ErrorOr<void> set_mergeable(bool);
+
+    // Checksums up to the given number of pages, and replaces the ones that haven't changed since we
+    // last looked at them with identical pages from the SamePageMerger. Returns the number of pages scanned.
+    size_t merge_identical_pages(size_t page_count_to_scan);
+
 private:
     class SharedCommittedCowPages;
 
@@ -56,12 +71,28 @@ private:
 
     virtual bool is_anonymous() const override { return true; }
 
+    enum class AllowSharedRegions {
+        No,
+        Yes,
+    };
+    bool find_page_directory_for_scanning(PageDirectory*&, AllowSharedRegions);
+
     ErrorOr<void> ensure_cow_map();
     ErrorOr<void> ensure_or_reset_cow_map();
 
     Optional<CommittedPhysicalPageSet> m_unused_committed_pages;
     Bitmap m_cow_map;
 
+    HashMap<size_t, NonnullRefPtr<CompressedPage>> m_compressed_pages;
+    size_t m_compression_scan_index { 0 };
+
+    FixedArray<u32> m_merge_checksums;
+    size_t m_merge_scan_index { 0 };
+    // Merging a page of committed memory gives its physical page back to the system, but writing
+    // to it later must not fail. So we keep a page committed for every merged page until it has
+    // been written to again.
+    Optional<CommittedPhysicalPageSet> m_merged_committed_pages;
+
     // AnonymousVMObject shares committed COW pages with cloned children (happens on fork)
     class SharedCommittedCowPages final : public AtomicRefCounted<SharedCommittedCowPages> {
         AK_MAKE_NONCOPYABLE(SharedCommittedCowPages);
@@ -88,6 +119,10 @@ private:
     bool m_purgeable { false };
     bool m_volatile { false };
     bool m_was_purged { false };
+    bool m_compressible { false };
+    // Whether the system promised this memory when it was created, so that faulting it in must not fail.
+    bool m_committed { false };
+    bool m_mergeable { false };
 };
 
 }
@@ -0,0 +1,257 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/LZ4Block.h>
+#include <AK/Optional.h>
+#include <Kernel/Debug.h>
+#include <Kernel/Library/StdLib.h>
+#include <Kernel/Memory/CompressedPageStore.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Sections.h>
+
+namespace Kernel::Memory {
+
+static CompressedPageStore* s_the;
+
+// The pool may use up to a quarter of physical memory.
+static constexpr size_t pool_size_divisor = 4;
+
+static bool is_zero_filled(u8 const* data)
+{
+    auto const* words = reinterpret_cast<u64 const*>(data);
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(u64); ++i) {
+        if (words[i] != 0)
+            return false;
+    }
+    return true;
+}
+
+CompressedPage::~CompressedPage()
+{
+    if (m_stored)
+        CompressedPageStore::the().release({}, *this);
+}
+
+UNMAP_AFTER_INIT void CompressedPageStore::initialize()
+{
+    VERIFY(!s_the);
+    auto max_pool_pages = MM.get_system_memory_info().physical_pages / pool_size_divisor;
+    auto pool_pages = MUST(FixedArray<PoolPage>::create(max_pool_pages));
+    s_the = new CompressedPageStore(move(pool_pages));
+    VERIFY(s_the);
+    s_the->refill_reserved_pages();
+    dmesgln("MM: Compressed page store can use up to {} KiB", max_pool_pages * PAGE_SIZE / KiB);
+}
+
+bool CompressedPageStore::is_initialized()
+{
+    return s_the != nullptr;
+}
+
+CompressedPageStore& CompressedPageStore::the()
+{
+    return *s_the;
+}
+
+UNMAP_AFTER_INIT CompressedPageStore::CompressedPageStore(FixedArray<PoolPage>&& pool_pages)
+    : m_pool_pages(move(pool_pages))
+{
+    // Thread all pool page slots onto the free list.
+    for (size_t i = m_pool_pages.size(); i > 0; --i) {
+        m_pool_pages[i - 1].next_free_index = m_first_free_pool_page_index;
+        m_first_free_pool_page_index = i - 1;
+    }
+}
+
+ErrorOr<NonnullRefPtr<CompressedPage>> CompressedPageStore::try_compress(RefPtr<PhysicalPage>& page)
+{
+    VERIFY(page);
+
+    // NOTE: This has to be allocated before taking our lock, as kmalloc may have to ask
+    //       MemoryManager for more memory, which might end up in here again.
+    auto compressed_page = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) CompressedPage));
+
+    SpinlockLocker locker(m_lock);
+
+    auto* source = MM.quickmap_page(*page);
+    bool zero_filled = is_zero_filled(source);
+    Optional<size_t> compressed_size;
+    if (!zero_filled)
+        compressed_size = lz4_compress_block({ source, PAGE_SIZE }, m_buffer.span().trim(max_compressed_size), m_hash_table.span());
+    MM.unquickmap_page();
+
+    if (zero_filled) {
+        compressed_page->m_stored = true;
+        ++m_statistics.zero_pages;
+        ++m_statistics.compressions;
+        return compressed_page;
+    }
+
+    if (!compressed_size.has_value()) {
+        ++m_statistics.incompressible_pages;
+        return E2BIG;
+    }
+
+    auto size = compressed_size.value();
+    if (m_current_pool_page_index == CompressedPage::no_pool_page
+        || m_pool_pages[m_current_pool_page_index].used_bytes + size > PAGE_SIZE) {
+        if (m_first_free_pool_page_index == CompressedPage::no_pool_page)
+            return ENOSPC;
+        auto index = m_first_free_pool_page_index;
+        auto& pool_page = m_pool_pages[index];
+        m_first_free_pool_page_index = pool_page.next_free_index;
+
+        // The previous pool page is now only waiting for its entries to be released.
+        if (m_current_pool_page_index != CompressedPage::no_pool_page)
+            VERIFY(m_pool_pages[m_current_pool_page_index].live_entries > 0);
+
+        // We've already copied out the compressed contents of the page, so instead of asking for
+        // another page (which we likely won't get when we're being asked to compress things),
+        // the page itself becomes our next pool page.
+        pool_page.page = move(page);
+        pool_page.used_bytes = 0;
+        pool_page.live_entries = 0;
+        pool_page.next_free_index = CompressedPage::no_pool_page;
+        m_current_pool_page_index = index;
+        ++m_statistics.pool_pages;
+    }
+
+    auto& pool_page = m_pool_pages[m_current_pool_page_index];
+    auto* destination = MM.quickmap_page(*pool_page.page);
+    memcpy(destination + pool_page.used_bytes, m_buffer.data(), size);
+    MM.unquickmap_page();
+
+    compressed_page->m_stored = true;
+    compressed_page->m_pool_page_index = m_current_pool_page_index;
+    compressed_page->m_offset = pool_page.used_bytes;
+    compressed_page->m_size = size;
+
+    pool_page.used_bytes += size;
+    ++pool_page.live_entries;
+
+    ++m_statistics.stored_pages;
+    m_statistics.compressed_bytes += size;
+    ++m_statistics.compressions;
+
+    dbgln_if(COMPRESSED_PAGE_STORE_DEBUG, "CompressedPageStore: Stored {} bytes in pool page {} at offset {}", size, compressed_page->m_pool_page_index, compressed_page->m_offset);
+    return compressed_page;
+}
+
+ErrorOr<void> CompressedPageStore::decompress(CompressedPage const& compressed_page, PhysicalPage& page)
+{
+    VERIFY(compressed_page.m_stored);
+
+    SpinlockLocker locker(m_lock);
+    ++m_statistics.decompressions;
+
+    if (compressed_page.m_pool_page_index == CompressedPage::no_pool_page) {
+        auto* destination = MM.quickmap_page(page);
+        memset(destination, 0, PAGE_SIZE);
+        MM.unquickmap_page();
+        return {};
+    }
+
+    auto& pool_page = m_pool_pages[compressed_page.m_pool_page_index];
+    VERIFY(pool_page.page);
+
+    // Only one page can be quickmapped at a time, so go through our buffer.
+    auto* source = MM.quickmap_page(*pool_page.page);
+    memcpy(m_buffer.data(), source + compressed_page.m_offset, compressed_page.m_size);
+    MM.unquickmap_page();
+
+    auto* destination = MM.quickmap_page(page);
+    auto decompressed_size = lz4_decompress_block(m_buffer.span().trim(compressed_page.m_size), { destination, PAGE_SIZE });
+    MM.unquickmap_page();
+
+    if (decompressed_size != PAGE_SIZE) {
+        dmesgln("CompressedPageStore: Corrupted page in pool page {} at offset {}", compressed_page.m_pool_page_index, compressed_page.m_offset);
+        return EIO;
+    }
+    return {};
+}
+
+ErrorOr<NonnullRefPtr<PhysicalPage>> CompressedPageStore::allocate_page_for_decompression()
+{
+    if (auto page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No); !page_or_error.is_error()) {
+        refill_reserved_pages();
+        return page_or_error.release_value();
+    }
+
+    SpinlockLocker locker(m_lock);
+    if (m_statistics.reserved_pages == 0)
+        return ENOMEM;
+    return m_reserved_pages[--m_statistics.reserved_pages].release_nonnull();
+}
+
+void CompressedPageStore::refill_reserved_pages()
+{
+    for (;;) {
+        {
+            SpinlockLocker locker(m_lock);
+            if (m_statistics.reserved_pages == max_reserved_pages)
+                return;
+        }
+
+        // Only take memory that is lying around anyway, we don't want to start reclaiming memory just for the reserve.
+        if (MM.get_system_memory_info().physical_pages_uncommitted <= max_reserved_pages)
+            return;
+        auto page_or_error = MM.allocate_physical_page(MemoryManager::ShouldZeroFill::No);
+        if (page_or_error.is_error())
+            return;
+        auto page = page_or_error.release_value();
+
+        SpinlockLocker locker(m_lock);
+        // NOTE: If someone else has filled up the reserve in the meantime, the page is freed after we've let go of our lock.
+        if (m_statistics.reserved_pages == max_reserved_pages)
+            return;
+        m_reserved_pages[m_statistics.reserved_pages++] = move(page);
+    }
+}
+
+void CompressedPageStore::release(Badge<CompressedPage>, CompressedPage const& compressed_page)
+{
+    RefPtr<PhysicalPage> page_to_free;
+    {
+        SpinlockLocker locker(m_lock);
+
+        if (compressed_page.m_pool_page_index == CompressedPage::no_pool_page) {
+            VERIFY(m_statistics.zero_pages > 0);
+            --m_statistics.zero_pages;
+            return;
+        }
+
+        auto index = compressed_page.m_pool_page_index;
+        auto& pool_page = m_pool_pages[index];
+        VERIFY(pool_page.live_entries > 0);
+        --pool_page.live_entries;
+        --m_statistics.stored_pages;
+        m_statistics.compressed_bytes -= compressed_page.m_size;
+
+        if (pool_page.live_entries == 0) {
+            if (index == m_current_pool_page_index) {
+                // Keep the current pool page around, and just start filling it up from the beginning again.
+                pool_page.used_bytes = 0;
+            } else {
+                page_to_free = move(pool_page.page);
+                pool_page.used_bytes = 0;
+                pool_page.next_free_index = m_first_free_pool_page_index;
+                m_first_free_pool_page_index = index;
+                --m_statistics.pool_pages;
+            }
+        }
+    }
+
+    // NOTE: page_to_free goes away here, after we've let go of our lock, as freeing a
+    //       physical page takes the MemoryManager lock.
+}
+
+CompressedPageStore::Statistics CompressedPageStore::statistics()
+{
+    SpinlockLocker locker(m_lock);
+    return m_statistics;
+}
+
+}
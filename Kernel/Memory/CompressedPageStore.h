@@ -0,0 +1,112 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/AtomicRefCounted.h>
+#include <AK/Badge.h>
+#include <AK/FixedArray.h>
+#include <AK/NumericLimits.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/PhysicalPage.h>
+
+namespace Kernel::Memory {
+
+// A page of anonymous memory that has been swapped out into the CompressedPageStore.
+// The compressed data is released from the store once the last reference goes away.
+class CompressedPage final : public AtomicRefCounted<CompressedPage> {
+    friend class CompressedPageStore;
+
+public:
+    ~CompressedPage();
+
+    size_t compressed_size() const { return m_size; }
+
+private:
+    CompressedPage() = default;
+
+    static constexpr u32 no_pool_page = NumericLimits<u32>::max();
+
+    bool m_stored { false };
+    u32 m_pool_page_index { no_pool_page };
+    u16 m_offset { 0 };
+    u16 m_size { 0 };
+};
+
+// An in-memory swap tier for anonymous memory.
+//
+// Pages are compressed into LZ4 blocks (see AK/LZ4Block.h) and appended to "pool pages", which
+// are physical pages owned by the store. A pool page is given back to the system once none of the
+// compressed pages it holds are in use anymore. Zero-filled pages don't take up any space in the
+// pool at all.
+class CompressedPageStore {
+    AK_MAKE_NONCOPYABLE(CompressedPageStore);
+    AK_MAKE_NONMOVABLE(CompressedPageStore);
+
+public:
+    static void initialize();
+    static bool is_initialized();
+    static CompressedPageStore& the();
+
+    // Compresses the contents of the given page into the store. Instead of allocating more memory
+    // for the pool, the store may take over the page itself, in which case `page` is cleared.
+    ErrorOr<NonnullRefPtr<CompressedPage>> try_compress(RefPtr<PhysicalPage>& page);
+    ErrorOr<void> decompress(CompressedPage const&, PhysicalPage&);
+
+    // Allocates a page to decompress into. Bringing back a page of committed memory must not fail,
+    // so if there is no memory left, this falls back to the pages the store keeps in reserve.
+    ErrorOr<NonnullRefPtr<PhysicalPage>> allocate_page_for_decompression();
+
+    void release(Badge<CompressedPage>, CompressedPage const&);
+
+    struct Statistics {
+        size_t stored_pages { 0 };
+        size_t zero_pages { 0 };
+        size_t compressed_bytes { 0 };
+        size_t pool_pages { 0 };
+        u64 compressions { 0 };
+        u64 decompressions { 0 };
+        u64 incompressible_pages { 0 };
+        size_t reserved_pages { 0 };
+    };
+    Statistics statistics();
+
+private:
+    struct PoolPage {
+        RefPtr<PhysicalPage> page;
+        u16 used_bytes { 0 };
+        u16 live_entries { 0 };
+        u32 next_free_index { CompressedPage::no_pool_page };
+    };
+
+    explicit CompressedPageStore(FixedArray<PoolPage>&&);
+
+    void refill_reserved_pages();
+
+    // Pages that compress worse than this are not worth keeping in the store.
+    static constexpr size_t max_compressed_size = PAGE_SIZE * 3 / 4;
+    static constexpr size_t hash_table_size = 4096;
+    static constexpr size_t max_reserved_pages = 32;
+
+    Spinlock<LockRank::None> m_lock {};
+
+    FixedArray<PoolPage> m_pool_pages;
+    u32 m_current_pool_page_index { CompressedPage::no_pool_page };
+    u32 m_first_free_pool_page_index { CompressedPage::no_pool_page };
+
+    // Scratch space for the codec, these are only used while holding m_lock.
+    Array<u8, PAGE_SIZE> m_buffer;
+    Array<u16, hash_table_size> m_hash_table;
+
+    Array<RefPtr<PhysicalPage>, max_reserved_pages> m_reserved_pages;
+
+    Statistics m_statistics;
+};
+
+}
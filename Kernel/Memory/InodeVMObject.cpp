@@ -86,6 +86,25 @@ int InodeVMObject::try_release_clean_pages(int page_amount)
     return count;
 }
 
+void InodeVMObject::release_pages_starting_at(size_t page_index)
+{
+    SpinlockLocker locker(m_lock);
+
+    bool released_any_page = false;
+    for (size_t i = page_index; i < page_count(); ++i) {
+        if (m_physical_pages[i]) {
+            m_physical_pages[i] = nullptr;
+            m_dirty_pages.set(i, false);
+            released_any_page = true;
+        }
+    }
+    if (released_any_page) {
+        for_each_region([](auto& region) {
+            region.remap();
+        });
+    }
+}
+
 u32 InodeVMObject::writable_mappings() const
 {
     u32 count = 0;
@@ -24,6 +24,7 @@ public:
 
     int release_all_clean_pages();
     int try_release_clean_pages(int page_amount);
+    void release_pages_starting_at(size_t page_index);
 
     u32 writable_mappings() const;
 
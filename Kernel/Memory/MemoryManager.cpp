@@ -19,6 +19,7 @@
 #include <Kernel/Library/Panic.h>
 #include <Kernel/Library/StdLib.h>
 #include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/CompressedPageStore.h>
 #include <Kernel/Memory/MemoryManager.h>
 #include <Kernel/Memory/PhysicalRegion.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
@@ -91,8 +92,8 @@ UNMAP_AFTER_INIT MemoryManager::MemoryManager()
     activate_kernel_page_directory(kernel_page_directory());
     protect_kernel_image();
 
-    // We're temporarily "committing" to two pages that we need to allocate below
-    auto committed_pages = commit_physical_pages(2).release_value();
+    // We're temporarily "committing" to three pages that we need to allocate below
+    auto committed_pages = commit_physical_pages(3).release_value();
 
     m_shared_zero_page = committed_pages.take_one();
 
@@ -103,6 +104,9 @@ UNMAP_AFTER_INIT MemoryManager::MemoryManager()
     // By using a tag we don't have to query the VMObject for every page
     // whether it was committed or not
     m_lazy_committed_page = committed_pages.take_one();
+
+    // Same as above, this tag marks anonymous pages that currently live in the CompressedPageStore.
+    m_compressed_page = committed_pages.take_one();
 }
 
 UNMAP_AFTER_INIT MemoryManager::~MemoryManager() = default;
@@ -895,16 +899,29 @@ ErrorOr<NonnullOwnPtr<Region>> MemoryManager::allocate_kernel_region_with_vmobje
 ErrorOr<CommittedPhysicalPageSet> MemoryManager::commit_physical_pages(size_t page_count)
 {
     VERIFY(page_count > 0);
-    auto result = m_global_data.with([&](auto& global_data) -> ErrorOr<CommittedPhysicalPageSet> {
-        if (global_data.system_memory_info.physical_pages_uncommitted < page_count) {
-            dbgln("MM: Unable to commit {} pages, have only {}", page_count, global_data.system_memory_info.physical_pages_uncommitted);
-            return ENOMEM;
-        }
+    auto try_commit = [&](bool log_failure) {
+        return m_global_data.with([&](auto& global_data) -> ErrorOr<CommittedPhysicalPageSet> {
+            if (global_data.system_memory_info.physical_pages_uncommitted < page_count) {
+                if (log_failure)
+                    dbgln("MM: Unable to commit {} pages, have only {}", page_count, global_data.system_memory_info.physical_pages_uncommitted);
+                return ENOMEM;
+            }
 
-        global_data.system_memory_info.physical_pages_uncommitted -= page_count;
-        global_data.system_memory_info.physical_pages_committed += page_count;
-        return CommittedPhysicalPageSet { {}, page_count };
-    });
+            global_data.system_memory_info.physical_pages_uncommitted -= page_count;
+            global_data.system_memory_info.physical_pages_committed += page_count;
+            return CommittedPhysicalPageSet { {}, page_count };
+        });
+    };
+    auto result = try_commit(false);
+    if (result.is_error()) {
+        // Compressing cold anonymous pages hands their physical pages back to the uncommitted pool.
+        // Don't bother if we couldn't possibly free up enough memory that way.
+        auto memory_info = get_system_memory_info();
+        auto missing_page_count = page_count - min(page_count, memory_info.physical_pages_uncommitted);
+        if (missing_page_count <= memory_info.physical_pages_used)
+            (void)reclaim_by_compressing_anonymous_pages(missing_page_count);
+        result = try_commit(true);
+    }
     if (result.is_error()) {
         Process::for_each_ignoring_jails([&](Process const& process) {
             size_t amount_resident = 0;
@@ -1006,9 +1023,9 @@ NonnullRefPtr<PhysicalPage> MemoryManager::allocate_committed_physical_page(Badg
 
 ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(ShouldZeroFill should_zero_fill, bool* did_purge)
 {
-    return m_global_data.with([&](auto&) -> ErrorOr<NonnullRefPtr<PhysicalPage>> {
+    bool purged_pages = false;
+    auto page = m_global_data.with([&](auto&) -> RefPtr<PhysicalPage> {
         auto page = find_free_physical_page(false);
-        bool purged_pages = false;
 
         if (!page) {
             // We didn't have a single free physical page. Let's try to free something up!
@@ -1044,21 +1061,57 @@ ErrorOr<NonnullRefPtr<PhysicalPage>> MemoryManager::allocate_physical_page(Shoul
                 return IterationDecision::Continue;
             });
         }
-        if (!page) {
-            dmesgln("MM: no physical pages available");
-            return ENOMEM;
-        }
+        return page;
+    });
 
-        if (should_zero_fill == ShouldZeroFill::Yes) {
-            auto* ptr = quickmap_page(*page);
-            memset(ptr, 0, PAGE_SIZE);
-            unquickmap_page();
+    if (!page) {
+        // Third, we move cold anonymous pages into the compressed page store.
+        // This takes VMObject locks, allocates memory and flushes the TLBs of other processors, so it has to happen
+        // outside of the global MM lock. We reclaim a few more pages than we need, so that the next allocations
+        // don't end up here right away.
+        if (auto reclaimed_page_count = reclaim_by_compressing_anonymous_pages(16)) {
+            dbgln("MM: Compression saved the day! Reclaimed {} pages from AnonymousVMObjects", reclaimed_page_count);
+            page = find_free_physical_page(false);
+            purged_pages = true;
         }
+    }
+    if (!page) {
+        dmesgln("MM: no physical pages available");
+        return ENOMEM;
+    }
 
-        if (did_purge)
-            *did_purge = purged_pages;
-        return page.release_nonnull();
-    });
+    if (should_zero_fill == ShouldZeroFill::Yes) {
+        InterruptDisabler disabler;
+        auto* ptr = quickmap_page(*page);
+        memset(ptr, 0, PAGE_SIZE);
+        unquickmap_page();
+    }
+
+    if (did_purge)
+        *did_purge = purged_pages;
+    return page.release_nonnull();
+}
+
+size_t MemoryManager::reclaim_by_compressing_anonymous_pages(size_t page_count)
+{
+    if (!CompressedPageStore::is_initialized())
+        return 0;
+
+    size_t reclaimed_page_count = 0;
+    // The first pass might only clear the accessed bits of recently used pages, so that
+    // the second pass can pick them up if they haven't been used since.
+    for (size_t pass = 0; pass < 2 && reclaimed_page_count < page_count; ++pass) {
+        for_each_vmobject([&](auto& vmobject) {
+            if (!vmobject.is_anonymous())
+                return IterationDecision::Continue;
+            auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject);
+            reclaimed_page_count += anonymous_vmobject.compress_cold_pages(page_count - reclaimed_page_count);
+            if (reclaimed_page_count >= page_count)
+                return IterationDecision::Break;
+            return IterationDecision::Continue;
+        });
+    }
+    return reclaimed_page_count;
 }
 
 ErrorOr<Vector<NonnullRefPtr<PhysicalPage>>> MemoryManager::allocate_contiguous_physical_pages(size_t size)
@@ -1128,6 +1181,7 @@ PageDirectoryEntry* MemoryManager::quickmap_pd(PageDirectory& directory, size_t
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
+        pte.set_global(true);
         flush_tlb_local(vaddr);
     }
     return (PageDirectoryEntry*)vaddr.get();
@@ -1146,6 +1200,7 @@ PageTableEntry* MemoryManager::quickmap_pt(PhysicalAddress pt_paddr)
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
+        pte.set_global(true);
         flush_tlb_local(vaddr);
     }
     return (PageTableEntry*)vaddr.get();
@@ -1166,6 +1221,7 @@ u8* MemoryManager::quickmap_page(PhysicalAddress const& physical_address)
         pte.set_present(true);
         pte.set_writable(true);
         pte.set_user_allowed(false);
+        pte.set_global(true);
         flush_tlb_local(vaddr);
     }
     return vaddr.as_ptr();
@@ -116,6 +116,9 @@ public:
     [[nodiscard]] NonnullRefPtr<PhysicalPage> take_one();
     void uncommit_one();
 
+    // Takes over the pages committed by another set.
+    void add(CommittedPhysicalPageSet&& other) { m_page_count += exchange(other.m_page_count, 0); }
+
     void operator=(CommittedPhysicalPageSet&&) = delete;
 
 private:
@@ -125,8 +128,11 @@ private:
 class MemoryManager {
     friend class PageDirectory;
     friend class AnonymousVMObject;
+    friend class CompressedPageStore;
     friend class Region;
     friend class RegionTree;
+    friend class SamePageMerger;
+    friend class TLBFlushBatch;
     friend class VMObject;
     friend struct ::KmallocGlobalData;
 
@@ -216,6 +222,7 @@ public:
 
     PhysicalPage& shared_zero_page() { return *m_shared_zero_page; }
     PhysicalPage& lazy_committed_page() { return *m_lazy_committed_page; }
+    PhysicalPage& compressed_page() { return *m_compressed_page; }
 
     PageDirectory& kernel_page_directory() { return *m_kernel_page_directory; }
 
@@ -251,6 +258,7 @@ private:
     static void flush_tlb(PageDirectory const*, VirtualAddress, size_t page_count = 1);
 
     RefPtr<PhysicalPage> find_free_physical_page(bool);
+    size_t reclaim_by_compressing_anonymous_pages(size_t page_count);
 
     ALWAYS_INLINE u8* quickmap_page(PhysicalPage& page)
     {
@@ -276,6 +284,7 @@ private:
     LockRefPtr<PageDirectory> m_kernel_page_directory;
     RefPtr<PhysicalPage> m_shared_zero_page;
     RefPtr<PhysicalPage> m_lazy_committed_page;
+    RefPtr<PhysicalPage> m_compressed_page;
 
     // NOTE: These are outside of GlobalData as they are initialized on startup,
     //       and then never change.
@@ -310,6 +319,11 @@ inline bool PhysicalPage::is_lazy_committed_page() const
     return this == &MM.lazy_committed_page();
 }
 
+inline bool PhysicalPage::is_compressed_page() const
+{
+    return this == &MM.compressed_page();
+}
+
 inline ErrorOr<Memory::VirtualRange> expand_range_to_page_boundaries(FlatPtr address, size_t size)
 {
     if ((address + size) < address)
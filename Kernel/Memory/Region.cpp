@@ -173,7 +173,7 @@ size_t Region::amount_resident() const
     size_t bytes = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         auto page = physical_page(i);
-        if (page && !page->is_shared_zero_page() && !page->is_lazy_committed_page())
+        if (page && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page())
             bytes += PAGE_SIZE;
     }
     return bytes;
@@ -184,7 +184,7 @@ size_t Region::amount_shared() const
     size_t bytes = 0;
     for (size_t i = 0; i < page_count(); ++i) {
         auto page = physical_page(i);
-        if (page && page->ref_count() > 1 && !page->is_shared_zero_page() && !page->is_lazy_committed_page())
+        if (page && page->ref_count() > 1 && !page->is_shared_zero_page() && !page->is_lazy_committed_page() && !page->is_compressed_page())
             bytes += PAGE_SIZE;
     }
     return bytes;
@@ -225,7 +225,7 @@ bool Region::map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage> pa
     if (!pte)
         return false;
 
-    if (!page || (!is_readable() && !is_writable())) {
+    if (!page || page->is_compressed_page() || (!is_readable() && !is_writable())) {
         pte->clear();
         return true;
     }
@@ -242,6 +242,10 @@ bool Region::map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage> pa
     if (Processor::current().has_pat())
         pte->set_pat(is_write_combine());
     pte->set_user_allowed(user_allowed);
+    // Kernel mappings are the same in every address space, so keep them across address space switches.
+    pte->set_global(!user_allowed);
+    // Give freshly mapped pages a chance to get used before they look cold to AnonymousVMObject::compress_cold_pages().
+    pte->set_accessed(true);
 
     return true;
 }
@@ -270,6 +274,56 @@ bool Region::remap_vmobject_page(size_t page_index, NonnullRefPtr<PhysicalPage>
     return success;
 }
 
+bool Region::test_and_clear_accessed(Badge<AnonymousVMObject>, size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    if (!translate_vmobject_page(page_index))
+        return false;
+
+    auto* pte = MM.pte(*m_page_directory, vaddr_from_page_index(page_index));
+    if (!pte || !pte->is_present() || !pte->is_accessed())
+        return false;
+    // NOTE: We don't flush the TLB here, so a processor that still has this page cached might
+    //       not mark it as accessed again. That's fine, we'd only bring it back in a bit later.
+    pte->set_accessed(false);
+    return true;
+}
+
+void Region::unmap_vmobject_page(Badge<AnonymousVMObject>, size_t page_index)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    if (!translate_vmobject_page(page_index))
+        return;
+
+    auto page_vaddr = vaddr_from_page_index(page_index);
+    auto* pte = MM.pte(*m_page_directory, page_vaddr);
+    if (!pte || pte->is_null())
+        return;
+    pte->clear();
+    MemoryManager::flush_tlb(m_page_directory, page_vaddr);
+}
+
+void Region::restore_vmobject_page(Badge<AnonymousVMObject>, size_t page_index, PhysicalPage& page)
+{
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    if (!translate_vmobject_page(page_index))
+        return;
+    // NOTE: This can't fail, as the page table for this page is still around after unmap_vmobject_page().
+    (void)map_individual_page_impl(page_index, page);
+}
+
+void Region::update_vmobject_page(Badge<AnonymousVMObject>, size_t page_index)
+{
+    if (!m_page_directory)
+        return;
+    VERIFY(m_page_directory->get_lock().is_locked_by_current_processor());
+    if (!translate_vmobject_page(page_index))
+        return;
+    // NOTE: If we can't allocate a page table here, the page simply gets mapped by the next page fault instead.
+    (void)map_individual_page_impl(page_index);
+    MemoryManager::flush_tlb(m_page_directory, vaddr_from_page_index(page_index));
+}
+
 void Region::unmap(ShouldFlushTLB should_flush_tlb)
 {
     if (!m_page_directory)
@@ -352,6 +406,8 @@ void Region::clear_to_zero()
         VERIFY(page);
         if (page->is_shared_zero_page())
             continue;
+        if (page->is_compressed_page())
+            static_cast<AnonymousVMObject&>(vmobject()).discard_compressed_page(translate_to_vmobject_page(i));
         page = MM.shared_zero_page();
     }
 }
@@ -375,6 +431,11 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
 
         SpinlockLocker vmobject_locker(vmobject().m_lock);
         auto& page_slot = physical_page_slot(page_index_in_region);
+        if (page_slot->is_compressed_page()) {
+            dbgln_if(PAGE_FAULT_DEBUG, "NP(compressed) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
+            vmobject_locker.unlock();
+            return handle_compressed_fault(page_index_in_region);
+        }
         if (page_slot->is_lazy_committed_page()) {
             auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
             VERIFY(m_vmobject->is_anonymous());
@@ -389,6 +450,7 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
             dbgln("     - Physical page: {}", page_slot->paddr());
             dbgln("     - Lazy committed: {}", page_slot->is_lazy_committed_page());
             dbgln("     - Shared zero: {}", page_slot->is_shared_zero_page());
+            dbgln("     - Compressed: {}", page_slot->is_compressed_page());
         }
         return PageFaultResponse::ShouldCrash;
     }
@@ -396,6 +458,8 @@ PageFaultResponse Region::handle_fault(PageFault const& fault)
     if (fault.access() == PageFault::Access::Write && is_writable() && should_cow(page_index_in_region)) {
         dbgln_if(PAGE_FAULT_DEBUG, "PV(cow) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
         auto phys_page = physical_page(page_index_in_region);
+        if (phys_page->is_compressed_page())
+            return handle_compressed_fault(page_index_in_region);
         if (phys_page->is_shared_zero_page() || phys_page->is_lazy_committed_page()) {
             dbgln_if(PAGE_FAULT_DEBUG, "NP(zero) fault in Region({})[{}] at {}", this, page_index_in_region, fault.vaddr());
             return handle_zero_fault(page_index_in_region, *phys_page);
@@ -454,6 +518,20 @@ PageFaultResponse Region::handle_zero_fault(size_t page_index_in_region, Physica
     return PageFaultResponse::Continue;
 }
 
+PageFaultResponse Region::handle_compressed_fault(size_t page_index_in_region)
+{
+    VERIFY(vmobject().is_anonymous());
+
+    auto page_index_in_vmobject = translate_to_vmobject_page(page_index_in_region);
+    auto response = static_cast<AnonymousVMObject&>(vmobject()).handle_compressed_fault(page_index_in_vmobject);
+    if (response != PageFaultResponse::Continue)
+        return response;
+
+    if (!remap_vmobject_page(page_index_in_vmobject, *physical_page(page_index_in_region)))
+        return PageFaultResponse::OutOfMemory;
+    return PageFaultResponse::Continue;
+}
+
 PageFaultResponse Region::handle_cow_fault(size_t page_index_in_region)
 {
     auto current_thread = Thread::current();
@@ -497,6 +575,27 @@ PageFaultResponse Region::handle_inode_fault(size_t page_index_in_region)
     if (current_thread)
         current_thread->did_inode_fault();
 
+    if (inode_vmobject.is_shared_inode() && inode_vmobject.inode().shares_pages_with_vmobject()) {
+        auto page_or_error = inode_vmobject.inode().page_for_shared_vmobject(page_index_in_vmobject);
+        if (page_or_error.is_error()) {
+            dmesgln("handle_inode_fault: Error ({}) while getting a page from inode", page_or_error.error());
+            return page_or_error.error().code() == ENOMEM ? PageFaultResponse::OutOfMemory : PageFaultResponse::ShouldCrash;
+        }
+        // NOTE: We must not read the page into a private copy here. If the file grows later on, the
+        //       shared mapping would keep that copy while reads and writes go to the inode's pages.
+        auto page = page_or_error.release_value();
+        if (!page)
+            return PageFaultResponse::BusError;
+        {
+            SpinlockLocker locker(inode_vmobject.m_lock);
+            if (vmobject_physical_page_slot.is_null())
+                vmobject_physical_page_slot = move(page);
+        }
+        if (!remap_vmobject_page(page_index_in_vmobject, *vmobject_physical_page_slot))
+            return PageFaultResponse::OutOfMemory;
+        return PageFaultResponse::Continue;
+    }
+
     u8 page_buffer[PAGE_SIZE];
     auto& inode = inode_vmobject.inode();
 
@@ -210,6 +210,14 @@ public:
     void start_handling_page_fault(Badge<MemoryManager>) { m_in_progress_page_faults++; }
     void finish_handling_page_fault(Badge<MemoryManager>) { m_in_progress_page_faults--; }
 
+    // These are used by AnonymousVMObject to move cold pages into the CompressedPageStore and to merge identical pages.
+    // They take VMObject page indices, and the caller has to hold the page directory lock.
+    [[nodiscard]] PageDirectory* page_directory(Badge<AnonymousVMObject>) { return m_page_directory.ptr(); }
+    [[nodiscard]] bool test_and_clear_accessed(Badge<AnonymousVMObject>, size_t page_index);
+    void unmap_vmobject_page(Badge<AnonymousVMObject>, size_t page_index);
+    void restore_vmobject_page(Badge<AnonymousVMObject>, size_t page_index, PhysicalPage&);
+    void update_vmobject_page(Badge<AnonymousVMObject>, size_t page_index);
+
 private:
     Region();
     Region(NonnullLockRefPtr<VMObject>, size_t offset_in_vmobject, OwnPtr<KString>, Region::Access access, Cacheable, bool shared);
@@ -228,6 +236,7 @@ private:
     [[nodiscard]] PageFaultResponse handle_cow_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_inode_fault(size_t page_index);
     [[nodiscard]] PageFaultResponse handle_zero_fault(size_t page_index, PhysicalPage& page_in_slot_at_time_of_fault);
+    [[nodiscard]] PageFaultResponse handle_compressed_fault(size_t page_index);
 
     [[nodiscard]] bool map_individual_page_impl(size_t page_index);
     [[nodiscard]] bool map_individual_page_impl(size_t page_index, RefPtr<PhysicalPage>);
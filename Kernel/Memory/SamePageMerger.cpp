@@ -0,0 +1,202 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Debug.h>
+#include <Kernel/Library/NonnullLockRefPtr.h>
+#include <Kernel/Memory/AnonymousVMObject.h>
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/SamePageMerger.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+
+namespace Kernel::Memory {
+
+static SamePageMerger* s_the;
+
+UNMAP_AFTER_INIT void SamePageMerger::initialize()
+{
+    VERIFY(!s_the);
+    s_the = new SamePageMerger;
+    VERIFY(s_the);
+    MUST(Process::create_kernel_process("Same Page Merger"sv, [] {
+        SamePageMerger::task_main();
+    }));
+}
+
+bool SamePageMerger::is_initialized()
+{
+    return s_the != nullptr;
+}
+
+SamePageMerger& SamePageMerger::the()
+{
+    return *s_the;
+}
+
+void SamePageMerger::task_main()
+{
+    dbgln("SamePageMerger is running");
+    for (;;) {
+        SamePageMerger::the().scan();
+        (void)Thread::current()->sleep(Duration::from_milliseconds(scan_interval_in_milliseconds));
+    }
+}
+
+void SamePageMerger::scan()
+{
+    size_t mergeable_vmobject_count = 0;
+    MemoryManager::for_each_vmobject([&](VMObject& vmobject) {
+        if (vmobject.is_anonymous() && static_cast<AnonymousVMObject&>(vmobject).is_mergeable())
+            ++mergeable_vmobject_count;
+    });
+    if (mergeable_vmobject_count == 0)
+        return;
+
+    // NOTE: We grab references to everything we want to look at first, as we can't scan
+    //       anything while holding the lock of the VMObject list.
+    Vector<NonnullLockRefPtr<AnonymousVMObject>> vmobjects;
+    if (vmobjects.try_ensure_capacity(mergeable_vmobject_count).is_error())
+        return;
+    size_t mergeable_page_count = 0;
+    MemoryManager::for_each_vmobject([&](VMObject& vmobject) {
+        if (vmobjects.size() == mergeable_vmobject_count)
+            return IterationDecision::Break;
+        if (!vmobject.is_anonymous())
+            return IterationDecision::Continue;
+        auto& anonymous_vmobject = static_cast<AnonymousVMObject&>(vmobject);
+        if (!anonymous_vmobject.is_mergeable())
+            return IterationDecision::Continue;
+        vmobjects.unchecked_append(anonymous_vmobject);
+        mergeable_page_count += anonymous_vmobject.page_count();
+        return IterationDecision::Continue;
+    });
+
+    // Spread the pages we want to look at evenly across all mergeable objects.
+    auto pages_to_scan_per_vmobject = max<size_t>(ceil_div(pages_to_scan, vmobjects.size()), 1);
+    size_t scanned_page_count = 0;
+    for (auto& vmobject : vmobjects) {
+        // Scanning happens with interrupts disabled, so give others a chance to get in every now and then.
+        for (size_t remaining_page_count = min(pages_to_scan_per_vmobject, vmobject->page_count()); remaining_page_count > 0;) {
+            auto page_count = vmobject->merge_identical_pages(min(remaining_page_count, pages_to_scan_at_once));
+            if (page_count == 0)
+                break;
+            scanned_page_count += page_count;
+            remaining_page_count -= min(remaining_page_count, page_count);
+        }
+    }
+
+    {
+        SpinlockLocker locker(m_statistics_lock);
+        m_statistics.scanned_pages += scanned_page_count;
+    }
+
+    m_pages_scanned_in_current_scan += scanned_page_count;
+    if (m_pages_scanned_in_current_scan >= mergeable_page_count)
+        finish_full_scan();
+}
+
+void SamePageMerger::finish_full_scan()
+{
+    m_pages_scanned_in_current_scan = 0;
+    m_checksums_seen_in_current_scan.clear();
+
+    // If we're the only ones left holding on to a merged page, everyone else has written to it or let go of it.
+    m_merged_pages.remove_all_matching([](auto, auto& page) {
+        return page->ref_count() == 1;
+    });
+
+    size_t sharing_pages = 0;
+    for (auto& it : m_merged_pages) {
+        // One reference is ours, and one of the others would have needed the page anyway.
+        sharing_pages += it.value->ref_count() - min<size_t>(it.value->ref_count(), 2);
+    }
+
+    SpinlockLocker locker(m_statistics_lock);
+    m_statistics.shared_pages = m_merged_pages.size();
+    m_statistics.sharing_pages = sharing_pages;
+    ++m_statistics.full_scans;
+}
+
+SamePageMerger::Checksum SamePageMerger::checksum_page(PhysicalPage& page)
+{
+    auto* words = reinterpret_cast<u64 const*>(MM.quickmap_page(page));
+    u64 hash = 0xcbf29ce484222325;
+    u64 all_bits = 0;
+    for (size_t i = 0; i < PAGE_SIZE / sizeof(u64); ++i) {
+        hash = (hash ^ words[i]) * 0x100000001b3;
+        all_bits |= words[i];
+    }
+    MM.unquickmap_page();
+    return { static_cast<u32>(hash ^ (hash >> 32)), all_bits == 0 };
+}
+
+bool SamePageMerger::pages_are_identical(PhysicalPage& a, PhysicalPage& b)
+{
+    // Only one page can be quickmapped at a time, so go through our buffer.
+    auto* source = MM.quickmap_page(a);
+    memcpy(m_buffer.data(), source, PAGE_SIZE);
+    MM.unquickmap_page();
+
+    auto* other = MM.quickmap_page(b);
+    bool identical = memcmp(m_buffer.data(), other, PAGE_SIZE) == 0;
+    MM.unquickmap_page();
+    return identical;
+}
+
+bool SamePageMerger::is_merge_candidate(Badge<AnonymousVMObject>, Checksum checksum)
+{
+    if (checksum.is_zero_filled)
+        return true;
+    if (m_merged_pages.contains(checksum.value))
+        return true;
+    if (m_checksums_seen_in_current_scan.contains(checksum.value))
+        return true;
+    // Let a page with the same contents know that we're here.
+    (void)m_checksums_seen_in_current_scan.set(checksum.value);
+    return false;
+}
+
+RefPtr<PhysicalPage> SamePageMerger::merge_page(Badge<AnonymousVMObject>, PhysicalPage& page, Checksum checksum)
+{
+    // The page might have changed between taking the checksum and write protecting it.
+    auto current_checksum = checksum_page(page);
+    if (current_checksum.value != checksum.value || current_checksum.is_zero_filled != checksum.is_zero_filled)
+        return nullptr;
+
+    if (checksum.is_zero_filled) {
+        SpinlockLocker locker(m_statistics_lock);
+        ++m_statistics.merged_zero_pages;
+        return MM.shared_zero_page();
+    }
+
+    if (auto merged_page = m_merged_pages.get(checksum.value); merged_page.has_value()) {
+        auto& existing_page = *merged_page.value();
+        if (&existing_page == &page)
+            return page;
+        if (!pages_are_identical(existing_page, page)) {
+            dbgln_if(SAME_PAGE_MERGER_DEBUG, "SamePageMerger: Checksum collision between {} and {}", existing_page.paddr(), page.paddr());
+            return nullptr;
+        }
+        dbgln_if(SAME_PAGE_MERGER_DEBUG, "SamePageMerger: Merging {} into {}", page.paddr(), existing_page.paddr());
+        SpinlockLocker locker(m_statistics_lock);
+        ++m_statistics.merged_pages;
+        return existing_page;
+    }
+
+    // Nobody has these contents yet, so this page becomes the one others get merged into.
+    if (m_merged_pages.try_set(checksum.value, page).is_error())
+        return nullptr;
+    dbgln_if(SAME_PAGE_MERGER_DEBUG, "SamePageMerger: {} is now a merged page", page.paddr());
+    return page;
+}
+
+SamePageMerger::Statistics SamePageMerger::statistics()
+{
+    SpinlockLocker locker(m_statistics_lock);
+    return m_statistics;
+}
+
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/HashMap.h>
+#include <AK/HashTable.h>
+#include <AK/RefPtr.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Locking/Spinlock.h>
+#include <Kernel/Memory/PhysicalPage.h>
+
+namespace Kernel::Memory {
+
+// Merges identical pages of anonymous memory that has been marked with MADV_MERGEABLE.
+//
+// A background task periodically checksums the pages of mergeable AnonymousVMObjects. Pages whose
+// checksum didn't change between two scans are considered stable enough to be merged: zero-filled
+// pages are replaced by the shared zero page, and other pages are replaced by an identical page
+// from our table of merged pages. Merged pages are shared copy-on-write, so the first write to one
+// of them gives the writer its own copy again.
+//
+// To keep us from having to lock two VMObjects at once, a page only makes it into the table of
+// merged pages once we've seen another page with the same checksum during the current scan. That
+// other page then gets merged into it when we come across it again during the next scan.
+class SamePageMerger {
+    AK_MAKE_NONCOPYABLE(SamePageMerger);
+    AK_MAKE_NONMOVABLE(SamePageMerger);
+
+public:
+    static void initialize();
+    static bool is_initialized();
+    static SamePageMerger& the();
+
+    struct Checksum {
+        u32 value { 0 };
+        bool is_zero_filled { false };
+    };
+    Checksum checksum_page(PhysicalPage&);
+
+    // Returns true if a page with the given (stable) checksum might be mergeable with another page.
+    // If not, the checksum is remembered so that the next page with the same contents will be.
+    bool is_merge_candidate(Badge<AnonymousVMObject>, Checksum);
+
+    // Returns the page that should replace the given (write protected) page, which may be the page itself
+    // if it has become the merged page for its contents. Returns null if the page couldn't be merged.
+    RefPtr<PhysicalPage> merge_page(Badge<AnonymousVMObject>, PhysicalPage&, Checksum);
+
+    struct Statistics {
+        size_t shared_pages { 0 };
+        size_t sharing_pages { 0 };
+        u64 merged_zero_pages { 0 };
+        u64 merged_pages { 0 };
+        u64 scanned_pages { 0 };
+        u64 full_scans { 0 };
+    };
+    Statistics statistics();
+
+private:
+    SamePageMerger() = default;
+
+    [[noreturn]] static void task_main();
+    void scan();
+    void finish_full_scan();
+
+    bool pages_are_identical(PhysicalPage&, PhysicalPage&);
+
+    // How many pages we look at every time the task wakes up.
+    static constexpr size_t pages_to_scan = 1024;
+    static constexpr size_t pages_to_scan_at_once = 64;
+    static constexpr size_t scan_interval_in_milliseconds = 200;
+
+    // These are only accessed by the merging task.
+    HashMap<u32, NonnullRefPtr<PhysicalPage>> m_merged_pages;
+    HashTable<u32> m_checksums_seen_in_current_scan;
+    size_t m_pages_scanned_in_current_scan { 0 };
+    Array<u8, PAGE_SIZE> m_buffer;
+
+    Spinlock<LockRank::None> m_statistics_lock {};
+    Statistics m_statistics;
+};
+
+}
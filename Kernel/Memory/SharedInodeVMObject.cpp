@@ -51,6 +51,10 @@ SharedInodeVMObject::SharedInodeVMObject(SharedInodeVMObject const& other, Fixed
 
 ErrorOr<void> SharedInodeVMObject::sync(off_t offset_in_pages, size_t pages)
 {
+    // Our pages are the inode's contents, so there is nothing to write back.
+    if (m_inode->shares_pages_with_vmobject())
+        return {};
+
     SpinlockLocker locker(m_lock);
 
     size_t highest_page_to_flush = min(page_count(), offset_in_pages + pages);
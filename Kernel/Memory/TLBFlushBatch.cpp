@@ -0,0 +1,58 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Memory/MemoryManager.h>
+#include <Kernel/Memory/Region.h>
+#include <Kernel/Memory/TLBFlushBatch.h>
+
+namespace Kernel::Memory {
+
+TLBFlushBatch::TLBFlushBatch(PageDirectory const& page_directory)
+    : m_page_directory(page_directory)
+{
+}
+
+TLBFlushBatch::~TLBFlushBatch()
+{
+    flush();
+}
+
+void TLBFlushBatch::add(VirtualRange const& range)
+{
+    if (range.size() == 0)
+        return;
+    if (m_start == m_end) {
+        m_start = range.base().get();
+        m_end = range.end().get();
+        return;
+    }
+    // NOTE: We only track a single covering range. Ranges touched by one operation are usually
+    //       adjacent, and large ranges are flushed wholesale by the processor anyway.
+    m_start = min(m_start, range.base().get());
+    m_end = max(m_end, range.end().get());
+}
+
+void TLBFlushBatch::unmap_and_release(NonnullOwnPtr<Region> region)
+{
+    add(region->range());
+    region->unmap(ShouldFlushTLB::No);
+    if (m_regions_to_release.try_append(move(region)).is_error()) {
+        // We can't defer destroying the region, so flush right away before its pages can be freed.
+        flush();
+    }
+}
+
+void TLBFlushBatch::flush()
+{
+    if (m_start != m_end) {
+        MemoryManager::flush_tlb(&m_page_directory, VirtualAddress(m_start), (m_end - m_start) / PAGE_SIZE);
+        m_start = 0;
+        m_end = 0;
+    }
+    m_regions_to_release.clear();
+}
+
+}
@@ -0,0 +1,44 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/NonnullOwnPtr.h>
+#include <AK/Vector.h>
+#include <Kernel/Forward.h>
+#include <Kernel/Memory/VirtualRange.h>
+
+namespace Kernel::Memory {
+
+// Collects the TLB invalidations of a single operation on an address space (like munmap or
+// mprotect spanning multiple regions), so they can be issued as one shootdown at the end
+// instead of one per region.
+//
+// Regions handed over to the batch are kept alive until the flush has happened, as their
+// physical pages must not be reused while other processors may still have them in their TLB.
+class TLBFlushBatch {
+    AK_MAKE_NONCOPYABLE(TLBFlushBatch);
+    AK_MAKE_NONMOVABLE(TLBFlushBatch);
+
+public:
+    explicit TLBFlushBatch(PageDirectory const&);
+    ~TLBFlushBatch();
+
+    void add(VirtualRange const&);
+
+    // Unmaps the region without flushing, and destroys it once the batch has been flushed.
+    void unmap_and_release(NonnullOwnPtr<Region>);
+
+    void flush();
+
+private:
+    PageDirectory const& m_page_directory;
+    FlatPtr m_start { 0 };
+    FlatPtr m_end { 0 };
+    Vector<NonnullOwnPtr<Region>, 4> m_regions_to_release;
+};
+
+}
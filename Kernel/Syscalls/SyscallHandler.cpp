@@ -14,6 +14,7 @@
 #include <Kernel/Tasks/PerformanceManager.h>
 #include <Kernel/Tasks/Process.h>
 #include <Kernel/Tasks/Scheduler.h>
+#include <Kernel/Tasks/SyscallStatistics.h>
 #include <Kernel/Tasks/ThreadTracer.h>
 
 namespace Kernel {
@@ -59,6 +60,8 @@ ErrorOr<FlatPtr> handle(RegisterState& regs, FlatPtr function, FlatPtr arg1, Fla
         return ENOSYS;
     }
 
+    auto start_time = SyscallStatistics::current_time();
+
     MutexLocker mutex_locker;
     auto const needs_big_lock = syscall_metadata.needs_lock == NeedsBigProcessLock::Yes;
     if (needs_big_lock) {
@@ -94,6 +97,9 @@ ErrorOr<FlatPtr> handle(RegisterState& regs, FlatPtr function, FlatPtr arg1, Fla
         result = (process.*(syscall_metadata.handler))(arg1, arg2, arg3, arg4);
     }
 
+    // NOTE: This includes the time spent waiting for the big lock, as that's part of what the caller waited for.
+    SyscallStatistics::the().record(process, static_cast<Function>(function), SyscallStatistics::current_time() - start_time, result.is_error());
+
     return result;
 }
 
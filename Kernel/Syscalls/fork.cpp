@@ -154,10 +154,23 @@ ErrorOr<FlatPtr> Process::sys$fork(RegisterState& regs)
 #    error Unknown architecture
 #endif
 
+    // The child only gets to see its own threads, so it gets a fresh running threads page in the same spot instead of sharing ours.
+    LockRefPtr<Memory::VMObject> parent_running_threads_page_vmobject;
+    LockRefPtr<Memory::VMObject> child_running_threads_page_vmobject;
+    if (running_threads_page()) {
+        parent_running_threads_page_vmobject = TRY(running_threads_page_vmobject());
+        child_running_threads_page_vmobject = TRY(child->running_threads_page_vmobject());
+    }
+
     TRY(address_space().with([&](auto& parent_space) {
         return child->address_space().with([&](auto& child_space) -> ErrorOr<void> {
             child_space->set_enforces_syscall_regions(parent_space->enforces_syscall_regions());
             for (auto& region : parent_space->region_tree().regions()) {
+                if (parent_running_threads_page_vmobject && &region.vmobject() == parent_running_threads_page_vmobject.ptr()) {
+                    TRY(child_space->allocate_region_with_vmobject(region.range(), *child_running_threads_page_vmobject, 0, region.name(), PROT_READ, true));
+                    continue;
+                }
+
                 dbgln_if(FORK_DEBUG, "fork: cloning Region '{}' @ {}", region.name(), region.vaddr());
                 auto region_clone = TRY(region.try_clone());
                 TRY(region_clone->map(child_space->page_directory(), Memory::ShouldFlushTLB::No));
@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
 #include <AK/Singleton.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Memory/InodeVMObject.h>
@@ -13,23 +14,86 @@
 
 namespace Kernel {
 
-static Singleton<SpinlockProtected<HashMap<GlobalFutexKey, NonnullLockRefPtr<FutexQueue>>, LockRank::None>> s_global_futex_queues;
+// The futex table is split into independently locked buckets, so that threads
+// contending on unrelated futexes don't serialize on a single lock.
+static constexpr size_t futex_bucket_count = 256;
+
+// Every bucket keeps a few empty FutexQueues around for reuse, so that waiting
+// on a futex usually doesn't have to allocate.
+static constexpr size_t futex_bucket_spare_queue_count = 4;
+
+struct FutexBucket {
+    HashMap<GlobalFutexKey, NonnullLockRefPtr<FutexQueue>> queues;
+    Vector<NonnullLockRefPtr<FutexQueue>, futex_bucket_spare_queue_count> spare_queues;
+};
+
+using FutexBuckets = Array<SpinlockProtected<FutexBucket, LockRank::None>, futex_bucket_count>;
+static Singleton<FutexBuckets> s_futex_buckets;
+
+static SpinlockProtected<FutexBucket, LockRank::None>& futex_bucket_for(GlobalFutexKey const& futex_key)
+{
+    return s_futex_buckets->at(Traits<GlobalFutexKey>::hash(futex_key) % futex_bucket_count);
+}
+
+static ErrorOr<LockRefPtr<FutexQueue>> find_futex_queue(GlobalFutexKey const& futex_key, bool create_if_not_found, bool* did_create = nullptr)
+{
+    return futex_bucket_for(futex_key).with([&](auto& bucket) -> ErrorOr<LockRefPtr<FutexQueue>> {
+        auto it = bucket.queues.find(futex_key);
+        if (it != bucket.queues.end())
+            return it->value;
+        if (!create_if_not_found)
+            return nullptr;
+        if (did_create)
+            *did_create = true;
+        LockRefPtr<FutexQueue> futex_queue;
+        if (!bucket.spare_queues.is_empty()) {
+            futex_queue = bucket.spare_queues.take_last();
+            futex_queue->prepare_for_reuse();
+        } else {
+            futex_queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) FutexQueue));
+        }
+        auto result = TRY(bucket.queues.try_set(futex_key, *futex_queue));
+        VERIFY(result == AK::HashSetResult::InsertedNewEntry);
+        return futex_queue;
+    });
+}
+
+static void remove_futex_queue(GlobalFutexKey const& futex_key, LockRefPtr<FutexQueue> futex_queue = nullptr)
+{
+    futex_bucket_for(futex_key).with([&](auto& bucket) {
+        // Drop the caller's reference while holding the bucket lock, nobody can
+        // acquire a new one without it.
+        futex_queue = nullptr;
+        auto it = bucket.queues.find(futex_key);
+        if (it == bucket.queues.end())
+            return;
+        if (!it->value->try_remove())
+            return;
+        NonnullLockRefPtr<FutexQueue> removed_queue = it->value;
+        bucket.queues.remove(it);
+        // If the table held the last other reference, the queue can be recycled.
+        if (removed_queue->ref_count() == 1 && bucket.spare_queues.size() < futex_bucket_spare_queue_count)
+            bucket.spare_queues.unchecked_append(move(removed_queue));
+    });
+}
 
 void Process::clear_futex_queues_on_exec()
 {
-    s_global_futex_queues->with([this](auto& queues) {
-        auto const* address_space = this->address_space().with([](auto& space) { return space.ptr(); });
-        queues.remove_all_matching([address_space](auto& futex_key, auto& futex_queue) {
-            if ((futex_key.raw.offset & futex_key_private_flag) == 0)
-                return false;
-            if (futex_key.private_.address_space != address_space)
-                return false;
-            bool did_wake_all;
-            futex_queue->wake_all(did_wake_all);
-            VERIFY(did_wake_all); // No one should be left behind...
-            return true;
+    auto const* address_space = this->address_space().with([](auto& space) { return space.ptr(); });
+    for (auto& futex_bucket : *s_futex_buckets) {
+        futex_bucket.with([&](auto& bucket) {
+            bucket.queues.remove_all_matching([address_space](auto& futex_key, auto& futex_queue) {
+                if ((futex_key.raw.offset & futex_key_private_flag) == 0)
+                    return false;
+                if (futex_key.private_.address_space != address_space)
+                    return false;
+                bool did_wake_all;
+                futex_queue->wake_all(did_wake_all);
+                VERIFY(did_wake_all); // No one should be left behind...
+                return true;
+            });
         });
-    });
+    }
 }
 
 ErrorOr<GlobalFutexKey> Process::get_futex_key(FlatPtr user_address, bool shared)
@@ -97,7 +161,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     u32 cmd = params.futex_op & FUTEX_CMD_MASK;
 
     bool use_realtime_clock = (params.futex_op & FUTEX_CLOCK_REALTIME) != 0;
-    if (use_realtime_clock && cmd != FUTEX_WAIT && cmd != FUTEX_WAIT_BITSET) {
+    if (use_realtime_clock && cmd != FUTEX_WAIT && cmd != FUTEX_WAIT_BITSET && cmd != FUTEX_WAITV) {
         return ENOSYS;
     }
 
@@ -106,6 +170,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     switch (cmd) {
     case FUTEX_WAIT:
     case FUTEX_WAIT_BITSET:
+    case FUTEX_WAITV:
     case FUTEX_REQUEUE:
     case FUTEX_CMP_REQUEUE: {
         if (params.timeout) {
@@ -124,32 +189,6 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
     }
     }
 
-    auto find_futex_queue = [&](GlobalFutexKey futex_key, bool create_if_not_found, bool* did_create = nullptr) -> ErrorOr<LockRefPtr<FutexQueue>> {
-        VERIFY(!create_if_not_found || did_create != nullptr);
-        return s_global_futex_queues->with([&](auto& queues) -> ErrorOr<LockRefPtr<FutexQueue>> {
-            auto it = queues.find(futex_key);
-            if (it != queues.end())
-                return it->value;
-            if (!create_if_not_found)
-                return nullptr;
-            *did_create = true;
-            auto futex_queue = TRY(adopt_nonnull_lock_ref_or_enomem(new (nothrow) FutexQueue));
-            auto result = TRY(queues.try_set(futex_key, futex_queue));
-            VERIFY(result == AK::HashSetResult::InsertedNewEntry);
-            return futex_queue;
-        });
-    };
-
-    auto remove_futex_queue = [&](GlobalFutexKey futex_key) {
-        return s_global_futex_queues->with([&](auto& queues) {
-            auto it = queues.find(futex_key);
-            if (it == queues.end())
-                return;
-            if (it->value->try_remove())
-                queues.remove(it);
-        });
-    };
-
     auto do_wake = [&](FlatPtr user_address, u32 count, Optional<u32> const& bitmask) -> ErrorOr<int> {
         if (count == 0)
             return 0;
@@ -161,7 +200,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         u32 woke_count = futex_queue->wake_n(count, bitmask, is_empty);
         if (is_empty) {
             // If there are no more waiters, we want to get rid of the futex!
-            remove_futex_queue(futex_key);
+            remove_futex_queue(futex_key, move(futex_queue));
         }
         return (int)woke_count;
     };
@@ -197,7 +236,7 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
 
         if (futex_queue->is_empty_and_no_imminent_waits()) {
             // If there are no more waiters, we want to get rid of the futex!
-            remove_futex_queue(futex_key);
+            remove_futex_queue(futex_key, move(futex_queue));
         }
         if (block_result == Thread::BlockResult::InterruptedByTimeout) {
             return ETIMEDOUT;
@@ -205,6 +244,81 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         return 0;
     };
 
+    auto do_waitv = [&]() -> ErrorOr<FlatPtr> {
+        if (params.val == 0 || params.val > FUTEX_WAITV_MAX)
+            return EINVAL;
+
+        Vector<futex_waitv> waiters;
+        TRY(waiters.try_resize(params.val));
+        TRY(copy_n_from_user(waiters.data(), Userspace<futex_waitv const*>(FlatPtr(params.userspace_address)), waiters.size()));
+
+        Vector<GlobalFutexKey> futex_keys;
+        TRY(futex_keys.try_ensure_capacity(waiters.size()));
+        for (auto const& waiter : waiters) {
+            if ((waiter.flags & ~FUTEX_PRIVATE_FLAG) != 0 || waiter.__reserved != 0 || waiter.val > NumericLimits<u32>::max())
+                return EINVAL;
+            futex_keys.unchecked_append(TRY(get_futex_key(waiter.uaddr, (waiter.flags & FUTEX_PRIVATE_FLAG) == 0)));
+        }
+
+        Vector<NonnullLockRefPtr<FutexQueue>> futex_queues;
+        TRY(futex_queues.try_ensure_capacity(waiters.size()));
+        auto cancel_imminent_waits = [&] {
+            for (size_t i = 0; i < futex_queues.size(); i++) {
+                if (futex_queues[i]->cancel_imminent_wait())
+                    remove_futex_queue(futex_keys[i]);
+            }
+        };
+
+        for (size_t i = 0; i < waiters.size(); i++) {
+            bool did_create;
+            LockRefPtr<FutexQueue> futex_queue;
+            do {
+                auto user_value = user_atomic_load_relaxed(reinterpret_cast<u32 volatile*>(waiters[i].uaddr));
+                if (!user_value.has_value() || user_value.value() != waiters[i].val) {
+                    cancel_imminent_waits();
+                    return user_value.has_value() ? EAGAIN : EFAULT;
+                }
+                atomic_thread_fence(AK::MemoryOrder::memory_order_acquire);
+
+                did_create = false;
+                auto result = find_futex_queue(futex_keys[i], true, &did_create);
+                if (result.is_error()) {
+                    cancel_imminent_waits();
+                    return result.release_error();
+                }
+                futex_queue = result.release_value();
+                VERIFY(futex_queue);
+            } while (!did_create && !futex_queue->queue_imminent_wait());
+            futex_queues.unchecked_append(futex_queue.release_nonnull());
+        }
+
+        Vector<NonnullOwnPtr<Thread::FutexBlocker>> blockers;
+        auto result = blockers.try_ensure_capacity(waiters.size());
+        for (size_t i = 0; !result.is_error() && i < futex_queues.size(); i++) {
+            auto blocker_or_error = adopt_nonnull_own_or_enomem(new (nothrow) Thread::FutexBlocker(*futex_queues[i], FUTEX_BITSET_MATCH_ANY));
+            if (blocker_or_error.is_error())
+                result = blocker_or_error.release_error();
+            else
+                blockers.unchecked_append(blocker_or_error.release_value());
+        }
+        if (result.is_error()) {
+            cancel_imminent_waits();
+            return result.release_error();
+        }
+
+        Optional<size_t> woken_index;
+        auto block_result = Thread::current()->block<Thread::FutexWaitvBlocker>(timeout, blockers.span(), woken_index);
+
+        for (size_t i = 0; i < futex_queues.size(); i++) {
+            if (futex_queues[i]->is_empty_and_no_imminent_waits())
+                remove_futex_queue(futex_keys[i]);
+        }
+        if (block_result == Thread::BlockResult::InterruptedByTimeout)
+            return ETIMEDOUT;
+        // NOTE: Like with every other futex wait, spurious wakeups are allowed.
+        return woken_index.value_or(0);
+    };
+
     auto do_requeue = [&](Optional<u32> val3) -> ErrorOr<FlatPtr> {
         auto user_value = user_atomic_load_relaxed(params.userspace_address);
         if (!user_value.has_value())
@@ -232,9 +346,9 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
             },
             params.val2, is_empty, is_target_empty));
         if (is_empty)
-            remove_futex_queue(futex_key);
+            remove_futex_queue(futex_key, move(futex_queue));
         if (is_target_empty && target_futex_queue)
-            remove_futex_queue(futex_key2);
+            remove_futex_queue(futex_key2, move(target_futex_queue));
         return woken_or_requeued;
     };
 
@@ -324,6 +438,9 @@ ErrorOr<FlatPtr> Process::sys$futex(Userspace<Syscall::SC_futex_params const*> u
         if (params.val3 == 0)
             return EINVAL;
         return TRY(do_wake(user_address, params.val, params.val3));
+
+    case FUTEX_WAITV:
+        return do_waitv();
     }
     return ENOSYS;
 }
@@ -17,6 +17,7 @@
 #include <Kernel/Memory/PrivateInodeVMObject.h>
 #include <Kernel/Memory/Region.h>
 #include <Kernel/Memory/SharedInodeVMObject.h>
+#include <Kernel/Memory/TLBFlushBatch.h>
 #include <Kernel/Tasks/PerformanceEventBuffer.h>
 #include <Kernel/Tasks/PerformanceManager.h>
 #include <Kernel/Tasks/Process.h>
@@ -313,10 +314,13 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
             if (old_region->vmobject().is_inode())
                 TRY(validate_inode_mmap_prot(prot, old_region->mmapped_from_readable(), old_region->mmapped_from_writable(), old_region->is_shared()));
 
+            Memory::TLBFlushBatch tlb_flush_batch(space->page_directory());
+
             // Remove the old region from our regions tree, since were going to add another region
             // with the exact same start address.
             auto region = space->take_region(*old_region);
-            region->unmap();
+            tlb_flush_batch.add(region->range());
+            region->unmap(Memory::ShouldFlushTLB::No);
 
             // This vector is the region(s) adjacent to our range.
             // We need to allocate a new region for the range we wanted to change permission bits on.
@@ -330,9 +334,9 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
 
             // Map the new regions using our page directory (they were just allocated and don't have one).
             for (auto* adjacent_region : adjacent_regions) {
-                TRY(adjacent_region->map(space->page_directory()));
+                TRY(adjacent_region->map(space->page_directory(), Memory::ShouldFlushTLB::No));
             }
-            TRY(new_region->map(space->page_directory()));
+            TRY(new_region->map(space->page_directory(), Memory::ShouldFlushTLB::No));
             return 0;
         }
 
@@ -354,6 +358,9 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
             if (full_size_found != range_to_mprotect.size())
                 return ENOMEM;
 
+            // Invalidate the TLB once for all affected regions, instead of once per region.
+            Memory::TLBFlushBatch tlb_flush_batch(space->page_directory());
+
             // Finally, iterate over each region, either updating its access flags if the range covers it wholly,
             // or carving out a new subregion with the appropriate access flags set.
             for (auto* old_region : regions) {
@@ -367,13 +374,15 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
                     old_region->set_writable(prot & PROT_WRITE);
                     old_region->set_executable(prot & PROT_EXEC);
 
-                    old_region->remap();
+                    TRY(old_region->map(space->page_directory(), Memory::ShouldFlushTLB::No));
+                    tlb_flush_batch.add(old_region->range());
                     continue;
                 }
                 // Remove the old region from our regions tree, since were going to add another region
                 // with the exact same start address.
                 auto region = space->take_region(*old_region);
-                region->unmap();
+                tlb_flush_batch.add(region->range());
+                region->unmap(Memory::ShouldFlushTLB::No);
 
                 // This vector is the region(s) adjacent to our range.
                 // We need to allocate a new region for the range we wanted to change permission bits on.
@@ -392,9 +401,9 @@ ErrorOr<FlatPtr> Process::sys$mprotect(Userspace<void*> addr, size_t size, int p
 
                 // Map the new region using our page directory (they were just allocated and don't have one) if any.
                 if (adjacent_regions.size())
-                    TRY(adjacent_regions[0]->map(space->page_directory()));
+                    TRY(adjacent_regions[0]->map(space->page_directory(), Memory::ShouldFlushTLB::No));
 
-                TRY(new_region->map(space->page_directory()));
+                TRY(new_region->map(space->page_directory(), Memory::ShouldFlushTLB::No));
             }
 
             return 0;
@@ -435,6 +444,14 @@ ErrorOr<FlatPtr> Process::sys$madvise(Userspace<void*> address, size_t size, int
             TRY(vmobject.set_volatile(advice == MADV_SET_VOLATILE, was_purged));
             return was_purged ? 1 : 0;
         }
+        if (advice == MADV_MERGEABLE || advice == MADV_UNMERGEABLE) {
+            // Merged pages are copy-on-write, which doesn't work for shared mappings.
+            if (!region->vmobject().is_anonymous() || region->is_shared())
+                return EINVAL;
+            auto& vmobject = static_cast<Memory::AnonymousVMObject&>(region->vmobject());
+            TRY(vmobject.set_mergeable(advice == MADV_MERGEABLE));
+            return 0;
+        }
         return EINVAL;
     });
 }
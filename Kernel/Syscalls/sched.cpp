@@ -19,6 +19,42 @@ ErrorOr<FlatPtr> Process::sys$yield()
     return 0;
 }
 
+ErrorOr<NonnullLockRefPtr<Memory::VMObject>> Process::running_threads_page_vmobject()
+{
+    if (auto vmobject = m_running_threads_page_region.with([](auto& region) -> LockRefPtr<Memory::VMObject> {
+            if (!region)
+                return nullptr;
+            return region->vmobject();
+        }))
+        return vmobject.release_nonnull();
+
+    auto new_region = TRY(MM.allocate_kernel_region(PAGE_SIZE, "Running threads page"sv, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+    auto& page = *reinterpret_cast<RunningThreadsPage*>(new_region->vaddr().as_ptr());
+    page.processor_count = Processor::count();
+
+    return m_running_threads_page_region.with([&](auto& region) -> NonnullLockRefPtr<Memory::VMObject> {
+        // Another thread got here first, use its page instead.
+        if (region)
+            return region->vmobject();
+        region = move(new_region);
+        m_running_threads_page.store(&page, AK::MemoryOrder::memory_order_release);
+        return region->vmobject();
+    });
+}
+
+ErrorOr<FlatPtr> Process::sys$map_running_threads_page()
+{
+    VERIFY_NO_PROCESS_BIG_LOCK(this);
+    TRY(require_promise(Pledge::stdio));
+
+    auto vmobject = TRY(running_threads_page_vmobject());
+
+    return address_space().with([&](auto& space) -> ErrorOr<FlatPtr> {
+        auto* region = TRY(space->allocate_region_with_vmobject(Memory::RandomizeVirtualAddress::Yes, {}, PAGE_SIZE, PAGE_SIZE, move(vmobject), 0, "Running threads page"sv, PROT_READ, true));
+        return region->vaddr().get();
+    });
+}
+
 ErrorOr<NonnullRefPtr<Thread>> Process::get_thread_from_pid_or_tid(pid_t pid_or_tid, Syscall::SchedulerParametersMode mode)
 {
     VERIFY(g_scheduler_lock.is_locked_by_current_processor());
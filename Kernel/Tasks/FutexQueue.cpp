@@ -146,6 +146,14 @@ bool FutexQueue::queue_imminent_wait()
     return true;
 }
 
+bool FutexQueue::cancel_imminent_wait()
+{
+    SpinlockLocker lock(m_lock);
+    VERIFY(m_imminent_waits > 0);
+    m_imminent_waits--;
+    return is_empty_and_no_imminent_waits_locked();
+}
+
 bool FutexQueue::try_remove()
 {
     SpinlockLocker lock(m_lock);
@@ -157,4 +165,13 @@ bool FutexQueue::try_remove()
     return true;
 }
 
+void FutexQueue::prepare_for_reuse()
+{
+    SpinlockLocker lock(m_lock);
+    VERIFY(m_was_removed);
+    VERIFY(is_empty_locked());
+    m_imminent_waits = 1;
+    m_was_removed = false;
+}
+
 }
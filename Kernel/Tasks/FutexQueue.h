@@ -30,7 +30,9 @@ public:
     }
 
     bool queue_imminent_wait();
+    bool cancel_imminent_wait();
     bool try_remove();
+    void prepare_for_reuse();
 
     bool is_empty_and_no_imminent_waits()
     {
@@ -12,6 +12,7 @@
 #include <Kernel/Arch/SafeMem.h>
 #include <Kernel/Arch/SmapDisabler.h>
 #include <Kernel/FileSystem/Custody.h>
+#include <Kernel/Interrupts/InterruptDisabler.h>
 #include <Kernel/Library/KBufferBuilder.h>
 #include <Kernel/Tasks/PerformanceEventBuffer.h>
 #include <Kernel/Tasks/Process.h>
@@ -76,7 +77,7 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
 ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, ThreadID tid,
     FlatPtr ip, FlatPtr bp, int type, u32 lost_samples, FlatPtr arg1, FlatPtr arg2, StringView arg3, FilesystemEvent filesystem_event)
 {
-    if (count() >= capacity())
+    if (!is_streaming() && count() >= capacity())
         return ENOBUFS;
 
     if ((g_profiling_event_mask & type) == 0)
@@ -163,6 +164,10 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
     case PERF_EVENT_FILESYSTEM:
         event.data.filesystem = filesystem_event;
         break;
+    case PERF_EVENT_LOCK_CONTENTION:
+        event.data.lock_contention.lock = arg1;
+        event.data.lock_contention.wait_time = arg2;
+        break;
     default:
         return EINVAL;
     }
@@ -174,10 +179,36 @@ ErrorOr<void> PerformanceEventBuffer::append_with_ip_and_bp(ProcessID pid, Threa
     event.pid = pid.value();
     event.tid = tid.value();
     event.timestamp = TimeManagement::the().uptime_ms();
+    if (is_streaming())
+        return append_to_ring(event);
     at(m_count++) = event;
     return {};
 }
 
+ErrorOr<void> PerformanceEventBuffer::append_to_ring(PerformanceEvent const& event)
+{
+    // Every processor only writes to its own ring, so all we have to worry about
+    // is an interrupt on this processor adding an event of its own in between.
+    InterruptDisabler disabler;
+    auto processor = Processor::current_id();
+    auto* ring = m_buffer->data() + processor * m_ring_size;
+    auto& header = *reinterpret_cast<PerformanceEventRingHeader*>(ring);
+
+    // NOTE: Userspace can scribble all over the header, so we only use it to find out how far along
+    //       the consumer is. Whatever is in there, we won't write outside of this ring.
+    auto head = AK::atomic_load(&header.head, AK::MemoryOrder::memory_order_relaxed);
+    auto tail = AK::atomic_load(&header.tail, AK::MemoryOrder::memory_order_acquire);
+    if (head - tail >= m_ring_capacity) {
+        AK::atomic_fetch_add(&header.lost_events, static_cast<u64>(1), AK::MemoryOrder::memory_order_relaxed);
+        return ENOBUFS;
+    }
+
+    auto* events = reinterpret_cast<PerformanceEvent*>(ring + sizeof(PerformanceEventRingHeader));
+    events[head % m_ring_capacity] = event;
+    AK::atomic_store(&header.head, head + 1, AK::MemoryOrder::memory_order_release);
+    return {};
+}
+
 PerformanceEvent& PerformanceEventBuffer::at(size_t index)
 {
     VERIFY(index < capacity());
@@ -217,7 +248,7 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
         auto const& event = at(i);
 
         if (!show_kernel_addresses) {
-            if (event.type == PERF_EVENT_KMALLOC || event.type == PERF_EVENT_KFREE)
+            if (event.type == PERF_EVENT_KMALLOC || event.type == PERF_EVENT_KFREE || event.type == PERF_EVENT_LOCK_CONTENTION)
                 continue;
         }
 
@@ -337,6 +368,11 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
             }
             }
             break;
+        case PERF_EVENT_LOCK_CONTENTION:
+            TRY(event_object.add("type"sv, "lock_contention"sv));
+            TRY(event_object.add("lock"sv, event.data.lock_contention.lock));
+            TRY(event_object.add("wait_time"sv, event.data.lock_contention.wait_time));
+            break;
         }
         TRY(event_object.add("pid"sv, event.pid));
         TRY(event_object.add("tid"sv, event.tid));
@@ -361,6 +397,10 @@ ErrorOr<void> PerformanceEventBuffer::to_json_impl(Serializer& object) const
 
 ErrorOr<void> PerformanceEventBuffer::to_json(KBufferBuilder& builder) const
 {
+    // Streamed events have to be read from the rings as they come in.
+    if (is_streaming())
+        return ENOTSUP;
+
     auto object = TRY(JsonObjectSerializer<>::try_create(builder));
     return to_json_impl(object);
 }
@@ -373,6 +413,30 @@ OwnPtr<PerformanceEventBuffer> PerformanceEventBuffer::try_create_with_size(size
     return adopt_own_if_nonnull(new (nothrow) PerformanceEventBuffer(buffer_or_error.release_value()));
 }
 
+ErrorOr<NonnullOwnPtr<PerformanceEventBuffer>> PerformanceEventBuffer::try_create_with_per_processor_rings(size_t events_per_processor)
+{
+    if (events_per_processor == 0 || events_per_processor > max_events_per_ring)
+        return EINVAL;
+
+    auto ring_size = TRY(Memory::page_round_up(sizeof(PerformanceEventRingHeader) + events_per_processor * sizeof(PerformanceEvent)));
+    auto processor_count = Processor::count();
+    auto buffer = TRY(KBuffer::try_create_with_size("Performance event rings"sv, ring_size * processor_count, Memory::Region::Access::ReadWrite, AllocationStrategy::AllocateNow));
+    for (u32 processor = 0; processor < processor_count; ++processor) {
+        auto& header = *reinterpret_cast<PerformanceEventRingHeader*>(buffer->data() + processor * ring_size);
+        header = {};
+        header.capacity = events_per_processor;
+        header.processor = processor;
+        header.processor_count = processor_count;
+        header.events_offset = sizeof(PerformanceEventRingHeader);
+        header.ring_size = ring_size;
+    }
+
+    auto event_buffer = TRY(adopt_nonnull_own_or_enomem(new (nothrow) PerformanceEventBuffer(move(buffer))));
+    event_buffer->m_ring_capacity = events_per_processor;
+    event_buffer->m_ring_size = ring_size;
+    return event_buffer;
+}
+
 ErrorOr<void> PerformanceEventBuffer::add_process(Process const& process, ProcessEventType event_type)
 {
     OwnPtr<KString> executable;
@@ -109,6 +109,15 @@ public:
         }
     }
 
+    static void add_lock_contention_event(Thread& current_thread, FlatPtr lock, u64 wait_time)
+    {
+        if (current_thread.is_profiling_suppressed())
+            return;
+        if (auto* event_buffer = current_thread.process().current_perf_events_buffer()) {
+            [[maybe_unused]] auto res = event_buffer->append(PERF_EVENT_LOCK_CONTENTION, lock, wait_time, {}, &current_thread);
+        }
+    }
+
     static void add_page_fault_event(Thread& thread, RegisterState const& regs)
     {
         if (thread.is_profiling_suppressed())
@@ -306,6 +306,8 @@ ErrorOr<Process::ProcessAndFirstThread> Process::create(StringView name, UserID
     auto credentials = TRY(Credentials::create(uid, gid, uid, gid, uid, gid, {}, fork_parent ? fork_parent->sid() : 0, fork_parent ? fork_parent->pgid() : 0));
 
     auto process = TRY(adopt_nonnull_ref_or_enomem(new (nothrow) Process(name, move(credentials), ppid, is_kernel_process, move(current_directory), move(executable), tty, move(unveil_tree), move(exec_unveil_tree), kgettimeofday())));
+    if (!is_kernel_process)
+        process->m_syscall_counters = TRY(adopt_nonnull_own_or_enomem(new (nothrow) ProcessSyscallCounters));
 
     OwnPtr<Memory::AddressSpace> new_address_space;
     if (fork_parent) {
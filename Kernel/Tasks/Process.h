@@ -17,6 +17,7 @@
 #include <AK/Variant.h>
 #include <Kernel/API/POSIX/select.h>
 #include <Kernel/API/POSIX/sys/resource.h>
+#include <Kernel/API/RunningThreadsPage.h>
 #include <Kernel/API/Syscall.h>
 #include <Kernel/FileSystem/InodeMetadata.h>
 #include <Kernel/FileSystem/OpenFileDescription.h>
@@ -35,6 +36,7 @@
 #include <Kernel/Tasks/FutexQueue.h>
 #include <Kernel/Tasks/PerformanceEventBuffer.h>
 #include <Kernel/Tasks/ProcessGroup.h>
+#include <Kernel/Tasks/SyscallStatistics.h>
 #include <Kernel/Tasks/Thread.h>
 #include <Kernel/UnixTypes.h>
 #include <LibELF/ELFABI.h>
@@ -461,6 +463,7 @@ public:
     ErrorOr<FlatPtr> sys$anon_create(size_t, int options);
     ErrorOr<FlatPtr> sys$statvfs(Userspace<Syscall::SC_statvfs_params const*> user_params);
     ErrorOr<FlatPtr> sys$fstatvfs(int fd, statvfs* buf);
+    ErrorOr<FlatPtr> sys$map_running_threads_page();
     ErrorOr<FlatPtr> sys$map_time_page();
     ErrorOr<FlatPtr> sys$jail_create(Userspace<Syscall::SC_jail_create_params*> user_params);
     ErrorOr<FlatPtr> sys$jail_attach(Userspace<Syscall::SC_jail_attach_params const*> user_params);
@@ -598,6 +601,13 @@ public:
     PerformanceEventBuffer* perf_events() { return m_perf_event_buffer; }
     PerformanceEventBuffer const* perf_events() const { return m_perf_event_buffer; }
 
+    ProcessSyscallCounters* syscall_counters() { return m_syscall_counters; }
+    ProcessSyscallCounters const* syscall_counters() const { return m_syscall_counters; }
+
+    // Only exists once one of our threads has called sys$map_running_threads_page().
+    RunningThreadsPage* running_threads_page() const { return m_running_threads_page.load(AK::MemoryOrder::memory_order_acquire); }
+    ErrorOr<NonnullLockRefPtr<Memory::VMObject>> running_threads_page_vmobject();
+
     SpinlockProtected<OwnPtr<Memory::AddressSpace>, LockRank::None>& address_space() { return m_space; }
     SpinlockProtected<OwnPtr<Memory::AddressSpace>, LockRank::None> const& address_space() const { return m_space; }
 
@@ -707,6 +717,7 @@ public:
     ErrorOr<void> procfs_get_binary_link(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_current_work_directory_link(KBufferBuilder& builder) const;
     ErrorOr<void> procfs_get_command_line(KBufferBuilder& builder) const;
+    ErrorOr<void> procfs_get_syscall_statistics(KBufferBuilder& builder) const;
     mode_t binary_link_required_mode() const;
     ErrorOr<void> procfs_get_thread_stack(ThreadID thread_id, KBufferBuilder& builder) const;
     ErrorOr<void> traverse_stacks_directory(FileSystemID, Function<ErrorOr<void>(FileSystem::DirectoryEntryView const&)> callback) const;
@@ -950,6 +961,12 @@ private:
 
     OwnPtr<PerformanceEventBuffer> m_perf_event_buffer;
 
+    SpinlockProtected<OwnPtr<Memory::Region>, LockRank::None> m_running_threads_page_region;
+    Atomic<RunningThreadsPage*> m_running_threads_page { nullptr };
+
+    // Kernel processes don't make any syscalls, so they don't get these.
+    OwnPtr<ProcessSyscallCounters> m_syscall_counters;
+
     // This member is used in the implementation of ptrace's PT_TRACEME flag.
     // If it is set to true, the process will stop at the next execve syscall
     // and wait for a tracer to attach.
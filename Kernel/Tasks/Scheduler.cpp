@@ -8,6 +8,7 @@
 #include <AK/ScopeGuard.h>
 #include <AK/Singleton.h>
 #include <AK/Time.h>
+#include <Kernel/API/RunningThreadsPage.h>
 #include <Kernel/Arch/TrapFrame.h>
 #include <Kernel/Debug.h>
 #include <Kernel/Interrupts/InterruptDisabler.h>
@@ -36,6 +37,18 @@ READONLY_AFTER_INIT WaitQueue* g_finalizer_wait_queue;
 Atomic<bool> g_finalizer_has_work { false };
 READONLY_AFTER_INIT static Process* s_colonel_process;
 
+static_assert(MAX_CPU_COUNT <= RunningThreadsPage::max_processor_count);
+
+// Every process only gets to see its own threads, so we have to take the thread we're switching away from out of its page.
+static void update_running_threads_pages(Thread const& from_thread, Thread const& to_thread)
+{
+    auto processor_id = Processor::current_id();
+    if (auto* page = from_thread.process().running_threads_page())
+        page->running_thread_ids[processor_id] = 0;
+    if (auto* page = to_thread.process().running_threads_page())
+        page->running_thread_ids[processor_id] = to_thread.tid().value();
+}
+
 struct ThreadReadyQueue {
     IntrusiveList<&Thread::m_ready_queue_node> thread_list;
 };
@@ -286,6 +299,7 @@ void Scheduler::context_switch(Thread* thread)
         thread->set_initialized(true);
     }
     thread->set_state(Thread::State::Running);
+    update_running_threads_pages(*from_thread, *thread);
 
     PerformanceManager::add_context_switch_perf_event(*from_thread, *thread);
 
@@ -480,7 +494,11 @@ void Scheduler::idle_loop(void*)
 
     for (;;) {
         proc.idle_begin();
+        // We get an IPI once there's something for us to run, so the timer tick would only wake us up needlessly.
+        bool did_stop_tick = TimeManagement::the().stop_tick_for_idle_processor();
         proc.wait_for_interrupt();
+        if (did_stop_tick)
+            TimeManagement::the().restart_tick_for_idle_processor();
         proc.idle_end();
         VERIFY_INTERRUPTS_ENABLED();
         yield();
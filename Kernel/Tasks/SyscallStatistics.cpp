@@ -0,0 +1,101 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/Arch/Processor.h>
+#include <Kernel/Library/ScopedCritical.h>
+#include <Kernel/Sections.h>
+#include <Kernel/Tasks/Process.h>
+#include <Kernel/Tasks/SyscallStatistics.h>
+#include <Kernel/Time/TimeManagement.h>
+
+namespace Kernel {
+
+static SyscallStatistics* s_the;
+
+UNMAP_AFTER_INIT void SyscallStatistics::initialize()
+{
+    VERIFY(!s_the);
+    auto* statistics = new SyscallStatistics;
+    VERIFY(statistics);
+
+    // NOTE: This has to happen after all processors have been brought up.
+    statistics->m_processor_counters = MUST(FixedArray<OwnPtr<CounterArray>>::create(Processor::count()));
+    for (auto& counters : statistics->m_processor_counters)
+        counters = MUST(adopt_nonnull_own_or_enomem(new (nothrow) CounterArray));
+
+    statistics->m_calibration_time = current_time();
+    statistics->m_calibration_time_in_nanoseconds = TimeManagement::the().monotonic_time(TimePrecision::Precise).nanoseconds();
+    s_the = statistics;
+}
+
+bool SyscallStatistics::is_initialized()
+{
+    return s_the != nullptr;
+}
+
+SyscallStatistics& SyscallStatistics::the()
+{
+    return *s_the;
+}
+
+u64 SyscallStatistics::current_time()
+{
+    return TimeManagement::scheduler_current_time();
+}
+
+void SyscallStatistics::record(Process& process, Syscall::Function function, u64 time, bool is_error)
+{
+    VERIFY(function < Syscall::Function::__Count);
+
+    if (auto* process_counters = process.syscall_counters()) {
+        auto& counters = process_counters->syscalls[function];
+        counters.calls.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        if (is_error)
+            counters.errors.fetch_add(1, AK::MemoryOrder::memory_order_relaxed);
+        counters.total_time.fetch_add(time, AK::MemoryOrder::memory_order_relaxed);
+    }
+
+    // Make sure we don't get moved to another processor while we're updating the counters of this one.
+    ScopedCritical critical;
+    auto& counters = (*m_processor_counters[Processor::current_id()])[function];
+    ++counters.calls;
+    if (is_error)
+        ++counters.errors;
+    counters.total_time += time;
+    counters.max_time = max(counters.max_time, time);
+    ++counters.histogram[histogram_bucket(time)];
+}
+
+void SyscallStatistics::sum_counters(CounterArray& sum) const
+{
+    // NOTE: Other processors may be updating their counters while we read them. That's fine, as
+    //       every single counter is read in one go, and we never need them to be exactly in sync.
+    for (auto& total : sum)
+        total = {};
+    for (auto const& processor_counters : m_processor_counters) {
+        for (size_t function = 0; function < Syscall::Function::__Count; ++function) {
+            auto const& counters = (*processor_counters)[function];
+            auto& total = sum[function];
+            total.calls += counters.calls;
+            total.errors += counters.errors;
+            total.total_time += counters.total_time;
+            total.max_time = max(total.max_time, counters.max_time);
+            for (size_t bucket = 0; bucket < histogram_bucket_count; ++bucket)
+                total.histogram[bucket] += counters.histogram[bucket];
+        }
+    }
+}
+
+SyscallStatistics::TimeScale SyscallStatistics::time_scale() const
+{
+    auto elapsed_time = current_time() - m_calibration_time;
+    auto elapsed_microseconds = (TimeManagement::the().monotonic_time(TimePrecision::Precise).nanoseconds() - m_calibration_time_in_nanoseconds) / 1000;
+    if (elapsed_microseconds <= 0 || elapsed_time < static_cast<u64>(elapsed_microseconds))
+        return {};
+    return { .units_per_microsecond = elapsed_time / static_cast<u64>(elapsed_microseconds) };
+}
+
+}
@@ -0,0 +1,96 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <AK/BuiltinWrappers.h>
+#include <AK/FixedArray.h>
+#include <AK/NumericLimits.h>
+#include <AK/OwnPtr.h>
+#include <AK/Types.h>
+#include <Kernel/API/Syscall.h>
+#include <Kernel/Forward.h>
+
+namespace Kernel {
+
+// How often every syscall has been made by a single process, and how much time it took.
+// Threads of a process can run on different processors at the same time, so these are atomic.
+struct ProcessSyscallCounters {
+    struct Counters {
+        Atomic<u64> calls { 0 };
+        Atomic<u64> errors { 0 };
+        Atomic<u64> total_time { 0 };
+    };
+    Array<Counters, Syscall::Function::__Count> syscalls;
+};
+
+// Counts and times every syscall made on the system.
+//
+// Every processor has its own set of counters, so recording a syscall never touches memory that
+// another processor might be writing to. The counters of all processors are only added up when
+// someone wants to look at them (through /sys/kernel/syscall_statistics). Besides the number of
+// calls and errors, we keep a histogram of how long the calls took, with power-of-two buckets.
+class SyscallStatistics {
+    AK_MAKE_NONCOPYABLE(SyscallStatistics);
+    AK_MAKE_NONMOVABLE(SyscallStatistics);
+
+public:
+    static constexpr size_t histogram_bucket_count = 32;
+
+    struct Counters {
+        u64 calls { 0 };
+        u64 errors { 0 };
+        u64 total_time { 0 };
+        u64 max_time { 0 };
+        Array<u64, histogram_bucket_count> histogram {};
+    };
+    using CounterArray = Array<Counters, Syscall::Function::__Count>;
+
+    static void initialize();
+    static bool is_initialized();
+    static SyscallStatistics& the();
+
+    // Syscalls are timed in whatever unit the scheduler uses, which might be processor cycles.
+    static u64 current_time();
+    void record(Process&, Syscall::Function, u64 time, bool is_error);
+
+    // Adds up the counters of all processors.
+    void sum_counters(CounterArray&) const;
+
+    struct TimeScale {
+        u64 units_per_microsecond { 1000 };
+        u64 to_nanoseconds(u64 time) const { return time / units_per_microsecond * 1000 + time % units_per_microsecond * 1000 / units_per_microsecond; }
+    };
+    // Figures out how our time unit relates to real time, by looking at how far both have come since we were initialized.
+    TimeScale time_scale() const;
+
+    // A time falls into the first bucket whose limit is larger than it.
+    static constexpr size_t histogram_bucket(u64 time)
+    {
+        if (time == 0)
+            return 0;
+        return min<size_t>(64 - count_leading_zeroes(time), histogram_bucket_count - 1);
+    }
+    static constexpr u64 histogram_bucket_limit(size_t bucket)
+    {
+        if (bucket == histogram_bucket_count - 1)
+            return NumericLimits<u64>::max();
+        return 1ull << bucket;
+    }
+
+private:
+    SyscallStatistics() = default;
+
+    // Indexed by processor id.
+    FixedArray<OwnPtr<CounterArray>> m_processor_counters;
+
+    u64 m_calibration_time { 0 };
+    i64 m_calibration_time_in_nanoseconds { 0 };
+};
+
+}
@@ -1271,7 +1271,7 @@ void Thread::set_state(State new_state, u8 stop_signal)
 
     if (m_state == Thread::State::Runnable) {
         Scheduler::enqueue_runnable_thread(*this);
-        Processor::smp_wake_n_idle_processors(1);
+        Processor::smp_wake_n_idle_processors(1, affinity());
     } else if (m_state == Thread::State::Stopped) {
         // We don't want to restore to Running state, only Runnable!
         m_stop_state = previous_state != Thread::State::Running ? previous_state : Thread::State::Runnable;
@@ -457,6 +457,8 @@ public:
         bool m_did_unblock { false };
     };
 
+    class FutexWaitvBlocker;
+
     class FutexBlocker final : public Blocker {
     public:
         explicit FutexBlocker(FutexQueue&, u32);
@@ -479,11 +481,41 @@ public:
         bool unblock_bitset(u32 bitset);
         bool unblock(bool force = false);
 
+        void set_waitv_blocker(FutexWaitvBlocker& waitv_blocker, size_t index)
+        {
+            m_waitv_blocker = &waitv_blocker;
+            m_waitv_index = index;
+        }
+
     protected:
+        bool finish_unblock();
+
         FutexQueue& m_futex_queue;
         u32 m_bitset { 0 };
         InterruptsState m_previous_interrupts_state { InterruptsState::Disabled };
         bool m_did_unblock { false };
+        FutexWaitvBlocker* m_waitv_blocker { nullptr };
+        size_t m_waitv_index { 0 };
+    };
+
+    // Blocks on several futexes at once. Each futex gets its own FutexBlocker entry
+    // in the corresponding FutexQueue, and the first entry to be woken unblocks the thread.
+    class FutexWaitvBlocker final : public Blocker {
+    public:
+        FutexWaitvBlocker(Span<NonnullOwnPtr<FutexBlocker>>, Optional<size_t>& woken_index);
+        virtual ~FutexWaitvBlocker();
+
+        virtual Type blocker_type() const override { return Type::Futex; }
+        virtual StringView state_string() const override { return "Futex"sv; }
+        virtual void will_unblock_immediately_without_blocking(UnblockImmediatelyReason) override { }
+        virtual bool setup_blocker() override;
+        virtual void finalize() override;
+
+        bool unblock_entry(size_t index);
+
+    private:
+        Span<NonnullOwnPtr<FutexBlocker>> m_entries;
+        Optional<size_t>& m_woken_index;
     };
 
     class FileBlocker : public Blocker {
@@ -177,8 +177,7 @@ bool Thread::FutexBlocker::unblock_bitset(u32 bitset)
         m_did_unblock = true;
     }
 
-    unblock_from_blocker();
-    return true;
+    return finish_unblock();
 }
 
 bool Thread::FutexBlocker::unblock(bool force)
@@ -190,6 +189,60 @@ bool Thread::FutexBlocker::unblock(bool force)
         m_did_unblock = true;
     }
 
+    return finish_unblock() || force;
+}
+
+bool Thread::FutexBlocker::finish_unblock()
+{
+    // If we are one of several futexes waited on together, only the first
+    // entry to be woken gets to unblock the thread.
+    if (m_waitv_blocker)
+        return m_waitv_blocker->unblock_entry(m_waitv_index);
+
+    unblock_from_blocker();
+    return true;
+}
+
+Thread::FutexWaitvBlocker::FutexWaitvBlocker(Span<NonnullOwnPtr<FutexBlocker>> entries, Optional<size_t>& woken_index)
+    : m_entries(entries)
+    , m_woken_index(woken_index)
+{
+    for (size_t i = 0; i < m_entries.size(); i++)
+        m_entries[i]->set_waitv_blocker(*this, i);
+}
+
+Thread::FutexWaitvBlocker::~FutexWaitvBlocker() = default;
+
+bool Thread::FutexWaitvBlocker::setup_blocker()
+{
+    // NOTE: Every entry has to be offered to its queue, even if an earlier one
+    //       failed, as each of them accounts for one imminent wait.
+    bool should_block = true;
+    for (auto& entry : m_entries) {
+        if (!entry->setup_blocker())
+            should_block = false;
+    }
+
+    SpinlockLocker lock(m_lock);
+    return should_block && !m_woken_index.has_value();
+}
+
+void Thread::FutexWaitvBlocker::finalize()
+{
+    for (auto& entry : m_entries)
+        entry->finalize();
+    Blocker::finalize();
+}
+
+bool Thread::FutexWaitvBlocker::unblock_entry(size_t index)
+{
+    {
+        SpinlockLocker lock(m_lock);
+        if (m_woken_index.has_value())
+            return false;
+        m_woken_index = index;
+    }
+
     unblock_from_blocker();
     return true;
 }
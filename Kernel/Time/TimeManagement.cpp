@@ -26,6 +26,8 @@
 #include <Kernel/Boot/CommandLine.h>
 #include <Kernel/Firmware/ACPI/Parser.h>
 #include <Kernel/Interrupts/InterruptDisabler.h>
+#include <Kernel/Library/ScopedCritical.h>
+#include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Sections.h>
 #include <Kernel/Tasks/PerformanceManager.h>
 #include <Kernel/Tasks/Scheduler.h>
@@ -37,6 +39,11 @@ namespace Kernel {
 
 static Singleton<TimeManagement> s_the;
 
+#if ARCH(X86_64)
+// The time page's TSC clock runs slow by 1/2048 (about 500 ppm), see calibrate_tsc_for_time_page().
+static constexpr u64 time_page_tsc_slowdown_divisor = 2048;
+#endif
+
 bool TimeManagement::is_initialized()
 {
     return s_the.is_initialized();
@@ -81,11 +88,11 @@ Duration TimeManagement::current_time(clockid_t clock_id) const
 {
     switch (clock_id) {
     case CLOCK_MONOTONIC:
-        return monotonic_time(TimePrecision::Precise).time_since_start({});
+        return max(monotonic_time(TimePrecision::Precise).time_since_start({}), Duration::from_nanoseconds(m_time_page_monotonic_floor_ns.load()));
     case CLOCK_MONOTONIC_COARSE:
         return monotonic_time(TimePrecision::Coarse).time_since_start({});
     case CLOCK_MONOTONIC_RAW:
-        return monotonic_time_raw().time_since_start({});
+        return max(monotonic_time_raw().time_since_start({}), Duration::from_nanoseconds(m_time_page_monotonic_floor_ns.load()));
     case CLOCK_REALTIME:
         return epoch_time(TimePrecision::Precise).offset_to_epoch();
     case CLOCK_REALTIME_COARSE:
@@ -269,6 +276,8 @@ UNMAP_AFTER_INIT TimeManagement::TimeManagement()
     } else if (!probe_and_set_x86_legacy_hardware_timers()) {
         VERIFY_NOT_REACHED();
     }
+    if (m_can_query_precise_time)
+        calibrate_tsc_for_time_page();
 #elif ARCH(AARCH64)
     probe_and_set_aarch64_hardware_timers();
 #else
@@ -394,6 +403,113 @@ UNMAP_AFTER_INIT bool TimeManagement::probe_and_set_x86_non_legacy_hardware_time
     return true;
 }
 
+UNMAP_AFTER_INIT void TimeManagement::calibrate_tsc_for_time_page()
+{
+    // Userspace can only use the TSC if it ticks at the same rate all the time, and on all processors.
+    auto& processor = Processor::current();
+    if (!processor.has_feature(CPUFeature::TSC) || !processor.has_feature(CPUFeature::CONSTANT_TSC) || !processor.has_feature(CPUFeature::NONSTOP_TSC)) {
+        dmesgln("Time: TSC is not invariant, the time page will only have the coarse clocks");
+        return;
+    }
+
+    // Count TSC ticks for about 10 ms of the HPET main counter.
+    auto& hpet = HPET::the();
+    u64 calibration_ticks = hpet.frequency() / 100;
+    u64 start_hpet = hpet.read_main_counter();
+    u64 start_tsc = read_tsc();
+    u64 end_hpet;
+    do {
+        end_hpet = hpet.read_main_counter();
+    } while (end_hpet >= start_hpet && end_hpet - start_hpet < calibration_ticks);
+    u64 end_tsc = read_tsc();
+
+    if (end_hpet < start_hpet || end_tsc <= start_tsc) {
+        dmesgln("Time: Could not calibrate the TSC, the time page will only have the coarse clocks");
+        return;
+    }
+
+    u64 tsc_frequency = (end_tsc - start_tsc) * hpet.frequency() / (end_hpet - start_hpet);
+    m_calibrated_tsc_multiplier = (1'000'000'000ull << TimePage::counter_shift) / tsc_frequency;
+    // Make the TSC clock run about 500 ppm slow, so that readers never get ahead of the HPET between two updates
+    // of the time page, and so that the next update never has to move the clocks backwards.
+    // NOTE: The syscall reads the HPET and is thus ahead of the time page, so userspace must not mix the two while the
+    //       time page has a counter. Once the TSC is given up, the syscall starts out from where the time page left off.
+    m_calibrated_tsc_multiplier -= m_calibrated_tsc_multiplier / time_page_tsc_slowdown_divisor;
+    dmesgln("Time: TSC runs at {}.{} MHz", tsc_frequency / 1000000, tsc_frequency % 1000000);
+}
+
+// Two processors take turns reading the TSC under a lock. If one of them ever reads a value that's lower than
+// the one the other processor read before it, their TSCs are out of sync.
+struct TSCWarpCheck {
+    static constexpr size_t iterations = 10'000;
+
+    Spinlock<LockRank::None> lock {};
+    u64 last_tsc { 0 };
+    bool warped { false };
+    Atomic<u32> ready_processors { 0 };
+    Atomic<bool> other_processor_is_done { false };
+
+    // The processor that started the check keeps handling messages from other processors while it waits.
+    static void wait_until(auto condition, bool is_initiator)
+    {
+        while (!condition()) {
+            Processor::pause();
+            if (is_initiator)
+                Processor::current().smp_process_pending_messages();
+        }
+    }
+
+    void run(bool is_initiator)
+    {
+        // Make sure that both processors actually race each other.
+        ready_processors.fetch_add(1);
+        wait_until([this] { return ready_processors.load() == 2; }, is_initiator);
+
+        for (size_t i = 0; i < iterations; ++i) {
+            SpinlockLocker locker(lock);
+            // Without the lfence, the TSC could be read before we took the lock.
+            asm volatile("lfence" ::
+                             : "memory");
+            u64 tsc = read_tsc();
+            if (tsc < last_tsc)
+                warped = true;
+            last_tsc = tsc;
+        }
+    }
+};
+
+UNMAP_AFTER_INIT void TimeManagement::check_tsc_synchronization_for_time_page()
+{
+    if (m_calibrated_tsc_multiplier == 0)
+        return;
+
+    // NOTE: We mustn't get preempted while another processor spins on us in its IPI handler.
+    ScopedCritical critical;
+    auto current_id = Processor::current_id();
+    for (u32 id = 0; id < Processor::count(); ++id) {
+        if (id == current_id)
+            continue;
+
+        TSCWarpCheck check;
+        Processor::smp_unicast(
+            id, [&check] {
+                check.run(false);
+                check.other_processor_is_done.store(true);
+            },
+            true);
+        check.run(true);
+        TSCWarpCheck::wait_until([&check] { return check.other_processor_is_done.load(); }, true);
+
+        if (check.warped) {
+            dmesgln("Time: TSC of CPU #{} is not in sync with CPU #{}, the time page will only have the coarse clocks", id, current_id);
+            return;
+        }
+    }
+
+    dmesgln("Time: Using the TSC for the time page");
+    m_time_page_counter_multiplier.store(m_calibrated_tsc_multiplier);
+}
+
 UNMAP_AFTER_INIT bool TimeManagement::probe_and_set_x86_legacy_hardware_timers()
 {
     if (ACPI::is_enabled()) {
@@ -509,6 +625,7 @@ void TimeManagement::increment_time_since_boot()
 
 void TimeManagement::system_timer_tick(RegisterState const& regs)
 {
+    ++the().m_timer_ticks;
     if (Processor::current_in_irq() <= 1) {
         // Don't expire timers while handling IRQs
         TimerQueue::the().fire();
@@ -516,6 +633,36 @@ void TimeManagement::system_timer_tick(RegisterState const& regs)
     Scheduler::timer_tick(regs);
 }
 
+bool TimeManagement::stop_tick_for_idle_processor()
+{
+#if ARCH(X86_64)
+    // The BSP keeps ticking, as it keeps the time and fires the timers for everyone else.
+    if (Processor::is_bootstrap_processor() || m_system_timer->timer_type() != HardwareTimerType::LocalAPICTimer)
+        return false;
+    static_cast<APICTimer&>(*m_system_timer).enable_local_one_shot_timer(max_tickless_idle_ticks);
+    ++m_tickless_idle_periods;
+    return true;
+#else
+    // FIXME: Stop the tick of idle processors on other architectures, once they support SMP.
+    return false;
+#endif
+}
+
+void TimeManagement::restart_tick_for_idle_processor()
+{
+#if ARCH(X86_64)
+    VERIFY(m_system_timer->timer_type() == HardwareTimerType::LocalAPICTimer);
+    static_cast<APICTimer&>(*m_system_timer).enable_local_timer();
+#else
+    VERIFY_NOT_REACHED();
+#endif
+}
+
+TimeManagement::TickStatistics TimeManagement::tick_statistics() const
+{
+    return { m_timer_ticks.load(), m_tickless_idle_periods.load() };
+}
+
 bool TimeManagement::enable_profile_timer()
 {
     if (!m_profile_timer)
@@ -540,9 +687,66 @@ void TimeManagement::update_time_page()
     u32 update_iteration = AK::atomic_fetch_add(&page.update2, 1u, AK::MemoryOrder::memory_order_acquire);
     page.clocks[CLOCK_REALTIME_COARSE] = m_epoch_time.to_timespec();
     page.clocks[CLOCK_MONOTONIC_COARSE] = monotonic_time(TimePrecision::Coarse).time_since_start({}).to_timespec();
+#if ARCH(X86_64)
+    if (m_time_page_counter_multiplier.load() != 0)
+        update_precise_clocks_in_time_page(page);
+#endif
     AK::atomic_store(&page.update1, update_iteration + 1u, AK::MemoryOrder::memory_order_release);
 }
 
+#if ARCH(X86_64)
+void TimeManagement::update_precise_clocks_in_time_page(TimePage& page)
+{
+    u64 counter = read_tsc();
+    auto monotonic_now = monotonic_time(TimePrecision::Precise).time_since_start({});
+
+    if (page.counter_multiplier != 0) {
+        // Readers extrapolate from the last update, and might have seen anything up to this.
+        auto published_monotonic = Duration::from_timespec(page.clocks[CLOCK_MONOTONIC]);
+        auto extrapolated_now = published_monotonic;
+        if (counter >= page.counter_base)
+            extrapolated_now += Duration::from_nanoseconds(static_cast<i64>(page.counter_ticks_to_nanoseconds(counter - page.counter_base)));
+
+        if (counter < page.counter_base) {
+            stop_using_tsc_for_time_page("went backwards"sv, max(monotonic_now, extrapolated_now));
+            return;
+        }
+
+        // The TSC clock runs slow on purpose, so it should fall behind the HPET by up to about 500 ppm of the time since the
+        // last update. If it gets ahead of the HPET or falls behind a lot further, the TSC doesn't tick at the rate we
+        // calibrated, and we can't trust it. The slack covers the time it takes to read the HPET.
+        constexpr i64 slack_ns = 10'000;
+        i64 elapsed_ns = (monotonic_now - published_monotonic).to_nanoseconds();
+        i64 behind_ns = (monotonic_now - extrapolated_now).to_nanoseconds();
+        if (behind_ns < -slack_ns || behind_ns > 2 * elapsed_ns / time_page_tsc_slowdown_divisor + slack_ns) {
+            stop_using_tsc_for_time_page("drifted more than 500 ppm from the HPET"sv, max(monotonic_now, extrapolated_now));
+            return;
+        }
+
+        monotonic_now = max(monotonic_now, extrapolated_now);
+    }
+
+    // m_epoch_time was last updated together with the coarse monotonic clock.
+    auto coarse_monotonic_now = monotonic_time(TimePrecision::Coarse).time_since_start({});
+    auto realtime_now = m_epoch_time.offset_to_epoch() + (monotonic_now - coarse_monotonic_now);
+
+    page.counter_base = counter;
+    page.counter_multiplier = m_time_page_counter_multiplier.load();
+    page.clocks[CLOCK_MONOTONIC] = monotonic_now.to_timespec();
+    page.clocks[CLOCK_MONOTONIC_RAW] = page.clocks[CLOCK_MONOTONIC];
+    page.clocks[CLOCK_REALTIME] = realtime_now.to_timespec();
+}
+
+void TimeManagement::stop_using_tsc_for_time_page(StringView reason, Duration monotonic_floor)
+{
+    dmesgln("Time: TSC {}, the time page will only have the coarse clocks from now on", reason);
+    m_time_page_monotonic_floor_ns.store(monotonic_floor.to_nanoseconds());
+    m_time_page_counter_multiplier.store(0);
+    // Readers fall back to the syscall once they see this.
+    time_page().counter_multiplier = 0;
+}
+#endif
+
 TimePage& TimeManagement::time_page()
 {
     return *static_cast<TimePage*>((void*)m_time_page_region->vaddr().as_ptr());
@@ -74,13 +74,33 @@ public:
 
     bool can_query_precise_time() const { return m_can_query_precise_time; }
 
+    // Idle processors don't need their periodic timer tick, as they get an IPI once there's work for them.
+    // Returns whether the tick of the current processor has been stopped.
+    bool stop_tick_for_idle_processor();
+    void restart_tick_for_idle_processor();
+
+    struct TickStatistics {
+        u64 timer_ticks { 0 };
+        u64 tickless_idle_periods { 0 };
+    };
+    TickStatistics tick_statistics() const;
+
     Memory::VMObject& time_page_vmobject();
 
+#if ARCH(X86_64)
+    // Lets the time page use the TSC that calibrate_tsc_for_time_page() calibrated, unless the processors disagree
+    // about it. This can only run once all processors are up.
+    void check_tsc_synchronization_for_time_page();
+#endif
+
 private:
     TimePage& time_page();
     void update_time_page();
 
 #if ARCH(X86_64)
+    void calibrate_tsc_for_time_page();
+    void update_precise_clocks_in_time_page(TimePage&);
+    void stop_using_tsc_for_time_page(StringView reason, Duration monotonic_floor);
     bool probe_and_set_x86_legacy_hardware_timers();
     bool probe_and_set_x86_non_legacy_hardware_timers();
     void increment_time_since_boot_hpet();
@@ -112,10 +132,22 @@ private:
     LockRefPtr<HardwareTimerBase> m_system_timer;
     LockRefPtr<HardwareTimerBase> m_time_keeper_timer;
 
+    // Even with its tick stopped, an idle processor wakes up every now and then, just in case.
+    static constexpr size_t max_tickless_idle_ticks = OPTIMAL_TICKS_PER_SECOND_RATE;
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> m_timer_ticks { 0 };
+    Atomic<u64, AK::MemoryOrder::memory_order_relaxed> m_tickless_idle_periods { 0 };
+
     Atomic<u32> m_profile_enable_count { 0 };
     LockRefPtr<HardwareTimerBase> m_profile_timer;
 
     NonnullOwnPtr<Memory::Region> m_time_page_region;
+    // Lets userspace read the precise clocks from the TSC, see TimePage::counter_ticks_to_nanoseconds().
+    // Zero if the TSC is not usable for that.
+    u64 m_calibrated_tsc_multiplier { 0 };
+    Atomic<u64> m_time_page_counter_multiplier { 0 };
+    // Readers of the time page may have seen CLOCK_MONOTONIC up to here before we stopped using the TSC,
+    // so the precise monotonic clocks never return anything earlier than this.
+    Atomic<i64> m_time_page_monotonic_floor_ns { 0 };
 };
 
 }
@@ -53,6 +53,7 @@ TimerQueue& TimerQueue::the()
 UNMAP_AFTER_INIT TimerQueue::TimerQueue()
 {
     m_ticks_per_second = TimeManagement::the().ticks_per_second();
+    m_timer_wheel.current_unit = wheel_unit_for(TimeManagement::the().current_time(CLOCK_MONOTONIC_COARSE), false);
 }
 
 bool TimerQueue::add_timer_without_id(NonnullRefPtr<Timer> timer, clockid_t clock_id, Duration const& deadline, Function<void()>&& callback)
@@ -86,33 +87,16 @@ TimerId TimerQueue::add_timer(NonnullRefPtr<Timer>&& timer)
 
 void TimerQueue::add_timer_locked(NonnullRefPtr<Timer> timer)
 {
-    Duration timer_expiration = timer->m_expires;
-
     timer->clear_cancelled();
     timer->clear_callback_finished();
     timer->set_in_use();
 
-    auto& queue = queue_for_timer(*timer);
-    if (queue.list.is_empty()) {
-        queue.list.append(timer.leak_ref());
-        queue.next_timer_due = timer_expiration;
-    } else {
-        Timer* following_timer = nullptr;
-        for (auto& t : queue.list) {
-            if (t.m_expires > timer_expiration) {
-                following_timer = &t;
-                break;
-            }
-        }
-        if (following_timer) {
-            bool next_timer_needs_update = queue.list.first() == following_timer;
-            queue.list.insert_before(*following_timer, timer.leak_ref());
-            if (next_timer_needs_update)
-                queue.next_timer_due = timer_expiration;
-        } else {
-            queue.list.append(timer.leak_ref());
-        }
-    }
+    // The queue holds on to a reference until the timer has fired or has been cancelled.
+    auto& queued_timer = timer.leak_ref();
+    ++m_statistics.added_timers;
+    if (queued_timer.m_clock_id == CLOCK_MONOTONIC_COARSE && try_add_timer_to_wheel(queued_timer))
+        return;
+    add_timer_to_heap(heap_for_timer(queued_timer), queued_timer);
 }
 
 bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
@@ -123,20 +107,19 @@ bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
 
     // If the timer isn't in use, the cancellation is a no-op.
     if (!in_use) {
-        VERIFY(!timer.m_list_node.is_in_list());
+        VERIFY(!timer.is_queued());
         return false;
     }
 
     bool did_already_run = timer.set_cancelled();
-    auto& timer_queue = queue_for_timer(timer);
     if (!did_already_run) {
         timer.clear_in_use();
 
         SpinlockLocker lock(g_timerqueue_lock);
-        if (timer_queue.list.contains(timer)) {
+        if (timer.m_queued_in != Timer::QueuedIn::Nothing) {
             // The timer has not fired, remove it
             VERIFY(timer.ref_count() > 1);
-            remove_timer_locked(timer_queue, timer);
+            remove_timer_locked(timer);
             return true;
         }
 
@@ -145,7 +128,7 @@ bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
         // and we don't need to spin. It still holds a reference
         // that will be dropped when it does get a chance to run,
         // but since we called set_cancelled it will only drop its reference
-        VERIFY(m_timers_executing.contains(timer));
+        VERIFY(timer.m_list_node.is_in_list());
         m_timers_executing.remove(timer);
         return true;
     }
@@ -158,75 +141,276 @@ bool TimerQueue::cancel_timer(Timer& timer, bool* was_in_use)
     return false;
 }
 
-void TimerQueue::remove_timer_locked(Queue& queue, Timer& timer)
+void TimerQueue::remove_timer_locked(Timer& timer)
 {
-    bool was_next_timer = (queue.list.first() == &timer);
-    queue.list.remove(timer);
+    switch (timer.m_queued_in) {
+    case Timer::QueuedIn::Wheel:
+        // The list node knows which slot it's in.
+        timer.m_list_node.remove();
+        timer.m_queued_in = Timer::QueuedIn::Nothing;
+        --m_timer_wheel.timer_count;
+        break;
+    case Timer::QueuedIn::WheelDueList:
+        m_timer_wheel.due_timers.remove(timer);
+        timer.m_queued_in = Timer::QueuedIn::Nothing;
+        break;
+    case Timer::QueuedIn::Heap:
+        remove_timer_from_heap(heap_for_timer(timer), timer);
+        break;
+    case Timer::QueuedIn::Nothing:
+        VERIFY_NOT_REACHED();
+    }
+
     auto now = timer.now(false);
     if (timer.m_expires > now)
         timer.m_remaining = timer.m_expires - now;
 
-    if (was_next_timer)
-        update_next_timer_due(queue);
     // Whenever we remove a timer that was still queued (but hasn't been
     // fired) we added a reference to it. So, when removing it from the
     // queue we need to drop that reference.
     timer.unref();
 }
 
+void TimerQueue::fire_timer_locked(Timer& timer, SpinlockLocker<Spinlock<LockRank::None>>& lock)
+{
+    VERIFY(timer.m_queued_in == Timer::QueuedIn::Nothing);
+    m_timers_executing.append(timer);
+    ++m_statistics.fired_timers;
+
+    lock.unlock();
+
+    // Defer executing the timer outside of the irq handler
+    Processor::deferred_call_queue([this, timer = &timer]() {
+        // Check if we were cancelled in between being triggered
+        // by the timer irq handler and now. If so, just drop
+        // our reference and don't execute the callback.
+        if (!timer->set_cancelled()) {
+            timer->m_callback();
+            SpinlockLocker lock(g_timerqueue_lock);
+            m_timers_executing.remove(*timer);
+        }
+        timer->clear_in_use();
+        timer->set_callback_finished();
+        // Drop the reference we added when queueing the timer
+        timer->unref();
+    });
+
+    lock.lock();
+}
+
 void TimerQueue::fire()
 {
     SpinlockLocker lock(g_timerqueue_lock);
 
-    auto fire_timers = [&](Queue& queue) {
-        auto* timer = queue.list.first();
-        VERIFY(timer);
-        VERIFY(queue.next_timer_due == timer->m_expires);
-
-        while (timer && timer->now(true) > timer->m_expires) {
-            queue.list.remove(*timer);
-
-            m_timers_executing.append(*timer);
-
-            update_next_timer_due(queue);
-
-            lock.unlock();
-
-            // Defer executing the timer outside of the irq handler
-            Processor::deferred_call_queue([this, timer]() {
-                // Check if we were cancelled in between being triggered
-                // by the timer irq handler and now. If so, just drop
-                // our reference and don't execute the callback.
-                if (!timer->set_cancelled()) {
-                    timer->m_callback();
-                    SpinlockLocker lock(g_timerqueue_lock);
-                    m_timers_executing.remove(*timer);
-                }
-                timer->clear_in_use();
-                timer->set_callback_finished();
-                // Drop the reference we added when queueing the timer
-                timer->unref();
-            });
-
-            lock.lock();
-            timer = queue.list.first();
+    advance_wheel(wheel_unit_for(TimeManagement::the().current_time(CLOCK_MONOTONIC_COARSE), false));
+
+    while (auto* timer = m_timer_wheel.due_timers.first()) {
+        m_timer_wheel.due_timers.remove(*timer);
+        timer->m_queued_in = Timer::QueuedIn::Nothing;
+        fire_timer_locked(*timer, lock);
+    }
+
+    auto fire_timers = [&](Heap& heap) {
+        while (auto* timer = heap.root) {
+            if (timer->now(true) <= timer->m_expires)
+                break;
+            remove_timer_from_heap(heap, *timer);
+            fire_timer_locked(*timer, lock);
         }
     };
 
-    if (!m_timer_queue_monotonic.list.is_empty())
-        fire_timers(m_timer_queue_monotonic);
-    if (!m_timer_queue_realtime.list.is_empty())
-        fire_timers(m_timer_queue_realtime);
+    fire_timers(m_timer_heap_monotonic);
+    fire_timers(m_timer_heap_realtime);
+}
+
+u64 TimerQueue::wheel_unit_for(Duration const& time, bool round_up)
+{
+    auto nanoseconds = static_cast<u64>(max<i64>(time.to_nanoseconds(), 0));
+    if (round_up)
+        return ceil_div(nanoseconds, static_cast<u64>(1) << wheel_granularity_shift);
+    return nanoseconds >> wheel_granularity_shift;
+}
+
+bool TimerQueue::try_add_timer_to_wheel(Timer& timer)
+{
+    // Round up, so that we never fire a timer before its deadline.
+    auto unit = wheel_unit_for(timer.m_expires, true);
+    auto current_unit = m_timer_wheel.current_unit;
+    if (unit <= current_unit) {
+        m_timer_wheel.due_timers.append(timer);
+        timer.m_queued_in = Timer::QueuedIn::WheelDueList;
+        return true;
+    }
+
+    // Timers that are too far out don't fit into the top level of the wheel.
+    constexpr size_t wheel_bits = wheel_level_bits * wheel_level_count;
+    if ((unit >> wheel_bits) != (current_unit >> wheel_bits))
+        return false;
+
+    add_timer_to_wheel(timer, unit);
+    timer.m_queued_in = Timer::QueuedIn::Wheel;
+    ++m_timer_wheel.timer_count;
+    return true;
+}
+
+void TimerQueue::add_timer_to_wheel(Timer& timer, u64 unit)
+{
+    // Put the timer into the lowest level at which it shares a slot with the current unit
+    // on the level above. That way it gets cascaded down exactly when we reach its slot.
+    auto current_unit = m_timer_wheel.current_unit;
+    VERIFY(unit > current_unit);
+    for (size_t level = 0; level < wheel_level_count; ++level) {
+        auto shift = wheel_level_bits * (level + 1);
+        if ((unit >> shift) != (current_unit >> shift))
+            continue;
+        auto slot = (unit >> (wheel_level_bits * level)) & (wheel_slots_per_level - 1);
+        m_timer_wheel.slots[level][slot].append(timer);
+        return;
+    }
+    VERIFY_NOT_REACHED();
+}
+
+void TimerQueue::cascade_wheel_slot(size_t level, size_t slot)
+{
+    auto& list = m_timer_wheel.slots[level][slot];
+    while (auto* timer = list.first()) {
+        list.remove(*timer);
+        auto unit = wheel_unit_for(timer->m_expires, true);
+        if (unit <= m_timer_wheel.current_unit) {
+            m_timer_wheel.due_timers.append(*timer);
+            timer->m_queued_in = Timer::QueuedIn::WheelDueList;
+            --m_timer_wheel.timer_count;
+        } else {
+            add_timer_to_wheel(*timer, unit);
+        }
+        ++m_statistics.cascaded_timers;
+    }
 }
 
-void TimerQueue::update_next_timer_due(Queue& queue)
+void TimerQueue::advance_wheel(u64 unit)
 {
     VERIFY(g_timerqueue_lock.is_locked());
 
-    if (auto* next_timer = queue.list.first())
-        queue.next_timer_due = next_timer->m_expires;
-    else
-        queue.next_timer_due = {};
+    while (m_timer_wheel.current_unit < unit) {
+        if (m_timer_wheel.timer_count == 0) {
+            // Nothing left in the wheel, so there's nothing to cascade along the way.
+            m_timer_wheel.current_unit = unit;
+            break;
+        }
+
+        auto current_unit = ++m_timer_wheel.current_unit;
+
+        // Cascade from the top, so that timers can fall through multiple levels at once.
+        for (size_t level = wheel_level_count - 1; level > 0; --level) {
+            auto shift = wheel_level_bits * level;
+            if ((current_unit & ((static_cast<u64>(1) << shift) - 1)) != 0)
+                continue;
+            cascade_wheel_slot(level, (current_unit >> shift) & (wheel_slots_per_level - 1));
+        }
+
+        auto& slot = m_timer_wheel.slots[0][current_unit & (wheel_slots_per_level - 1)];
+        while (auto* timer = slot.first()) {
+            slot.remove(*timer);
+            m_timer_wheel.due_timers.append(*timer);
+            timer->m_queued_in = Timer::QueuedIn::WheelDueList;
+            --m_timer_wheel.timer_count;
+        }
+    }
+}
+
+Timer* TimerQueue::meld_heaps(Timer* a, Timer* b)
+{
+    if (!a)
+        return b;
+    if (!b)
+        return a;
+    if (b->m_expires < a->m_expires)
+        swap(a, b);
+
+    // b becomes the first child of a.
+    VERIFY(!b->m_heap_previous && !b->m_heap_next_sibling);
+    b->m_heap_previous = a;
+    b->m_heap_next_sibling = a->m_heap_first_child;
+    if (a->m_heap_first_child)
+        a->m_heap_first_child->m_heap_previous = b;
+    a->m_heap_first_child = b;
+    return a;
+}
+
+Timer* TimerQueue::merge_heap_pairs(Timer* first)
+{
+    // First pass: Meld the heaps pairwise from left to right, and keep the results in reverse order.
+    Timer* pairs = nullptr;
+    while (first) {
+        auto* a = first;
+        auto* b = a->m_heap_next_sibling;
+        first = b ? b->m_heap_next_sibling : nullptr;
+
+        a->m_heap_previous = nullptr;
+        a->m_heap_next_sibling = nullptr;
+        if (b) {
+            b->m_heap_previous = nullptr;
+            b->m_heap_next_sibling = nullptr;
+        }
+
+        auto* melded = meld_heaps(a, b);
+        melded->m_heap_next_sibling = pairs;
+        pairs = melded;
+    }
+
+    // Second pass: Meld the results from right to left.
+    Timer* root = nullptr;
+    while (pairs) {
+        auto* next = pairs->m_heap_next_sibling;
+        pairs->m_heap_next_sibling = nullptr;
+        root = meld_heaps(root, pairs);
+        pairs = next;
+    }
+    return root;
+}
+
+void TimerQueue::add_timer_to_heap(Heap& heap, Timer& timer)
+{
+    VERIFY(timer.m_queued_in == Timer::QueuedIn::Nothing);
+    timer.m_heap_first_child = nullptr;
+    timer.m_heap_next_sibling = nullptr;
+    timer.m_heap_previous = nullptr;
+    heap.root = meld_heaps(heap.root, &timer);
+    timer.m_queued_in = Timer::QueuedIn::Heap;
+    ++heap.timer_count;
+}
+
+void TimerQueue::remove_timer_from_heap(Heap& heap, Timer& timer)
+{
+    VERIFY(timer.m_queued_in == Timer::QueuedIn::Heap);
+    auto* children = merge_heap_pairs(timer.m_heap_first_child);
+    if (&timer == heap.root) {
+        heap.root = children;
+    } else {
+        // Unlink the timer (and with it, its subtree) from its parent or previous sibling.
+        auto* previous = timer.m_heap_previous;
+        if (previous->m_heap_first_child == &timer)
+            previous->m_heap_first_child = timer.m_heap_next_sibling;
+        else
+            previous->m_heap_next_sibling = timer.m_heap_next_sibling;
+        if (timer.m_heap_next_sibling)
+            timer.m_heap_next_sibling->m_heap_previous = previous;
+        heap.root = meld_heaps(heap.root, children);
+    }
+
+    timer.m_heap_first_child = nullptr;
+    timer.m_heap_next_sibling = nullptr;
+    timer.m_heap_previous = nullptr;
+    timer.m_queued_in = Timer::QueuedIn::Nothing;
+    --heap.timer_count;
+}
+
+TimerQueue::Statistics TimerQueue::statistics()
+{
+    SpinlockLocker lock(g_timerqueue_lock);
+    auto statistics = m_statistics;
+    statistics.queued_timers = m_timer_wheel.timer_count + m_timer_wheel.due_timers.size_slow() + m_timer_heap_monotonic.timer_count + m_timer_heap_realtime.timer_count;
+    return statistics;
 }
 
 }
@@ -6,12 +6,14 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/AtomicRefCounted.h>
 #include <AK/Function.h>
 #include <AK/IntrusiveList.h>
 #include <AK/OwnPtr.h>
 #include <AK/Time.h>
 #include <Kernel/Library/NonnullLockRefPtr.h>
+#include <Kernel/Locking/Spinlock.h>
 #include <Kernel/Time/TimeManagement.h>
 
 namespace Kernel {
@@ -73,7 +75,20 @@ private:
 
     Duration now(bool) const;
 
-    bool is_queued() const { return m_list_node.is_in_list(); }
+    bool is_queued() const { return m_list_node.is_in_list() || m_queued_in != QueuedIn::Nothing; }
+
+    enum class QueuedIn : u8 {
+        Nothing,
+        Wheel,
+        WheelDueList,
+        Heap,
+    };
+    QueuedIn m_queued_in { QueuedIn::Nothing };
+
+    // Links for the pairing heap, m_heap_previous points at the parent for the first child.
+    Timer* m_heap_first_child { nullptr };
+    Timer* m_heap_next_sibling { nullptr };
+    Timer* m_heap_previous { nullptr };
 
 public:
     IntrusiveListNode<Timer> m_list_node;
@@ -92,25 +107,66 @@ public:
     bool cancel_timer(Timer& timer, bool* was_in_use = nullptr);
     void fire();
 
+    struct Statistics {
+        size_t queued_timers { 0 };
+        u64 added_timers { 0 };
+        u64 fired_timers { 0 };
+        u64 cascaded_timers { 0 };
+    };
+    Statistics statistics();
+
 private:
-    struct Queue {
-        Timer::List list;
-        Duration next_timer_due {};
+    // Most timers are timeouts on CLOCK_MONOTONIC_COARSE (e.g. blocking with a timeout), which don't need to
+    // fire any more precisely than the timer tick. These are kept in a hierarchical timer wheel, which makes
+    // adding and cancelling them O(1). Every level of the wheel has 64 slots, with each slot of a level
+    // covering all slots of the level below it. As time passes, the timers of a slot are cascaded down into
+    // the level below, until they end up in a slot of the first level which is due.
+    static constexpr size_t wheel_granularity_shift = 22; // ~4.2ms, about one timer tick
+    static constexpr size_t wheel_level_bits = 6;
+    static constexpr size_t wheel_slots_per_level = 1 << wheel_level_bits;
+    static constexpr size_t wheel_level_count = 4;
+
+    struct Wheel {
+        Array<Array<Timer::List, wheel_slots_per_level>, wheel_level_count> slots;
+        // Timers of the slot we're at, and timers that were added with a deadline in the past.
+        Timer::List due_timers;
+        u64 current_unit { 0 };
+        // The number of timers in the slots (but not in the list of due timers).
+        size_t timer_count { 0 };
     };
-    void remove_timer_locked(Queue&, Timer&);
-    void update_next_timer_due(Queue&);
+
+    // All other timers (precise ones, ones on CLOCK_REALTIME, and ones beyond the range of the wheel)
+    // are kept in a pairing heap ordered by their expiration time.
+    struct Heap {
+        Timer* root { nullptr };
+        size_t timer_count { 0 };
+    };
+
     void add_timer_locked(NonnullRefPtr<Timer>);
+    void remove_timer_locked(Timer&);
+    void fire_timer_locked(Timer&, SpinlockLocker<Spinlock<LockRank::None>>&);
+
+    static u64 wheel_unit_for(Duration const&, bool round_up);
+    void add_timer_to_wheel(Timer&, u64 unit);
+    bool try_add_timer_to_wheel(Timer&);
+    void advance_wheel(u64 unit);
+    void cascade_wheel_slot(size_t level, size_t slot);
+
+    static Timer* meld_heaps(Timer*, Timer*);
+    static Timer* merge_heap_pairs(Timer* first);
+    void add_timer_to_heap(Heap&, Timer&);
+    void remove_timer_from_heap(Heap&, Timer&);
 
-    Queue& queue_for_timer(Timer& timer)
+    Heap& heap_for_timer(Timer& timer)
     {
         switch (timer.m_clock_id) {
         case CLOCK_MONOTONIC:
         case CLOCK_MONOTONIC_COARSE:
         case CLOCK_MONOTONIC_RAW:
-            return m_timer_queue_monotonic;
+            return m_timer_heap_monotonic;
         case CLOCK_REALTIME:
         case CLOCK_REALTIME_COARSE:
-            return m_timer_queue_realtime;
+            return m_timer_heap_realtime;
         default:
             VERIFY_NOT_REACHED();
         }
@@ -118,9 +174,11 @@ private:
 
     u64 m_timer_id_count { 0 };
     u64 m_ticks_per_second { 0 };
-    Queue m_timer_queue_monotonic;
-    Queue m_timer_queue_realtime;
+    Wheel m_timer_wheel;
+    Heap m_timer_heap_monotonic;
+    Heap m_timer_heap_realtime;
     Timer::List m_timers_executing;
+    Statistics m_statistics;
 };
 
 }
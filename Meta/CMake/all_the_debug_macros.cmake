@@ -9,6 +9,7 @@ set(AUDIO_DEBUG ON)
 set(AWAVLOADER_DEBUG ON)
 set(AFLACLOADER_DEBUG ON)
 set(BBFS_DEBUG ON)
+set(BLOCK_DEVICE_QUEUE_DEBUG ON)
 set(BMP_DEBUG ON)
 set(BXVGA_DEBUG ON)
 set(CACHE_DEBUG ON)
@@ -18,6 +19,7 @@ set(CFF_DEBUG ON)
 set(CMAKE_DEBUG ON)
 set(COMMIT_DEBUG ON)
 set(COMPOSE_DEBUG ON)
+set(COMPRESSED_PAGE_STORE_DEBUG ON)
 set(CONTEXT_SWITCH_DEBUG ON)
 set(COPY_DEBUG ON)
 set(CPP_DEBUG ON)
@@ -153,6 +155,7 @@ set(RESOURCE_DEBUG ON)
 set(ROUTING_DEBUG ON)
 set(RSA_PARSE_DEBUG ON)
 set(RTL8168_DEBUG ON)
+set(SAME_PAGE_MERGER_DEBUG ON)
 set(SCHEDULER_DEBUG ON)
 set(SCHEDULER_RUNNABLE_DEBUG ON)
 set(SERVICE_DEBUG ON)
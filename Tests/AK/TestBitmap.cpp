@@ -294,3 +294,56 @@ TEST_CASE(find_first_edge_case)
         EXPECT_EQ(bitmap.find_first_unset().value(), 0UL);
     }
 }
+
+TEST_CASE(move_assign_over_owning_bitmap)
+{
+    auto bitmap = MUST(Bitmap::create(16, false));
+    auto other = MUST(Bitmap::create(32, false));
+    other.set(31, true);
+
+    bitmap = move(other);
+    EXPECT_EQ(bitmap.size(), 32u);
+    EXPECT(bitmap.get(31));
+    EXPECT_EQ(other.size(), 0u);
+    EXPECT_EQ(other.data(), nullptr);
+}
+
+TEST_CASE(move_assign_non_owning_bitmap)
+{
+    // The bitmap we move in doesn't own its data, so it must not be freed when we go away.
+    u8 data[2] = { 0xff, 0 };
+    auto bitmap = MUST(Bitmap::create(16, false));
+    bitmap = Bitmap { data, 16 };
+    EXPECT_EQ(bitmap.size(), 16u);
+    EXPECT_EQ(bitmap.data(), data);
+    EXPECT_EQ(bitmap.count_slow(true), 8u);
+
+    // Moving an owning bitmap over a non-owning one must not free the data it was looking at.
+    bitmap = MUST(Bitmap::create(8, true));
+    EXPECT_EQ(bitmap.count_slow(true), 8u);
+    EXPECT_EQ(data[0], 0xff);
+}
+
+TEST_CASE(move_assign_to_self)
+{
+    auto bitmap = MUST(Bitmap::create(16, false));
+    bitmap.set(3, true);
+
+    auto& same_bitmap = bitmap;
+    bitmap = move(same_bitmap);
+    EXPECT_EQ(bitmap.size(), 16u);
+    EXPECT(bitmap.get(3));
+}
+
+TEST_CASE(move_assign_empty_bitmap)
+{
+    auto bitmap = MUST(Bitmap::create(16, true));
+    bitmap = Bitmap {};
+    EXPECT_EQ(bitmap.size(), 0u);
+    EXPECT_EQ(bitmap.data(), nullptr);
+
+    Bitmap empty;
+    empty = MUST(Bitmap::create(8, true));
+    EXPECT_EQ(empty.size(), 8u);
+    EXPECT_EQ(empty.count_slow(true), 8u);
+}
@@ -0,0 +1,117 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <AK/Array.h>
+#include <AK/LZ4Block.h>
+#include <AK/Random.h>
+#include <AK/StringView.h>
+
+static constexpr size_t page_size = 4096;
+
+static void expect_round_trip(ReadonlyBytes input)
+{
+    Array<u16, 4096> hash_table;
+    Array<u8, page_size * 2> compressed;
+    auto compressed_size = lz4_compress_block(input, compressed, hash_table);
+    EXPECT(compressed_size.has_value());
+
+    Array<u8, page_size> decompressed;
+    auto decompressed_size = lz4_decompress_block(compressed.span().trim(compressed_size.value()), decompressed);
+    EXPECT_EQ(decompressed_size, input.size());
+    EXPECT_EQ(decompressed.span().trim(input.size()), input);
+}
+
+TEST_CASE(round_trip_zero_page)
+{
+    Array<u8, page_size> page {};
+    expect_round_trip(page);
+
+    Array<u16, 4096> hash_table;
+    Array<u8, page_size> compressed;
+    auto compressed_size = lz4_compress_block(page, compressed, hash_table);
+    EXPECT(compressed_size.has_value());
+    EXPECT(compressed_size.value() < 32);
+}
+
+TEST_CASE(round_trip_text)
+{
+    Array<u8, page_size> page;
+    auto text = "Well hello friends! Today we're going to look at some compressible text. "sv;
+    for (size_t i = 0; i < page_size; ++i)
+        page[i] = text[i % text.length()];
+    expect_round_trip(page);
+}
+
+TEST_CASE(round_trip_random)
+{
+    Array<u8, page_size> page;
+    fill_with_random(page);
+    expect_round_trip(page);
+}
+
+TEST_CASE(round_trip_short_inputs)
+{
+    Array<u8, 32> data;
+    for (size_t i = 0; i < data.size(); ++i)
+        data[i] = i % 3;
+    for (size_t size = 0; size <= data.size(); ++size)
+        expect_round_trip(data.span().trim(size));
+}
+
+TEST_CASE(incompressible_input_does_not_fit)
+{
+    Array<u8, page_size> page;
+    fill_with_random(page);
+
+    Array<u16, 4096> hash_table;
+    Array<u8, page_size / 2> compressed;
+    EXPECT(!lz4_compress_block(page, compressed, hash_table).has_value());
+}
+
+// A block written by the reference implementation (lz4 -B4), of "Serenity is a love letter to 90s user interfaces. " repeated 4 times.
+static constexpr Array<u8, 61> reference_block {
+    0xff, 0x23, 0x53, 0x65, 0x72, 0x65, 0x6e, 0x69, 0x74, 0x79, 0x20, 0x69, 0x73, 0x20, 0x61, 0x20,
+    0x6c, 0x6f, 0x76, 0x65, 0x20, 0x6c, 0x65, 0x74, 0x74, 0x65, 0x72, 0x20, 0x74, 0x6f, 0x20, 0x39,
+    0x30, 0x73, 0x20, 0x75, 0x73, 0x65, 0x72, 0x20, 0x69, 0x6e, 0x74, 0x65, 0x72, 0x66, 0x61, 0x63,
+    0x65, 0x73, 0x2e, 0x20, 0x32, 0x00, 0x7e, 0x50, 0x63, 0x65, 0x73, 0x2e, 0x20
+};
+
+TEST_CASE(decompress_reference_block)
+{
+    auto sentence = "Serenity is a love letter to 90s user interfaces. "sv;
+
+    Array<u8, 256> decompressed;
+    auto decompressed_size = lz4_decompress_block(reference_block, decompressed);
+    EXPECT_EQ(decompressed_size, sentence.length() * 4);
+    for (size_t i = 0; i < 4; ++i)
+        EXPECT_EQ(StringView(decompressed.span().slice(i * sentence.length(), sentence.length())), sentence);
+}
+
+TEST_CASE(reject_malformed_blocks)
+{
+    Array<u8, 256> decompressed;
+
+    // An empty block.
+    EXPECT(!lz4_decompress_block({}, decompressed).has_value());
+
+    // A truncated block.
+    EXPECT(!lz4_decompress_block(ReadonlyBytes { reference_block }.trim(20), decompressed).has_value());
+    EXPECT(!lz4_decompress_block(ReadonlyBytes { reference_block }.trim(54), decompressed).has_value());
+
+    // A match that reaches back before the start of the output.
+    Array<u8, 4> bad_offset { 0x10, 'a', 0x02, 0x00 };
+    EXPECT(!lz4_decompress_block(bad_offset, decompressed).has_value());
+
+    // A zero match offset.
+    Array<u8, 4> zero_offset { 0x10, 'a', 0x00, 0x00 };
+    EXPECT(!lz4_decompress_block(zero_offset, decompressed).has_value());
+
+    // Output that doesn't fit.
+    Array<u8, 100> too_small;
+    EXPECT(!lz4_decompress_block(reference_block, too_small).has_value());
+}
@@ -0,0 +1,94 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/ScopeGuard.h>
+#include <AK/StringBuilder.h>
+#include <LibTest/TestCase.h>
+#include <dirent.h>
+#include <fcntl.h>
+#include <sys/statvfs.h>
+#include <unistd.h>
+
+static constexpr auto test_file_path = "/home/anon/.block_request_merging_test";
+
+static Optional<JsonValue> read_json(StringView path)
+{
+    auto path_string = path.to_deprecated_string();
+    int fd = open(path_string.characters(), O_RDONLY);
+    if (fd < 0)
+        return {};
+    char buffer[4096];
+    auto nread = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    if (nread <= 0)
+        return {};
+    auto json_or_error = JsonValue::from_string({ buffer, static_cast<size_t>(nread) });
+    if (json_or_error.is_error())
+        return {};
+    return json_or_error.release_value();
+}
+
+struct MergeCounts {
+    u64 merges { 0 };
+    // Whether every storage device can transfer at least two file system blocks at once.
+    bool all_devices_can_merge { true };
+};
+
+static MergeCounts storage_merge_counts(u64 file_system_block_size)
+{
+    MergeCounts counts;
+    auto* directory = opendir("/sys/devices/storage");
+    VERIFY(directory);
+    while (auto* entry = readdir(directory)) {
+        if (entry->d_name[0] == '.')
+            continue;
+        auto device_path = DeprecatedString::formatted("/sys/devices/storage/{}", entry->d_name);
+        auto statistics = read_json(DeprecatedString::formatted("{}/queue_statistics", device_path));
+        auto sector_size = read_json(DeprecatedString::formatted("{}/sector_size", device_path));
+        if (!statistics.has_value() || !statistics->is_object() || !sector_size.has_value())
+            continue;
+
+        auto const& object = statistics->as_object();
+        counts.merges += object.get_u64("front_merges"sv).value_or(0) + object.get_u64("back_merges"sv).value_or(0);
+        auto max_bytes_per_request = object.get_u64("max_blocks_per_request"sv).value_or(0) * sector_size->to_u64();
+        if (max_bytes_per_request < 2 * file_system_block_size)
+            counts.all_devices_can_merge = false;
+    }
+    closedir(directory);
+    return counts;
+}
+
+TEST_CASE(writeback_merges_adjacent_blocks)
+{
+    struct statvfs file_system;
+    EXPECT_EQ(statvfs("/home/anon", &file_system), 0);
+
+    // Start out with nothing left to write back, so that the blocks of our file go out together.
+    sync();
+    auto counts_before = storage_merge_counts(file_system.f_bsize);
+    if (!counts_before.all_devices_can_merge) {
+        warnln("Skipping: a storage device can't transfer two file system blocks at once");
+        return;
+    }
+
+    int fd = open(test_file_path, O_CREAT | O_TRUNC | O_WRONLY, 0600);
+    EXPECT(fd >= 0);
+    ScopeGuard remove_file = [&] {
+        close(fd);
+        unlink(test_file_path);
+    };
+
+    char data[4096];
+    memset(data, 0x5a, sizeof(data));
+    for (size_t i = 0; i < 64; ++i)
+        EXPECT_EQ(write(fd, data, sizeof(data)), static_cast<ssize_t>(sizeof(data)));
+    sync();
+
+    auto counts_after = storage_merge_counts(file_system.f_bsize);
+    EXPECT(counts_after.merges > counts_before.merges);
+}
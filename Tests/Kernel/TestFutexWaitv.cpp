@@ -0,0 +1,124 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Array.h>
+#include <AK/Atomic.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <pthread.h>
+#include <serenity.h>
+#include <time.h>
+#include <unistd.h>
+
+static constexpr size_t futex_count = 3;
+
+struct WakeContext {
+    Array<u32, futex_count> futexes {};
+    size_t index_to_wake { 0 };
+    Atomic<bool> waiter_was_woken { false };
+};
+
+static void fill_waiters(Array<struct futex_waitv, futex_count>& waiters, Array<u32, futex_count>& futexes)
+{
+    for (size_t i = 0; i < futex_count; ++i) {
+        waiters[i] = {};
+        waiters[i].val = futexes[i];
+        waiters[i].uaddr = reinterpret_cast<FlatPtr>(&futexes[i]);
+        waiters[i].flags = FUTEX_PRIVATE_FLAG;
+    }
+}
+
+static timespec deadline_after_milliseconds(long milliseconds)
+{
+    timespec deadline;
+    clock_gettime(CLOCK_MONOTONIC, &deadline);
+    deadline.tv_nsec += milliseconds * 1'000'000;
+    deadline.tv_sec += deadline.tv_nsec / 1'000'000'000;
+    deadline.tv_nsec %= 1'000'000'000;
+    return deadline;
+}
+
+static void* wake_until_woken(void* argument)
+{
+    auto& context = *static_cast<WakeContext*>(argument);
+    // NOTE: The waiter may not be blocked yet when we wake it, so keep waking until it has noticed.
+    while (!context.waiter_was_woken)
+        futex_wake(&context.futexes[context.index_to_wake], 1, false);
+    return nullptr;
+}
+
+TEST_CASE(wakes_on_each_entry)
+{
+    for (size_t index = 0; index < futex_count; ++index) {
+        WakeContext context;
+        context.index_to_wake = index;
+
+        Array<struct futex_waitv, futex_count> waiters;
+        fill_waiters(waiters, context.futexes);
+
+        pthread_t waker;
+        EXPECT_EQ(pthread_create(&waker, nullptr, wake_until_woken, &context), 0);
+
+        auto deadline = deadline_after_milliseconds(5000);
+        int rc;
+        do {
+            rc = futex_waitv(waiters.data(), futex_count, &deadline, CLOCK_MONOTONIC);
+            // NOTE: Spurious wakeups are allowed, and report the first entry.
+        } while (rc == 0 && index != 0);
+        context.waiter_was_woken = true;
+
+        EXPECT_EQ(rc, static_cast<int>(index));
+        EXPECT_EQ(pthread_join(waker, nullptr), 0);
+    }
+}
+
+TEST_CASE(value_mismatch)
+{
+    Array<u32, futex_count> futexes {};
+    Array<struct futex_waitv, futex_count> waiters;
+    fill_waiters(waiters, futexes);
+    waiters[futex_count - 1].val = 1;
+
+    auto deadline = deadline_after_milliseconds(5000);
+    errno = 0;
+    EXPECT_EQ(futex_waitv(waiters.data(), futex_count, &deadline, CLOCK_MONOTONIC), -1);
+    EXPECT_EQ(errno, EAGAIN);
+}
+
+TEST_CASE(timeout)
+{
+    Array<u32, futex_count> futexes {};
+    Array<struct futex_waitv, futex_count> waiters;
+    fill_waiters(waiters, futexes);
+
+    timespec start;
+    clock_gettime(CLOCK_MONOTONIC, &start);
+    auto deadline = deadline_after_milliseconds(100);
+    errno = 0;
+    EXPECT_EQ(futex_waitv(waiters.data(), futex_count, &deadline, CLOCK_MONOTONIC), -1);
+    EXPECT_EQ(errno, ETIMEDOUT);
+
+    timespec end;
+    clock_gettime(CLOCK_MONOTONIC, &end);
+    auto elapsed_milliseconds = (end.tv_sec - start.tv_sec) * 1000 + (end.tv_nsec - start.tv_nsec) / 1'000'000;
+    EXPECT(elapsed_milliseconds >= 100);
+}
+
+TEST_CASE(invalid_arguments)
+{
+    Array<u32, futex_count> futexes {};
+    Array<struct futex_waitv, futex_count> waiters;
+    fill_waiters(waiters, futexes);
+
+    errno = 0;
+    EXPECT_EQ(futex_waitv(waiters.data(), 0, nullptr, CLOCK_MONOTONIC), -1);
+    EXPECT_EQ(errno, EINVAL);
+
+    waiters[0].flags = 0xff;
+    errno = 0;
+    EXPECT_EQ(futex_waitv(waiters.data(), futex_count, nullptr, CLOCK_MONOTONIC), -1);
+    EXPECT_EQ(errno, EINVAL);
+}
@@ -0,0 +1,156 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <LibTest/TestCase.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static constexpr size_t page_count = 16;
+
+static u64 merged_page_count()
+{
+    int fd = open("/sys/kernel/memstat", O_RDONLY);
+    VERIFY(fd >= 0);
+    char buffer[4096];
+    auto nread = read(fd, buffer, sizeof(buffer));
+    close(fd);
+    VERIFY(nread > 0);
+
+    auto json = MUST(JsonValue::from_string({ buffer, static_cast<size_t>(nread) }));
+    auto const& object = json.as_object();
+    return object.get_u64("merged_pages"sv).value_or(0) + object.get_u64("merged_zero_pages"sv).value_or(0);
+}
+
+static bool wait_for_merges(u64 previous_merged_page_count, u64 expected_merges)
+{
+    // The merger needs a couple of scans to notice that pages are stable and identical.
+    for (size_t i = 0; i < 100; ++i) {
+        if (merged_page_count() >= previous_merged_page_count + expected_merges)
+            return true;
+        usleep(100'000);
+    }
+    return false;
+}
+
+static u8 pattern_for_page(size_t page_index)
+{
+    return page_index % 2 ? 0xaa : 0x55;
+}
+
+static u8* map_pattern_pages()
+{
+    auto* pages = static_cast<u8*>(mmap(nullptr, page_count * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, -1, 0));
+    VERIFY(pages != MAP_FAILED);
+    for (size_t i = 0; i < page_count; ++i)
+        memset(pages + i * PAGE_SIZE, pattern_for_page(i), PAGE_SIZE);
+    return pages;
+}
+
+static bool page_is_filled_with(u8 const* page, u8 value)
+{
+    for (size_t i = 0; i < PAGE_SIZE; ++i) {
+        if (page[i] != value)
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(reject_shared_and_purgeable_memory)
+{
+    auto* shared = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_SHARED, -1, 0);
+    EXPECT_NE(shared, MAP_FAILED);
+    errno = 0;
+    EXPECT_EQ(madvise(shared, PAGE_SIZE, MADV_MERGEABLE), -1);
+    EXPECT_EQ(errno, EINVAL);
+    munmap(shared, PAGE_SIZE);
+
+    auto* purgeable = mmap(nullptr, PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE | MAP_PURGEABLE, -1, 0);
+    EXPECT_NE(purgeable, MAP_FAILED);
+    errno = 0;
+    EXPECT_EQ(madvise(purgeable, PAGE_SIZE, MADV_MERGEABLE), -1);
+    EXPECT_EQ(errno, EINVAL);
+    munmap(purgeable, PAGE_SIZE);
+}
+
+TEST_CASE(writes_to_merged_pages_stay_private)
+{
+    auto* pages = map_pattern_pages();
+    auto previous_merged_page_count = merged_page_count();
+    EXPECT_EQ(madvise(pages, page_count * PAGE_SIZE, MADV_MERGEABLE), 0);
+
+    // Of each pattern, all but one page can be merged into the remaining one.
+    EXPECT(wait_for_merges(previous_merged_page_count, page_count - 2));
+
+    for (size_t i = 0; i < page_count; ++i) {
+        EXPECT(page_is_filled_with(pages + i * PAGE_SIZE, pattern_for_page(i)));
+        pages[i * PAGE_SIZE] = i;
+    }
+    for (size_t i = 0; i < page_count; ++i) {
+        EXPECT_EQ(pages[i * PAGE_SIZE], i);
+        EXPECT_EQ(pages[i * PAGE_SIZE + 1], pattern_for_page(i));
+        EXPECT_EQ(pages[(i + 1) * PAGE_SIZE - 1], pattern_for_page(i));
+    }
+
+    munmap(pages, page_count * PAGE_SIZE);
+}
+
+TEST_CASE(merged_pages_across_fork)
+{
+    auto* pages = map_pattern_pages();
+    EXPECT_EQ(madvise(pages, page_count * PAGE_SIZE, MADV_MERGEABLE), 0);
+
+    auto previous_merged_page_count = merged_page_count();
+    pid_t child = fork();
+    VERIFY(child >= 0);
+    if (child == 0) {
+        // The child writes to all of its pages while they are being merged.
+        for (size_t round = 0; round < 20; ++round) {
+            for (size_t i = 0; i < page_count; ++i)
+                memset(pages + i * PAGE_SIZE, round, PAGE_SIZE);
+            usleep(50'000);
+        }
+        for (size_t i = 0; i < page_count; ++i) {
+            if (!page_is_filled_with(pages + i * PAGE_SIZE, 19))
+                _exit(1);
+        }
+        _exit(0);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(child, &status, 0), child);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    EXPECT(wait_for_merges(previous_merged_page_count, page_count - 2));
+    for (size_t i = 0; i < page_count; ++i)
+        EXPECT(page_is_filled_with(pages + i * PAGE_SIZE, pattern_for_page(i)));
+
+    munmap(pages, page_count * PAGE_SIZE);
+}
+
+TEST_CASE(zeroed_pages_can_be_written_again)
+{
+    auto* pages = map_pattern_pages();
+    EXPECT_EQ(madvise(pages, page_count * PAGE_SIZE, MADV_MERGEABLE), 0);
+    memset(pages, 0, page_count * PAGE_SIZE);
+
+    auto previous_merged_page_count = merged_page_count();
+    EXPECT(wait_for_merges(previous_merged_page_count, page_count));
+
+    for (size_t i = 0; i < page_count; ++i) {
+        EXPECT(page_is_filled_with(pages + i * PAGE_SIZE, 0));
+        memset(pages + i * PAGE_SIZE, pattern_for_page(i), PAGE_SIZE);
+    }
+    for (size_t i = 0; i < page_count; ++i)
+        EXPECT(page_is_filled_with(pages + i * PAGE_SIZE, pattern_for_page(i)));
+
+    munmap(pages, page_count * PAGE_SIZE);
+}
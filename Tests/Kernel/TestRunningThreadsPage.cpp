@@ -0,0 +1,71 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <Kernel/API/RunningThreadsPage.h>
+#include <LibTest/TestCase.h>
+#include <sys/wait.h>
+#include <syscall.h>
+#include <unistd.h>
+
+static Kernel::RunningThreadsPage const* map_running_threads_page()
+{
+    auto rc = syscall(SC_map_running_threads_page);
+    VERIFY(!((int)rc < 0 && (int)rc > -EMAXERRNO));
+    return reinterpret_cast<Kernel::RunningThreadsPage const*>(rc);
+}
+
+static bool page_contains(Kernel::RunningThreadsPage const& page, pid_t tid)
+{
+    for (u32 i = 0; i < page.processor_count; ++i) {
+        if (page.running_thread_ids[i] == tid)
+            return true;
+    }
+    return false;
+}
+
+static bool page_only_contains(Kernel::RunningThreadsPage const& page, pid_t tid)
+{
+    for (u32 i = 0; i < page.processor_count; ++i) {
+        if (page.running_thread_ids[i] != 0 && page.running_thread_ids[i] != tid)
+            return false;
+    }
+    return true;
+}
+
+TEST_CASE(only_shows_own_threads)
+{
+    auto const& page = *map_running_threads_page();
+    EXPECT(page.processor_count > 0);
+    EXPECT(page.processor_count <= Kernel::RunningThreadsPage::max_processor_count);
+
+    // NOTE: The page is only updated on context switches, so make sure that we went through one.
+    usleep(1000);
+    EXPECT(page_contains(page, gettid()));
+    EXPECT(page_only_contains(page, gettid()));
+}
+
+TEST_CASE(forked_child_gets_its_own_page)
+{
+    auto const& page = *map_running_threads_page();
+    auto parent_tid = gettid();
+
+    pid_t child = fork();
+    VERIFY(child >= 0);
+    if (child == 0) {
+        usleep(1000);
+        bool sees_itself = page_contains(page, gettid());
+        bool sees_parent = page_contains(page, parent_tid);
+        _exit(sees_itself && !sees_parent ? 0 : 1);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(child, &status, 0), child);
+    EXPECT(WIFEXITED(status));
+    EXPECT_EQ(WEXITSTATUS(status), 0);
+
+    usleep(1000);
+    EXPECT(page_only_contains(page, parent_tid));
+}
@@ -0,0 +1,78 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/wait.h>
+#include <unistd.h>
+
+static int create_one_page_file(char const* path)
+{
+    int fd = open(path, O_RDWR | O_CREAT | O_TRUNC, 0644);
+    VERIFY(fd >= 0);
+    u8 buffer[PAGE_SIZE] = {};
+    VERIFY(write(fd, buffer, sizeof(buffer)) == sizeof(buffer));
+    return fd;
+}
+
+TEST_CASE(fault_past_end_of_file_raises_sigbus)
+{
+    int fd = create_one_page_file("/tmp/shared_ramfs_mapping_sigbus_test");
+    auto* mapping = static_cast<u8 volatile*>(mmap(nullptr, 2 * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    EXPECT_NE(mapping, MAP_FAILED);
+
+    pid_t child = fork();
+    VERIFY(child >= 0);
+    if (child == 0) {
+        (void)mapping[PAGE_SIZE];
+        _exit(0);
+    }
+
+    int status = 0;
+    EXPECT_EQ(waitpid(child, &status, 0), child);
+    EXPECT(WIFSIGNALED(status));
+    EXPECT_EQ(WTERMSIG(status), SIGBUS);
+
+    munmap(const_cast<u8*>(mapping), 2 * PAGE_SIZE);
+    close(fd);
+    unlink("/tmp/shared_ramfs_mapping_sigbus_test");
+}
+
+TEST_CASE(mapping_follows_file_after_it_grows)
+{
+    int fd = create_one_page_file("/tmp/shared_ramfs_mapping_growth_test");
+    auto* mapping = static_cast<u8*>(mmap(nullptr, 2 * PAGE_SIZE, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0));
+    EXPECT_NE(mapping, MAP_FAILED);
+
+    // Touch the page past the end of the file in a child first, so the fault has happened before the file grows.
+    pid_t child = fork();
+    VERIFY(child >= 0);
+    if (child == 0) {
+        mapping[PAGE_SIZE] = 1;
+        _exit(0);
+    }
+    int status = 0;
+    EXPECT_EQ(waitpid(child, &status, 0), child);
+    EXPECT(WIFSIGNALED(status));
+
+    EXPECT_EQ(ftruncate(fd, 2 * PAGE_SIZE), 0);
+
+    // Writes to the file show up in the mapping...
+    u8 value = 0x42;
+    EXPECT_EQ(pwrite(fd, &value, 1, PAGE_SIZE + 1), 1);
+    EXPECT_EQ(mapping[PAGE_SIZE + 1], 0x42);
+
+    // ...and writes to the mapping show up in the file.
+    mapping[PAGE_SIZE + 2] = 0x43;
+    EXPECT_EQ(pread(fd, &value, 1, PAGE_SIZE + 2), 1);
+    EXPECT_EQ(value, 0x43);
+
+    munmap(mapping, 2 * PAGE_SIZE);
+    close(fd);
+    unlink("/tmp/shared_ramfs_mapping_growth_test");
+}
@@ -0,0 +1,103 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/Atomic.h>
+#include <LibTest/TestCase.h>
+
+#include <pthread.h>
+
+// Each benchmark has a few threads take the same lock over and over, and do a little bit of work while holding it,
+// so that the lock is contended most of the time.
+
+static constexpr size_t thread_count = 4;
+static constexpr size_t iterations_per_thread = 200'000;
+static constexpr size_t work_per_critical_section = 20;
+
+static void do_some_work(u64& value)
+{
+    for (size_t i = 0; i < work_per_critical_section; ++i)
+        value = value * 6364136223846793005ull + 1442695040888963407ull;
+}
+
+template<typename Callback>
+static void run_on_threads(Callback callback)
+{
+    pthread_t threads[thread_count];
+    for (auto& thread : threads) {
+        auto rc = pthread_create(
+            &thread, nullptr, [](void* argument) -> void* {
+                (*static_cast<Callback*>(argument))();
+                return nullptr;
+            },
+            &callback);
+        VERIFY(rc == 0);
+    }
+    for (auto thread : threads)
+        pthread_join(thread, nullptr);
+}
+
+BENCHMARK_CASE(mutex_contended)
+{
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    u64 value = 0;
+    run_on_threads([&] {
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            pthread_mutex_lock(&mutex);
+            do_some_work(value);
+            pthread_mutex_unlock(&mutex);
+        }
+    });
+    EXPECT_NE(value, 0u);
+}
+
+BENCHMARK_CASE(mutex_uncontended)
+{
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    u64 value = 0;
+    for (size_t i = 0; i < thread_count * iterations_per_thread; ++i) {
+        pthread_mutex_lock(&mutex);
+        do_some_work(value);
+        pthread_mutex_unlock(&mutex);
+    }
+    EXPECT_NE(value, 0u);
+}
+
+BENCHMARK_CASE(rwlock_contended_mostly_readers)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    u64 value = 1;
+    Atomic<u64> total_read { 0 };
+    run_on_threads([&] {
+        u64 sum = 0;
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            if (i % 16 == 0) {
+                pthread_rwlock_wrlock(&lock);
+                do_some_work(value);
+                pthread_rwlock_unlock(&lock);
+            } else {
+                pthread_rwlock_rdlock(&lock);
+                sum += value;
+                pthread_rwlock_unlock(&lock);
+            }
+        }
+        total_read += sum;
+    });
+    EXPECT_NE(total_read.load(), 0u);
+}
+
+BENCHMARK_CASE(rwlock_contended_writers)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    u64 value = 0;
+    run_on_threads([&] {
+        for (size_t i = 0; i < iterations_per_thread; ++i) {
+            pthread_rwlock_wrlock(&lock);
+            do_some_work(value);
+            pthread_rwlock_unlock(&lock);
+        }
+    });
+    EXPECT_NE(value, 0u);
+}
@@ -0,0 +1,79 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <stdio.h>
+
+// Each benchmark writes a few megabytes to /dev/null through a fully buffered stream, so that it measures the time
+// spent in LibC rather than in the kernel.
+
+static constexpr size_t line_count = 200'000;
+
+static FILE* open_null_stream()
+{
+    auto* stream = fopen("/dev/null", "w");
+    VERIFY(stream);
+    setvbuf(stream, nullptr, _IOFBF, BUFSIZ);
+    return stream;
+}
+
+BENCHMARK_CASE(fprintf_integers)
+{
+    auto* stream = open_null_stream();
+    for (size_t i = 0; i < line_count; ++i)
+        fprintf(stream, "%zu: %d %5u %08llx %lld\n", i, -static_cast<int>(i), static_cast<unsigned>(i * 7), i * 0x9e3779b97f4a7c15ull, static_cast<long long>(i) * 1000003);
+    EXPECT_EQ(ferror(stream), 0);
+    fclose(stream);
+}
+
+BENCHMARK_CASE(fprintf_floats)
+{
+    auto* stream = open_null_stream();
+    for (size_t i = 0; i < line_count; ++i)
+        fprintf(stream, "%f %.2f %10.4f\n", i / 3.0, i * 1.5, -(i / 7.0));
+    EXPECT_EQ(ferror(stream), 0);
+    fclose(stream);
+}
+
+BENCHMARK_CASE(fprintf_log_lines)
+{
+    auto* stream = open_null_stream();
+    for (size_t i = 0; i < line_count; ++i)
+        fprintf(stream, "[%s] request %zu from %s took %d ms\n", "info", i, "localhost", static_cast<int>(i % 1000));
+    EXPECT_EQ(ferror(stream), 0);
+    fclose(stream);
+}
+
+BENCHMARK_CASE(fputc)
+{
+    auto* stream = open_null_stream();
+    for (size_t i = 0; i < line_count * 40; ++i)
+        fputc('a' + i % 26, stream);
+    EXPECT_EQ(ferror(stream), 0);
+    fclose(stream);
+}
+
+BENCHMARK_CASE(putc_unlocked)
+{
+    auto* stream = open_null_stream();
+    flockfile(stream);
+    for (size_t i = 0; i < line_count * 40; ++i)
+        putc_unlocked('a' + i % 26, stream);
+    funlockfile(stream);
+    EXPECT_EQ(ferror(stream), 0);
+    fclose(stream);
+}
+
+BENCHMARK_CASE(fwrite_small_chunks)
+{
+    static constexpr char chunk[] = "0123456789abcdef";
+    auto* stream = open_null_stream();
+    for (size_t i = 0; i < line_count * 4; ++i)
+        fwrite(chunk, 1, sizeof(chunk) - 1, stream);
+    EXPECT_EQ(ferror(stream), 0);
+    fclose(stream);
+}
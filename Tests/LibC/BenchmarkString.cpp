@@ -0,0 +1,128 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibTest/TestCase.h>
+
+#include <string.h>
+
+// Each benchmark runs a function over a mix of small, medium and large sizes, once with aligned
+// and once with misaligned buffers, so the total work stays roughly the same between them.
+
+static constexpr size_t small_sizes[] = { 1, 3, 7, 8, 15, 16, 24, 31, 32, 48, 63, 64 };
+static constexpr size_t medium_sizes[] = { 100, 128, 200, 256, 500, 512, 1000, 1024 };
+static constexpr size_t large_sizes[] = { 4 * KiB, 16 * KiB, 64 * KiB, 256 * KiB };
+
+static constexpr size_t buffer_size = 256 * KiB + 64;
+alignas(64) static u8 s_source[buffer_size];
+alignas(64) static u8 s_destination[buffer_size];
+
+template<size_t N>
+static void run_memcpy(size_t const (&sizes)[N], size_t alignment_offset, size_t bytes_per_size)
+{
+    for (auto size : sizes) {
+        for (size_t copied = 0; copied < bytes_per_size; copied += size) {
+            memcpy(s_destination + alignment_offset, s_source + alignment_offset / 2, size);
+            asm volatile("" ::: "memory");
+        }
+    }
+}
+
+template<size_t N>
+static void run_memmove_overlapping(size_t const (&sizes)[N], size_t alignment_offset, size_t bytes_per_size)
+{
+    for (auto size : sizes) {
+        for (size_t moved = 0; moved < bytes_per_size; moved += size) {
+            // Alternate directions, so both the forward and the backward loops get measured.
+            memmove(s_destination + alignment_offset + 8, s_destination + alignment_offset, size);
+            memmove(s_destination + alignment_offset, s_destination + alignment_offset + 8, size);
+            asm volatile("" ::: "memory");
+        }
+    }
+}
+
+template<size_t N>
+static void run_memcmp(size_t const (&sizes)[N], size_t alignment_offset, size_t bytes_per_size)
+{
+    int total = 0;
+    for (auto size : sizes) {
+        for (size_t compared = 0; compared < bytes_per_size; compared += size)
+            total += memcmp(s_destination + alignment_offset, s_source + alignment_offset / 2, size);
+    }
+    asm volatile("" ::"r"(total));
+}
+
+template<size_t N>
+static void run_memchr(size_t const (&sizes)[N], size_t alignment_offset, size_t bytes_per_size)
+{
+    FlatPtr total = 0;
+    for (auto size : sizes) {
+        for (size_t searched = 0; searched < bytes_per_size; searched += size)
+            total += reinterpret_cast<FlatPtr>(memchr(s_source + alignment_offset, 'x', size));
+    }
+    asm volatile("" ::"r"(total));
+}
+
+template<size_t N>
+static void run_strlen(size_t const (&sizes)[N], size_t alignment_offset, size_t bytes_per_size)
+{
+    size_t total = 0;
+    for (auto size : sizes) {
+        auto* string = reinterpret_cast<char*>(s_source + alignment_offset);
+        string[size] = '\0';
+        for (size_t scanned = 0; scanned < bytes_per_size; scanned += size)
+            total += strlen(string);
+        string[size] = 'a';
+    }
+    asm volatile("" ::"r"(total));
+}
+
+static void prepare_buffers()
+{
+    __builtin_memset(s_source, 'a', sizeof(s_source));
+    __builtin_memset(s_destination, 'a', sizeof(s_destination));
+}
+
+static constexpr size_t bytes_per_small_size = 16 * MiB;
+static constexpr size_t bytes_per_medium_size = 64 * MiB;
+static constexpr size_t bytes_per_large_size = 256 * MiB;
+
+#define STRING_BENCHMARKS(function)                                           \
+    BENCHMARK_CASE(function##_small_aligned)                                  \
+    {                                                                         \
+        prepare_buffers();                                                    \
+        run_##function(small_sizes, 0, bytes_per_small_size);                 \
+    }                                                                         \
+    BENCHMARK_CASE(function##_small_misaligned)                               \
+    {                                                                         \
+        prepare_buffers();                                                    \
+        run_##function(small_sizes, 13, bytes_per_small_size);                \
+    }                                                                         \
+    BENCHMARK_CASE(function##_medium_aligned)                                 \
+    {                                                                         \
+        prepare_buffers();                                                    \
+        run_##function(medium_sizes, 0, bytes_per_medium_size);               \
+    }                                                                         \
+    BENCHMARK_CASE(function##_medium_misaligned)                              \
+    {                                                                         \
+        prepare_buffers();                                                    \
+        run_##function(medium_sizes, 13, bytes_per_medium_size);              \
+    }                                                                         \
+    BENCHMARK_CASE(function##_large_aligned)                                  \
+    {                                                                         \
+        prepare_buffers();                                                    \
+        run_##function(large_sizes, 0, bytes_per_large_size);                 \
+    }                                                                         \
+    BENCHMARK_CASE(function##_large_misaligned)                               \
+    {                                                                         \
+        prepare_buffers();                                                    \
+        run_##function(large_sizes, 13, bytes_per_large_size);                \
+    }
+
+STRING_BENCHMARKS(memcpy)
+STRING_BENCHMARKS(memmove_overlapping)
+STRING_BENCHMARKS(memcmp)
+STRING_BENCHMARKS(memchr)
+STRING_BENCHMARKS(strlen)
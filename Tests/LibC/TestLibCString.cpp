@@ -5,6 +5,7 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/DeprecatedString.h>
 #include <LibTest/TestCase.h>
 #include <errno.h>
 #include <string.h>
@@ -29,3 +30,120 @@ TEST_CASE(strtok_r_delimiters_only)
     // The string to which `saved_str` initially points to shouldn't be modified.
     EXPECT_EQ(strcmp(dummy, "a;"), 0);
 }
+
+// The string functions pick different code paths depending on the size and alignment of their arguments,
+// so make sure to hit all of them.
+static constexpr size_t max_tested_size = 600;
+static constexpr size_t max_tested_offset = 70;
+
+static void fill_with_pattern(u8* buffer, size_t size)
+{
+    for (size_t i = 0; i < size; ++i)
+        buffer[i] = static_cast<u8>(i * 131 + 7);
+}
+
+TEST_CASE(memmove_sizes_and_overlaps)
+{
+    static u8 buffer[4096];
+    static u8 expected[4096];
+    constexpr size_t base = 1024;
+
+    for (size_t size = 0; size <= max_tested_size; size += size < 300 ? 1 : 23) {
+        for (size_t src_offset = 0; src_offset < max_tested_offset; src_offset += 3) {
+            for (int distance = -static_cast<int>(max_tested_offset); distance <= static_cast<int>(max_tested_offset); distance += 5) {
+                fill_with_pattern(buffer, sizeof(buffer));
+                fill_with_pattern(expected, sizeof(expected));
+                auto* src = buffer + base + src_offset;
+                auto* dest = src + distance;
+
+                EXPECT_EQ(memmove(dest, src, size), dest);
+
+                u8 copy[max_tested_size];
+                for (size_t i = 0; i < size; ++i)
+                    copy[i] = expected[base + src_offset + i];
+                for (size_t i = 0; i < size; ++i)
+                    expected[base + src_offset + distance + i] = copy[i];
+                if (__builtin_memcmp(buffer, expected, sizeof(buffer)) != 0) {
+                    FAIL(DeprecatedString::formatted("memmove of {} bytes from offset {} to {} went wrong", size, src_offset, distance));
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(memcpy_sizes_and_alignments)
+{
+    static u8 src_buffer[max_tested_size + max_tested_offset];
+    static u8 dest_buffer[max_tested_size + 2 * max_tested_offset];
+    fill_with_pattern(src_buffer, sizeof(src_buffer));
+
+    for (size_t size = 0; size <= max_tested_size; ++size) {
+        for (size_t offset = 0; offset < max_tested_offset; offset += 7) {
+            __builtin_memset(dest_buffer, 0, sizeof(dest_buffer));
+            memcpy(dest_buffer + offset, src_buffer + (offset / 2), size);
+            for (size_t i = 0; i < sizeof(dest_buffer); ++i) {
+                u8 expected = (i >= offset && i < offset + size) ? src_buffer[offset / 2 + i - offset] : 0;
+                if (dest_buffer[i] != expected) {
+                    FAIL(DeprecatedString::formatted("memcpy of {} bytes to offset {} went wrong", size, offset));
+                    return;
+                }
+            }
+        }
+    }
+}
+
+TEST_CASE(memcmp_finds_first_difference)
+{
+    u8 a[max_tested_size + 16];
+    u8 b[max_tested_size + 16];
+
+    for (size_t size = 0; size <= max_tested_size; size += size < 100 ? 1 : 11) {
+        fill_with_pattern(a, sizeof(a));
+        EXPECT_EQ(memcmp(a + 3, a + 3, size), 0);
+        for (size_t position = 0; position < size; position += size < 100 ? 1 : 13) {
+            fill_with_pattern(a, sizeof(a));
+            fill_with_pattern(b, sizeof(b));
+            a[3 + position] = 0x10;
+            b[3 + position] = 0x80;
+            // Another difference further on must not matter.
+            if (position + 1 < size) {
+                a[3 + size - 1] = 0xff;
+                b[3 + size - 1] = 0x00;
+            }
+            EXPECT(memcmp(a + 3, b + 3, size) < 0);
+            EXPECT(memcmp(b + 3, a + 3, size) > 0);
+        }
+    }
+}
+
+TEST_CASE(strlen_alignments)
+{
+    alignas(64) static char buffer[max_tested_size + 2 * max_tested_offset];
+    for (size_t offset = 0; offset < max_tested_offset; ++offset) {
+        for (size_t length = 0; length < max_tested_size; length += length < 100 ? 1 : 17) {
+            __builtin_memset(buffer, 'a', sizeof(buffer));
+            buffer[offset + length] = '\0';
+            EXPECT_EQ(strlen(buffer + offset), length);
+        }
+    }
+}
+
+TEST_CASE(memchr_boundaries)
+{
+    u8 buffer[max_tested_size + 16];
+    for (size_t size = 0; size <= max_tested_size; size += size < 100 ? 1 : 11) {
+        __builtin_memset(buffer, 'a', sizeof(buffer));
+        // A match right past the end must not be found.
+        buffer[3 + size] = 'b';
+        EXPECT_EQ(memchr(buffer + 3, 'b', size), nullptr);
+
+        for (size_t position = 0; position < size; position += size < 100 ? 1 : 7) {
+            __builtin_memset(buffer, 'a', sizeof(buffer));
+            buffer[3 + position] = 'b';
+            if (position + 1 < size)
+                buffer[3 + size - 1] = 'b';
+            EXPECT_EQ(memchr(buffer + 3, 'b', size), buffer + 3 + position);
+        }
+    }
+}
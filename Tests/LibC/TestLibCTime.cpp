@@ -4,8 +4,12 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Array.h>
 #include <AK/StringView.h>
+#include <AK/Time.h>
 #include <LibTest/TestCase.h>
+#include <pthread.h>
+#include <syscall.h>
 #include <time.h>
 
 auto const expected_epoch = "Thu Jan  1 00:00:00 1970\n"sv;
@@ -119,3 +123,64 @@ TEST_CASE(tzset)
     EXPECT_EQ(tzname[0], "CET"sv);
     EXPECT_EQ(tzname[1], "CEST"sv);
 }
+
+TEST_CASE(clock_gettime_monotonic_never_goes_backwards)
+{
+    for (auto clock_id : { CLOCK_MONOTONIC, CLOCK_MONOTONIC_COARSE }) {
+        auto previous = AK::Duration::zero();
+        for (size_t i = 0; i < 100'000; ++i) {
+            timespec ts;
+            EXPECT_EQ(clock_gettime(clock_id, &ts), 0);
+            auto now = AK::Duration::from_timespec(ts);
+            EXPECT(now >= previous);
+            previous = now;
+        }
+    }
+}
+
+struct SharedMonotonicClock {
+    pthread_mutex_t mutex = PTHREAD_MUTEX_INITIALIZER;
+    AK::Duration latest;
+    bool went_backwards { false };
+};
+
+static void* read_shared_monotonic_clock(void* argument)
+{
+    auto& clock = *static_cast<SharedMonotonicClock*>(argument);
+    for (size_t i = 0; i < 10'000; ++i) {
+        pthread_mutex_lock(&clock.mutex);
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        auto now = AK::Duration::from_timespec(ts);
+        if (now < clock.latest)
+            clock.went_backwards = true;
+        clock.latest = now;
+        pthread_mutex_unlock(&clock.mutex);
+    }
+    return nullptr;
+}
+
+// The threads likely run on different processors, so this catches TSCs that aren't in sync.
+TEST_CASE(clock_gettime_monotonic_never_goes_backwards_across_threads)
+{
+    SharedMonotonicClock clock;
+    Array<pthread_t, 4> threads;
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_create(&thread, nullptr, read_shared_monotonic_clock, &clock), 0);
+    for (auto& thread : threads)
+        EXPECT_EQ(pthread_join(thread, nullptr), 0);
+    EXPECT(!clock.went_backwards);
+}
+
+TEST_CASE(clock_gettime_matches_kernel)
+{
+    for (auto clock_id : { CLOCK_MONOTONIC, CLOCK_REALTIME }) {
+        timespec from_libc;
+        timespec from_kernel;
+        EXPECT_EQ(clock_gettime(clock_id, &from_libc), 0);
+        EXPECT_EQ(syscall(SC_clock_gettime, clock_id, &from_kernel), 0);
+        auto difference = AK::Duration::from_timespec(from_kernel) - AK::Duration::from_timespec(from_libc);
+        EXPECT(difference > AK::Duration::from_milliseconds(-10));
+        EXPECT(difference < AK::Duration::from_milliseconds(100));
+    }
+}
@@ -4,11 +4,16 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Vector.h>
 #include <LibTest/TestCase.h>
 
 #include <errno.h>
 #include <mallocdefs.h>
+#include <pthread.h>
+#include <spawn.h>
 #include <stdlib.h>
+#include <sys/wait.h>
+#include <unistd.h>
 
 TEST_CASE(malloc_limits)
 {
@@ -38,3 +43,178 @@ TEST_CASE(malloc_limits)
         return Test::Crash::Failure::DidNotCrash;
     });
 }
+
+TEST_CASE(malloc_info)
+{
+    serenity_malloc_info info;
+    EXPECT_EQ(serenity_get_malloc_info(&info, nullptr, 0), 0);
+    EXPECT_EQ(info.size_class_count, num_size_classes);
+    EXPECT_EQ(info.block_size, ChunkedBlock::block_size);
+
+    serenity_malloc_size_class_info size_class_infos[num_size_classes];
+    EXPECT_EQ(serenity_get_malloc_info(&info, size_class_infos, num_size_classes), 0);
+    for (size_t i = 0; i < num_size_classes; ++i) {
+        EXPECT_EQ(size_class_infos[i].chunk_size, size_classes[i]);
+        EXPECT(size_class_infos[i].chunks_in_use + size_class_infos[i].chunks_cached <= size_class_infos[i].chunk_capacity);
+    }
+
+    auto big_allocation_count = info.big_allocation_count;
+    void* ptr = malloc(ChunkedBlock::block_size * 2);
+    EXPECT_EQ(serenity_get_malloc_info(&info, nullptr, 0), 0);
+    EXPECT_EQ(info.big_allocation_count, big_allocation_count + 1);
+    free(ptr);
+    EXPECT_EQ(serenity_get_malloc_info(&info, nullptr, 0), 0);
+    EXPECT_EQ(info.big_allocation_count, big_allocation_count);
+
+    errno = 0;
+    EXPECT_EQ(serenity_get_malloc_info(nullptr, nullptr, 0), -1);
+    EXPECT_EQ(errno, EINVAL);
+}
+
+// Nothing else in these tests uses this size class, so the thread caches only hold what the tests put there.
+static constexpr size_t thread_cache_test_chunk_size = 1500;
+
+static size_t thread_cache_test_size_class_index()
+{
+    size_t index = 0;
+    while (size_classes[index] < thread_cache_test_chunk_size)
+        ++index;
+    return index;
+}
+
+static serenity_malloc_size_class_info thread_cache_test_size_class_info()
+{
+    serenity_malloc_info info;
+    serenity_malloc_size_class_info size_class_infos[num_size_classes];
+    VERIFY(serenity_get_malloc_info(&info, size_class_infos, num_size_classes) == 0);
+    return size_class_infos[thread_cache_test_size_class_index()];
+}
+
+static size_t thread_cache_count()
+{
+    serenity_malloc_info info;
+    VERIFY(serenity_get_malloc_info(&info, nullptr, 0) == 0);
+    return info.thread_cache_count;
+}
+
+static Vector<void*> allocate_thread_cache_test_chunks(size_t count)
+{
+    Vector<void*> chunks;
+    for (size_t i = 0; i < count; ++i)
+        chunks.append(malloc(thread_cache_test_chunk_size));
+    return chunks;
+}
+
+template<typename Callback>
+static void run_in_thread(Callback callback)
+{
+    pthread_t thread;
+    auto thread_main = [](void* argument) -> void* {
+        (*static_cast<Callback*>(argument))();
+        return nullptr;
+    };
+    VERIFY(pthread_create(&thread, nullptr, thread_main, &callback) == 0);
+    VERIFY(pthread_join(thread, nullptr) == 0);
+}
+
+TEST_CASE(thread_cache_cross_thread_free)
+{
+    // Few enough chunks to fit into one thread cache.
+    auto chunks = allocate_thread_cache_test_chunks(4);
+
+    // Chunks don't belong to the thread that allocated them, so another thread can free them and use them again.
+    size_t reused_chunk_count = 0;
+    run_in_thread([&] {
+        for (auto* chunk : chunks)
+            free(chunk);
+        auto new_chunks = allocate_thread_cache_test_chunks(4);
+        for (auto* chunk : new_chunks) {
+            if (chunks.contains_slow(chunk))
+                ++reused_chunk_count;
+            free(chunk);
+        }
+    });
+    EXPECT_EQ(reused_chunk_count, 4u);
+}
+
+TEST_CASE(thread_cache_remote_batches)
+{
+    auto remote_chunks_before = thread_cache_test_size_class_info().chunks_in_remote_batches;
+    auto chunks = allocate_thread_cache_test_chunks(64);
+
+    // Freeing more chunks than fit into a thread cache gives the rest away as batches for other threads.
+    run_in_thread([&] {
+        for (auto* chunk : chunks)
+            free(chunk);
+    });
+    auto remote_chunks_after_free = thread_cache_test_size_class_info().chunks_in_remote_batches;
+    EXPECT(remote_chunks_after_free > remote_chunks_before);
+
+    // A thread with an empty cache takes these batches before it goes to the shared allocator.
+    size_t reused_chunk_count = 0;
+    size_t remote_chunks_after_malloc = 0;
+    run_in_thread([&] {
+        auto new_chunks = allocate_thread_cache_test_chunks(1);
+        remote_chunks_after_malloc = thread_cache_test_size_class_info().chunks_in_remote_batches;
+        for (auto* chunk : new_chunks) {
+            if (chunks.contains_slow(chunk))
+                ++reused_chunk_count;
+            free(chunk);
+        }
+    });
+    EXPECT_EQ(reused_chunk_count, 1u);
+    EXPECT(remote_chunks_after_malloc < remote_chunks_after_free);
+}
+
+TEST_CASE(thread_cache_drained_at_thread_exit)
+{
+    auto thread_caches_before = thread_cache_count();
+    auto info_before = thread_cache_test_size_class_info();
+    auto chunks_in_thread_caches_before = info_before.chunks_cached - info_before.chunks_in_remote_batches;
+
+    size_t thread_caches_in_thread = 0;
+    size_t chunks_in_thread_caches_in_thread = 0;
+    run_in_thread([&] {
+        auto chunks = allocate_thread_cache_test_chunks(2);
+        for (auto* chunk : chunks)
+            free(chunk);
+        thread_caches_in_thread = thread_cache_count();
+        auto info = thread_cache_test_size_class_info();
+        chunks_in_thread_caches_in_thread = info.chunks_cached - info.chunks_in_remote_batches;
+    });
+    EXPECT_EQ(thread_caches_in_thread, thread_caches_before + 1);
+    EXPECT(chunks_in_thread_caches_in_thread > chunks_in_thread_caches_before);
+
+    // Once the thread is gone, so is its cache, and its chunks went back to their blocks.
+    EXPECT_EQ(thread_cache_count(), thread_caches_before);
+    auto info_after = thread_cache_test_size_class_info();
+    EXPECT_EQ(info_after.chunks_cached - info_after.chunks_in_remote_batches, chunks_in_thread_caches_before);
+}
+
+TEST_CASE(thread_cache_can_be_turned_off)
+{
+    if (!getenv("LIBC_NO_MALLOC_THREAD_CACHE")) {
+        // The variable is only looked at on startup, so run just this test again in a new process.
+        char const* argv[] = { "TestMalloc", "thread_cache_can_be_turned_off", nullptr };
+        char const* envp[] = { "LIBC_NO_MALLOC_THREAD_CACHE=1", nullptr };
+        pid_t pid;
+        EXPECT_EQ(posix_spawn(&pid, "/proc/self/exe", nullptr, nullptr, const_cast<char**>(argv), const_cast<char**>(envp)), 0);
+        int status = 0;
+        EXPECT_EQ(waitpid(pid, &status, 0), pid);
+        EXPECT(WIFEXITED(status));
+        EXPECT_EQ(WEXITSTATUS(status), 0);
+        return;
+    }
+
+    run_in_thread([] {
+        auto chunks = allocate_thread_cache_test_chunks(8);
+        for (auto* chunk : chunks)
+            free(chunk);
+    });
+    auto chunks = allocate_thread_cache_test_chunks(8);
+    for (auto* chunk : chunks)
+        free(chunk);
+
+    EXPECT_EQ(thread_cache_count(), 0u);
+    EXPECT_EQ(thread_cache_test_size_class_info().chunks_cached, 0u);
+}
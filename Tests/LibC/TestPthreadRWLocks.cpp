@@ -4,8 +4,11 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <LibTest/TestCase.h>
+#include <errno.h>
 #include <pthread.h>
+#include <time.h>
 
 TEST_CASE(rwlock_init)
 {
@@ -88,3 +91,74 @@ TEST_CASE(rwlock_wrlock_init_in_once)
     result = pthread_rwlock_unlock(&lock);
     EXPECT_EQ(0, result);
 }
+
+TEST_CASE(rwlock_try_and_timed_locks)
+{
+    pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+
+    auto result = pthread_rwlock_tryrdlock(&lock);
+    EXPECT_EQ(0, result);
+    result = pthread_rwlock_trywrlock(&lock);
+    EXPECT_EQ(EBUSY, result);
+
+    timespec deadline;
+    clock_gettime(CLOCK_REALTIME, &deadline);
+    deadline.tv_nsec += 10'000'000;
+    if (deadline.tv_nsec >= 1'000'000'000) {
+        deadline.tv_sec++;
+        deadline.tv_nsec -= 1'000'000'000;
+    }
+    result = pthread_rwlock_timedwrlock(&lock, &deadline);
+    EXPECT_EQ(ETIMEDOUT, result);
+
+    // The writer that gave up must not keep new readers out.
+    result = pthread_rwlock_tryrdlock(&lock);
+    EXPECT_EQ(0, result);
+    result = pthread_rwlock_unlock(&lock);
+    EXPECT_EQ(0, result);
+    result = pthread_rwlock_unlock(&lock);
+    EXPECT_EQ(0, result);
+
+    result = pthread_rwlock_trywrlock(&lock);
+    EXPECT_EQ(0, result);
+    result = pthread_rwlock_tryrdlock(&lock);
+    EXPECT_EQ(EBUSY, result);
+    result = pthread_rwlock_unlock(&lock);
+    EXPECT_EQ(0, result);
+}
+
+TEST_CASE(rwlock_contended)
+{
+    static pthread_rwlock_t lock = PTHREAD_RWLOCK_INITIALIZER;
+    static int value = 0;
+    static int readers_inside = 0;
+    static int writers_inside = 0;
+
+    auto thread_function = [](void* argument) -> void* {
+        auto thread_index = reinterpret_cast<FlatPtr>(argument);
+        for (size_t i = 0; i < 10'000; ++i) {
+            if ((i + thread_index) % 4 == 0) {
+                VERIFY(pthread_rwlock_wrlock(&lock) == 0);
+                VERIFY(AK::atomic_fetch_add(&writers_inside, 1) == 0);
+                VERIFY(AK::atomic_load(&readers_inside) == 0);
+                ++value;
+                AK::atomic_fetch_sub(&writers_inside, 1);
+            } else {
+                VERIFY(pthread_rwlock_rdlock(&lock) == 0);
+                AK::atomic_fetch_add(&readers_inside, 1);
+                VERIFY(AK::atomic_load(&writers_inside) == 0);
+                AK::atomic_fetch_sub(&readers_inside, 1);
+            }
+            VERIFY(pthread_rwlock_unlock(&lock) == 0);
+        }
+        return nullptr;
+    };
+
+    pthread_t threads[4];
+    for (size_t i = 0; i < 4; ++i)
+        EXPECT_EQ(0, pthread_create(&threads[i], nullptr, thread_function, reinterpret_cast<void*>(i)));
+    for (auto thread : threads)
+        EXPECT_EQ(0, pthread_join(thread, nullptr));
+
+    EXPECT_EQ(value, 4 * 10'000 / 4);
+}
@@ -6,6 +6,7 @@
 
 #include <LibTest/TestCase.h>
 #include <stdio.h>
+#include <string.h>
 #include <sys/wait.h>
 #include <unistd.h>
 
@@ -54,3 +55,56 @@ TEST_CASE(sprintf_sign)
     EXPECT_EQ(buf1, "+12"sv);
     EXPECT_EQ(buf2, "-12"sv);
 }
+
+TEST_CASE(fprintf_longer_than_one_chunk)
+{
+    char expected[1024];
+    memset(expected, 'x', sizeof(expected) - 1);
+    expected[sizeof(expected) - 1] = '\0';
+
+    auto* fp = fopen("/tmp/fprintftest", "w+");
+    VERIFY(fp != nullptr);
+    int rc = fprintf(fp, "%s %d|%-5u|%05d", expected, 1234567890, 42u, -42);
+    EXPECT_EQ(rc, 1023 + 23);
+    rewind(fp);
+
+    char buf[2048];
+    auto nread = fread(buf, 1, sizeof(buf), fp);
+    fclose(fp);
+    unlink("/tmp/fprintftest");
+
+    EXPECT_EQ(nread, 1023u + 23u);
+    EXPECT_EQ(memcmp(buf, expected, 1023), 0);
+    EXPECT_EQ(StringView(buf + 1023, nread - 1023), " 1234567890|42   |-0042"sv);
+}
+
+TEST_CASE(unlocked_variants)
+{
+    auto* fp = fopen("/tmp/unlockedtest", "w+");
+    VERIFY(fp != nullptr);
+
+    flockfile(fp);
+    EXPECT_EQ(putc_unlocked('a', fp), 'a');
+    EXPECT_EQ(fputc_unlocked('b', fp), 'b');
+    EXPECT_NE(fputs_unlocked("cd", fp), EOF);
+    EXPECT_EQ(fwrite_unlocked("ef\n", 1, 3, fp), 3u);
+    EXPECT_EQ(fflush_unlocked(fp), 0);
+    funlockfile(fp);
+
+    rewind(fp);
+    char buf[16];
+    flockfile(fp);
+    EXPECT_EQ(getc_unlocked(fp), 'a');
+    EXPECT_NE(fgets_unlocked(buf, sizeof(buf), fp), nullptr);
+    EXPECT_EQ(fgetc_unlocked(fp), EOF);
+    EXPECT_NE(feof_unlocked(fp), 0);
+    EXPECT_EQ(ferror_unlocked(fp), 0);
+    clearerr_unlocked(fp);
+    EXPECT_EQ(feof_unlocked(fp), 0);
+    funlockfile(fp);
+
+    fclose(fp);
+    unlink("/tmp/unlockedtest");
+
+    EXPECT_EQ(StringView(buf, strlen(buf)), "bcdef\n"sv);
+}
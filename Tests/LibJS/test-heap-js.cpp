@@ -0,0 +1,81 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Heap/DeferGC.h>
+#include <LibJS/Heap/Heap.h>
+#include <LibJS/Heap/HeapBlock.h>
+#include <LibJS/Runtime/VM.h>
+#include <LibTest/TestCase.h>
+
+template<size_t Size>
+class TestCell final : public JS::Cell {
+    JS_CELL(TestCell, JS::Cell);
+
+public:
+    TestCell() = default;
+
+private:
+    u8 m_data[Size - sizeof(JS::Cell)] {};
+};
+
+template<size_t Size>
+static size_t cell_size_of_block_for(JS::Heap& heap)
+{
+    static_assert(sizeof(TestCell<Size>) == Size);
+    auto cell = heap.allocate_without_realm<TestCell<Size>>();
+    return JS::HeapBlock::from_cell(cell.ptr())->cell_size();
+}
+
+TEST_CASE(cells_go_to_the_smallest_size_class_that_fits)
+{
+    auto vm = MUST(JS::VM::create());
+    auto& heap = vm->heap();
+
+    EXPECT_EQ(cell_size_of_block_for<32>(heap), 32u);
+    EXPECT_EQ(cell_size_of_block_for<40>(heap), 64u);
+    EXPECT_EQ(cell_size_of_block_for<64>(heap), 64u);
+    EXPECT_EQ(cell_size_of_block_for<72>(heap), 96u);
+    EXPECT_EQ(cell_size_of_block_for<96>(heap), 96u);
+    EXPECT_EQ(cell_size_of_block_for<104>(heap), 128u);
+    EXPECT_EQ(cell_size_of_block_for<136>(heap), 256u);
+    EXPECT_EQ(cell_size_of_block_for<520>(heap), 1024u);
+    EXPECT_EQ(cell_size_of_block_for<1032>(heap), 3072u);
+    EXPECT_EQ(cell_size_of_block_for<3072>(heap), 3072u);
+}
+
+template<size_t Size>
+static void allocate_cells(JS::Heap& heap, size_t count)
+{
+    for (size_t i = 0; i < count; ++i)
+        (void)heap.allocate_without_realm<TestCell<Size>>();
+}
+
+// Measures the allocation path that every cell goes through, including the collections that allocating this much
+// garbage causes.
+BENCHMARK_CASE(allocate_cells_of_mixed_sizes)
+{
+    auto vm = MUST(JS::VM::create());
+    for (size_t i = 0; i < 100; ++i) {
+        allocate_cells<48>(vm->heap(), 10'000);
+        allocate_cells<72>(vm->heap(), 10'000);
+        allocate_cells<104>(vm->heap(), 10'000);
+        allocate_cells<200>(vm->heap(), 5'000);
+    }
+}
+
+// Same as above, but without collecting in between, so this only measures finding an allocator and taking a cell
+// from a block.
+BENCHMARK_CASE(allocate_cells_of_mixed_sizes_without_collecting)
+{
+    auto vm = MUST(JS::VM::create());
+    JS::DeferGC defer_gc(vm->heap());
+    for (size_t i = 0; i < 10; ++i) {
+        allocate_cells<48>(vm->heap(), 10'000);
+        allocate_cells<72>(vm->heap(), 10'000);
+        allocate_cells<104>(vm->heap(), 10'000);
+        allocate_cells<200>(vm->heap(), 5'000);
+    }
+}
@@ -77,6 +77,23 @@ TESTJS_GLOBAL_FUNCTION(mark_as_garbage, markAsGarbage)
     return JS::js_undefined();
 }
 
+TESTJS_GLOBAL_FUNCTION(set_lazy_gc_sweeping, setLazyGCSweeping)
+{
+    vm.heap().set_lazy_sweeping_enabled(vm.argument(0).to_boolean());
+    return JS::js_undefined();
+}
+
+TESTJS_GLOBAL_FUNCTION(set_parallel_gc_marking, setParallelGCMarking)
+{
+    vm.heap().set_parallel_marking_enabled(vm.argument(0).to_boolean());
+    return JS::js_undefined();
+}
+
+TESTJS_GLOBAL_FUNCTION(gc_pause_histogram, gcPauseHistogram, 0)
+{
+    return vm.heap().pause_histogram().to_object(*vm.current_realm());
+}
+
 TESTJS_GLOBAL_FUNCTION(detach_array_buffer, detachArrayBuffer)
 {
     auto array_buffer = vm.argument(0);
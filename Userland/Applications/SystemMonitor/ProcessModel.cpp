@@ -431,38 +431,39 @@ ErrorOr<String> ProcessModel::read_command_line(pid_t pid)
     return String::join(" "sv, array);
 }
 
-ErrorOr<void> ProcessModel::ensure_process_statistics_file()
+ErrorOr<void> ProcessModel::ensure_process_statistics_reader()
 {
-    if (!m_process_statistics_file || !m_process_statistics_file->is_open())
-        m_process_statistics_file = TRY(Core::File::open("/sys/kernel/processes"sv, Core::File::OpenMode::Read));
+    if (!m_process_statistics_reader)
+        m_process_statistics_reader = TRY(Core::IncrementalProcessStatisticsReader::create(true));
 
     return {};
 }
 
 void ProcessModel::update()
 {
-    auto result = ensure_process_statistics_file();
+    auto result = ensure_process_statistics_reader();
     if (result.is_error()) {
         dbgln("Process model couldn't be updated: {}", result.release_error());
         return;
     }
 
-    auto all_processes = Core::ProcessStatisticsReader::get_all(*m_process_statistics_file, true);
+    auto update_result = m_process_statistics_reader->update();
+    auto const& all_processes = m_process_statistics_reader->statistics();
 
     auto previous_tid_count = m_threads.size();
 
     HashTable<int> live_tids;
     u64 total_time_scheduled_diff = 0;
-    if (!all_processes.is_error()) {
+    if (!update_result.is_error()) {
         if (m_has_total_scheduled_time)
-            total_time_scheduled_diff = all_processes.value().total_time_scheduled - m_total_time_scheduled;
+            total_time_scheduled_diff = all_processes.total_time_scheduled - m_total_time_scheduled;
 
-        m_total_time_scheduled = all_processes.value().total_time_scheduled;
-        m_total_time_scheduled_kernel = all_processes.value().total_time_scheduled_kernel;
+        m_total_time_scheduled = all_processes.total_time_scheduled;
+        m_total_time_scheduled_kernel = all_processes.total_time_scheduled_kernel;
         m_has_total_scheduled_time = true;
 
-        for (size_t i = 0; i < all_processes.value().processes.size(); ++i) {
-            auto const& process = all_processes.value().processes[i];
+        for (size_t i = 0; i < all_processes.processes.size(); ++i) {
+            auto const& process = all_processes.processes[i];
             NonnullOwnPtr<Process>* process_state = nullptr;
             for (size_t i = 0; i < m_processes.size(); ++i) {
                 auto* other_process = &m_processes[i];
@@ -607,7 +608,7 @@ void ProcessModel::update()
         on_cpu_info_change(m_cpus);
 
     if (on_state_update)
-        on_state_update(!all_processes.is_error() ? all_processes.value().processes.size() : 0, m_threads.size());
+        on_state_update(!update_result.is_error() ? all_processes.processes.size() : 0, m_threads.size());
 
     // FIXME: This is a rather hackish way of invalidating indices.
     //        It would be good if GUI::Model had a way to orchestrate removal/insertion while preserving indices.
@@ -10,6 +10,7 @@
 #include <AK/DeprecatedString.h>
 #include <AK/HashMap.h>
 #include <AK/Vector.h>
+#include <LibCore/ProcessStatisticsReader.h>
 #include <LibGUI/Icon.h>
 #include <LibGUI/Model.h>
 #include <LibGUI/ModelIndex.h>
@@ -267,9 +268,9 @@ private:
 
     int thread_model_row(Thread const& thread) const;
 
-    ErrorOr<void> ensure_process_statistics_file();
+    ErrorOr<void> ensure_process_statistics_reader();
 
-    OwnPtr<Core::File> m_process_statistics_file;
+    OwnPtr<Core::IncrementalProcessStatisticsReader> m_process_statistics_reader;
 
     // The thread list contains the same threads as the Process structs.
     HashMap<int, NonnullRefPtr<Thread>> m_threads;
@@ -0,0 +1,121 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include "LockContentionModel.h"
+#include "Profile.h"
+#include <AK/QuickSort.h>
+
+namespace Profiler {
+
+LockContentionModel::LockContentionModel(Profile& profile)
+    : m_profile(profile)
+{
+}
+
+// The innermost frames of a lock contention event belong to the locking and profiling machinery,
+// so skip over those to find whoever actually wanted the lock.
+static bool is_locking_frame(Profile::Frame const& frame)
+{
+    return frame.symbol.starts_with("Kernel::Mutex"sv)
+        || frame.symbol.starts_with("Kernel::PerformanceManager"sv)
+        || frame.symbol.starts_with("Kernel::PerformanceEventBuffer"sv)
+        || frame.symbol.starts_with("Kernel::Thread::block"sv);
+}
+
+void LockContentionModel::update()
+{
+    m_rows.clear();
+    for (auto event_index : m_profile.filtered_lock_contention_indices()) {
+        auto const& event = m_profile.events().at(event_index);
+        auto const& data = event.data.get<Profile::Event::LockContentionData>();
+
+        DeprecatedString symbol;
+        for (size_t i = event.frames.size(); i > 0; --i) {
+            auto const& frame = event.frames[i - 1];
+            if (is_locking_frame(frame))
+                continue;
+            symbol = frame.symbol;
+            break;
+        }
+
+        Row* row = nullptr;
+        for (auto& existing_row : m_rows) {
+            if (existing_row.lock == data.lock && existing_row.symbol == symbol) {
+                row = &existing_row;
+                break;
+            }
+        }
+        if (!row) {
+            m_rows.append({ .lock = data.lock, .symbol = move(symbol) });
+            row = &m_rows.last();
+        }
+        ++row->contentions;
+        row->total_wait_time += data.wait_time;
+        row->max_wait_time = max(row->max_wait_time, data.wait_time);
+    }
+
+    quick_sort(m_rows, [](auto& a, auto& b) { return a.total_wait_time > b.total_wait_time; });
+    invalidate();
+}
+
+int LockContentionModel::row_count(GUI::ModelIndex const&) const
+{
+    return m_rows.size();
+}
+
+int LockContentionModel::column_count(GUI::ModelIndex const&) const
+{
+    return Column::__Count;
+}
+
+ErrorOr<String> LockContentionModel::column_name(int column) const
+{
+    switch (column) {
+    case Column::Lock:
+        return "Lock"_string;
+    case Column::Symbol:
+        return "Symbol"_string;
+    case Column::Contentions:
+        return "Contentions"_string;
+    case Column::TotalWaitTime:
+        return "Total wait"_string;
+    case Column::MaxWaitTime:
+        return "Max wait"_string;
+    default:
+        VERIFY_NOT_REACHED();
+    }
+}
+
+GUI::Variant LockContentionModel::data(GUI::ModelIndex const& index, GUI::ModelRole role) const
+{
+    auto const& row = m_rows[index.row()];
+
+    if (role == GUI::ModelRole::TextAlignment) {
+        if (index.column() == Column::Lock || index.column() == Column::Symbol)
+            return Gfx::TextAlignment::CenterLeft;
+        return Gfx::TextAlignment::CenterRight;
+    }
+
+    if (role == GUI::ModelRole::Display) {
+        switch (index.column()) {
+        case Column::Lock:
+            return DeprecatedString::formatted("{:p}", row.lock);
+        case Column::Symbol:
+            return row.symbol;
+        case Column::Contentions:
+            return row.contentions;
+        case Column::TotalWaitTime:
+            return row.total_wait_time;
+        case Column::MaxWaitTime:
+            return row.max_wait_time;
+        default:
+            return {};
+        }
+    }
+    return {};
+}
+
+}
@@ -0,0 +1,59 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/DeprecatedString.h>
+#include <AK/Vector.h>
+#include <LibGUI/Model.h>
+
+namespace Profiler {
+
+class Profile;
+
+// Sums up the lock_contention events of a profile per lock and per function that tried to take it.
+class LockContentionModel final : public GUI::Model {
+public:
+    static NonnullRefPtr<LockContentionModel> create(Profile& profile)
+    {
+        return adopt_ref(*new LockContentionModel(profile));
+    }
+
+    enum Column {
+        Lock,
+        Symbol,
+        Contentions,
+        TotalWaitTime,
+        MaxWaitTime,
+        __Count
+    };
+
+    virtual ~LockContentionModel() override = default;
+
+    virtual int row_count(GUI::ModelIndex const& = GUI::ModelIndex()) const override;
+    virtual int column_count(GUI::ModelIndex const& = GUI::ModelIndex()) const override;
+    virtual ErrorOr<String> column_name(int) const override;
+    virtual GUI::Variant data(GUI::ModelIndex const&, GUI::ModelRole) const override;
+    virtual bool is_column_sortable(int) const override { return false; }
+
+    void update();
+
+private:
+    explicit LockContentionModel(Profile&);
+
+    struct Row {
+        FlatPtr lock { 0 };
+        DeprecatedString symbol;
+        u64 contentions { 0 };
+        u64 total_wait_time { 0 };
+        u64 max_wait_time { 0 };
+    };
+
+    Profile& m_profile;
+    Vector<Row> m_rows;
+};
+
+}
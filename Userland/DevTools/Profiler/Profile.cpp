@@ -49,6 +49,7 @@ Profile::Profile(Vector<Process> processes, Vector<Event> events)
     m_samples_model = SamplesModel::create(*this);
     m_signposts_model = SignpostsModel::create(*this);
     m_file_event_model = FileEventModel::create(*this);
+    m_lock_contention_model = LockContentionModel::create(*this);
 
     rebuild_tree();
 }
@@ -102,6 +103,7 @@ void Profile::rebuild_tree()
 
     m_filtered_event_indices.clear();
     m_filtered_signpost_indices.clear();
+    m_filtered_lock_contention_indices.clear();
     m_file_event_nodes->children().clear();
 
     for (size_t event_index = 0; event_index < m_events.size(); ++event_index) {
@@ -121,6 +123,11 @@ void Profile::rebuild_tree()
             continue;
         }
 
+        if (event.data.has<Event::LockContentionData>()) {
+            m_filtered_lock_contention_indices.append(event_index);
+            continue;
+        }
+
         m_filtered_event_indices.append(event_index);
 
         if (auto* malloc_data = event.data.get_pointer<Event::MallocData>(); malloc_data && !live_allocations.contains(malloc_data->ptr))
@@ -260,6 +267,7 @@ void Profile::rebuild_tree()
 
     m_roots = move(roots);
     m_model->invalidate();
+    m_lock_contention_model->update();
 }
 
 Optional<MappedObject> g_kernel_debuginfo_object;
@@ -467,6 +475,11 @@ ErrorOr<NonnullOwnPtr<Profile>> Profile::load_from_perfcore_file(StringView path
             }
 
             event.data = fsdata;
+        } else if (type_string == "lock_contention"sv) {
+            event.data = Event::LockContentionData {
+                .lock = perf_event.get_addr("lock"sv).value_or(0),
+                .wait_time = perf_event.get_integer<u64>("wait_time"sv).value_or(0),
+            };
         } else {
             dbgln("Unknown event type '{}'", type_string);
             VERIFY_NOT_REACHED();
@@ -675,6 +688,11 @@ GUI::Model* Profile::file_event_model()
     return m_file_event_model;
 }
 
+GUI::Model& Profile::lock_contention_model()
+{
+    return *m_lock_contention_model;
+}
+
 ProfileNode::ProfileNode(Process const& process)
     : m_root(true)
     , m_process(process)
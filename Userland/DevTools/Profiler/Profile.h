@@ -9,6 +9,7 @@
 
 #include "DisassemblyModel.h"
 #include "FilesystemEventModel.h"
+#include "LockContentionModel.h"
 #include "Process.h"
 #include "Profile.h"
 #include "ProfileModel.h"
@@ -152,6 +153,7 @@ public:
     GUI::Model* disassembly_model();
     GUI::Model* source_model();
     GUI::Model* file_event_model();
+    GUI::Model& lock_contention_model();
 
     Process const* find_process(pid_t pid, EventSerialNumber serial) const
     {
@@ -262,12 +264,18 @@ public:
             Variant<OpenEventData, CloseEventData, ReadvEventData, ReadEventData, PreadEventData> data;
         };
 
-        Variant<nullptr_t, SampleData, MallocData, FreeData, SignpostData, MmapData, MunmapData, ProcessCreateData, ProcessExecData, ThreadCreateData, FilesystemEventData> data { nullptr };
+        struct LockContentionData {
+            FlatPtr lock {};
+            u64 wait_time {};
+        };
+
+        Variant<nullptr_t, SampleData, MallocData, FreeData, SignpostData, MmapData, MunmapData, ProcessCreateData, ProcessExecData, ThreadCreateData, FilesystemEventData, LockContentionData> data { nullptr };
     };
 
     Vector<Event> const& events() const { return m_events; }
     Vector<size_t> const& filtered_event_indices() const { return m_filtered_event_indices; }
     Vector<size_t> const& filtered_signpost_indices() const { return m_filtered_signpost_indices; }
+    Vector<size_t> const& filtered_lock_contention_indices() const { return m_filtered_lock_contention_indices; }
     NonnullRefPtr<FileEventNode> const& file_event_nodes() { return m_file_event_nodes; }
 
     u64 length_in_ms() const { return m_last_timestamp - m_first_timestamp; }
@@ -328,6 +336,7 @@ private:
     RefPtr<DisassemblyModel> m_disassembly_model;
     RefPtr<SourceModel> m_source_model;
     RefPtr<FileEventModel> m_file_event_model;
+    RefPtr<LockContentionModel> m_lock_contention_model;
 
     GUI::ModelIndex m_disassembly_index;
     GUI::ModelIndex m_source_index;
@@ -341,6 +350,7 @@ private:
     Vector<Event> m_events;
     Vector<size_t> m_signpost_indices;
     Vector<size_t> m_filtered_signpost_indices;
+    Vector<size_t> m_filtered_lock_contention_indices;
 
     bool m_has_timestamp_filter_range { false };
     u64 m_timestamp_filter_range_start { 0 };
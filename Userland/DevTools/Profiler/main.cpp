@@ -210,6 +210,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         individual_signpost_view.set_model(move(model));
     };
 
+    auto& lock_contention_tab = tab_widget.add_tab<GUI::Widget>("Lock Contention"_string);
+    lock_contention_tab.set_layout<GUI::VerticalBoxLayout>(4);
+
+    auto& lock_contention_table_view = lock_contention_tab.add<GUI::TableView>();
+    lock_contention_table_view.set_model(profile->lock_contention_model());
+
     auto& flamegraph_tab = tab_widget.add_tab<GUI::Widget>("Flame Graph"_string);
     flamegraph_tab.set_layout<GUI::VerticalBoxLayout>(GUI::Margins { 4, 4, 4, 4 });
 
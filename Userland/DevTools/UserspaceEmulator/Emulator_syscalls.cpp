@@ -158,6 +158,7 @@ u32 Emulator::virt_syscall(u32 function, u32 arg1, u32 arg2, u32 arg3)
         return virt$lseek(arg1, arg2, arg3);
     case SC_madvise:
         return virt$madvise(arg1, arg2, arg3);
+    case SC_map_running_threads_page:
     case SC_map_time_page:
         return -ENOSYS;
     case SC_mkdir:
@@ -0,0 +1,64 @@
+/*
+ * Copyright (c) 2022, Daniel Bertalan <dani@danielbertalan.dev>
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Types.h>
+#include <cpuid.h>
+
+// NOTE: These are used by IFUNC resolvers, which can run before LibC has been relocated.
+//       Keep them self-contained.
+
+namespace {
+
+constexpr u32 tcg_signature_ebx = 0x54474354;
+constexpr u32 tcg_signature_ecx = 0x43544743;
+constexpr u32 tcg_signature_edx = 0x47435447;
+
+// Bit 27 of ecx in cpuid[eax = 1] indicates that the OS has enabled XSAVE (and thus XGETBV).
+constexpr u32 cpuid_1_ecx_bit_osxsave = 1 << 27;
+// Bit 5 of ebx in cpuid[eax = 7] indicates support for AVX2.
+constexpr u32 cpuid_7_ebx_bit_avx2 = 1 << 5;
+// Bit 9 of ebx in cpuid[eax = 7] indicates support for "Enhanced REP MOVSB/STOSB"
+constexpr u32 cpuid_7_ebx_bit_erms = 1 << 9;
+
+// Bits 1 and 2 of XCR0 indicate that the OS saves the SSE and AVX register state.
+constexpr u64 xcr0_sse_and_avx_state = 0b110;
+
+[[gnu::always_inline]] inline bool is_running_under_tcg()
+{
+    u32 eax, ebx, ecx, edx;
+    __cpuid(0x40000000, eax, ebx, ecx, edx);
+    return ebx == tcg_signature_ebx && ecx == tcg_signature_ecx && edx == tcg_signature_edx;
+}
+
+[[gnu::always_inline]] inline bool cpu_has_erms()
+{
+    u32 eax, ebx, ecx, edx;
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & cpuid_7_ebx_bit_erms;
+}
+
+[[gnu::always_inline]] inline bool cpu_has_avx2()
+{
+    u32 eax, ebx, ecx, edx;
+    __cpuid(1, eax, ebx, ecx, edx);
+    if (!(ecx & cpuid_1_ecx_bit_osxsave))
+        return false;
+
+    u32 xcr0_low, xcr0_high;
+    asm volatile("xgetbv"
+                 : "=a"(xcr0_low), "=d"(xcr0_high)
+                 : "c"(0));
+    if ((xcr0_low & xcr0_sse_and_avx_state) != xcr0_sse_and_avx_state)
+        return false;
+
+    __cpuid_count(7, 0, eax, ebx, ecx, edx);
+    return ebx & cpuid_7_ebx_bit_avx2;
+}
+
+}
@@ -0,0 +1,501 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+// SSE2 and AVX2 implementations of the string functions that show up the most in profiles. The best one
+// for the CPU is picked once at load time, in the same way as memset.
+//
+// - The copy routines handle up to 64 (SSE2) or 128 (AVX2) bytes with a few loads that may overlap each
+//   other, followed by the stores. Since all loads happen before any store, this also works for overlapping
+//   buffers, so memcpy() is simply memmove(). Larger copies run an aligned loop in whichever direction is
+//   safe, and use REP MOVSB for big forward copies where that's fast.
+// - memcmp() and memchr() never read outside of the given buffers. The last vector is allowed to overlap the
+//   one before it instead.
+// - strlen() only does aligned loads, which can read past the end of the string, but never into the next page.
+
+#include "cpu_features.h"
+#include <AK/BuiltinWrappers.h>
+#include <AK/Platform.h>
+#include <AK/StdLibExtras.h>
+#include <AK/Types.h>
+#include <immintrin.h>
+#include <string.h>
+
+namespace {
+
+using UnalignedU16 = u16 __attribute__((may_alias, aligned(1)));
+using UnalignedU32 = u32 __attribute__((may_alias, aligned(1)));
+using UnalignedU64 = u64 __attribute__((may_alias, aligned(1)));
+
+// Forward copies of at least this many bytes use REP MOVSB on CPUs with ERMS.
+constexpr size_t rep_movsb_threshold = 2048;
+
+ALWAYS_INLINE __m128i load16(u8 const* ptr) { return _mm_loadu_si128(reinterpret_cast<__m128i const*>(ptr)); }
+ALWAYS_INLINE void store16(u8* ptr, __m128i value) { _mm_storeu_si128(reinterpret_cast<__m128i*>(ptr), value); }
+ALWAYS_INLINE void store16_aligned(u8* ptr, __m128i value) { _mm_store_si128(reinterpret_cast<__m128i*>(ptr), value); }
+
+[[gnu::target("avx2")]] ALWAYS_INLINE __m256i load32(u8 const* ptr) { return _mm256_loadu_si256(reinterpret_cast<__m256i const*>(ptr)); }
+[[gnu::target("avx2")]] ALWAYS_INLINE void store32(u8* ptr, __m256i value) { _mm256_storeu_si256(reinterpret_cast<__m256i*>(ptr), value); }
+[[gnu::target("avx2")]] ALWAYS_INLINE void store32_aligned(u8* ptr, __m256i value) { _mm256_store_si256(reinterpret_cast<__m256i*>(ptr), value); }
+
+ALWAYS_INLINE void rep_movsb(u8* dest, u8 const* src, size_t n)
+{
+    asm volatile(
+        "rep movsb"
+        : "+D"(dest), "+S"(src), "+c"(n)::"memory");
+}
+
+ALWAYS_INLINE bool can_copy_forward(u8* dest, u8 const* src, size_t n)
+{
+    // Either the destination comes first, or the buffers don't overlap at all.
+    return (FlatPtr)dest - (FlatPtr)src >= n;
+}
+
+ALWAYS_INLINE void copy_up_to_32(u8* dest, u8 const* src, size_t n)
+{
+    if (n >= 16) {
+        auto head = load16(src);
+        auto tail = load16(src + n - 16);
+        store16(dest, head);
+        store16(dest + n - 16, tail);
+    } else if (n >= 8) {
+        u64 head = *reinterpret_cast<UnalignedU64 const*>(src);
+        u64 tail = *reinterpret_cast<UnalignedU64 const*>(src + n - 8);
+        *reinterpret_cast<UnalignedU64*>(dest) = head;
+        *reinterpret_cast<UnalignedU64*>(dest + n - 8) = tail;
+    } else if (n >= 4) {
+        u32 head = *reinterpret_cast<UnalignedU32 const*>(src);
+        u32 tail = *reinterpret_cast<UnalignedU32 const*>(src + n - 4);
+        *reinterpret_cast<UnalignedU32*>(dest) = head;
+        *reinterpret_cast<UnalignedU32*>(dest + n - 4) = tail;
+    } else if (n >= 2) {
+        u16 head = *reinterpret_cast<UnalignedU16 const*>(src);
+        u16 tail = *reinterpret_cast<UnalignedU16 const*>(src + n - 2);
+        *reinterpret_cast<UnalignedU16*>(dest) = head;
+        *reinterpret_cast<UnalignedU16*>(dest + n - 2) = tail;
+    } else if (n == 1) {
+        *dest = *src;
+    }
+}
+
+template<bool use_rep_movsb>
+ALWAYS_INLINE void* memmove_sse2_impl(void* dest_ptr, void const* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto* src = static_cast<u8 const*>(src_ptr);
+
+    if (n <= 32) {
+        copy_up_to_32(dest, src, n);
+        return dest_ptr;
+    }
+
+    if (n <= 64) {
+        auto a = load16(src);
+        auto b = load16(src + 16);
+        auto c = load16(src + n - 32);
+        auto d = load16(src + n - 16);
+        store16(dest, a);
+        store16(dest + 16, b);
+        store16(dest + n - 32, c);
+        store16(dest + n - 16, d);
+        return dest_ptr;
+    }
+
+    if (can_copy_forward(dest, src, n)) {
+        if constexpr (use_rep_movsb) {
+            if (n >= rep_movsb_threshold) {
+                rep_movsb(dest, src, n);
+                return dest_ptr;
+            }
+        }
+
+        // Copy everything but the first 16 and the last 64 bytes in aligned chunks of 64 bytes, and the rest once we're done.
+        auto head = load16(src);
+        auto tail0 = load16(src + n - 64);
+        auto tail1 = load16(src + n - 48);
+        auto tail2 = load16(src + n - 32);
+        auto tail3 = load16(src + n - 16);
+
+        size_t offset = 16 - ((FlatPtr)dest & 15);
+        for (; offset < n - 64; offset += 64) {
+            auto a = load16(src + offset);
+            auto b = load16(src + offset + 16);
+            auto c = load16(src + offset + 32);
+            auto d = load16(src + offset + 48);
+            store16_aligned(dest + offset, a);
+            store16_aligned(dest + offset + 16, b);
+            store16_aligned(dest + offset + 32, c);
+            store16_aligned(dest + offset + 48, d);
+        }
+
+        store16(dest + n - 64, tail0);
+        store16(dest + n - 48, tail1);
+        store16(dest + n - 32, tail2);
+        store16(dest + n - 16, tail3);
+        store16(dest, head);
+        return dest_ptr;
+    }
+
+    // The destination overlaps the end of the source, so go backwards.
+    auto head0 = load16(src);
+    auto head1 = load16(src + 16);
+    auto head2 = load16(src + 32);
+    auto head3 = load16(src + 48);
+    auto tail = load16(src + n - 16);
+
+    size_t end = n - (((FlatPtr)dest + n) & 15);
+    for (; end > 64; end -= 64) {
+        auto a = load16(src + end - 64);
+        auto b = load16(src + end - 48);
+        auto c = load16(src + end - 32);
+        auto d = load16(src + end - 16);
+        store16_aligned(dest + end - 64, a);
+        store16_aligned(dest + end - 48, b);
+        store16_aligned(dest + end - 32, c);
+        store16_aligned(dest + end - 16, d);
+    }
+
+    store16(dest, head0);
+    store16(dest + 16, head1);
+    store16(dest + 32, head2);
+    store16(dest + 48, head3);
+    store16(dest + n - 16, tail);
+    return dest_ptr;
+}
+
+template<bool use_rep_movsb>
+[[gnu::target("avx2")]] ALWAYS_INLINE void* memmove_avx2_impl(void* dest_ptr, void const* src_ptr, size_t n)
+{
+    auto* dest = static_cast<u8*>(dest_ptr);
+    auto* src = static_cast<u8 const*>(src_ptr);
+
+    if (n <= 32) {
+        copy_up_to_32(dest, src, n);
+        return dest_ptr;
+    }
+
+    if (n <= 64) {
+        auto head = load32(src);
+        auto tail = load32(src + n - 32);
+        store32(dest, head);
+        store32(dest + n - 32, tail);
+        return dest_ptr;
+    }
+
+    if (n <= 128) {
+        auto a = load32(src);
+        auto b = load32(src + 32);
+        auto c = load32(src + n - 64);
+        auto d = load32(src + n - 32);
+        store32(dest, a);
+        store32(dest + 32, b);
+        store32(dest + n - 64, c);
+        store32(dest + n - 32, d);
+        return dest_ptr;
+    }
+
+    if (can_copy_forward(dest, src, n)) {
+        if constexpr (use_rep_movsb) {
+            if (n >= rep_movsb_threshold) {
+                rep_movsb(dest, src, n);
+                return dest_ptr;
+            }
+        }
+
+        auto head = load32(src);
+        auto tail0 = load32(src + n - 128);
+        auto tail1 = load32(src + n - 96);
+        auto tail2 = load32(src + n - 64);
+        auto tail3 = load32(src + n - 32);
+
+        size_t offset = 32 - ((FlatPtr)dest & 31);
+        for (; offset < n - 128; offset += 128) {
+            auto a = load32(src + offset);
+            auto b = load32(src + offset + 32);
+            auto c = load32(src + offset + 64);
+            auto d = load32(src + offset + 96);
+            store32_aligned(dest + offset, a);
+            store32_aligned(dest + offset + 32, b);
+            store32_aligned(dest + offset + 64, c);
+            store32_aligned(dest + offset + 96, d);
+        }
+
+        store32(dest + n - 128, tail0);
+        store32(dest + n - 96, tail1);
+        store32(dest + n - 64, tail2);
+        store32(dest + n - 32, tail3);
+        store32(dest, head);
+        return dest_ptr;
+    }
+
+    auto head0 = load32(src);
+    auto head1 = load32(src + 32);
+    auto head2 = load32(src + 64);
+    auto head3 = load32(src + 96);
+    auto tail = load32(src + n - 32);
+
+    size_t end = n - (((FlatPtr)dest + n) & 31);
+    for (; end > 128; end -= 128) {
+        auto a = load32(src + end - 128);
+        auto b = load32(src + end - 96);
+        auto c = load32(src + end - 64);
+        auto d = load32(src + end - 32);
+        store32_aligned(dest + end - 128, a);
+        store32_aligned(dest + end - 96, b);
+        store32_aligned(dest + end - 64, c);
+        store32_aligned(dest + end - 32, d);
+    }
+
+    store32(dest, head0);
+    store32(dest + 32, head1);
+    store32(dest + 64, head2);
+    store32(dest + 96, head3);
+    store32(dest + n - 32, tail);
+    return dest_ptr;
+}
+
+}
+
+extern "C" {
+
+namespace {
+
+[[gnu::used]] void* memmove_sse2(void* dest, void const* src, size_t n) { return memmove_sse2_impl<false>(dest, src, n); }
+[[gnu::used]] void* memmove_sse2_erms(void* dest, void const* src, size_t n) { return memmove_sse2_impl<true>(dest, src, n); }
+[[gnu::used, gnu::target("avx2")]] void* memmove_avx2(void* dest, void const* src, size_t n) { return memmove_avx2_impl<false>(dest, src, n); }
+[[gnu::used, gnu::target("avx2")]] void* memmove_avx2_erms(void* dest, void const* src, size_t n) { return memmove_avx2_impl<true>(dest, src, n); }
+
+ALWAYS_INLINE int compare_u64_big_endian(u8 const* a, u8 const* b)
+{
+    u64 x = *reinterpret_cast<UnalignedU64 const*>(a);
+    u64 y = *reinterpret_cast<UnalignedU64 const*>(b);
+    if (x == y)
+        return 0;
+    return __builtin_bswap64(x) < __builtin_bswap64(y) ? -1 : 1;
+}
+
+ALWAYS_INLINE int memcmp_up_to_16(u8 const* a, u8 const* b, size_t n)
+{
+    if (n >= 8) {
+        if (int result = compare_u64_big_endian(a, b))
+            return result;
+        return compare_u64_big_endian(a + n - 8, b + n - 8);
+    }
+    for (size_t i = 0; i < n; ++i) {
+        if (a[i] != b[i])
+            return a[i] < b[i] ? -1 : 1;
+    }
+    return 0;
+}
+
+ALWAYS_INLINE int compare_bytes_at(u8 const* a, u8 const* b, size_t index)
+{
+    return a[index] < b[index] ? -1 : 1;
+}
+
+[[gnu::used]] int memcmp_sse2(void const* a_ptr, void const* b_ptr, size_t n)
+{
+    auto* a = static_cast<u8 const*>(a_ptr);
+    auto* b = static_cast<u8 const*>(b_ptr);
+
+    if (n < 16)
+        return memcmp_up_to_16(a, b, n);
+
+    size_t offset = 0;
+    for (;;) {
+        u32 equal_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load16(a + offset), load16(b + offset)));
+        if (equal_mask != 0xffff)
+            return compare_bytes_at(a, b, offset + count_trailing_zeroes(~equal_mask));
+        if (offset + 16 == n)
+            return 0;
+        // The last 16 bytes may overlap the ones we just compared.
+        offset = min(offset + 16, n - 16);
+    }
+}
+
+[[gnu::used, gnu::target("avx2")]] int memcmp_avx2(void const* a_ptr, void const* b_ptr, size_t n)
+{
+    auto* a = static_cast<u8 const*>(a_ptr);
+    auto* b = static_cast<u8 const*>(b_ptr);
+
+    if (n < 32)
+        return memcmp_sse2(a, b, n);
+
+    size_t offset = 0;
+    for (;;) {
+        u32 equal_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(a + offset), load32(b + offset)));
+        if (equal_mask != 0xffffffff)
+            return compare_bytes_at(a, b, offset + count_trailing_zeroes(~equal_mask));
+        if (offset + 32 == n)
+            return 0;
+        offset = min(offset + 32, n - 32);
+    }
+}
+
+[[gnu::used]] size_t strlen_sse2(char const* str)
+{
+    auto zero = _mm_setzero_si128();
+    auto misalignment = (FlatPtr)str & 15;
+    auto* chunk = reinterpret_cast<u8 const*>(str) - misalignment;
+
+    u32 zero_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<__m128i const*>(chunk)), zero)) >> misalignment;
+    if (zero_mask)
+        return count_trailing_zeroes(zero_mask);
+
+    for (;;) {
+        chunk += 16;
+        zero_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(_mm_load_si128(reinterpret_cast<__m128i const*>(chunk)), zero));
+        if (zero_mask)
+            return chunk + count_trailing_zeroes(zero_mask) - reinterpret_cast<u8 const*>(str);
+    }
+}
+
+[[gnu::used, gnu::target("avx2")]] size_t strlen_avx2(char const* str)
+{
+    auto zero = _mm256_setzero_si256();
+    auto misalignment = (FlatPtr)str & 31;
+    auto* chunk = reinterpret_cast<u8 const*>(str) - misalignment;
+
+    u32 zero_mask = static_cast<u32>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<__m256i const*>(chunk)), zero))) >> misalignment;
+    if (zero_mask)
+        return count_trailing_zeroes(zero_mask);
+
+    for (;;) {
+        chunk += 32;
+        zero_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(_mm256_load_si256(reinterpret_cast<__m256i const*>(chunk)), zero));
+        if (zero_mask)
+            return chunk + count_trailing_zeroes(zero_mask) - reinterpret_cast<u8 const*>(str);
+    }
+}
+
+[[gnu::used]] void* memchr_sse2(void const* ptr, int c, size_t n)
+{
+    auto* bytes = static_cast<u8 const*>(ptr);
+
+    if (n < 16) {
+        for (size_t i = 0; i < n; ++i) {
+            if (bytes[i] == static_cast<u8>(c))
+                return const_cast<u8*>(bytes + i);
+        }
+        return nullptr;
+    }
+
+    auto needle = _mm_set1_epi8(static_cast<char>(c));
+    size_t offset = 0;
+    for (;;) {
+        u32 match_mask = _mm_movemask_epi8(_mm_cmpeq_epi8(load16(bytes + offset), needle));
+        if (match_mask)
+            return const_cast<u8*>(bytes + offset + count_trailing_zeroes(match_mask));
+        if (offset + 16 == n)
+            return nullptr;
+        // The bytes that the last 16 share with the ones we just searched didn't match, so the first match is still the right one.
+        offset = min(offset + 16, n - 16);
+    }
+}
+
+[[gnu::used, gnu::target("avx2")]] void* memchr_avx2(void const* ptr, int c, size_t n)
+{
+    auto* bytes = static_cast<u8 const*>(ptr);
+
+    if (n < 32)
+        return memchr_sse2(ptr, c, n);
+
+    auto needle = _mm256_set1_epi8(static_cast<char>(c));
+    size_t offset = 0;
+    for (;;) {
+        u32 match_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(load32(bytes + offset), needle));
+        if (match_mask)
+            return const_cast<u8*>(bytes + offset + count_trailing_zeroes(match_mask));
+        if (offset + 32 == n)
+            return nullptr;
+        offset = min(offset + 32, n - 32);
+    }
+}
+
+[[gnu::used]] decltype(&memmove) resolve_memmove()
+{
+    // Like for memset, REP MOVSB is slower than SSE copies under TCG, even though it reports ERMS support.
+    bool use_rep_movsb = !is_running_under_tcg() && cpu_has_erms();
+    if (cpu_has_avx2())
+        return use_rep_movsb ? memmove_avx2_erms : memmove_avx2;
+    return use_rep_movsb ? memmove_sse2_erms : memmove_sse2;
+}
+
+[[gnu::used]] decltype(&memcpy) resolve_memcpy()
+{
+    return resolve_memmove();
+}
+
+[[gnu::used]] decltype(&memcmp) resolve_memcmp()
+{
+    return cpu_has_avx2() ? memcmp_avx2 : memcmp_sse2;
+}
+
+[[gnu::used]] decltype(&strlen) resolve_strlen()
+{
+    return cpu_has_avx2() ? strlen_avx2 : strlen_sse2;
+}
+
+[[gnu::used]] decltype(&memchr) resolve_memchr()
+{
+    return cpu_has_avx2() ? memchr_avx2 : memchr_sse2;
+}
+
+}
+
+#if !defined(AK_COMPILER_CLANG) && !defined(_DYNAMIC_LOADER)
+[[gnu::ifunc("resolve_memcpy")]] void* memcpy(void*, void const*, size_t);
+[[gnu::ifunc("resolve_memmove")]] void* memmove(void*, void const*, size_t);
+[[gnu::ifunc("resolve_memcmp")]] int memcmp(void const*, void const*, size_t);
+[[gnu::ifunc("resolve_strlen")]] size_t strlen(char const*);
+[[gnu::ifunc("resolve_memchr")]] void* memchr(void const*, int, size_t);
+#else
+// See memset.cpp for why we can't use IFUNCs here.
+void* memcpy(void* dest_ptr, void const* src_ptr, size_t n)
+{
+    static decltype(&memcpy) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_memcpy();
+
+    return s_impl(dest_ptr, src_ptr, n);
+}
+
+void* memmove(void* dest_ptr, void const* src_ptr, size_t n)
+{
+    static decltype(&memmove) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_memmove();
+
+    return s_impl(dest_ptr, src_ptr, n);
+}
+
+int memcmp(void const* a, void const* b, size_t n)
+{
+    static decltype(&memcmp) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_memcmp();
+
+    return s_impl(a, b, n);
+}
+
+size_t strlen(char const* str)
+{
+    static decltype(&strlen) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_strlen();
+
+    return s_impl(str);
+}
+
+void* memchr(void const* ptr, int c, size_t n)
+{
+    static decltype(&memchr) s_impl = nullptr;
+    if (s_impl == nullptr)
+        s_impl = resolve_memchr();
+
+    return s_impl(ptr, c, n);
+}
+#endif
+}
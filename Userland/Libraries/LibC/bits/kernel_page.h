@@ -0,0 +1,40 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Atomic.h>
+#include <errno.h>
+#include <limits.h>
+#include <sys/mman.h>
+#include <syscall.h>
+
+namespace LibC {
+
+// Maps one of the read-only pages that the kernel keeps up to date for us (like the time page) the first time
+// it's needed, and hands out the same mapping to every thread afterwards. Returns nullptr if the kernel refuses.
+// NOTE: This doesn't touch errno, since the callers have a fallback and must not clobber it.
+template<typename Page>
+Page const* map_kernel_page_once(Atomic<Page const*>& mapped_page, int syscall_function)
+{
+    if (auto const* page = mapped_page.load(AK::memory_order_acquire))
+        return page;
+
+    auto rc = syscall(syscall_function);
+    if ((int)rc < 0 && (int)rc > -EMAXERRNO)
+        return nullptr;
+
+    auto const* page = reinterpret_cast<Page const*>(rc);
+    Page const* existing_page = nullptr;
+    if (!mapped_page.compare_exchange_strong(existing_page, page, AK::memory_order_acq_rel)) {
+        // Another thread got here first, use its mapping instead.
+        munmap(const_cast<Page*>(page), PAGE_SIZE);
+        return existing_page;
+    }
+    return page;
+}
+
+}
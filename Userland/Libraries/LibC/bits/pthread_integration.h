@@ -19,6 +19,22 @@ void __pthread_fork_atfork_register_parent(void (*)(void));
 void __pthread_fork_atfork_register_child(void (*)(void));
 
 int __pthread_mutex_lock_pessimistic_np(pthread_mutex_t*);
+int __pthread_is_running_on_processor_np(pthread_t);
+
+// Contended locks spin for a while before going to sleep, as long as the thread holding them is running.
+// This bounds spinning to a few microseconds, which is about what sleeping on a futex and being woken up costs.
+#define __PTHREAD_MAX_SPIN_COUNT 1000
+// Looking up whether a thread is running is more expensive than looking at a lock, so don't do it on every spin.
+#define __PTHREAD_SPINS_BETWEEN_OWNER_CHECKS 16
+
+static inline void __pthread_spin_pause(void)
+{
+#if defined(__x86_64__)
+    __builtin_ia32_pause();
+#elif defined(__aarch64__)
+    __asm__ volatile("yield");
+#endif
+}
 
 typedef void (*KeyDestructor)(void*);
 
@@ -5,8 +5,10 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
 #include <AK/BuiltinWrappers.h>
 #include <AK/Debug.h>
+#include <AK/Optional.h>
 #include <AK/ScopedValueRollback.h>
 #include <AK/Vector.h>
 #include <assert.h>
@@ -20,6 +22,7 @@
 #include <sys/internals.h>
 #include <sys/mman.h>
 #include <syscall.h>
+#include <unistd.h>
 
 class PthreadMutexLocker {
 public:
@@ -46,8 +49,13 @@ private:
 static pthread_mutex_t s_malloc_mutex = PTHREAD_MUTEX_INITIALIZER;
 bool __heap_is_stable = true;
 
+// Empty blocks are kept "hot" (still mapped and populated) for a while, in case we need them again soon.
+// Hot blocks that go unused for a whole decay period are made "cold": they're protected and marked
+// volatile, so the kernel can take their pages back whenever it needs memory, while we keep the
+// address space around for later. Only when the cold cache is full are blocks unmapped.
 constexpr size_t number_of_hot_chunked_blocks_to_keep_around = 16;
-constexpr size_t number_of_cold_chunked_blocks_to_keep_around = 16;
+constexpr size_t number_of_cold_chunked_blocks_to_keep_around = 64;
+constexpr size_t empty_block_decay_period = 4096; // Calls into the shared allocator.
 constexpr size_t number_of_big_blocks_to_keep_around_per_size_class = 8;
 
 static bool s_log_malloc = false;
@@ -114,6 +122,7 @@ struct MallocStats {
     size_t number_of_freed_full_blocks;
     size_t number_of_hot_keeps;
     size_t number_of_cold_keeps;
+    size_t number_of_decayed_hot_blocks;
     size_t number_of_frees;
 };
 static MallocStats g_malloc_stats = {};
@@ -122,6 +131,11 @@ static size_t s_hot_empty_block_count { 0 };
 static ChunkedBlock* s_hot_empty_blocks[number_of_hot_chunked_blocks_to_keep_around] { nullptr };
 static size_t s_cold_empty_block_count { 0 };
 static ChunkedBlock* s_cold_empty_blocks[number_of_cold_chunked_blocks_to_keep_around] { nullptr };
+static size_t s_hot_empty_block_low_water_mark { 0 };
+static size_t s_empty_block_decay_ticks { 0 };
+
+static size_t s_big_allocation_count { 0 };
+static size_t s_big_allocation_bytes { 0 };
 
 struct Allocator {
     size_t size { 0 };
@@ -284,6 +298,174 @@ static void* try_allocate_chunk_aligned(size_t align, ChunkedBlock& block)
     return nullptr;
 }
 
+// All of these must be called with the malloc lock held.
+static void make_empty_block_cold(ChunkedBlock* block)
+{
+    if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
+        dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
+        g_malloc_stats.number_of_cold_keeps++;
+        s_cold_empty_blocks[s_cold_empty_block_count++] = block;
+        mprotect(block, ChunkedBlock::block_size, PROT_NONE);
+        madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
+        return;
+    }
+    dbgln_if(MALLOC_DEBUG, "Releasing block {:p}", block);
+    g_malloc_stats.number_of_frees++;
+    os_free(block, ChunkedBlock::block_size);
+}
+
+static void make_oldest_hot_empty_blocks_cold(size_t count)
+{
+    VERIFY(count <= s_hot_empty_block_count);
+    for (size_t i = 0; i < count; ++i)
+        make_empty_block_cold(s_hot_empty_blocks[i]);
+    for (size_t i = count; i < s_hot_empty_block_count; ++i)
+        s_hot_empty_blocks[i - count] = s_hot_empty_blocks[i];
+    s_hot_empty_block_count -= count;
+    s_hot_empty_block_low_water_mark = min(s_hot_empty_block_low_water_mark, s_hot_empty_block_count);
+}
+
+static void keep_empty_block(ChunkedBlock* block)
+{
+    if (s_hot_empty_block_count == number_of_hot_chunked_blocks_to_keep_around)
+        make_oldest_hot_empty_blocks_cold(1);
+    dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
+    g_malloc_stats.number_of_hot_keeps++;
+    s_hot_empty_blocks[s_hot_empty_block_count++] = block;
+}
+
+static ChunkedBlock* take_hot_empty_block()
+{
+    auto* block = s_hot_empty_blocks[--s_hot_empty_block_count];
+    s_hot_empty_block_low_water_mark = min(s_hot_empty_block_low_water_mark, s_hot_empty_block_count);
+    return block;
+}
+
+static void tick_empty_block_decay()
+{
+    if (++s_empty_block_decay_ticks < empty_block_decay_period)
+        return;
+    s_empty_block_decay_ticks = 0;
+
+    // The oldest hot blocks that have been sitting around for a whole period weren't needed, so let them go cold.
+    if (s_hot_empty_block_low_water_mark) {
+        g_malloc_stats.number_of_decayed_hot_blocks += s_hot_empty_block_low_water_mark;
+        make_oldest_hot_empty_blocks_cold(s_hot_empty_block_low_water_mark);
+    }
+    s_hot_empty_block_low_water_mark = s_hot_empty_block_count;
+}
+
+// Takes a chunk from one of the allocator's blocks, getting a new block if there isn't a free chunk left.
+// Must be called with the malloc lock held.
+static ErrorOr<void*> allocate_chunk(Allocator& allocator, size_t good_size, size_t align)
+{
+    tick_empty_block_decay();
+
+    ChunkedBlock* block = nullptr;
+    void* ptr = nullptr;
+    for (auto& current : allocator.usable_blocks) {
+        if (current.free_chunks()) {
+            ptr = try_allocate_chunk_aligned(align, current);
+            if (ptr) {
+                block = &current;
+                break;
+            }
+        }
+    }
+
+    if (!block && s_hot_empty_block_count) {
+        g_malloc_stats.number_of_hot_empty_block_hits++;
+        block = take_hot_empty_block();
+        if (block->m_size != good_size) {
+            new (block) ChunkedBlock(good_size);
+            ue_notify_chunk_size_changed(block, good_size);
+            char buffer[64];
+            snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+            set_mmap_name(block, ChunkedBlock::block_size, buffer);
+        }
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
+    }
+
+    if (!block && s_cold_empty_block_count) {
+        g_malloc_stats.number_of_cold_empty_block_hits++;
+        block = s_cold_empty_blocks[--s_cold_empty_block_count];
+        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
+        bool this_block_was_purged = rc == 1;
+        if (rc < 0) {
+            perror("madvise");
+            VERIFY_NOT_REACHED();
+        }
+        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
+        if (rc < 0) {
+            perror("mprotect");
+            VERIFY_NOT_REACHED();
+        }
+        if (this_block_was_purged || block->m_size != good_size) {
+            if (this_block_was_purged)
+                g_malloc_stats.number_of_cold_empty_block_purge_hits++;
+            new (block) ChunkedBlock(good_size);
+            ue_notify_chunk_size_changed(block, good_size);
+        }
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
+    }
+
+    if (!block) {
+        g_malloc_stats.number_of_block_allocs++;
+        char buffer[64];
+        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
+        block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
+        new (block) ChunkedBlock(good_size);
+        allocator.usable_blocks.append(*block);
+        ++allocator.block_count;
+    }
+
+    if (!ptr) {
+        ptr = try_allocate_chunk_aligned(align, *block);
+    }
+
+    VERIFY(ptr);
+    if (block->is_full()) {
+        g_malloc_stats.number_of_blocks_full++;
+        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
+        allocator.usable_blocks.remove(*block);
+        allocator.full_blocks.append(*block);
+    }
+    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    return ptr;
+}
+
+// Puts a chunk back into its block, giving the block back if nothing else is in use.
+// Must be called with the malloc lock held.
+static void free_chunk(ChunkedBlock* block, void* ptr)
+{
+    tick_empty_block_decay();
+
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = block->m_freelist;
+    block->m_freelist = entry;
+
+    if (block->is_full()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
+        g_malloc_stats.number_of_freed_full_blocks++;
+        allocator->full_blocks.remove(*block);
+        allocator->usable_blocks.prepend(*block);
+    }
+
+    ++block->m_free_chunks;
+
+    if (!block->used_chunks()) {
+        size_t good_size;
+        auto* allocator = allocator_for_size(block->m_size, good_size);
+        allocator->usable_blocks.remove(*block);
+        --allocator->block_count;
+        keep_empty_block(block);
+    }
+}
+
 enum class CallerWillInitializeMemory {
     No,
     Yes,
@@ -291,6 +473,264 @@ enum class CallerWillInitializeMemory {
 
 #ifndef NO_TLS
 __thread bool s_allocation_enabled = true;
+
+// Every thread keeps a few free chunks of the smaller size classes to itself, so most calls to malloc()
+// and free() never have to take the malloc lock. A thread cache is refilled from the shared allocator,
+// and drained back into it, a batch of chunks at a time.
+//
+// Chunks don't belong to any particular thread, so a chunk freed by another thread than the one that
+// allocated it simply ends up in the freeing thread's cache. When a cache overflows, the batch it gives up
+// is pushed onto a lock-free list for its size class first, where any thread that runs out of chunks
+// can pick it up without going through the shared allocator. Only when those lists are full as well
+// do chunks go back into their blocks under the malloc lock.
+static constexpr size_t max_thread_cached_chunk_size = 4 * KiB;
+static constexpr size_t thread_cache_bytes_per_size_class = 8 * KiB;
+static constexpr size_t number_of_cached_size_classes = [] {
+    size_t count = 0;
+    while (size_classes[count] && size_classes[count] <= max_thread_cached_chunk_size)
+        ++count;
+    return count;
+}();
+static constexpr size_t max_remote_batches_per_size_class = 16;
+
+static constexpr size_t thread_cache_limit(size_t size_class_index)
+{
+    return clamp<size_t>(thread_cache_bytes_per_size_class / size_classes[size_class_index], 4, 32);
+}
+
+static constexpr size_t thread_cache_batch_size(size_t size_class_index)
+{
+    return thread_cache_limit(size_class_index) / 2;
+}
+
+struct ThreadCacheStats {
+    size_t number_of_malloc_calls;
+    size_t number_of_cache_hits;
+    size_t number_of_refills;
+    size_t number_of_remote_batch_refills;
+
+    size_t number_of_free_calls;
+    size_t number_of_drains;
+    size_t number_of_remote_batch_drains;
+};
+
+struct ThreadCache {
+    struct Bin {
+        FreelistEntry* chunks { nullptr };
+        size_t count { 0 };
+    };
+
+    pid_t tid { 0 };
+    Bin bins[number_of_cached_size_classes];
+    ThreadCacheStats stats {};
+
+    IntrusiveListNode<ThreadCache> list_node;
+    using List = IntrusiveList<&ThreadCache::list_node>;
+};
+
+// A batch of chunks that a thread cache had no room for. The chunks of a batch are linked through their
+// freelist entries, and the first chunk of each batch also links to the next batch.
+struct RemoteBatch {
+    FreelistEntry entry;
+    RemoteBatch* next_batch;
+};
+static_assert(sizeof(RemoteBatch) <= size_classes[0]);
+
+struct RemoteFreeList {
+    Atomic<RemoteBatch*> batches { nullptr };
+    Atomic<size_t> batch_count { 0 };
+};
+
+static RemoteFreeList s_remote_free_lists[number_of_cached_size_classes];
+
+// Like the allocators, the list of thread caches is initialized in __malloc_init.
+alignas(ThreadCache::List) static u8 g_thread_caches_storage[sizeof(ThreadCache::List)];
+static ThreadCacheStats g_exited_thread_cache_stats = {};
+static size_t s_exited_thread_cache_count { 0 };
+
+static inline ThreadCache::List& thread_caches()
+{
+    return reinterpret_cast<ThreadCache::List&>(g_thread_caches_storage);
+}
+
+static bool s_use_thread_caches = true;
+static __thread ThreadCache* s_thread_cache;
+static __thread bool s_thread_cache_torn_down;
+
+static ThreadCache* thread_cache()
+{
+    if (s_thread_cache) [[likely]]
+        return s_thread_cache;
+    if (!s_use_thread_caches || s_thread_cache_torn_down)
+        return nullptr;
+
+    auto* memory = serenity_mmap(nullptr, PAGE_ROUND_UP(sizeof(ThreadCache)), PROT_READ | PROT_WRITE, MAP_ANONYMOUS | MAP_PRIVATE, 0, 0, PAGE_SIZE, "malloc: ThreadCache");
+    if (memory == MAP_FAILED) {
+        // We'll just have to make do with the shared allocator.
+        s_thread_cache_torn_down = true;
+        return nullptr;
+    }
+
+    auto* cache = new (memory) ThreadCache;
+    cache->tid = gettid();
+    {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        thread_caches().append(*cache);
+    }
+    s_thread_cache = cache;
+    return cache;
+}
+
+static Optional<size_t> cached_size_class_index(size_t size)
+{
+    for (size_t i = 0; i < number_of_cached_size_classes; ++i) {
+        if (size <= size_classes[i])
+            return i;
+    }
+    return {};
+}
+
+static void push_remote_batch(RemoteFreeList& list, RemoteBatch* first, RemoteBatch* last)
+{
+    last->next_batch = list.batches.load(AK::memory_order_relaxed);
+    while (!list.batches.compare_exchange_strong(last->next_batch, first, AK::memory_order_acq_rel))
+        ;
+}
+
+static RemoteBatch* take_remote_batch(RemoteFreeList& list)
+{
+    if (!list.batches.load(AK::memory_order_relaxed))
+        return nullptr;
+
+    // Popping a single batch off the list could fall prey to the ABA problem, so we take all of them and
+    // put back the ones we don't need. Nobody else can see these batches in the meantime.
+    auto* batches = list.batches.exchange(nullptr, AK::memory_order_acquire);
+    if (!batches)
+        return nullptr;
+    list.batch_count.fetch_sub(1, AK::memory_order_relaxed);
+
+    if (auto* rest = batches->next_batch) {
+        auto* last = rest;
+        while (last->next_batch)
+            last = last->next_batch;
+        push_remote_batch(list, rest, last);
+    }
+    batches->next_batch = nullptr;
+    return batches;
+}
+
+static bool refill_thread_cache(ThreadCache& cache, size_t size_class_index)
+{
+    auto& bin = cache.bins[size_class_index];
+    VERIFY(bin.count == 0);
+    auto batch_size = thread_cache_batch_size(size_class_index);
+
+    if (auto* batch = take_remote_batch(s_remote_free_lists[size_class_index])) {
+        cache.stats.number_of_remote_batch_refills++;
+        bin.chunks = &batch->entry;
+        bin.count = batch_size;
+        return true;
+    }
+
+    cache.stats.number_of_refills++;
+    PthreadMutexLocker locker(s_malloc_mutex);
+    auto& allocator = allocators()[size_class_index];
+    for (size_t i = 0; i < batch_size; ++i) {
+        auto ptr_or_error = allocate_chunk(allocator, size_classes[size_class_index], 16);
+        if (ptr_or_error.is_error())
+            break;
+        auto* entry = (FreelistEntry*)ptr_or_error.value();
+        entry->next = bin.chunks;
+        bin.chunks = entry;
+        ++bin.count;
+    }
+    return bin.count > 0;
+}
+
+// Must be called with the malloc lock held.
+static void return_chunks_to_blocks(FreelistEntry* chunks)
+{
+    while (chunks) {
+        auto* next = chunks->next;
+        free_chunk((ChunkedBlock*)((FlatPtr)chunks & ChunkedBlock::block_mask), chunks);
+        chunks = next;
+    }
+}
+
+static void drain_thread_cache(ThreadCache& cache, size_t size_class_index)
+{
+    auto& bin = cache.bins[size_class_index];
+    auto batch_size = thread_cache_batch_size(size_class_index);
+    VERIFY(bin.count >= batch_size);
+
+    auto* first = bin.chunks;
+    auto* last = first;
+    for (size_t i = 1; i < batch_size; ++i)
+        last = last->next;
+    bin.chunks = last->next;
+    bin.count -= batch_size;
+    last->next = nullptr;
+
+    auto& remote_list = s_remote_free_lists[size_class_index];
+    if (remote_list.batch_count.fetch_add(1, AK::memory_order_relaxed) < max_remote_batches_per_size_class) {
+        cache.stats.number_of_remote_batch_drains++;
+        auto* batch = (RemoteBatch*)first;
+        push_remote_batch(remote_list, batch, batch);
+        return;
+    }
+    remote_list.batch_count.fetch_sub(1, AK::memory_order_relaxed);
+
+    cache.stats.number_of_drains++;
+    PthreadMutexLocker locker(s_malloc_mutex);
+    return_chunks_to_blocks(first);
+}
+
+static void* allocate_from_thread_cache(ThreadCache& cache, size_t size_class_index)
+{
+    auto& bin = cache.bins[size_class_index];
+    cache.stats.number_of_malloc_calls++;
+    if (bin.chunks)
+        cache.stats.number_of_cache_hits++;
+    else if (!refill_thread_cache(cache, size_class_index))
+        return nullptr;
+
+    auto* entry = bin.chunks;
+    bin.chunks = entry->next;
+    --bin.count;
+    return entry;
+}
+
+static void free_to_thread_cache(ThreadCache& cache, size_t size_class_index, void* ptr)
+{
+    auto& bin = cache.bins[size_class_index];
+    cache.stats.number_of_free_calls++;
+    if (bin.count >= thread_cache_limit(size_class_index))
+        drain_thread_cache(cache, size_class_index);
+
+    auto* entry = (FreelistEntry*)ptr;
+    entry->next = bin.chunks;
+    bin.chunks = entry;
+    ++bin.count;
+}
+
+static void add_thread_cache_stats(ThreadCacheStats& total, ThreadCacheStats const& stats)
+{
+    total.number_of_malloc_calls += stats.number_of_malloc_calls;
+    total.number_of_cache_hits += stats.number_of_cache_hits;
+    total.number_of_refills += stats.number_of_refills;
+    total.number_of_remote_batch_refills += stats.number_of_remote_batch_refills;
+    total.number_of_free_calls += stats.number_of_free_calls;
+    total.number_of_drains += stats.number_of_drains;
+    total.number_of_remote_batch_drains += stats.number_of_remote_batch_drains;
+}
+
+static void dump_thread_cache_stats(ThreadCacheStats const& stats)
+{
+    dbgln("    malloc() calls: {} ({} cache hits, {} refills, {} batches from other threads)",
+        stats.number_of_malloc_calls, stats.number_of_cache_hits, stats.number_of_refills, stats.number_of_remote_batch_refills);
+    dbgln("    free() calls: {} ({} drains, {} batches to other threads)",
+        stats.number_of_free_calls, stats.number_of_drains, stats.number_of_remote_batch_drains);
+}
 #endif
 
 static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializeMemory caller_will_initialize_memory)
@@ -316,6 +756,22 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
         size = 1;
     }
 
+#ifndef NO_TLS
+    // Every chunk is 16-byte aligned, so the thread cache can handle anything that doesn't ask for more.
+    if (align <= 16) {
+        if (auto size_class_index = cached_size_class_index(size); size_class_index.has_value()) {
+            if (auto* cache = thread_cache()) {
+                if (auto* ptr = allocate_from_thread_cache(*cache, size_class_index.value())) {
+                    if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
+                        memset(ptr, MALLOC_SCRUB_BYTE, size_classes[size_class_index.value()]);
+                    ue_notify_malloc(ptr, size);
+                    return ptr;
+                }
+            }
+        }
+    }
+#endif
+
     g_malloc_stats.number_of_malloc_calls++;
 
     size_t good_size;
@@ -349,6 +805,9 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
                     new (block) BigAllocationBlock(real_size);
                 }
 
+                ++s_big_allocation_count;
+                s_big_allocation_bytes += real_size;
+
                 void* ptr = reinterpret_cast<void*>(round_up_to_power_of_two(reinterpret_cast<uintptr_t>(&block->m_slot[0]), align));
 
                 ue_notify_malloc(ptr, size);
@@ -359,85 +818,18 @@ static ErrorOr<void*> malloc_impl(size_t size, size_t align, CallerWillInitializ
         auto* block = (BigAllocationBlock*)TRY(os_alloc(real_size, "malloc: BigAllocationBlock"));
         g_malloc_stats.number_of_big_allocs++;
         new (block) BigAllocationBlock(real_size);
+        ++s_big_allocation_count;
+        s_big_allocation_bytes += real_size;
 
         void* ptr = reinterpret_cast<void*>(round_up_to_power_of_two(reinterpret_cast<uintptr_t>(&block->m_slot[0]), align));
         ue_notify_malloc(ptr, size);
         return ptr;
     }
 
-    ChunkedBlock* block = nullptr;
-    void* ptr = nullptr;
-    for (auto& current : allocator->usable_blocks) {
-        if (current.free_chunks()) {
-            ptr = try_allocate_chunk_aligned(align, current);
-            if (ptr) {
-                block = &current;
-                break;
-            }
-        }
-    }
-
-    if (!block && s_hot_empty_block_count) {
-        g_malloc_stats.number_of_hot_empty_block_hits++;
-        block = s_hot_empty_blocks[--s_hot_empty_block_count];
-        if (block->m_size != good_size) {
-            new (block) ChunkedBlock(good_size);
-            ue_notify_chunk_size_changed(block, good_size);
-            char buffer[64];
-            snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-            set_mmap_name(block, ChunkedBlock::block_size, buffer);
-        }
-        allocator->usable_blocks.append(*block);
-    }
-
-    if (!block && s_cold_empty_block_count) {
-        g_malloc_stats.number_of_cold_empty_block_hits++;
-        block = s_cold_empty_blocks[--s_cold_empty_block_count];
-        int rc = madvise(block, ChunkedBlock::block_size, MADV_SET_NONVOLATILE);
-        bool this_block_was_purged = rc == 1;
-        if (rc < 0) {
-            perror("madvise");
-            VERIFY_NOT_REACHED();
-        }
-        rc = mprotect(block, ChunkedBlock::block_size, PROT_READ | PROT_WRITE);
-        if (rc < 0) {
-            perror("mprotect");
-            VERIFY_NOT_REACHED();
-        }
-        if (this_block_was_purged || block->m_size != good_size) {
-            if (this_block_was_purged)
-                g_malloc_stats.number_of_cold_empty_block_purge_hits++;
-            new (block) ChunkedBlock(good_size);
-            ue_notify_chunk_size_changed(block, good_size);
-        }
-        allocator->usable_blocks.append(*block);
-    }
-
-    if (!block) {
-        g_malloc_stats.number_of_block_allocs++;
-        char buffer[64];
-        snprintf(buffer, sizeof(buffer), "malloc: ChunkedBlock(%zu)", good_size);
-        block = (ChunkedBlock*)TRY(os_alloc(ChunkedBlock::block_size, buffer));
-        new (block) ChunkedBlock(good_size);
-        allocator->usable_blocks.append(*block);
-        ++allocator->block_count;
-    }
-
-    if (!ptr) {
-        ptr = try_allocate_chunk_aligned(align, *block);
-    }
-
-    VERIFY(ptr);
-    if (block->is_full()) {
-        g_malloc_stats.number_of_blocks_full++;
-        dbgln_if(MALLOC_DEBUG, "Block {:p} is now full in size class {}", block, good_size);
-        allocator->usable_blocks.remove(*block);
-        allocator->full_blocks.append(*block);
-    }
-    dbgln_if(MALLOC_DEBUG, "LibC: allocated {:p} (chunk in block {:p}, size {})", ptr, block, block->bytes_per_chunk());
+    auto* ptr = TRY(allocate_chunk(*allocator, good_size, align));
 
     if (s_scrub_malloc && caller_will_initialize_memory == CallerWillInitializeMemory::No)
-        memset(ptr, MALLOC_SCRUB_BYTE, block->m_size);
+        memset(ptr, MALLOC_SCRUB_BYTE, good_size);
 
     ue_notify_malloc(ptr, size);
     return ptr;
@@ -454,15 +846,32 @@ static void free_impl(void* ptr)
     if (!ptr)
         return;
 
-    g_malloc_stats.number_of_free_calls++;
-
     void* block_base = (void*)((FlatPtr)ptr & ChunkedBlock::ChunkedBlock::block_mask);
     size_t magic = *(size_t*)block_base;
 
+#ifndef NO_TLS
+    if (magic == MAGIC_PAGE_HEADER) {
+        // The block can't go anywhere while we own one of its chunks, so its size is safe to look at.
+        auto* block = (ChunkedBlock*)block_base;
+        if (auto size_class_index = cached_size_class_index(block->m_size); size_class_index.has_value()) {
+            if (auto* cache = thread_cache()) {
+                if (s_scrub_free)
+                    memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
+                free_to_thread_cache(*cache, size_class_index.value(), ptr);
+                return;
+            }
+        }
+    }
+#endif
+
+    g_malloc_stats.number_of_free_calls++;
+
     PthreadMutexLocker locker(s_malloc_mutex);
 
     if (magic == MAGIC_BIGALLOC_HEADER) {
         auto* block = (BigAllocationBlock*)block_base;
+        --s_big_allocation_count;
+        s_big_allocation_bytes -= block->m_size;
 #ifdef RECYCLE_BIG_ALLOCATIONS
         if (auto* allocator = big_allocator_for_size(block->m_size)) {
             if (allocator->blocks.size() < number_of_big_blocks_to_keep_around_per_size_class) {
@@ -494,46 +903,7 @@ static void free_impl(void* ptr)
     if (s_scrub_free)
         memset(ptr, FREE_SCRUB_BYTE, block->bytes_per_chunk());
 
-    auto* entry = (FreelistEntry*)ptr;
-    entry->next = block->m_freelist;
-    block->m_freelist = entry;
-
-    if (block->is_full()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        dbgln_if(MALLOC_DEBUG, "Block {:p} no longer full in size class {}", block, good_size);
-        g_malloc_stats.number_of_freed_full_blocks++;
-        allocator->full_blocks.remove(*block);
-        allocator->usable_blocks.prepend(*block);
-    }
-
-    ++block->m_free_chunks;
-
-    if (!block->used_chunks()) {
-        size_t good_size;
-        auto* allocator = allocator_for_size(block->m_size, good_size);
-        if (s_hot_empty_block_count < number_of_hot_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping hot block {:p} around", block);
-            g_malloc_stats.number_of_hot_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_hot_empty_blocks[s_hot_empty_block_count++] = block;
-            return;
-        }
-        if (s_cold_empty_block_count < number_of_cold_chunked_blocks_to_keep_around) {
-            dbgln_if(MALLOC_DEBUG, "Keeping cold block {:p} around", block);
-            g_malloc_stats.number_of_cold_keeps++;
-            allocator->usable_blocks.remove(*block);
-            s_cold_empty_blocks[s_cold_empty_block_count++] = block;
-            mprotect(block, ChunkedBlock::block_size, PROT_NONE);
-            madvise(block, ChunkedBlock::block_size, MADV_SET_VOLATILE);
-            return;
-        }
-        dbgln_if(MALLOC_DEBUG, "Releasing block {:p} for size class {}", block, good_size);
-        g_malloc_stats.number_of_frees++;
-        allocator->usable_blocks.remove(*block);
-        --allocator->block_count;
-        os_free(block, ChunkedBlock::block_size);
-    }
+    free_chunk(block, ptr);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/malloc.html
@@ -673,6 +1043,11 @@ void __malloc_init()
         s_log_malloc = true;
     if (secure_getenv("LIBC_PROFILE_MALLOC"))
         s_profiling = true;
+#ifndef NO_TLS
+    // UE tracks every chunk by itself, so let it see each one go back into its block right away.
+    if (s_in_userspace_emulator || secure_getenv("LIBC_NO_MALLOC_THREAD_CACHE"))
+        s_use_thread_caches = false;
+#endif
 
     for (size_t i = 0; i < num_size_classes; ++i) {
         new (&allocators()[i]) Allocator();
@@ -680,6 +1055,90 @@ void __malloc_init()
     }
 
     new (&big_allocators()[0])(BigAllocator);
+
+#ifndef NO_TLS
+    new (&thread_caches()) ThreadCache::List();
+#endif
+}
+
+void __malloc_thread_exit()
+{
+#ifndef NO_TLS
+    // Anything freed from here on (e.g. by TLS destructors) goes straight back to the shared allocator.
+    auto* cache = s_thread_cache;
+    s_thread_cache = nullptr;
+    s_thread_cache_torn_down = true;
+    if (!cache)
+        return;
+
+    {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        for (auto& bin : cache->bins)
+            return_chunks_to_blocks(bin.chunks);
+        add_thread_cache_stats(g_exited_thread_cache_stats, cache->stats);
+        ++s_exited_thread_cache_count;
+        thread_caches().remove(*cache);
+    }
+    munmap(cache, PAGE_ROUND_UP(sizeof(ThreadCache)));
+#endif
+}
+
+int serenity_get_malloc_info(serenity_malloc_info* info, serenity_malloc_size_class_info* size_class_infos, size_t size_class_count)
+{
+    if (!info || (!size_class_infos && size_class_count)) {
+        errno = EINVAL;
+        return -1;
+    }
+
+    MemoryAuditingSuppressor suppressor;
+    PthreadMutexLocker locker(s_malloc_mutex);
+
+    *info = {};
+    info->size_class_count = num_size_classes;
+    info->block_size = ChunkedBlock::block_size;
+    info->hot_empty_block_count = s_hot_empty_block_count;
+    info->cold_empty_block_count = s_cold_empty_block_count;
+    info->big_allocation_count = s_big_allocation_count;
+    info->big_allocation_bytes = s_big_allocation_bytes;
+    info->recycled_big_block_count = big_allocators()[0].blocks.size();
+#ifndef NO_TLS
+    info->thread_cache_count = thread_caches().size_slow();
+#endif
+
+    for (size_t i = 0; i < num_size_classes; ++i) {
+        auto& allocator = allocators()[i];
+        info->chunked_block_count += allocator.block_count;
+        if (i >= size_class_count)
+            continue;
+
+        serenity_malloc_size_class_info class_info {};
+        class_info.chunk_size = size_classes[i];
+        class_info.block_count = allocator.block_count;
+        size_t used_chunks = 0;
+        auto count_block = [&](ChunkedBlock const& block) {
+            class_info.chunk_capacity += block.chunk_capacity();
+            used_chunks += block.used_chunks();
+        };
+        for (auto& block : allocator.usable_blocks)
+            count_block(block);
+        for (auto& block : allocator.full_blocks)
+            count_block(block);
+
+#ifndef NO_TLS
+        // NOTE: Other threads keep changing their caches as we go, so this is only an estimate.
+        if (i < number_of_cached_size_classes) {
+            for (auto& cache : thread_caches())
+                class_info.chunks_cached += cache.bins[i].count;
+            class_info.chunks_in_remote_batches = min(s_remote_free_lists[i].batch_count.load(AK::memory_order_relaxed), max_remote_batches_per_size_class) * thread_cache_batch_size(i);
+            class_info.chunks_cached += class_info.chunks_in_remote_batches;
+            class_info.chunks_cached = min(class_info.chunks_cached, used_chunks);
+            class_info.chunks_in_remote_batches = min(class_info.chunks_in_remote_batches, class_info.chunks_cached);
+        }
+#endif
+        class_info.chunks_in_use = used_chunks - class_info.chunks_cached;
+        size_class_infos[i] = class_info;
+    }
+    return 0;
 }
 
 void serenity_dump_malloc_stats()
@@ -704,6 +1163,60 @@ void serenity_dump_malloc_stats()
     dbgln("full block frees: {}", g_malloc_stats.number_of_freed_full_blocks);
     dbgln("number of hot keeps: {}", g_malloc_stats.number_of_hot_keeps);
     dbgln("number of cold keeps: {}", g_malloc_stats.number_of_cold_keeps);
+    dbgln("number of hot blocks that went cold: {}", g_malloc_stats.number_of_decayed_hot_blocks);
     dbgln("number of frees: {}", g_malloc_stats.number_of_frees);
+
+    serenity_malloc_info info;
+    serenity_malloc_size_class_info size_class_infos[num_size_classes];
+    if (serenity_get_malloc_info(&info, size_class_infos, num_size_classes) == 0) {
+        dbgln();
+        dbgln("chunked blocks: {} in use, {} hot, {} cold", info.chunked_block_count, info.hot_empty_block_count, info.cold_empty_block_count);
+        dbgln("big allocations: {} ({} bytes), {} recycled blocks", info.big_allocation_count, info.big_allocation_bytes, info.recycled_big_block_count);
+        for (auto& size_class_info : size_class_infos) {
+            if (!size_class_info.block_count)
+                continue;
+            auto free_chunks = size_class_info.chunk_capacity - size_class_info.chunks_in_use - size_class_info.chunks_cached;
+            dbgln("size class {}: {} blocks, {}/{} chunks in use, {} cached, {}% free",
+                size_class_info.chunk_size, size_class_info.block_count, size_class_info.chunks_in_use, size_class_info.chunk_capacity,
+                size_class_info.chunks_cached, free_chunks * 100 / size_class_info.chunk_capacity);
+        }
+    }
+#ifndef NO_TLS
+    if (!s_use_thread_caches)
+        return;
+    dbgln();
+
+    // Printing allocates, so we take a snapshot of the numbers first and print them after letting go of the lock.
+    // NOTE: Other threads may still be busy, so their numbers are only a rough snapshot anyway.
+    constexpr size_t max_threads_to_dump = 64;
+    pid_t tids[max_threads_to_dump];
+    ThreadCacheStats stats[max_threads_to_dump];
+    size_t live_thread_count = 0;
+    ThreadCacheStats total;
+    {
+        PthreadMutexLocker locker(s_malloc_mutex);
+        total = g_exited_thread_cache_stats;
+        for (auto& cache : thread_caches()) {
+            if (live_thread_count < max_threads_to_dump) {
+                tids[live_thread_count] = cache.tid;
+                stats[live_thread_count] = cache.stats;
+            }
+            ++live_thread_count;
+            add_thread_cache_stats(total, cache.stats);
+        }
+    }
+
+    dbgln("# thread caches: {} live, {} exited", live_thread_count, s_exited_thread_cache_count);
+    for (size_t i = 0; i < min(live_thread_count, max_threads_to_dump); ++i) {
+        dbgln("thread {}:", tids[i]);
+        dump_thread_cache_stats(stats[i]);
+    }
+    if (s_exited_thread_cache_count) {
+        dbgln("exited threads:");
+        dump_thread_cache_stats(g_exited_thread_cache_stats);
+    }
+    dbgln("all threads:");
+    dump_thread_cache_stats(total);
+#endif
 }
 }
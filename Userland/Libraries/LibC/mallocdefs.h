@@ -16,7 +16,16 @@
 
 #define PAGE_ROUND_UP(x) ((((size_t)(x)) + PAGE_SIZE - 1) & (~(PAGE_SIZE - 1)))
 
-static constexpr unsigned short size_classes[] = { 16, 32, 64, 128, 256, 496, 1008, 2032, 4080, 8176, 16368, 32752, 0 };
+// Size classes are spaced a quarter of a power of two apart, so an allocation never wastes more than
+// about a fifth of its chunk. Each class is stretched to the largest multiple of 16 that still fits
+// the same number of chunks into a ChunkedBlock, so the end of a block isn't wasted either.
+static constexpr unsigned short size_classes[] = {
+    16, 32, 48, 64, 80, 96, 112, 128,
+    160, 192, 224, 256, 320, 384, 448, 512,
+    640, 768, 896, 1024, 1280, 1552, 1808, 2112,
+    2608, 3104, 3632, 4352, 5456, 6544, 7264, 9344,
+    10912, 13088, 16368, 21824, 32736, 0
+};
 static constexpr size_t num_size_classes = (sizeof(size_classes) / sizeof(unsigned short)) - 1;
 
 #ifndef NO_TLS
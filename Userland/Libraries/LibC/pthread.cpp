@@ -17,10 +17,12 @@
 #include <limits.h>
 #include <mallocdefs.h>
 #include <pthread.h>
+#include <sched.h>
 #include <serenity.h>
 #include <signal.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/internals.h>
 #include <sys/mman.h>
 #include <sys/prctl.h>
 #include <syscall.h>
@@ -58,6 +60,7 @@ extern "C" {
 [[noreturn]] static void exit_thread(void* code, void* stack_location, size_t stack_size)
 {
     __pthread_key_destroy_for_current_thread();
+    __malloc_thread_exit();
     syscall(SC_exit_thread, code, stack_location, stack_size);
     VERIFY_NOT_REACHED();
 }
@@ -649,8 +652,6 @@ int pthread_equal(pthread_t t1, pthread_t t2)
     return t1 == t2;
 }
 
-// FIXME: Use the fancy futex mechanism above to write an rw lock.
-//        For the time being, let's just use a less-than-good lock to get things working.
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_destroy.html
 int pthread_rwlock_destroy(pthread_rwlock_t* rl)
 {
@@ -659,18 +660,32 @@ int pthread_rwlock_destroy(pthread_rwlock_t* rl)
     return 0;
 }
 
-// In a very non-straightforward way, this value is composed of two 32-bit integers
-// the top 32 bits are reserved for the ID of write-locking thread (if any)
-// and the bottom 32 bits are:
-//     top 2 bits (30,31): reader wake mask, writer wake mask
-//     middle 16 bits: information
-//        bit 16: someone is waiting to write
-//        bit 17: locked for write
-//     bottom 16 bits (0..15): reader count
-constexpr static u32 reader_wake_mask = 1 << 30;
-constexpr static u32 writer_wake_mask = 1 << 31;
-constexpr static u32 writer_locked_mask = 1 << 17;
-constexpr static u32 writer_intent_mask = 1 << 16;
+// The lower 32 bits of a pthread_rwlock_t are the state of the lock, which is also what waiting threads sleep on.
+// The upper 32 bits hold the ID of the thread that has locked it for writing, if any.
+//     bits 0..17:  number of readers holding the lock
+//     bits 18..29: number of writers waiting for the lock
+//     bit 30:      locked for writing
+//     bit 31:      readers are asleep, waiting for the writers to be done
+// Writers are preferred: as long as any writer is waiting, no new readers get the lock.
+static constexpr u32 rwlock_reader_count_mask = (1u << 18) - 1;
+static constexpr u32 rwlock_waiting_writer = 1u << 18;
+static constexpr u32 rwlock_waiting_writer_count_mask = ((1u << 12) - 1) << 18;
+static constexpr u32 rwlock_write_locked = 1u << 30;
+static constexpr u32 rwlock_readers_waiting = 1u << 31;
+
+static constexpr u32 rwlock_reader_wake_bitset = 1;
+static constexpr u32 rwlock_writer_wake_bitset = 2;
+
+static u32* rwlock_state(pthread_rwlock_t* lockp)
+{
+    return reinterpret_cast<u32*>(lockp);
+}
+
+static pthread_t* rwlock_writer(pthread_rwlock_t* lockp)
+{
+    return reinterpret_cast<pthread_t*>(lockp) + 1;
+}
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_init.html
 int pthread_rwlock_init(pthread_rwlock_t* __restrict lockp, pthread_rwlockattr_t const* __restrict attr)
 {
@@ -682,100 +697,145 @@ int pthread_rwlock_init(pthread_rwlock_t* __restrict lockp, pthread_rwlockattr_t
     return 0;
 }
 
-// Note that this function does not care about the top 32 bits at all.
-static int rwlock_rdlock_maybe_timed(u32* lockp, const struct timespec* timeout = nullptr, bool only_once = false, int value_if_timeout = -1, int value_if_okay = -2)
-{
-    auto current = AK::atomic_load(lockp);
-    for (; !only_once;) {
-        // First, see if this is locked for writing
-        // if it's not, try to add to the counter.
-        // If someone is waiting to write, and there is one or no other readers, let them have the lock.
-        if (!(current & writer_locked_mask)) {
-            auto count = (u16)current;
-            if (!(current & writer_intent_mask) || count > 1) {
-                ++count;
-                auto desired = (current & 0xffff0000u) | count;
-                auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-                if (!did_exchange)
-                    continue; // tough luck, try again.
-                return value_if_okay;
-            }
-        }
+static int rwlock_wait(u32* state, u32 expected_state, u32 wake_bitset, const struct timespec* abstime)
+{
+    int saved_errno = errno;
+    int rc = futex(state, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG | (abstime ? FUTEX_CLOCK_REALTIME : 0), expected_state, abstime, nullptr, wake_bitset);
+    bool did_time_out = rc < 0 && errno == ETIMEDOUT;
+    errno = saved_errno;
+    return did_time_out ? ETIMEDOUT : 0;
+}
 
-        // If no one else is waiting for the read wake bit, set it.
-        if (!(current & reader_wake_mask)) {
-            auto desired = current | reader_wake_mask;
-            auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-            if (!did_exchange)
-                continue; // Something interesting happened!
+static void rwlock_wake(u32* state, u32 count, u32 wake_bitset)
+{
+    int saved_errno = errno;
+    futex(state, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, count, nullptr, nullptr, wake_bitset);
+    errno = saved_errno;
+}
 
-            current = desired;
+// Like the spinning in pthread_mutex_lock(), but a lock held by readers doesn't tell us whether they are running,
+// so we only spin on those when we want to write.
+static u32 rwlock_spin(pthread_rwlock_t* lockp, u32 current, bool for_writing)
+{
+    auto* state = rwlock_state(lockp);
+    for (size_t i = 0; i < __PTHREAD_MAX_SPIN_COUNT; ++i) {
+        if (!(current & rwlock_write_locked)) {
+            if (!for_writing || !(current & rwlock_reader_count_mask))
+                break;
+        } else if (i % __PTHREAD_SPINS_BETWEEN_OWNER_CHECKS == 0) {
+            pthread_t writer = AK::atomic_load(rwlock_writer(lockp), AK::memory_order_relaxed);
+            if (writer != 0 && !__pthread_is_running_on_processor_np(writer))
+                break;
         }
+        __pthread_spin_pause();
+        current = AK::atomic_load(state, AK::memory_order_relaxed);
+    }
+    return current;
+}
+
+static int rwlock_rdlock(pthread_rwlock_t* lockp, const struct timespec* abstime, bool only_once)
+{
+    auto* state = rwlock_state(lockp);
+    auto current = AK::atomic_load(state, AK::memory_order_relaxed);
+    bool did_spin = false;
+    for (;;) {
+        if (!(current & (rwlock_write_locked | rwlock_waiting_writer_count_mask))) {
+            if ((current & rwlock_reader_count_mask) == rwlock_reader_count_mask)
+                return EAGAIN;
+            if (AK::atomic_compare_exchange_strong(state, current, current + 1, AK::memory_order_acquire))
+                return 0;
+            continue;
+        }
+
+        if (only_once)
+            return EBUSY;
 
-        // Seems like someone is writing (or is interested in writing and we let them have the lock)
-        // wait until they're done.
-        auto rc = futex(lockp, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, current, timeout, nullptr, reader_wake_mask);
-        if (rc < 0 && errno == ETIMEDOUT && timeout) {
-            return value_if_timeout;
+        // Writers that are merely waiting could take a long time, but one that holds the lock is likely to be done soon.
+        if (!did_spin && !(current & rwlock_waiting_writer_count_mask)) {
+            did_spin = true;
+            current = rwlock_spin(lockp, current, false);
+            continue;
         }
-        if (rc < 0 && errno != EAGAIN) {
-            // Something broke. let's just bail out.
-            return errno;
+
+        if (!(current & rwlock_readers_waiting)) {
+            if (!AK::atomic_compare_exchange_strong(state, current, current | rwlock_readers_waiting, AK::memory_order_relaxed))
+                continue;
+            current |= rwlock_readers_waiting;
         }
-        errno = 0;
-        // Reload the 'current' value
-        current = AK::atomic_load(lockp);
+
+        if (auto rc = rwlock_wait(state, current, rwlock_reader_wake_bitset, abstime); rc != 0)
+            return rc;
+        current = AK::atomic_load(state, AK::memory_order_relaxed);
     }
-    return value_if_timeout;
-}
-
-static int rwlock_wrlock_maybe_timed(pthread_rwlock_t* lockval_p, const struct timespec* timeout = nullptr, bool only_once = false, int value_if_timeout = -1, int value_if_okay = -2)
-{
-    u32* lockp = reinterpret_cast<u32*>(lockval_p);
-    auto current = AK::atomic_load(lockp);
-    for (; !only_once;) {
-        // First, see if this is locked for writing, and if there are any readers.
-        // if not, lock it.
-        // If someone is waiting to write, let them have the lock.
-        if (!(current & writer_locked_mask) && ((u16)current) == 0) {
-            if (!(current & writer_intent_mask)) {
-                auto desired = current | writer_locked_mask | writer_intent_mask;
-                auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-                if (!did_exchange)
-                    continue;
-
-                // Now that we've locked the value, it's safe to set our thread ID.
-                AK::atomic_store(reinterpret_cast<i32*>(lockval_p) + 1, pthread_self());
-                return value_if_okay;
-            }
+}
+
+static void rwlock_stop_waiting_to_write(u32* state)
+{
+    auto current = AK::atomic_load(state, AK::memory_order_relaxed);
+    u32 desired;
+    do {
+        desired = current - rwlock_waiting_writer;
+        if (!(desired & (rwlock_waiting_writer_count_mask | rwlock_write_locked)))
+            desired &= ~rwlock_readers_waiting;
+    } while (!AK::atomic_compare_exchange_strong(state, current, desired, AK::memory_order_relaxed));
+
+    // We may have been woken up right as we gave up, so make sure that whoever is next in line gets to go.
+    if (desired & rwlock_waiting_writer_count_mask) {
+        if (!(desired & (rwlock_write_locked | rwlock_reader_count_mask)))
+            rwlock_wake(state, 1, rwlock_writer_wake_bitset);
+    } else if ((current & rwlock_readers_waiting) && !(desired & rwlock_readers_waiting)) {
+        rwlock_wake(state, INT_MAX, rwlock_reader_wake_bitset);
+    }
+}
+
+static int rwlock_wrlock(pthread_rwlock_t* lockp, const struct timespec* abstime, bool only_once)
+{
+    auto* state = rwlock_state(lockp);
+    auto current = AK::atomic_load(state, AK::memory_order_relaxed);
+    bool is_waiting = false;
+    bool did_spin = false;
+    for (;;) {
+        if (!(current & (rwlock_write_locked | rwlock_reader_count_mask))) {
+            auto desired = current | rwlock_write_locked;
+            if (is_waiting)
+                desired -= rwlock_waiting_writer;
+            if (!AK::atomic_compare_exchange_strong(state, current, desired, AK::memory_order_acquire))
+                continue;
+
+            // Now that we've locked the value, it's safe to set our thread ID.
+            AK::atomic_store(rwlock_writer(lockp), pthread_self(), AK::memory_order_relaxed);
+            return 0;
         }
 
-        // That didn't work, if no one else is waiting for the write bit, set it.
-        if (!(current & writer_wake_mask)) {
-            auto desired = current | writer_wake_mask | writer_intent_mask;
-            auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_acquire);
-            if (!did_exchange)
-                continue; // Something interesting happened!
+        if (only_once)
+            return EBUSY;
 
-            current = desired;
+        if (!did_spin) {
+            did_spin = true;
+            current = rwlock_spin(lockp, current, true);
+            continue;
         }
 
-        // Seems like someone is writing (or is interested in writing and we let them have the lock)
-        // wait until they're done.
-        auto rc = futex(lockp, FUTEX_WAIT_BITSET | FUTEX_PRIVATE_FLAG, current, timeout, nullptr, writer_wake_mask);
-        if (rc < 0 && errno == ETIMEDOUT && timeout) {
-            return value_if_timeout;
+        // Register as a waiting writer, which keeps new readers out.
+        if (!is_waiting) {
+            if ((current & rwlock_waiting_writer_count_mask) == rwlock_waiting_writer_count_mask) {
+                // Too many writers are waiting to count one more, but one of them will be done eventually.
+                sched_yield();
+                current = AK::atomic_load(state, AK::memory_order_relaxed);
+                continue;
+            }
+            if (!AK::atomic_compare_exchange_strong(state, current, current + rwlock_waiting_writer, AK::memory_order_relaxed))
+                continue;
+            current += rwlock_waiting_writer;
+            is_waiting = true;
         }
-        if (rc < 0 && errno != EAGAIN) {
-            // Something broke. let's just bail out.
-            return errno;
+
+        if (auto rc = rwlock_wait(state, current, rwlock_writer_wake_bitset, abstime); rc != 0) {
+            rwlock_stop_waiting_to_write(state);
+            return rc;
         }
-        errno = 0;
-        // Reload the 'current' value
-        current = AK::atomic_load(lockp);
+        current = AK::atomic_load(state, AK::memory_order_relaxed);
     }
-
-    return value_if_timeout;
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_rdlock.html
@@ -784,7 +844,7 @@ int pthread_rwlock_rdlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), nullptr, false, 0, 0);
+    return rwlock_rdlock(lockp, nullptr, false);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_timedrdlock.html
@@ -793,12 +853,7 @@ int pthread_rwlock_timedrdlock(pthread_rwlock_t* __restrict lockp, const struct
     if (!lockp)
         return EINVAL;
 
-    auto rc = rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), timespec);
-    if (rc == -1) // "ok"
-        return 0;
-    if (rc == -2) // "timed out"
-        return 1;
-    return rc;
+    return rwlock_rdlock(lockp, timespec, false);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_timedwrlock.html
@@ -807,12 +862,7 @@ int pthread_rwlock_timedwrlock(pthread_rwlock_t* __restrict lockp, const struct
     if (!lockp)
         return EINVAL;
 
-    auto rc = rwlock_wrlock_maybe_timed(lockp, timespec);
-    if (rc == -1) // "ok"
-        return 0;
-    if (rc == -2) // "timed out"
-        return 1;
-    return rc;
+    return rwlock_wrlock(lockp, timespec, false);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_tryrdlock.html
@@ -821,7 +871,7 @@ int pthread_rwlock_tryrdlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_rdlock_maybe_timed(reinterpret_cast<u32*>(lockp), nullptr, true, EBUSY, 0);
+    return rwlock_rdlock(lockp, nullptr, true);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_trywrlock.html
@@ -830,50 +880,51 @@ int pthread_rwlock_trywrlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_wrlock_maybe_timed(lockp, nullptr, true, EBUSY, 0);
+    return rwlock_wrlock(lockp, nullptr, true);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlock_unlock.html
-int pthread_rwlock_unlock(pthread_rwlock_t* lockval_p)
+int pthread_rwlock_unlock(pthread_rwlock_t* lockp)
 {
-    if (!lockval_p)
+    if (!lockp)
         return EINVAL;
 
     // This is a weird API, we don't really know whether we're unlocking write or read...
-    auto lockp = reinterpret_cast<u32*>(lockval_p);
-    auto current = AK::atomic_load(lockp, AK::MemoryOrder::memory_order_relaxed);
-    if (current & writer_locked_mask) {
+    auto* state = rwlock_state(lockp);
+    auto current = AK::atomic_load(state, AK::memory_order_relaxed);
+    if (current & rwlock_write_locked) {
         // If this lock is locked for writing, its owner better be us!
-        auto owner_id = AK::atomic_load(reinterpret_cast<i32*>(lockval_p) + 1);
-        auto my_id = pthread_self();
-        if (owner_id != my_id)
+        if (AK::atomic_load(rwlock_writer(lockp), AK::memory_order_relaxed) != pthread_self())
             return EINVAL; // you don't own this lock, silly.
-
-        // Now just unlock it.
-        auto desired = current & ~(writer_locked_mask | writer_intent_mask);
-        AK::atomic_store(lockp, desired, AK::MemoryOrder::memory_order_release);
-        // Then wake both readers and writers, if any.
-        auto rc = futex(lockp, FUTEX_WAKE_BITSET | FUTEX_PRIVATE_FLAG, UINT32_MAX, nullptr, nullptr, (current & writer_wake_mask) | reader_wake_mask);
-        if (rc < 0)
-            return errno;
+        AK::atomic_store(rwlock_writer(lockp), 0, AK::memory_order_relaxed);
+
+        // Readers that are asleep have to keep waiting if there is another writer.
+        u32 desired;
+        do {
+            desired = current & ~rwlock_write_locked;
+            if (!(desired & rwlock_waiting_writer_count_mask))
+                desired &= ~rwlock_readers_waiting;
+        } while (!AK::atomic_compare_exchange_strong(state, current, desired, AK::memory_order_release));
+
+        if (desired & rwlock_waiting_writer_count_mask)
+            rwlock_wake(state, 1, rwlock_writer_wake_bitset);
+        else if (current & rwlock_readers_waiting)
+            rwlock_wake(state, INT_MAX, rwlock_reader_wake_bitset);
         return 0;
     }
 
-    for (;;) {
-        auto count = (u16)current;
-        if (!count) {
+    u32 desired;
+    do {
+        if (!(current & rwlock_reader_count_mask)) {
             // Are you crazy? this isn't even locked!
             return EINVAL;
         }
-        --count;
-        auto desired = (current & 0xffff0000u) | count;
-        auto did_exchange = AK::atomic_compare_exchange_strong(lockp, current, desired, AK::MemoryOrder::memory_order_release);
-        if (did_exchange)
-            break;
-        // tough luck, try again.
-    }
+        desired = current - 1;
+    } while (!AK::atomic_compare_exchange_strong(state, current, desired, AK::memory_order_release));
 
-    // Finally, unlocked at last!
+    // The last reader out lets the next writer in.
+    if (!(desired & rwlock_reader_count_mask) && (desired & rwlock_waiting_writer_count_mask))
+        rwlock_wake(state, 1, rwlock_writer_wake_bitset);
     return 0;
 }
 
@@ -883,7 +934,7 @@ int pthread_rwlock_wrlock(pthread_rwlock_t* lockp)
     if (!lockp)
         return EINVAL;
 
-    return rwlock_wrlock_maybe_timed(lockp, nullptr, false, 0, 0);
+    return rwlock_wrlock(lockp, nullptr, false);
 }
 
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_rwlockattr_destroy.html
@@ -8,6 +8,8 @@
 #include <AK/NeverDestroyed.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
+#include <Kernel/API/RunningThreadsPage.h>
+#include <bits/kernel_page.h>
 #include <bits/pthread_integration.h>
 #include <errno.h>
 #include <pthread.h>
@@ -93,6 +95,34 @@ int pthread_self()
     return gettid();
 }
 
+static Atomic<Kernel::RunningThreadsPage const*> s_running_threads_page { nullptr };
+static Atomic<bool> s_running_threads_page_is_unavailable { false };
+
+static Kernel::RunningThreadsPage const* running_threads_page()
+{
+    if (s_running_threads_page_is_unavailable.load(AK::memory_order_relaxed))
+        return nullptr;
+    auto const* page = LibC::map_kernel_page_once(s_running_threads_page, SC_map_running_threads_page);
+    if (!page)
+        s_running_threads_page_is_unavailable.store(true, AK::memory_order_relaxed);
+    return page;
+}
+
+int __pthread_is_running_on_processor_np(pthread_t thread)
+{
+    auto const* page = running_threads_page();
+    if (!page)
+        return 0;
+
+    u32 processor_count = page->processor_count;
+    processor_count = min(processor_count, static_cast<u32>(Kernel::RunningThreadsPage::max_processor_count));
+    for (u32 i = 0; i < processor_count; ++i) {
+        if (page->running_thread_ids[i] == thread)
+            return 1;
+    }
+    return 0;
+}
+
 static constexpr u32 MUTEX_UNLOCKED = 0;
 static constexpr u32 MUTEX_LOCKED_NO_NEED_TO_WAKE = 1;
 static constexpr u32 MUTEX_LOCKED_NEED_TO_WAKE = 2;
@@ -114,8 +144,7 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex)
     bool exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, expected, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire);
 
     if (exchanged) [[likely]] {
-        if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
-            AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
+        AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
         mutex->level = 0;
         return 0;
     } else if (mutex->type == __PTHREAD_MUTEX_RECURSIVE) {
@@ -129,6 +158,24 @@ int pthread_mutex_trylock(pthread_mutex_t* mutex)
     return EBUSY;
 }
 
+// Spins until the mutex is unlocked, but only for as long as its owner is running on another processor.
+// Critical sections are usually short, so this is a lot cheaper than going to sleep and being woken up again.
+static bool spin_until_mutex_is_unlocked(pthread_mutex_t* mutex)
+{
+    for (size_t i = 0; i < __PTHREAD_MAX_SPIN_COUNT; ++i) {
+        if (i % __PTHREAD_SPINS_BETWEEN_OWNER_CHECKS == 0) {
+            pthread_t owner = AK::atomic_load(&mutex->owner, AK::memory_order_relaxed);
+            // The owner might not have written its ID yet, give it a moment.
+            if (owner != 0 && !__pthread_is_running_on_processor_np(owner))
+                return false;
+        }
+        if (AK::atomic_load(&mutex->lock, AK::memory_order_relaxed) == MUTEX_UNLOCKED)
+            return true;
+        __pthread_spin_pause();
+    }
+    return false;
+}
+
 // https://pubs.opengroup.org/onlinepubs/009695399/functions/pthread_mutex_lock.html
 int pthread_mutex_lock(pthread_mutex_t* mutex)
 {
@@ -136,8 +183,7 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
     u32 value = MUTEX_UNLOCKED;
     bool exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, value, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire);
     if (exchanged) [[likely]] {
-        if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
-            AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
+        AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
         mutex->level = 0;
         return 0;
     } else if (mutex->type == __PTHREAD_MUTEX_RECURSIVE) {
@@ -149,6 +195,17 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
         }
     }
 
+    // Medium path: if nobody is asleep yet, the owner is likely about to release the mutex.
+    if (value == MUTEX_LOCKED_NO_NEED_TO_WAKE && spin_until_mutex_is_unlocked(mutex)) {
+        value = MUTEX_UNLOCKED;
+        exchanged = AK::atomic_compare_exchange_strong(&mutex->lock, value, MUTEX_LOCKED_NO_NEED_TO_WAKE, AK::memory_order_acquire);
+        if (exchanged) {
+            AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
+            mutex->level = 0;
+            return 0;
+        }
+    }
+
     // Slow path: wait, record the fact that we're going to wait, and always
     // remember to wake the next thread up once we release the mutex.
     if (value != MUTEX_LOCKED_NEED_TO_WAKE)
@@ -159,8 +216,7 @@ int pthread_mutex_lock(pthread_mutex_t* mutex)
         value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
     }
 
-    if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
-        AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
+    AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
     mutex->level = 0;
     return 0;
 }
@@ -176,8 +232,7 @@ int __pthread_mutex_lock_pessimistic_np(pthread_mutex_t* mutex)
         value = AK::atomic_exchange(&mutex->lock, MUTEX_LOCKED_NEED_TO_WAKE, AK::memory_order_acquire);
     }
 
-    if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
-        AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
+    AK::atomic_store(&mutex->owner, pthread_self(), AK::memory_order_relaxed);
     mutex->level = 0;
     return 0;
 }
@@ -190,8 +245,7 @@ int pthread_mutex_unlock(pthread_mutex_t* mutex)
         return 0;
     }
 
-    if (mutex->type == __PTHREAD_MUTEX_RECURSIVE)
-        AK::atomic_store(&mutex->owner, 0, AK::memory_order_relaxed);
+    AK::atomic_store(&mutex->owner, 0, AK::memory_order_relaxed);
 
     u32 value = AK::atomic_exchange(&mutex->lock, MUTEX_UNLOCKED, AK::memory_order_release);
     if (value == MUTEX_LOCKED_NEED_TO_WAKE) [[unlikely]] {
@@ -48,6 +48,15 @@ static ALWAYS_INLINE int futex_wake(uint32_t* userspace_address, uint32_t count,
     return futex(userspace_address, FUTEX_WAKE | (process_shared ? 0 : FUTEX_PRIVATE_FLAG), count, NULL, NULL, 0);
 }
 
+// Waits until any of the given futexes is woken, and returns the index of the one that was.
+static ALWAYS_INLINE int futex_waitv(struct futex_waitv* waiters, uint32_t count, const struct timespec* abstime, int clockid)
+{
+    int op = FUTEX_WAITV;
+    if (abstime && (clockid == CLOCK_REALTIME || clockid == CLOCK_REALTIME_COARSE))
+        op |= FUTEX_CLOCK_REALTIME;
+    return futex((uint32_t*)waiters, op, count, abstime, NULL, 0);
+}
+
 #ifdef ALWAYS_INLINE_SERENITY_H
 #    undef ALWAYS_INLINE
 #endif
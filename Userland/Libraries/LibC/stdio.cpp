@@ -542,6 +542,38 @@ void FILE::unlock()
     pthread_mutex_unlock(&m_mutex);
 }
 
+// Collects the output of a single printf() call and passes it on in chunks, instead of one character at a time.
+template<typename WriteFunction>
+class PrintfOutputBuffer {
+public:
+    explicit PrintfOutputBuffer(WriteFunction write)
+        : m_write(move(write))
+    {
+    }
+
+    ~PrintfOutputBuffer() { flush(); }
+
+    ALWAYS_INLINE void append(char ch)
+    {
+        if (m_size == sizeof(m_data))
+            flush();
+        m_data[m_size++] = ch;
+    }
+
+    void flush()
+    {
+        if (m_size == 0)
+            return;
+        m_write(m_data, m_size);
+        m_size = 0;
+    }
+
+private:
+    WriteFunction m_write;
+    size_t m_size { 0 };
+    char m_data[256];
+};
+
 extern "C" {
 
 alignas(FILE) static u8 default_streams[3][sizeof(FILE)];
@@ -591,6 +623,12 @@ int fileno(FILE* stream)
 {
     VERIFY(stream);
     ScopedFileLock lock(stream);
+    return fileno_unlocked(stream);
+}
+
+int fileno_unlocked(FILE* stream)
+{
+    VERIFY(stream);
     return stream->fileno();
 }
 
@@ -599,6 +637,12 @@ int feof(FILE* stream)
 {
     VERIFY(stream);
     ScopedFileLock lock(stream);
+    return feof_unlocked(stream);
+}
+
+int feof_unlocked(FILE* stream)
+{
+    VERIFY(stream);
     return stream->eof();
 }
 
@@ -615,6 +659,12 @@ int fflush(FILE* stream)
         return rc;
     }
     ScopedFileLock lock(stream);
+    return fflush_unlocked(stream);
+}
+
+int fflush_unlocked(FILE* stream)
+{
+    VERIFY(stream);
     return stream->flush() ? 0 : EOF;
 }
 
@@ -623,6 +673,12 @@ char* fgets(char* buffer, int size, FILE* stream)
 {
     VERIFY(stream);
     ScopedFileLock lock(stream);
+    return fgets_unlocked(buffer, size, stream);
+}
+
+char* fgets_unlocked(char* buffer, int size, FILE* stream)
+{
+    VERIFY(stream);
     bool ok = stream->gets(reinterpret_cast<u8*>(buffer), size);
     return ok ? buffer : nullptr;
 }
@@ -631,12 +687,8 @@ char* fgets(char* buffer, int size, FILE* stream)
 int fgetc(FILE* stream)
 {
     VERIFY(stream);
-    unsigned char ch;
-    size_t nread = fread(&ch, sizeof(unsigned char), 1, stream);
-    if (nread == 1) {
-        return ch;
-    }
-    return EOF;
+    ScopedFileLock lock(stream);
+    return fgetc_unlocked(stream);
 }
 
 int fgetc_unlocked(FILE* stream)
@@ -666,6 +718,11 @@ int getchar()
     return getc(stdin);
 }
 
+int getchar_unlocked()
+{
+    return getc_unlocked(stdin);
+}
+
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/getdelim.html
 ssize_t getdelim(char** lineptr, size_t* n, int delim, FILE* stream)
 {
@@ -681,12 +738,14 @@ ssize_t getdelim(char** lineptr, size_t* n, int delim, FILE* stream)
         }
     }
 
+    ScopedFileLock lock(stream);
+
     char* ptr;
     char* eptr;
     for (ptr = *lineptr, eptr = *lineptr + *n;;) {
-        int c = fgetc(stream);
+        int c = fgetc_unlocked(stream);
         if (c == -1) {
-            if (feof(stream)) {
+            if (feof_unlocked(stream)) {
                 *ptr = '\0';
                 return ptr == *lineptr ? -1 : ptr - *lineptr;
             } else {
@@ -732,8 +791,14 @@ int ungetc(int c, FILE* stream)
 int fputc(int ch, FILE* stream)
 {
     VERIFY(stream);
-    u8 byte = ch;
     ScopedFileLock lock(stream);
+    return fputc_unlocked(ch, stream);
+}
+
+int fputc_unlocked(int ch, FILE* stream)
+{
+    VERIFY(stream);
+    u8 byte = ch;
     size_t nwritten = stream->write(&byte, 1);
     if (nwritten == 0)
         return EOF;
@@ -747,18 +812,34 @@ int putc(int ch, FILE* stream)
     return fputc(ch, stream);
 }
 
+int putc_unlocked(int ch, FILE* stream)
+{
+    return fputc_unlocked(ch, stream);
+}
+
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/putchar.html
 int putchar(int ch)
 {
     return putc(ch, stdout);
 }
 
+int putchar_unlocked(int ch)
+{
+    return putc_unlocked(ch, stdout);
+}
+
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/fputs.html
 int fputs(char const* s, FILE* stream)
 {
     VERIFY(stream);
-    size_t len = strlen(s);
     ScopedFileLock lock(stream);
+    return fputs_unlocked(s, stream);
+}
+
+int fputs_unlocked(char const* s, FILE* stream)
+{
+    VERIFY(stream);
+    size_t len = strlen(s);
     size_t nwritten = stream->write(reinterpret_cast<u8 const*>(s), len);
     if (nwritten < len)
         return EOF;
@@ -768,10 +849,11 @@ int fputs(char const* s, FILE* stream)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/puts.html
 int puts(char const* s)
 {
-    int rc = fputs(s, stdout);
+    ScopedFileLock lock(stdout);
+    int rc = fputs_unlocked(s, stdout);
     if (rc == EOF)
         return EOF;
-    return fputc('\n', stdout);
+    return fputc_unlocked('\n', stdout);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/clearerr.html
@@ -779,6 +861,12 @@ void clearerr(FILE* stream)
 {
     VERIFY(stream);
     ScopedFileLock lock(stream);
+    clearerr_unlocked(stream);
+}
+
+void clearerr_unlocked(FILE* stream)
+{
+    VERIFY(stream);
     stream->clear_err();
 }
 
@@ -787,6 +875,12 @@ int ferror(FILE* stream)
 {
     VERIFY(stream);
     ScopedFileLock lock(stream);
+    return ferror_unlocked(stream);
+}
+
+int ferror_unlocked(FILE* stream)
+{
+    VERIFY(stream);
     return stream->error();
 }
 
@@ -811,11 +905,17 @@ size_t fread(void* ptr, size_t size, size_t nmemb, FILE* stream)
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/fwrite.html
 size_t fwrite(void const* ptr, size_t size, size_t nmemb, FILE* stream)
+{
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    return fwrite_unlocked(ptr, size, nmemb, stream);
+}
+
+size_t fwrite_unlocked(void const* ptr, size_t size, size_t nmemb, FILE* stream)
 {
     VERIFY(stream);
     VERIFY(!Checked<size_t>::multiplication_would_overflow(size, nmemb));
 
-    ScopedFileLock lock(stream);
     size_t nwritten = stream->write(reinterpret_cast<u8 const*>(ptr), size * nmemb);
     if (!nwritten)
         return 0;
@@ -886,15 +986,15 @@ void rewind(FILE* stream)
     clearerr(stream);
 }
 
-ALWAYS_INLINE void stdout_putch(char*&, char ch)
-{
-    putchar(ch);
-}
-
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/vfprintf.html
 int vfprintf(FILE* stream, char const* fmt, va_list ap)
 {
-    return printf_internal([stream](auto, char ch) { fputc(ch, stream); }, nullptr, fmt, ap);
+    VERIFY(stream);
+    ScopedFileLock lock(stream);
+    PrintfOutputBuffer buffer([stream](char const* data, size_t size) {
+        stream->write(reinterpret_cast<u8 const*>(data), size);
+    });
+    return printf_internal([&buffer](auto, char ch) { buffer.append(ch); }, nullptr, fmt, ap);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/fprintf.html
@@ -910,8 +1010,19 @@ int fprintf(FILE* stream, char const* fmt, ...)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/vdprintf.html
 int vdprintf(int fd, char const* fmt, va_list ap)
 {
-    // FIXME: Implement buffering so that we don't issue one write syscall for every character.
-    return printf_internal([fd](auto, char ch) { write(fd, &ch, 1); }, nullptr, fmt, ap);
+    PrintfOutputBuffer buffer([fd](char const* data, size_t size) {
+        while (size > 0) {
+            ssize_t nwritten = write(fd, data, size);
+            if (nwritten < 0) {
+                if (errno == EINTR)
+                    continue;
+                return;
+            }
+            data += nwritten;
+            size -= nwritten;
+        }
+    });
+    return printf_internal([&buffer](auto, char ch) { buffer.append(ch); }, nullptr, fmt, ap);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/dprintf.html
@@ -927,7 +1038,7 @@ int dprintf(int fd, char const* fmt, ...)
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/vprintf.html
 int vprintf(char const* fmt, va_list ap)
 {
-    return printf_internal(stdout_putch, nullptr, fmt, ap);
+    return vfprintf(stdout, fmt, ap);
 }
 
 // https://pubs.opengroup.org/onlinepubs/9699919799/functions/printf.html
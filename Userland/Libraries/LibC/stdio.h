@@ -48,13 +48,17 @@ int fsetpos(FILE*, fpos_t const*);
 long ftell(FILE*);
 off_t ftello(FILE*);
 char* fgets(char* buffer, int size, FILE*);
+char* fgets_unlocked(char* buffer, int size, FILE*);
 int fputc(int ch, FILE*);
+int fputc_unlocked(int ch, FILE*);
 int fileno(FILE*);
+int fileno_unlocked(FILE*);
 int fgetc(FILE*);
 int fgetc_unlocked(FILE*);
 int getc(FILE*);
 int getc_unlocked(FILE* stream);
 int getchar(void);
+int getchar_unlocked(void);
 ssize_t getdelim(char**, size_t*, int, FILE*);
 ssize_t getline(char**, size_t*, FILE*);
 int ungetc(int c, FILE*);
@@ -68,12 +72,17 @@ void funlockfile(FILE* filehandle);
 int fclose(FILE*);
 void rewind(FILE*);
 void clearerr(FILE*);
+void clearerr_unlocked(FILE*);
 int ferror(FILE*);
+int ferror_unlocked(FILE*);
 int feof(FILE*);
+int feof_unlocked(FILE*);
 int fflush(FILE*);
+int fflush_unlocked(FILE*);
 size_t fread(void* ptr, size_t size, size_t nmemb, FILE*);
 size_t fread_unlocked(void* ptr, size_t size, size_t nmemb, FILE*);
 size_t fwrite(void const* ptr, size_t size, size_t nmemb, FILE*);
+size_t fwrite_unlocked(void const* ptr, size_t size, size_t nmemb, FILE*);
 int vprintf(char const* fmt, va_list) __attribute__((format(printf, 1, 0)));
 int vfprintf(FILE*, char const* fmt, va_list) __attribute__((format(printf, 2, 0)));
 int vasprintf(char** strp, char const* fmt, va_list) __attribute__((format(printf, 2, 0)));
@@ -88,9 +97,12 @@ int sprintf(char* buffer, char const* fmt, ...) __attribute__((format(printf, 2,
 int asprintf(char** strp, char const* fmt, ...) __attribute__((format(printf, 2, 3)));
 int snprintf(char* buffer, size_t, char const* fmt, ...) __attribute__((format(printf, 3, 4)));
 int putchar(int ch);
+int putchar_unlocked(int ch);
 int putc(int ch, FILE*);
+int putc_unlocked(int ch, FILE*);
 int puts(char const*);
 int fputs(char const*, FILE*);
+int fputs_unlocked(char const*, FILE*);
 void perror(char const*);
 int scanf(char const* fmt, ...) __attribute__((format(scanf, 1, 2)));
 int sscanf(char const* str, char const* fmt, ...) __attribute__((format(scanf, 2, 3)));
@@ -29,6 +29,29 @@ __attribute__((malloc)) __attribute__((alloc_size(1, 2))) void* calloc(size_t nm
 size_t malloc_size(void const*);
 size_t malloc_good_size(size_t);
 void serenity_dump_malloc_stats(void);
+
+struct serenity_malloc_size_class_info {
+    size_t chunk_size;
+    size_t block_count;
+    size_t chunk_capacity;
+    size_t chunks_in_use;
+    size_t chunks_cached;
+    size_t chunks_in_remote_batches;
+};
+
+struct serenity_malloc_info {
+    size_t size_class_count;
+    size_t block_size;
+    size_t chunked_block_count;
+    size_t hot_empty_block_count;
+    size_t cold_empty_block_count;
+    size_t big_allocation_count;
+    size_t big_allocation_bytes;
+    size_t recycled_big_block_count;
+    size_t thread_cache_count;
+};
+
+int serenity_get_malloc_info(struct serenity_malloc_info*, struct serenity_malloc_size_class_info* size_classes, size_t size_class_count);
 void free(void*);
 __attribute__((alloc_size(2))) void* realloc(void* ptr, size_t);
 char* getenv(char const* name);
@@ -11,12 +11,14 @@
 #include <Kernel/API/TimePage.h>
 #include <LibTimeZone/TimeZone.h>
 #include <assert.h>
+#include <bits/kernel_page.h>
 #include <bits/pthread_cancel.h>
 #include <errno.h>
 #include <fcntl.h>
 #include <limits.h>
 #include <stdio.h>
 #include <string.h>
+#include <sys/mman.h>
 #include <sys/time.h>
 #include <sys/times.h>
 #include <syscall.h>
@@ -456,36 +458,72 @@ clock_t clock()
     return tms.tms_utime + tms.tms_stime;
 }
 
-static Kernel::TimePage* get_kernel_time_page()
+static Atomic<Kernel::TimePage const*> s_kernel_time_page { nullptr };
+
+static Kernel::TimePage const* get_kernel_time_page()
+{
+    return LibC::map_kernel_page_once(s_kernel_time_page, SC_map_time_page);
+}
+
+static u64 read_time_page_counter()
 {
-    static Kernel::TimePage* s_kernel_time_page;
-    // FIXME: Thread safety
-    if (!s_kernel_time_page) {
-        auto rc = syscall(SC_map_time_page);
-        if ((int)rc < 0 && (int)rc > -EMAXERRNO) {
-            errno = -(int)rc;
-            return nullptr;
+#if ARCH(X86_64)
+    u32 low;
+    u32 high;
+    // The lfence keeps the TSC from being read before the time page.
+    asm volatile("lfence\n"
+                 "rdtsc"
+                 : "=a"(low), "=d"(high)
+                 :
+                 : "memory");
+    return ((u64)high << 32) | low;
+#else
+    // The kernel only provides a counter on x86_64.
+    VERIFY_NOT_REACHED();
+#endif
+}
+
+// Returns false if the clock can't be read from the time page right now.
+static bool read_clock_from_time_page(Kernel::TimePage const& page, clockid_t clock_id, struct timespec& ts)
+{
+    bool needs_counter = Kernel::time_page_supports_with_counter(clock_id);
+    u64 nanoseconds = 0;
+    u32 update_iteration;
+    do {
+        update_iteration = AK::atomic_load(&page.update1, AK::memory_order_acquire);
+        ts = page.clocks[clock_id];
+        if (needs_counter) {
+            if (page.counter_multiplier == 0)
+                return false;
+            u64 counter = read_time_page_counter();
+            u64 counter_base = page.counter_base;
+            // The kernel only lets us use the TSC if it's in sync on all processors, but it might still be a tiny bit
+            // behind the processor that updated the page. Don't fall back to the syscall then: it reads the HPET, which
+            // is ahead of the (slightly slow) time page clock, so the next read from the page would go backwards.
+            // The clocks as published in the page are never ahead of anything we've handed out before.
+            if (counter > counter_base)
+                nanoseconds = page.counter_ticks_to_nanoseconds(counter - counter_base);
+            else
+                nanoseconds = 0;
         }
-        s_kernel_time_page = (Kernel::TimePage*)rc;
-    }
-    return s_kernel_time_page;
+    } while (update_iteration != AK::atomic_load(&page.update2, AK::memory_order_acquire));
+
+    if (nanoseconds != 0)
+        ts = (Duration::from_timespec(ts) + Duration::from_nanoseconds(static_cast<i64>(nanoseconds))).to_timespec();
+    return true;
 }
 
 int clock_gettime(clockid_t clock_id, struct timespec* ts)
 {
-    if (Kernel::time_page_supports(clock_id)) {
+    if (Kernel::time_page_supports(clock_id) || Kernel::time_page_supports_with_counter(clock_id)) {
         if (!ts) {
             errno = EFAULT;
             return -1;
         }
 
-        if (auto* kernel_time_page = get_kernel_time_page()) {
-            u32 update_iteration;
-            do {
-                update_iteration = AK::atomic_load(&kernel_time_page->update1, AK::memory_order_acquire);
-                *ts = kernel_time_page->clocks[clock_id];
-            } while (update_iteration != AK::atomic_load(&kernel_time_page->update2, AK::memory_order_acquire));
-            return 0;
+        if (auto const* kernel_time_page = get_kernel_time_page()) {
+            if (read_clock_from_time_page(*kernel_time_page, clock_id, *ts))
+                return 0;
         }
     }
 
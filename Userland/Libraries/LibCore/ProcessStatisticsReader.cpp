@@ -5,12 +5,15 @@
  */
 
 #include <AK/ByteBuffer.h>
+#include <AK/HashTable.h>
 #include <AK/JsonArray.h>
 #include <AK/JsonObject.h>
 #include <AK/JsonValue.h>
+#include <Kernel/API/ProcessStatistics.h>
 #include <LibCore/File.h>
 #include <LibCore/ProcessStatisticsReader.h>
 #include <pwd.h>
+#include <string.h>
 
 namespace Core {
 
@@ -89,10 +92,142 @@ ErrorOr<AllProcessesStatistics> ProcessStatisticsReader::get_all(SeekableStream&
     return all_processes_statistics;
 }
 
+template<typename T>
+static ErrorOr<T const*> read_from_snapshot(ReadonlyBytes snapshot, size_t& offset, size_t count = 1)
+{
+    if (offset + sizeof(T) * count > snapshot.size())
+        return Error::from_string_view("Truncated process statistics"sv);
+    auto const* data = reinterpret_cast<T const*>(snapshot.offset_pointer(offset));
+    offset += sizeof(T) * count;
+    return data;
+}
+
+static DeprecatedString veil_state_to_string(Kernel::ProcessStatisticsVeilState veil_state)
+{
+    switch (veil_state) {
+    case Kernel::ProcessStatisticsVeilState::None:
+        return "None";
+    case Kernel::ProcessStatisticsVeilState::Dropped:
+        return "Dropped";
+    case Kernel::ProcessStatisticsVeilState::Locked:
+        return "Locked";
+    case Kernel::ProcessStatisticsVeilState::NotApplicable:
+        break;
+    }
+    return "";
+}
+
+template<size_t Size>
+static DeprecatedString string_from_fixed_buffer(char const (&buffer)[Size])
+{
+    return DeprecatedString(buffer, strnlen(buffer, Size));
+}
+
+ErrorOr<void> ProcessStatisticsReader::apply_snapshot(ReadonlyBytes snapshot, AllProcessesStatistics& all_processes_statistics, bool include_usernames)
+{
+    size_t offset = 0;
+    auto const& header = *TRY(read_from_snapshot<Kernel::ProcessStatisticsHeader>(snapshot, offset));
+    if (header.magic != Kernel::ProcessStatisticsHeader::expected_magic || header.version != Kernel::ProcessStatisticsHeader::expected_version)
+        return Error::from_string_view("Unsupported process statistics format"sv);
+    offset = header.header_size;
+
+    auto const* removed_pids = TRY(read_from_snapshot<u32>(snapshot, offset, header.removed_process_count));
+    offset = align_up_to(offset, 8);
+
+    auto& processes = all_processes_statistics.processes;
+    if (header.flags & Kernel::ProcessStatisticsHeader::Full) {
+        processes.clear_with_capacity();
+    } else if (header.removed_process_count > 0) {
+        HashTable<pid_t> removed;
+        for (size_t i = 0; i < header.removed_process_count; ++i)
+            removed.set(removed_pids[i]);
+        processes.remove_all_matching([&](auto& process) { return removed.contains(process.pid); });
+    }
+
+    HashMap<pid_t, size_t> process_indices;
+    for (size_t i = 0; i < processes.size(); ++i)
+        process_indices.set(processes[i].pid, i);
+
+    for (size_t i = 0; i < header.process_count; ++i) {
+        auto entry_offset = offset;
+        auto const& entry = *TRY(read_from_snapshot<Kernel::ProcessStatisticsEntry>(snapshot, offset));
+        if (entry.entry_size < sizeof(entry) || entry_offset + entry.entry_size > snapshot.size())
+            return Error::from_string_view("Truncated process statistics"sv);
+
+        Core::ProcessStatistics process;
+        process.pid = entry.pid;
+        process.pgid = entry.pgid;
+        process.pgp = entry.pgp;
+        process.sid = entry.sid;
+        process.uid = entry.uid;
+        process.gid = entry.gid;
+        process.ppid = entry.ppid;
+        process.kernel = entry.is_kernel;
+        process.name = string_from_fixed_buffer(entry.name);
+        process.executable = DeprecatedString(TRY(read_from_snapshot<char>(snapshot, offset, entry.executable_length)), entry.executable_length);
+        process.tty = DeprecatedString(TRY(read_from_snapshot<char>(snapshot, offset, entry.tty_length)), entry.tty_length);
+        process.pledge = DeprecatedString(TRY(read_from_snapshot<char>(snapshot, offset, entry.pledge_length)), entry.pledge_length);
+        process.veil = veil_state_to_string(entry.veil);
+        process.creation_time = UnixDateTime::from_nanoseconds_since_epoch(entry.creation_time_ns);
+        process.amount_virtual = entry.amount_virtual;
+        process.amount_resident = entry.amount_resident;
+        process.amount_shared = entry.amount_shared;
+        process.amount_dirty_private = entry.amount_dirty_private;
+        process.amount_clean_inode = entry.amount_clean_inode;
+        process.amount_purgeable_volatile = entry.amount_purgeable_volatile;
+        process.amount_purgeable_nonvolatile = entry.amount_purgeable_nonvolatile;
+        offset = align_up_to(offset, 8);
+
+        auto const* threads = TRY(read_from_snapshot<Kernel::ThreadStatisticsEntry>(snapshot, offset, entry.thread_count));
+        TRY(process.threads.try_ensure_capacity(entry.thread_count));
+        for (size_t j = 0; j < entry.thread_count; ++j) {
+            auto const& thread_entry = threads[j];
+            Core::ThreadStatistics thread;
+            thread.tid = thread_entry.tid;
+            thread.times_scheduled = thread_entry.times_scheduled;
+            thread.name = string_from_fixed_buffer(thread_entry.name);
+            thread.state = string_from_fixed_buffer(thread_entry.state);
+            thread.time_user = thread_entry.time_user;
+            thread.time_kernel = thread_entry.time_kernel;
+            thread.cpu = thread_entry.cpu;
+            thread.priority = thread_entry.priority;
+            thread.syscall_count = thread_entry.syscall_count;
+            thread.inode_faults = thread_entry.inode_faults;
+            thread.zero_faults = thread_entry.zero_faults;
+            thread.cow_faults = thread_entry.cow_faults;
+            thread.unix_socket_read_bytes = thread_entry.unix_socket_read_bytes;
+            thread.unix_socket_write_bytes = thread_entry.unix_socket_write_bytes;
+            thread.ipv4_socket_read_bytes = thread_entry.ipv4_socket_read_bytes;
+            thread.ipv4_socket_write_bytes = thread_entry.ipv4_socket_write_bytes;
+            thread.file_read_bytes = thread_entry.file_read_bytes;
+            thread.file_write_bytes = thread_entry.file_write_bytes;
+            process.threads.unchecked_append(move(thread));
+        }
+        offset = entry_offset + entry.entry_size;
+
+        if (include_usernames)
+            process.username = username_from_uid(process.uid);
+
+        if (auto index = process_indices.get(process.pid); index.has_value()) {
+            processes[index.value()] = move(process);
+        } else {
+            process_indices.set(process.pid, processes.size());
+            TRY(processes.try_append(move(process)));
+        }
+    }
+
+    all_processes_statistics.total_time_scheduled = header.total_time;
+    all_processes_statistics.total_time_scheduled_kernel = header.total_time_kernel;
+    return {};
+}
+
 ErrorOr<AllProcessesStatistics> ProcessStatisticsReader::get_all(bool include_usernames)
 {
-    auto proc_all_file = TRY(Core::File::open("/sys/kernel/processes"sv, Core::File::OpenMode::Read));
-    return get_all(*proc_all_file, include_usernames);
+    auto file = TRY(Core::File::open("/sys/kernel/process_statistics"sv, Core::File::OpenMode::Read));
+    auto snapshot = TRY(file->read_until_eof());
+    AllProcessesStatistics all_processes_statistics {};
+    TRY(apply_snapshot(snapshot, all_processes_statistics, include_usernames));
+    return all_processes_statistics;
 }
 
 DeprecatedString ProcessStatisticsReader::username_from_uid(uid_t uid)
@@ -109,4 +244,27 @@ DeprecatedString ProcessStatisticsReader::username_from_uid(uid_t uid)
         return (*it).value;
     return DeprecatedString::number(uid);
 }
+
+ErrorOr<NonnullOwnPtr<IncrementalProcessStatisticsReader>> IncrementalProcessStatisticsReader::create(bool include_usernames)
+{
+    auto file = TRY(Core::File::open("/sys/kernel/process_statistics"sv, Core::File::OpenMode::Read));
+    return adopt_nonnull_own_or_enomem(new (nothrow) IncrementalProcessStatisticsReader(move(file), include_usernames));
+}
+
+IncrementalProcessStatisticsReader::IncrementalProcessStatisticsReader(NonnullOwnPtr<File> file, bool include_usernames)
+    : m_file(move(file))
+    , m_include_usernames(include_usernames)
+{
+}
+
+IncrementalProcessStatisticsReader::~IncrementalProcessStatisticsReader() = default;
+
+ErrorOr<void> IncrementalProcessStatisticsReader::update()
+{
+    // Seeking back to the start makes the kernel give us everything that changed since we last did that.
+    TRY(m_file->seek(0, SeekMode::SetPosition));
+    auto snapshot = TRY(m_file->read_until_eof());
+    return ProcessStatisticsReader::apply_snapshot(snapshot, m_statistics, m_include_usernames);
+}
+
 }
@@ -7,8 +7,11 @@
 #pragma once
 
 #include <AK/DeprecatedString.h>
+#include <AK/HashMap.h>
+#include <AK/NonnullOwnPtr.h>
 #include <AK/Time.h>
 #include <AK/Vector.h>
+#include <LibCore/Forward.h>
 #include <unistd.h>
 
 namespace Core {
@@ -35,7 +38,7 @@ struct ThreadStatistics {
 };
 
 struct ProcessStatistics {
-    // Keep this in sync with /sys/kernel/processes.
+    // Keep this in sync with /sys/kernel/processes and /sys/kernel/process_statistics.
     // From the kernel side:
     pid_t pid;
     pid_t pgid;
@@ -72,13 +75,36 @@ struct AllProcessesStatistics {
 };
 
 class ProcessStatisticsReader {
+    friend class IncrementalProcessStatisticsReader;
+
 public:
+    // Reads the JSON from /sys/kernel/processes.
     static ErrorOr<AllProcessesStatistics> get_all(SeekableStream&, bool include_usernames = true);
+    // Reads a snapshot of /sys/kernel/process_statistics.
     static ErrorOr<AllProcessesStatistics> get_all(bool include_usernames = true);
 
 private:
+    static ErrorOr<void> apply_snapshot(ReadonlyBytes, AllProcessesStatistics&, bool include_usernames);
     static DeprecatedString username_from_uid(uid_t);
     static HashMap<uid_t, DeprecatedString> s_usernames;
 };
 
+// Keeps /sys/kernel/process_statistics open, so that every update only has to
+// transfer the processes that changed since the previous one.
+class IncrementalProcessStatisticsReader {
+public:
+    static ErrorOr<NonnullOwnPtr<IncrementalProcessStatisticsReader>> create(bool include_usernames = true);
+    ~IncrementalProcessStatisticsReader();
+
+    ErrorOr<void> update();
+    AllProcessesStatistics const& statistics() const { return m_statistics; }
+
+private:
+    IncrementalProcessStatisticsReader(NonnullOwnPtr<File>, bool include_usernames);
+
+    NonnullOwnPtr<File> m_file;
+    bool m_include_usernames { true };
+    AllProcessesStatistics m_statistics {};
+};
+
 }
@@ -14,6 +14,7 @@
 #include <AK/LexicalPath.h>
 #include <AK/Platform.h>
 #include <AK/ScopeGuard.h>
+#include <AK/Time.h>
 #include <AK/Vector.h>
 #include <Kernel/API/VirtualMemoryAnnotations.h>
 #include <Kernel/API/prctl_numbers.h>
@@ -64,6 +65,18 @@ static bool s_do_breakpoint_trap_before_entry { false };
 static StringView s_ld_library_path;
 static StringView s_main_program_pledge_promises;
 static DeprecatedString s_loader_pledge_promises;
+static bool s_print_loader_statistics { false };
+
+struct SymbolLookupCacheTraits : public GenericTraits<DynamicObject::HashSymbol> {
+    static unsigned hash(DynamicObject::HashSymbol const& symbol) { return symbol.gnu_hash(); }
+    static bool equals(DynamicObject::HashSymbol const& a, DynamicObject::HashSymbol const& b) { return a.gnu_hash() == b.gnu_hash() && a.name() == b.name(); }
+};
+
+// Most symbols are referenced from many objects, so remember where they were found while a set of objects is being linked.
+// This has to be forgotten afterwards, as objects loaded later on could change the outcome of a lookup.
+static HashMap<DynamicObject::HashSymbol, Optional<DynamicObject::SymbolLookupResult>, SymbolLookupCacheTraits> s_symbol_lookup_cache;
+static size_t s_symbol_lookup_count { 0 };
+static size_t s_symbol_lookup_cache_hit_count { 0 };
 
 static Result<void, DlErrorMessage> __dlclose(void* handle);
 static Result<void*, DlErrorMessage> __dlopen(char const* filename, int flags);
@@ -71,12 +84,10 @@ static Result<void*, DlErrorMessage> __dlsym(void* handle, char const* symbol_na
 static Result<void, DlErrorMessage> __dladdr(void const* addr, Dl_info* info);
 static void __call_fini_functions();
 
-Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(StringView name)
+static Optional<DynamicObject::SymbolLookupResult> lookup_global_symbol_in_objects(DynamicObject::HashSymbol const& symbol)
 {
     Optional<DynamicObject::SymbolLookupResult> weak_result;
 
-    auto symbol = DynamicObject::HashSymbol { name };
-
     for (auto& lib : s_global_objects) {
         auto res = lib.value->lookup_symbol(symbol);
         if (!res.has_value())
@@ -90,6 +101,27 @@ Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(
     return weak_result;
 }
 
+Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol(StringView name)
+{
+    return lookup_global_symbol_in_objects(DynamicObject::HashSymbol { name });
+}
+
+Optional<DynamicObject::SymbolLookupResult> DynamicLinker::lookup_global_symbol_for_relocation(DynamicObject::Symbol const& referencing_symbol)
+{
+    ++s_symbol_lookup_count;
+
+    auto symbol = DynamicObject::HashSymbol { referencing_symbol.name() };
+    Optional<DynamicObject::SymbolLookupResult> result;
+    if (auto it = s_symbol_lookup_cache.find(symbol); it != s_symbol_lookup_cache.end()) {
+        ++s_symbol_lookup_cache_hit_count;
+        result = it->value;
+    } else {
+        result = lookup_global_symbol_in_objects(symbol);
+        s_symbol_lookup_cache.set(symbol, result);
+    }
+    return result;
+}
+
 static Result<NonnullRefPtr<DynamicLoader>, DlErrorMessage> map_library(DeprecatedString const& filepath, int fd)
 {
     VERIFY(filepath.starts_with('/'));
@@ -387,6 +419,25 @@ static void drop_loader_promise(StringView promise_to_drop)
     }
 }
 
+static void print_loader_statistics(StringView path, Vector<NonnullRefPtr<DynamicLoader>> const& loaders, Vector<Duration> const& relocation_times)
+{
+    warnln("Loader statistics for {}:", path);
+
+    size_t total_relocation_count = 0;
+    auto total_relocation_time = Duration::zero();
+    for (size_t i = 0; i < loaders.size(); ++i) {
+        auto const& loader = *loaders[i];
+        auto const& object = loader.dynamic_object();
+        size_t relocation_count = object.relocation_section().relocation_count() + object.plt_relocation_section().relocation_count();
+        total_relocation_count += relocation_count;
+        total_relocation_time += relocation_times[i];
+        warnln("    {}: {} relocations in {} us", loader.filepath(), relocation_count, relocation_times[i].to_microseconds());
+    }
+
+    warnln("    Total: {} relocations in {} us", total_relocation_count, total_relocation_time.to_microseconds());
+    warnln("    {} global symbol lookups, {} of them answered by the symbol lookup cache", s_symbol_lookup_count, s_symbol_lookup_cache_hit_count);
+}
+
 static Result<void, DlErrorMessage> link_main_library(DeprecatedString const& path, int flags)
 {
     VERIFY(path.starts_with('/'));
@@ -397,17 +448,37 @@ static Result<void, DlErrorMessage> link_main_library(DeprecatedString const& pa
     for (auto& loader : loaders)
         VERIFY(!loader->map());
 
-    for (auto& loader : loaders) {
+    ScopeGuard clear_symbol_lookup_cache = [] { s_symbol_lookup_cache.clear(); };
+    s_symbol_lookup_count = 0;
+    s_symbol_lookup_cache_hit_count = 0;
+
+    Vector<Duration> relocation_times;
+    if (s_print_loader_statistics)
+        relocation_times.resize(loaders.size());
+
+    for (size_t i = 0; i < loaders.size(); ++i) {
+        auto& loader = loaders[i];
+        Optional<MonotonicTime> start_time;
+        if (s_print_loader_statistics)
+            start_time = MonotonicTime::now();
         bool success = loader->link(flags);
         if (!success) {
             return DlErrorMessage { DeprecatedString::formatted("Failed to link library {}", loader->filepath()) };
         }
+        if (start_time.has_value())
+            relocation_times[i] = MonotonicTime::now() - start_time.value();
     }
 
-    for (auto& loader : loaders) {
+    for (size_t i = 0; i < loaders.size(); ++i) {
+        auto& loader = loaders[i];
+        Optional<MonotonicTime> start_time;
+        if (s_print_loader_statistics)
+            start_time = MonotonicTime::now();
         auto result = loader->load_stage_3(flags);
         VERIFY(!result.is_error());
         auto& object = result.value();
+        if (start_time.has_value())
+            relocation_times[i] += MonotonicTime::now() - start_time.value();
 
         if (loader->filepath().ends_with("/libc.so"sv)) {
             initialize_libc(*object);
@@ -431,6 +502,9 @@ static Result<void, DlErrorMessage> link_main_library(DeprecatedString const& pa
         }
     }
 
+    if (s_print_loader_statistics)
+        print_loader_statistics(path, loaders, relocation_times);
+
     drop_loader_promise("prot_exec"sv);
 
     for (auto& loader : loaders) {
@@ -639,6 +713,10 @@ static void read_environment_variables()
             s_do_breakpoint_trap_before_entry = true;
         }
 
+        if (env_string == "LD_DEBUG=statistics"sv) {
+            s_print_loader_statistics = true;
+        }
+
         constexpr auto library_path_string = "LD_LIBRARY_PATH="sv;
         if (env_string.starts_with(library_path_string)) {
             s_ld_library_path = env_string.substring_view(library_path_string.length());
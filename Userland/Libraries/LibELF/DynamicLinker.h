@@ -15,6 +15,8 @@ namespace ELF {
 class DynamicLinker {
 public:
     static Optional<DynamicObject::SymbolLookupResult> lookup_global_symbol(StringView symbol);
+    // Like lookup_global_symbol(), but remembers the result until the objects that are currently being linked are done.
+    static Optional<DynamicObject::SymbolLookupResult> lookup_global_symbol_for_relocation(DynamicObject::Symbol const& referencing_symbol);
     [[noreturn]] static void linker_main(DeprecatedString&& main_program_path, int fd, bool is_secure, int argc, char** argv, char** envp);
 
     static Optional<DeprecatedString> resolve_library(DeprecatedString const& name, DynamicObject const& parent_object);
@@ -546,7 +546,7 @@ DynamicLoader::RelocationResult DynamicLoader::do_direct_relocation(DynamicObjec
         // in large inheritance hierarchies are involved, there might be tens of references to
         // the same symbol. We can avoid redundant lookups by keeping track of the previous result.
         if (!cached_result.has_value() || !cached_result.value().symbol.definitely_equals(symbol))
-            cached_result = DynamicLoader::CachedLookupResult { symbol, DynamicLoader::lookup_symbol(symbol) };
+            cached_result = DynamicLoader::CachedLookupResult { symbol, DynamicLoader::lookup_symbol_for_relocation(symbol) };
         return cached_result.value().result;
     };
 
@@ -832,4 +832,12 @@ Optional<DynamicObject::SymbolLookupResult> DynamicLoader::lookup_symbol(const E
     return DynamicObject::SymbolLookupResult { symbol.value(), symbol.size(), symbol.address(), symbol.bind(), symbol.type(), &symbol.object() };
 }
 
+Optional<DynamicObject::SymbolLookupResult> DynamicLoader::lookup_symbol_for_relocation(const ELF::DynamicObject::Symbol& symbol)
+{
+    if (symbol.is_undefined() || symbol.bind() == STB_WEAK)
+        return DynamicLinker::lookup_global_symbol_for_relocation(symbol);
+
+    return DynamicObject::SymbolLookupResult { symbol.value(), symbol.size(), symbol.address(), symbol.bind(), symbol.type(), &symbol.object() };
+}
+
 } // end namespace ELF
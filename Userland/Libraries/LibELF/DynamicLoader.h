@@ -150,6 +150,8 @@ private:
     RelocationResult do_direct_relocation(DynamicObject::Relocation const&, Optional<CachedLookupResult>&, ShouldInitializeWeak, ShouldCallIfuncResolver);
     // Will be called from _fixup_plt_entry, as part of the PLT trampoline
     static RelocationResult do_plt_relocation(DynamicObject::Relocation const&, ShouldCallIfuncResolver);
+    // Only used while linking, as lazy PLT relocations can happen on any thread.
+    static Optional<DynamicObject::SymbolLookupResult> lookup_symbol_for_relocation(const ELF::DynamicObject::Symbol&);
     void do_relr_relocations();
     void find_tls_size_and_alignment();
 
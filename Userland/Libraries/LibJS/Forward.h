@@ -186,6 +186,7 @@ class ImportStatement;
 class Identifier;
 class Intrinsics;
 struct IteratorRecord;
+class MarkingThreadPool;
 class MemberExpression;
 class MetaProperty;
 class Module;
@@ -6,6 +6,7 @@
 
 #pragma once
 
+#include <AK/Atomic.h>
 #include <AK/Badge.h>
 #include <AK/Format.h>
 #include <AK/Forward.h>
@@ -37,8 +38,15 @@ public:
     bool is_marked() const { return m_mark; }
     void set_marked(bool b) { m_mark = b; }
 
+    // These may be used while several threads are marking cells at the same time.
+    bool is_marked_atomically() const { return AK::atomic_load(&m_mark, AK::memory_order_relaxed); }
+    // Returns whether the cell was already marked.
+    bool test_and_set_marked_atomically() { return AK::atomic_exchange(&m_mark, true, AK::memory_order_relaxed); }
+
     enum class State {
         Live,
+        // The cell is unreachable and has been finalized, but its destructor hasn't run yet. See Heap::set_lazy_sweeping_enabled().
+        Dying,
         Dead,
     };
 
@@ -110,9 +118,10 @@ protected:
     void set_overrides_must_survive_garbage_collection(bool b) { m_overrides_must_survive_garbage_collection = b; }
 
 private:
-    bool m_mark : 1 { false };
+    // NOTE: This is not a bitfield, so that marking threads can update it atomically without affecting the other flags.
+    bool m_mark { false };
     bool m_overrides_must_survive_garbage_collection : 1 { false };
-    State m_state : 1 { State::Live };
+    State m_state : 2 { State::Live };
 };
 
 }
@@ -19,6 +19,9 @@ CellAllocator::CellAllocator(size_t cell_size)
 
 Cell* CellAllocator::allocate_cell(Heap& heap)
 {
+    while (m_usable_blocks.is_empty() && !m_blocks_to_sweep.is_empty())
+        sweep_block(*m_blocks_to_sweep.first());
+
     if (m_usable_blocks.is_empty()) {
         auto block = HeapBlock::create_with_cell_size(heap, m_cell_size);
         m_usable_blocks.append(*block.leak_ptr());
@@ -33,6 +36,11 @@ Cell* CellAllocator::allocate_cell(Heap& heap)
 }
 
 void CellAllocator::block_did_become_empty(Badge<Heap>, HeapBlock& block)
+{
+    destroy_block(block);
+}
+
+void CellAllocator::destroy_block(HeapBlock& block)
 {
     auto& heap = block.heap();
     block.m_list_node.remove();
@@ -47,4 +55,27 @@ void CellAllocator::block_did_become_usable(Badge<Heap>, HeapBlock& block)
     m_usable_blocks.append(block);
 }
 
+void CellAllocator::block_did_get_dying_cells(Badge<Heap>, HeapBlock& block)
+{
+    block.m_list_node.remove();
+    m_blocks_to_sweep.append(block);
+}
+
+void CellAllocator::sweep_all_blocks(Badge<Heap>)
+{
+    while (!m_blocks_to_sweep.is_empty())
+        sweep_block(*m_blocks_to_sweep.first());
+}
+
+void CellAllocator::sweep_block(HeapBlock& block)
+{
+    block.m_list_node.remove();
+    if (!block.sweep_dying_cells())
+        destroy_block(block);
+    else if (block.is_full())
+        m_full_blocks.append(block);
+    else
+        m_usable_blocks.append(block);
+}
+
 }
@@ -33,18 +33,30 @@ public:
             if (callback(block) == IterationDecision::Break)
                 return IterationDecision::Break;
         }
+        for (auto& block : m_blocks_to_sweep) {
+            if (callback(block) == IterationDecision::Break)
+                return IterationDecision::Break;
+        }
         return IterationDecision::Continue;
     }
 
     void block_did_become_empty(Badge<Heap>, HeapBlock&);
     void block_did_become_usable(Badge<Heap>, HeapBlock&);
+    void block_did_get_dying_cells(Badge<Heap>, HeapBlock&);
+
+    void sweep_all_blocks(Badge<Heap>);
 
 private:
+    void sweep_block(HeapBlock&);
+    void destroy_block(HeapBlock&);
+
     const size_t m_cell_size;
 
     using BlockList = IntrusiveList<&HeapBlock::m_list_node>;
     BlockList m_full_blocks;
     BlockList m_usable_blocks;
+    // Blocks with dying cells, which are swept when this allocator runs out of usable blocks, or before the next garbage collection.
+    BlockList m_blocks_to_sweep;
 };
 
 }
@@ -18,9 +18,15 @@
 #include <LibJS/Heap/Handle.h>
 #include <LibJS/Heap/Heap.h>
 #include <LibJS/Heap/HeapBlock.h>
+#include <LibJS/Heap/MarkingThreadPool.h>
+#include <LibJS/Runtime/Array.h>
+#include <LibJS/Runtime/Intrinsics.h>
 #include <LibJS/Runtime/Object.h>
+#include <LibJS/Runtime/Realm.h>
 #include <LibJS/Runtime/WeakContainer.h>
 #include <LibJS/SafeFunction.h>
+#include <LibThreading/ConditionVariable.h>
+#include <LibThreading/Mutex.h>
 #include <setjmp.h>
 
 #ifdef AK_OS_SERENITY
@@ -61,6 +67,15 @@ Heap::Heap(VM& vm)
     m_allocators.append(make<CellAllocator>(512));
     m_allocators.append(make<CellAllocator>(1024));
     m_allocators.append(make<CellAllocator>(3072));
+
+    auto size_class_count = m_allocators.last()->cell_size() / SIZE_CLASS_GRANULARITY + 1;
+    m_allocators_by_size_class.ensure_capacity(size_class_count);
+    for (size_t size_class = 0; size_class < size_class_count; ++size_class) {
+        auto cell_size = size_class * SIZE_CLASS_GRANULARITY;
+        auto allocator = m_allocators.find_if([&](auto& candidate) { return candidate->cell_size() >= cell_size; });
+        VERIFY(!allocator.is_end());
+        m_allocators_by_size_class.unchecked_append((*allocator).ptr());
+    }
 }
 
 Heap::~Heap()
@@ -72,10 +87,9 @@ Heap::~Heap()
 
 ALWAYS_INLINE CellAllocator& Heap::allocator_for_size(size_t cell_size)
 {
-    for (auto& allocator : m_allocators) {
-        if (allocator->cell_size() >= cell_size)
-            return *allocator;
-    }
+    auto size_class = ceil_div(cell_size, SIZE_CLASS_GRANULARITY);
+    if (size_class < m_allocators_by_size_class.size()) [[likely]]
+        return *m_allocators_by_size_class[size_class];
     dbgln("Cannot get CellAllocator for cell size {}, largest available is {}!", cell_size, m_allocators.last()->cell_size());
     VERIFY_NOT_REACHED();
 }
@@ -285,21 +299,32 @@ void Heap::collect_garbage(CollectionType collection_type, bool print_report)
     perf_event(PERF_EVENT_SIGNPOST, gc_perf_string_id, global_gc_counter++);
 #endif
 
-    Core::ElapsedTimer collection_measurement_timer;
-    if (print_report)
-        collection_measurement_timer.start();
+    if (collection_type == CollectionType::CollectGarbage && m_gc_deferrals) {
+        m_should_gc_when_deferral_ends = true;
+        return;
+    }
+
+    Core::ElapsedTimer collection_measurement_timer(true);
+    collection_measurement_timer.start();
+
+    // NOTE: Cells left dying by the previous collection are destroyed first, so they are never more than one collection late.
+    finish_lazy_sweeping();
 
     if (collection_type == CollectionType::CollectGarbage) {
-        if (m_gc_deferrals) {
-            m_should_gc_when_deferral_ends = true;
-            return;
-        }
         HashMap<Cell*, HeapRoot> roots;
         gather_roots(roots);
         mark_live_cells(roots);
     }
     finalize_unmarked_cells();
-    sweep_dead_cells(print_report, collection_measurement_timer);
+    sweep_dead_cells(m_lazy_sweeping_enabled && collection_type == CollectionType::CollectGarbage, print_report, collection_measurement_timer);
+
+    m_pause_histogram.record(collection_measurement_timer.elapsed_time());
+}
+
+void Heap::finish_lazy_sweeping()
+{
+    for (auto& allocator : m_allocators)
+        allocator->sweep_all_blocks({});
 }
 
 void Heap::gather_roots(HashMap<Cell*, HeapRoot>& roots)
@@ -397,29 +422,75 @@ __attribute__((no_sanitize("address"))) void Heap::gather_conservative_roots(Has
     });
 }
 
-class MarkingVisitor final : public Cell::Visitor {
+// Marking threads share their work in chunks of cells. Each thread keeps a mark stack of its own, and hands a chunk
+// of it over whenever another thread has run out of cells to visit. Marking is done once all threads are out of work.
+class MarkingWorkPool {
+    AK_MAKE_NONCOPYABLE(MarkingWorkPool);
+    AK_MAKE_NONMOVABLE(MarkingWorkPool);
+
 public:
-    explicit MarkingVisitor(Heap& heap, HashMap<Cell*, HeapRoot> const& roots)
-        : m_heap(heap)
+    static constexpr size_t chunk_size = 64;
+
+    explicit MarkingWorkPool(size_t thread_count)
+        : m_thread_count(thread_count)
     {
-        m_heap.find_min_and_max_block_addresses(m_min_block_address, m_max_block_address);
-        m_heap.for_each_block([&](auto& block) {
-            m_all_live_heap_blocks.set(&block);
-            return IterationDecision::Continue;
-        });
+    }
 
-        for (auto* root : roots.keys()) {
-            visit(root);
+    bool has_idle_threads() const { return m_idle_thread_count.load(AK::memory_order_relaxed) > 0; }
+
+    void give(Vector<Cell&>&& chunk)
+    {
+        Threading::MutexLocker locker(m_mutex);
+        m_chunks.append(move(chunk));
+        m_work_was_given.signal();
+    }
+
+    // Waits until there's a chunk to take, and returns false instead once every thread has run out of work.
+    bool take(Vector<Cell&>& work_queue)
+    {
+        Threading::MutexLocker locker(m_mutex);
+        m_idle_thread_count.fetch_add(1, AK::memory_order_relaxed);
+        for (;;) {
+            if (!m_chunks.is_empty()) {
+                work_queue = m_chunks.take_last();
+                m_idle_thread_count.fetch_sub(1, AK::memory_order_relaxed);
+                return true;
+            }
+            if (m_idle_thread_count.load(AK::memory_order_relaxed) == m_thread_count) {
+                m_work_was_given.broadcast();
+                return false;
+            }
+            m_work_was_given.wait();
         }
     }
 
+private:
+    size_t const m_thread_count { 0 };
+    Atomic<size_t> m_idle_thread_count { 0 };
+
+    Threading::Mutex m_mutex;
+    Threading::ConditionVariable m_work_was_given { m_mutex };
+    Vector<Vector<Cell&>> m_chunks;
+};
+
+class MarkingVisitor final : public Cell::Visitor {
+public:
+    MarkingVisitor(HashTable<HeapBlock*> const& all_live_heap_blocks, FlatPtr min_block_address, FlatPtr max_block_address)
+        : m_all_live_heap_blocks(all_live_heap_blocks)
+        , m_min_block_address(min_block_address)
+        , m_max_block_address(max_block_address)
+    {
+    }
+
+    // Once a work pool is set, marking happens on several threads at once, and this visitor shares its work with them.
+    void set_work_pool(MarkingWorkPool* work_pool) { m_work_pool = work_pool; }
+
     virtual void visit_impl(Cell& cell) override
     {
-        if (cell.is_marked())
+        if (!try_mark(cell))
             return;
         dbgln_if(HEAP_DEBUG, "  ! {}", &cell);
 
-        cell.set_marked(true);
         m_work_queue.append(cell);
     }
 
@@ -432,39 +503,103 @@ public:
             add_possible_value(possible_pointers, raw_pointer_sized_values[i], HeapRoot { .type = HeapRoot::Type::HeapFunctionCapturedPointer }, m_min_block_address, m_max_block_address);
 
         for_each_cell_among_possible_pointers(m_all_live_heap_blocks, possible_pointers, [&](Cell* cell, FlatPtr) {
-            if (cell->is_marked())
-                return;
             if (cell->state() != Cell::State::Live)
                 return;
-            cell->set_marked(true);
+            if (!try_mark(*cell))
+                return;
             m_work_queue.append(*cell);
         });
     }
 
     void mark_all_live_cells()
     {
-        while (!m_work_queue.is_empty()) {
-            m_work_queue.take_last().visit_edges(*this);
+        for (;;) {
+            while (!m_work_queue.is_empty()) {
+                m_work_queue.take_last().visit_edges(*this);
+                if (m_work_pool && m_work_queue.size() >= 2 * MarkingWorkPool::chunk_size && m_work_pool->has_idle_threads())
+                    give_chunk_to_work_pool();
+            }
+            if (!m_work_pool || !m_work_pool->take(m_work_queue))
+                return;
         }
     }
 
 private:
-    Heap& m_heap;
+    // Returns whether the cell was newly marked by this visitor.
+    ALWAYS_INLINE bool try_mark(Cell& cell)
+    {
+        if (!m_work_pool) {
+            if (cell.is_marked())
+                return false;
+            cell.set_marked(true);
+            return true;
+        }
+        if (cell.is_marked_atomically())
+            return false;
+        return !cell.test_and_set_marked_atomically();
+    }
+
+    void give_chunk_to_work_pool()
+    {
+        Vector<Cell&> chunk;
+        chunk.ensure_capacity(MarkingWorkPool::chunk_size);
+        for (size_t i = 0; i < MarkingWorkPool::chunk_size; ++i)
+            chunk.unchecked_append(m_work_queue.take_last());
+        m_work_pool->give(move(chunk));
+    }
+
     Vector<Cell&> m_work_queue;
-    HashTable<HeapBlock*> m_all_live_heap_blocks;
+    MarkingWorkPool* m_work_pool { nullptr };
+    HashTable<HeapBlock*> const& m_all_live_heap_blocks;
     FlatPtr m_min_block_address;
     FlatPtr m_max_block_address;
 };
 
+MarkingThreadPool* Heap::marking_thread_pool()
+{
+    if (!m_did_try_to_create_marking_thread_pool) {
+        m_did_try_to_create_marking_thread_pool = true;
+        m_marking_thread_pool = MarkingThreadPool::try_create(MAX_MARKING_THREAD_COUNT);
+    }
+    return m_marking_thread_pool.ptr();
+}
+
 void Heap::mark_live_cells(HashMap<Cell*, HeapRoot> const& roots)
 {
     dbgln_if(HEAP_DEBUG, "mark_live_cells:");
 
-    MarkingVisitor visitor(*this, roots);
+    FlatPtr min_block_address, max_block_address;
+    find_min_and_max_block_addresses(min_block_address, max_block_address);
+
+    HashTable<HeapBlock*> all_live_heap_blocks;
+    for_each_block([&](auto& block) {
+        all_live_heap_blocks.set(&block);
+        return IterationDecision::Continue;
+    });
+
+    MarkingVisitor visitor(all_live_heap_blocks, min_block_address, max_block_address);
+
+    for (auto* root : roots.keys())
+        visitor.visit(root);
 
     vm().bytecode_interpreter().visit_edges(visitor);
 
-    visitor.mark_all_live_cells();
+    auto* thread_pool = m_parallel_marking_enabled && all_live_heap_blocks.size() >= PARALLEL_MARKING_MIN_BLOCK_COUNT ? marking_thread_pool() : nullptr;
+    if (thread_pool) {
+        MarkingWorkPool work_pool(thread_pool->thread_count());
+        visitor.set_work_pool(&work_pool);
+        thread_pool->run([&](size_t thread_index) {
+            if (thread_index == 0) {
+                visitor.mark_all_live_cells();
+                return;
+            }
+            MarkingVisitor helper_visitor(all_live_heap_blocks, min_block_address, max_block_address);
+            helper_visitor.set_work_pool(&work_pool);
+            helper_visitor.mark_all_live_cells();
+        });
+    } else {
+        visitor.mark_all_live_cells();
+    }
 
     for (auto& inverse_root : m_uprooted_cells)
         inverse_root->set_marked(false);
@@ -490,11 +625,12 @@ void Heap::finalize_unmarked_cells()
     });
 }
 
-void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measurement_timer)
+void Heap::sweep_dead_cells(bool sweep_lazily, bool print_report, Core::ElapsedTimer const& measurement_timer)
 {
     dbgln_if(HEAP_DEBUG, "sweep_dead_cells:");
     Vector<HeapBlock*, 32> empty_blocks;
     Vector<HeapBlock*, 32> full_blocks_that_became_usable;
+    Vector<HeapBlock*, 32> blocks_with_dying_cells;
 
     size_t collected_cells = 0;
     size_t live_cells = 0;
@@ -503,11 +639,17 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
 
     for_each_block([&](auto& block) {
         bool block_has_live_cells = false;
+        bool block_has_dying_cells = false;
         bool block_was_full = block.is_full();
         block.template for_each_cell_in_state<Cell::State::Live>([&](Cell* cell) {
             if (!cell->is_marked() && !cell_must_survive_garbage_collection(*cell)) {
                 dbgln_if(HEAP_DEBUG, "  ~ {}", cell);
-                block.deallocate(cell);
+                if (sweep_lazily) {
+                    cell->set_state(Cell::State::Dying);
+                    block_has_dying_cells = true;
+                } else {
+                    block.deallocate(cell);
+                }
                 ++collected_cells;
                 collected_cell_bytes += block.cell_size();
             } else {
@@ -517,15 +659,21 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
                 live_cell_bytes += block.cell_size();
             }
         });
-        if (!block_has_live_cells)
+        if (block_has_dying_cells)
+            blocks_with_dying_cells.append(&block);
+        else if (!block_has_live_cells)
             empty_blocks.append(&block);
         else if (block_was_full != block.is_full())
             full_blocks_that_became_usable.append(&block);
         return IterationDecision::Continue;
     });
 
-    for (auto& weak_container : m_weak_containers)
+    for (auto& weak_container : m_weak_containers) {
+        // NOTE: A weak container that is dying itself must not act on the cells it refers to anymore.
+        if (auto* cell = dynamic_cast<Cell*>(&weak_container); cell && cell->state() != Cell::State::Live)
+            continue;
         weak_container.remove_dead_cells({});
+    }
 
     for (auto* block : empty_blocks) {
         dbgln_if(HEAP_DEBUG, " - HeapBlock empty @ {}: cell_size={}", block, block->cell_size());
@@ -537,6 +685,11 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
         allocator_for_size(block->cell_size()).block_did_become_usable({}, *block);
     }
 
+    for (auto* block : blocks_with_dying_cells) {
+        dbgln_if(HEAP_DEBUG, " - HeapBlock has dying cells @ {}: cell_size={}", block, block->cell_size());
+        allocator_for_size(block->cell_size()).block_did_get_dying_cells({}, *block);
+    }
+
     if constexpr (HEAP_DEBUG) {
         for_each_block([&](auto& block) {
             dbgln(" > Live HeapBlock @ {}: cell_size={}", &block, block.cell_size());
@@ -565,6 +718,49 @@ void Heap::sweep_dead_cells(bool print_report, Core::ElapsedTimer const& measure
     }
 }
 
+Optional<Duration> Heap::PauseHistogram::bucket_upper_bound(size_t index)
+{
+    VERIFY(index < bucket_count);
+    if (index == bucket_count - 1)
+        return {};
+    return Duration::from_microseconds(100 << index);
+}
+
+void Heap::PauseHistogram::record(Duration pause_time)
+{
+    size_t index = 0;
+    while (index < bucket_count - 1 && pause_time >= *bucket_upper_bound(index))
+        ++index;
+    ++bucket_pause_counts[index];
+    ++pause_count;
+    total_pause_time += pause_time;
+    longest_pause_time = max(longest_pause_time, pause_time);
+}
+
+static Value duration_to_milliseconds_value(Duration duration)
+{
+    return Value(static_cast<double>(duration.to_nanoseconds()) / 1'000'000);
+}
+
+NonnullGCPtr<Object> Heap::PauseHistogram::to_object(Realm& realm) const
+{
+    Vector<Value> buckets;
+    for (size_t i = 0; i < bucket_count; ++i) {
+        auto bucket = Object::create(realm, realm.intrinsics().object_prototype());
+        auto upper_bound = bucket_upper_bound(i);
+        bucket->define_direct_property("upperBoundMilliseconds", upper_bound.has_value() ? duration_to_milliseconds_value(*upper_bound) : js_infinity(), default_attributes);
+        bucket->define_direct_property("pauseCount", Value(static_cast<double>(bucket_pause_counts[i])), default_attributes);
+        buckets.append(bucket);
+    }
+
+    auto histogram = Object::create(realm, realm.intrinsics().object_prototype());
+    histogram->define_direct_property("pauseCount", Value(static_cast<double>(pause_count)), default_attributes);
+    histogram->define_direct_property("totalMilliseconds", duration_to_milliseconds_value(total_pause_time), default_attributes);
+    histogram->define_direct_property("longestMilliseconds", duration_to_milliseconds_value(longest_pause_time), default_attributes);
+    histogram->define_direct_property("buckets", Array::create_from(realm, buckets), default_attributes);
+    return histogram;
+}
+
 void Heap::defer_gc()
 {
     ++m_gc_deferrals;
@@ -6,11 +6,14 @@
 
 #pragma once
 
+#include <AK/Array.h>
 #include <AK/Badge.h>
 #include <AK/HashTable.h>
 #include <AK/IntrusiveList.h>
 #include <AK/Noncopyable.h>
 #include <AK/NonnullOwnPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/Time.h>
 #include <AK/Types.h>
 #include <AK/Vector.h>
 #include <LibCore/Forward.h>
@@ -68,6 +71,36 @@ public:
     bool should_collect_on_every_allocation() const { return m_should_collect_on_every_allocation; }
     void set_should_collect_on_every_allocation(bool b) { m_should_collect_on_every_allocation = b; }
 
+    // With lazy sweeping, garbage collection only finalizes dead cells, and leaves running their destructors to later
+    // allocations of the same size (or at the latest, the next garbage collection). This makes collections shorter,
+    // but may only be enabled if no destructor of a cell in this heap relies on running at collection time.
+    bool lazy_sweeping_enabled() const { return m_lazy_sweeping_enabled; }
+    void set_lazy_sweeping_enabled(bool b) { m_lazy_sweeping_enabled = b; }
+
+    // With parallel marking, large heaps are marked by a small pool of helper threads along with the collecting thread.
+    // This needs every visit_edges() in this heap to be safe to run on any thread, as long as the mutator is paused.
+    bool parallel_marking_enabled() const { return m_parallel_marking_enabled; }
+    void set_parallel_marking_enabled(bool b) { m_parallel_marking_enabled = b; }
+
+    struct PauseHistogram {
+        static constexpr size_t bucket_count = 12;
+
+        // Bucket i counts the pauses shorter than 2^i * 100µs (and not shorter than the bound of bucket i - 1).
+        // The last bucket counts all pauses that are too long for the others.
+        static Optional<Duration> bucket_upper_bound(size_t index);
+
+        void record(Duration);
+        NonnullGCPtr<Object> to_object(Realm&) const;
+
+        AK::Array<u64, bucket_count> bucket_pause_counts {};
+        u64 pause_count { 0 };
+        Duration total_pause_time;
+        Duration longest_pause_time;
+    };
+
+    // Keeps track of how long the program was paused by each garbage collection.
+    PauseHistogram const& pause_histogram() const { return m_pause_histogram; }
+
     void did_create_handle(Badge<HandleImpl>, HandleImpl&);
     void did_destroy_handle(Badge<HandleImpl>, HandleImpl&);
 
@@ -99,7 +132,10 @@ private:
     void gather_asan_fake_stack_roots(HashMap<FlatPtr, HeapRoot>&, FlatPtr, FlatPtr min_block_address, FlatPtr max_block_address);
     void mark_live_cells(HashMap<Cell*, HeapRoot> const& live_cells);
     void finalize_unmarked_cells();
-    void sweep_dead_cells(bool print_report, Core::ElapsedTimer const&);
+    void sweep_dead_cells(bool sweep_lazily, bool print_report, Core::ElapsedTimer const&);
+    void finish_lazy_sweeping();
+
+    MarkingThreadPool* marking_thread_pool();
 
     CellAllocator& allocator_for_size(size_t);
 
@@ -117,9 +153,23 @@ private:
     size_t m_allocated_bytes_since_last_gc { 0 };
 
     bool m_should_collect_on_every_allocation { false };
+    bool m_lazy_sweeping_enabled { false };
+    bool m_parallel_marking_enabled { false };
+
+    // With parallel marking enabled, marking is spread over several threads once the heap has at least this many blocks.
+    static constexpr size_t PARALLEL_MARKING_MIN_BLOCK_COUNT { 256 };
+    static constexpr size_t MAX_MARKING_THREAD_COUNT { 4 };
+    OwnPtr<MarkingThreadPool> m_marking_thread_pool;
+    bool m_did_try_to_create_marking_thread_pool { false };
+
+    PauseHistogram m_pause_histogram;
 
     Vector<NonnullOwnPtr<CellAllocator>> m_allocators;
 
+    // Maps each cell size, rounded up to a multiple of the granularity, to the smallest allocator that fits it.
+    static constexpr size_t SIZE_CLASS_GRANULARITY { 16 };
+    Vector<CellAllocator*> m_allocators_by_size_class;
+
     HandleImpl::List m_handles;
     MarkedVectorBase::List m_marked_vectors;
     WeakContainer::List m_weak_containers;
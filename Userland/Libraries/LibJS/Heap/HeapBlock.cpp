@@ -34,6 +34,7 @@ NonnullOwnPtr<HeapBlock> HeapBlock::create_with_cell_size(Heap& heap, size_t cel
 HeapBlock::HeapBlock(Heap& heap, size_t cell_size)
     : HeapBlockBase(heap)
     , m_cell_size(cell_size)
+    , m_cell_count((block_size - sizeof(HeapBlock)) / cell_size)
 {
     VERIFY(cell_size >= sizeof(FreelistEntry));
     ASAN_POISON_MEMORY_REGION(m_storage, block_size - sizeof(HeapBlock));
@@ -43,7 +44,7 @@ void HeapBlock::deallocate(Cell* cell)
 {
     VERIFY(is_valid_cell_pointer(cell));
     VERIFY(!m_freelist || is_valid_cell_pointer(m_freelist));
-    VERIFY(cell->state() == Cell::State::Live);
+    VERIFY(cell->state() != Cell::State::Dead);
     VERIFY(!cell->is_marked());
 
     cell->~Cell();
@@ -63,4 +64,16 @@ void HeapBlock::deallocate(Cell* cell)
 #endif
 }
 
+bool HeapBlock::sweep_dying_cells()
+{
+    bool has_live_cells = false;
+    for_each_cell([&](Cell* cell) {
+        if (cell->state() == Cell::State::Dying)
+            deallocate(cell);
+        else if (cell->state() == Cell::State::Live)
+            has_live_cells = true;
+    });
+    return has_live_cells;
+}
+
 }
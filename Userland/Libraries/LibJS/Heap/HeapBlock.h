@@ -29,7 +29,7 @@ public:
     static NonnullOwnPtr<HeapBlock> create_with_cell_size(Heap&, size_t);
 
     size_t cell_size() const { return m_cell_size; }
-    size_t cell_count() const { return (block_size - sizeof(HeapBlock)) / m_cell_size; }
+    size_t cell_count() const { return m_cell_count; }
     bool is_full() const { return !has_lazy_freelist() && !m_freelist; }
 
     ALWAYS_INLINE Cell* allocate()
@@ -50,6 +50,9 @@ public:
 
     void deallocate(Cell*);
 
+    // Destroys the cells that were left dying by the last garbage collection, and returns whether any live cells remain.
+    bool sweep_dying_cells();
+
     template<typename Callback>
     void for_each_cell(Callback callback)
     {
@@ -107,6 +110,8 @@ private:
     }
 
     size_t m_cell_size { 0 };
+    // NOTE: This is cached so that allocating from the lazy freelist doesn't have to divide by the cell size.
+    size_t m_cell_count { 0 };
     size_t m_next_lazy_freelist_index { 0 };
     GCPtr<FreelistEntry> m_freelist;
     alignas(__BIGGEST_ALIGNMENT__) u8 m_storage[];
@@ -0,0 +1,86 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <LibJS/Heap/MarkingThreadPool.h>
+#include <unistd.h>
+
+namespace JS {
+
+OwnPtr<MarkingThreadPool> MarkingThreadPool::try_create(size_t max_thread_count)
+{
+    auto processor_count = sysconf(_SC_NPROCESSORS_ONLN);
+    if (processor_count <= 1 || max_thread_count <= 1)
+        return nullptr;
+    auto thread_count = min(static_cast<size_t>(processor_count), max_thread_count);
+    return adopt_own(*new MarkingThreadPool(thread_count - 1));
+}
+
+MarkingThreadPool::MarkingThreadPool(size_t helper_count)
+{
+    m_helpers.ensure_capacity(helper_count);
+    for (size_t i = 0; i < helper_count; ++i) {
+        // Index 0 is the thread that collects garbage.
+        auto index = i + 1;
+        auto helper = Threading::Thread::construct([this, index] { return helper_main(index); }, "JS GC marker"sv);
+        helper->start();
+        m_helpers.unchecked_append(move(helper));
+    }
+}
+
+MarkingThreadPool::~MarkingThreadPool()
+{
+    {
+        Threading::MutexLocker locker(m_mutex);
+        m_shutting_down = true;
+        m_task_was_posted.broadcast();
+    }
+    for (auto& helper : m_helpers)
+        (void)helper->join();
+}
+
+void MarkingThreadPool::run(Function<void(size_t)> const& task)
+{
+    {
+        Threading::MutexLocker locker(m_mutex);
+        VERIFY(!m_task);
+        m_task = &task;
+        m_busy_helper_count = m_helpers.size();
+        ++m_task_generation;
+        m_task_was_posted.broadcast();
+    }
+
+    task(0);
+
+    Threading::MutexLocker locker(m_mutex);
+    while (m_busy_helper_count > 0)
+        m_helpers_did_finish.wait();
+    m_task = nullptr;
+}
+
+intptr_t MarkingThreadPool::helper_main(size_t index)
+{
+    u64 last_task_generation = 0;
+    for (;;) {
+        Function<void(size_t)> const* task = nullptr;
+        {
+            Threading::MutexLocker locker(m_mutex);
+            while (!m_shutting_down && m_task_generation == last_task_generation)
+                m_task_was_posted.wait();
+            if (m_shutting_down)
+                return 0;
+            last_task_generation = m_task_generation;
+            task = m_task;
+        }
+
+        (*task)(index);
+
+        Threading::MutexLocker locker(m_mutex);
+        if (--m_busy_helper_count == 0)
+            m_helpers_did_finish.signal();
+    }
+}
+
+}
@@ -0,0 +1,53 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#pragma once
+
+#include <AK/Function.h>
+#include <AK/Noncopyable.h>
+#include <AK/NonnullRefPtr.h>
+#include <AK/OwnPtr.h>
+#include <AK/Vector.h>
+#include <LibThreading/ConditionVariable.h>
+#include <LibThreading/Mutex.h>
+#include <LibThreading/Thread.h>
+
+namespace JS {
+
+// Threads that help the heap mark live cells. The thread that collects garbage always takes part in marking as well,
+// so a pool with N helper threads has N + 1 marking threads in total.
+class MarkingThreadPool {
+    AK_MAKE_NONCOPYABLE(MarkingThreadPool);
+    AK_MAKE_NONMOVABLE(MarkingThreadPool);
+
+public:
+    // Returns nullptr if there is only one processor to mark on.
+    static OwnPtr<MarkingThreadPool> try_create(size_t max_thread_count);
+    ~MarkingThreadPool();
+
+    size_t thread_count() const { return m_helpers.size() + 1; }
+
+    // Runs the task on every marking thread and returns once all of them have finished it.
+    // Each thread is passed its index, the calling thread being index 0.
+    void run(Function<void(size_t)> const& task);
+
+private:
+    explicit MarkingThreadPool(size_t helper_count);
+
+    intptr_t helper_main(size_t index);
+
+    Vector<NonnullRefPtr<Threading::Thread>> m_helpers;
+
+    Threading::Mutex m_mutex;
+    Threading::ConditionVariable m_task_was_posted { m_mutex };
+    Threading::ConditionVariable m_helpers_did_finish { m_mutex };
+    Function<void(size_t)> const* m_task { nullptr };
+    u64 m_task_generation { 0 };
+    size_t m_busy_helper_count { 0 };
+    bool m_shutting_down { false };
+};
+
+}
@@ -0,0 +1,53 @@
+test("weak containers forget cells as soon as a lazy collection finds them dead", () => {
+    setLazyGCSweeping(true);
+    try {
+        const weakSet = new WeakSet();
+        const item = { a: 1 };
+        weakSet.add(item);
+        expect(getWeakSetSize(weakSet)).toBe(1);
+
+        markAsGarbage("item");
+        gc();
+
+        expect(getWeakSetSize(weakSet)).toBe(0);
+    } finally {
+        setLazyGCSweeping(false);
+    }
+});
+
+test("dying cells make room for later allocations of the same size", () => {
+    setLazyGCSweeping(true);
+    try {
+        const garbage = [];
+        for (let i = 0; i < 50_000; ++i) garbage.push({ value: -i });
+
+        markAsGarbage("garbage");
+        gc();
+
+        // These cells can only be allocated once the dying cells have been destroyed.
+        const live = [];
+        for (let i = 0; i < 50_000; ++i) live.push({ value: i });
+        gc();
+
+        let sum = 0;
+        for (const object of live) sum += object.value;
+        expect(sum).toBe((49_999 * 50_000) / 2);
+    } finally {
+        setLazyGCSweeping(false);
+    }
+});
+
+test("dying cells are destroyed by the next collection after lazy sweeping is turned off", () => {
+    setLazyGCSweeping(true);
+    const garbage = [];
+    for (let i = 0; i < 10_000; ++i) garbage.push({ value: i });
+    markAsGarbage("garbage");
+    gc();
+
+    setLazyGCSweeping(false);
+    gc();
+
+    const live = [];
+    for (let i = 0; i < 10_000; ++i) live.push([i]);
+    expect(live[9_999][0]).toBe(9_999);
+});
@@ -0,0 +1,58 @@
+test("parallel marking of a large heap finds every live cell", () => {
+    setParallelGCMarking(true);
+    try {
+        // Marking is only spread over several threads once the heap has a few hundred blocks.
+        const lists = [];
+        for (let i = 0; i < 1000; ++i) {
+            let list = null;
+            for (let j = 0; j < 200; ++j) list = { value: j, next: list };
+            lists.push(list);
+        }
+
+        // A single long chain is found by one thread, and the others have to take work from it to help.
+        const chain = {};
+        let o = chain;
+        for (let i = 0; i < 100_000; ++i) {
+            o.next = { value: i };
+            o = o.next;
+        }
+
+        for (let i = 0; i < 3; ++i) gc();
+
+        let sum = 0;
+        for (const list of lists) {
+            for (let node = list; node !== null; node = node.next) sum += node.value;
+        }
+        expect(sum).toBe(1000 * ((199 * 200) / 2));
+
+        let length = 0;
+        for (let node = chain.next; node !== undefined; node = node.next) {
+            if (node.value !== length) break;
+            ++length;
+        }
+        expect(length).toBe(100_000);
+    } finally {
+        setParallelGCMarking(false);
+    }
+});
+
+test("parallel marking of a large heap still frees dead cells", () => {
+    setParallelGCMarking(true);
+    try {
+        const weakSet = new WeakSet();
+        const live = [];
+        for (let i = 0; i < 100_000; ++i) live.push({ value: i });
+
+        const garbage = {};
+        weakSet.add(garbage);
+        weakSet.add(live[0]);
+
+        markAsGarbage("garbage");
+        gc();
+
+        expect(getWeakSetSize(weakSet)).toBe(1);
+        expect(weakSet.has(live[0])).toBeTrue();
+    } finally {
+        setParallelGCMarking(false);
+    }
+});
@@ -0,0 +1,23 @@
+test("every collection is recorded in the pause histogram", () => {
+    const before = gcPauseHistogram();
+    gc();
+    gc();
+    const after = gcPauseHistogram();
+
+    expect(after.pauseCount).toBeGreaterThanOrEqual(before.pauseCount + 2);
+    expect(after.totalMilliseconds).toBeGreaterThanOrEqual(before.totalMilliseconds);
+    expect(after.totalMilliseconds).toBeGreaterThanOrEqual(after.longestMilliseconds);
+
+    let bucketPauseCount = 0;
+    for (const bucket of after.buckets) bucketPauseCount += bucket.pauseCount;
+    expect(bucketPauseCount).toBe(after.pauseCount);
+});
+
+test("buckets double in size", () => {
+    const { buckets } = gcPauseHistogram();
+    expect(buckets).toHaveLength(12);
+    expect(buckets[0].upperBoundMilliseconds).toBe(0.1);
+    for (let i = 1; i < buckets.length - 1; ++i)
+        expect(buckets[i].upperBoundMilliseconds).toBe(buckets[i - 1].upperBoundMilliseconds * 2);
+    expect(buckets[buckets.length - 1].upperBoundMilliseconds).toBe(Infinity);
+});
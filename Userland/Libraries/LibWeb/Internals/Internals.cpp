@@ -41,6 +41,11 @@ void Internals::gc()
     vm().heap().collect_garbage();
 }
 
+JS::Object* Internals::gc_pause_histogram()
+{
+    return vm().heap().pause_histogram().to_object(realm());
+}
+
 JS::Object* Internals::hit_test(double x, double y)
 {
     auto* active_document = global_object().browsing_context()->top_level_browsing_context()->active_document();
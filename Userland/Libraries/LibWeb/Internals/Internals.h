@@ -19,6 +19,7 @@ public:
     void signal_text_test_is_done();
 
     void gc();
+    JS::Object* gc_pause_histogram();
     JS::Object* hit_test(double x, double y);
 
 private:
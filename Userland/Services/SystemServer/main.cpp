@@ -133,6 +133,7 @@ static ErrorOr<void> prepare_bare_minimum_devtmpfs_directory_structure()
     TRY(Core::System::create_char_device("/dev/null"sv, 0666, 1, 3));
     TRY(Core::System::create_char_device("/dev/full"sv, 0666, 1, 7));
     TRY(Core::System::create_char_device("/dev/random"sv, 0666, 1, 8));
+    TRY(Core::System::create_char_device("/dev/profile"sv, 0600, 31, 0));
     TRY(Core::System::create_char_device("/dev/console"sv, 0666, 5, 1));
     TRY(Core::System::create_char_device("/dev/ptmx"sv, 0666, 5, 2));
     TRY(Core::System::create_char_device("/dev/tty"sv, 0666, 5, 0));
@@ -35,7 +35,7 @@ ErrorOr<int> serenity_main(Main::Arguments)
     TRY(Core::System::unveil("/dev/input/", "rw"));
     TRY(Core::System::unveil("/bin/keymap", "x"));
     TRY(Core::System::unveil("/sys/kernel/keymap", "r"));
-    TRY(Core::System::unveil("/sys/kernel/processes", "r"));
+    TRY(Core::System::unveil("/sys/kernel/process_statistics", "r"));
     TRY(Core::System::unveil("/etc/passwd", "r"));
 
     struct sigaction act = {};
@@ -54,6 +54,7 @@ private:
     JS_DECLARE_NATIVE_FUNCTION(load_json);
     JS_DECLARE_NATIVE_FUNCTION(last_value_getter);
     JS_DECLARE_NATIVE_FUNCTION(print);
+    JS_DECLARE_NATIVE_FUNCTION(gc_pause_histogram);
 };
 
 class ScriptObject final : public JS::GlobalObject {
@@ -71,6 +72,7 @@ private:
     JS_DECLARE_NATIVE_FUNCTION(load_ini);
     JS_DECLARE_NATIVE_FUNCTION(load_json);
     JS_DECLARE_NATIVE_FUNCTION(print);
+    JS_DECLARE_NATIVE_FUNCTION(gc_pause_histogram);
 };
 
 static bool s_dump_ast = false;
@@ -352,6 +354,7 @@ void ReplObject::initialize(JS::Realm& realm)
     define_native_function(realm, "loadINI", load_ini, 1, attr);
     define_native_function(realm, "loadJSON", load_json, 1, attr);
     define_native_function(realm, "print", print, 1, attr);
+    define_native_function(realm, "gcPauseHistogram", gc_pause_histogram, 0, attr);
 
     define_native_accessor(
         realm,
@@ -397,6 +400,7 @@ JS_DEFINE_NATIVE_FUNCTION(ReplObject::repl_help)
 {
     warnln("REPL commands:");
     warnln("    exit(code): exit the REPL with specified code. Defaults to 0.");
+    warnln("    gcPauseHistogram(): get statistics on how long garbage collections have paused execution.");
     warnln("    help(): display this menu");
     warnln("    loadINI(file): load the given file as INI.");
     warnln("    loadJSON(file): load the given file as JSON.");
@@ -426,6 +430,11 @@ JS_DEFINE_NATIVE_FUNCTION(ReplObject::print)
     return JS::js_undefined();
 }
 
+JS_DEFINE_NATIVE_FUNCTION(ReplObject::gc_pause_histogram)
+{
+    return vm.heap().pause_histogram().to_object(*vm.current_realm());
+}
+
 void ScriptObject::initialize(JS::Realm& realm)
 {
     Base::initialize(realm);
@@ -435,6 +444,7 @@ void ScriptObject::initialize(JS::Realm& realm)
     define_native_function(realm, "loadINI", load_ini, 1, attr);
     define_native_function(realm, "loadJSON", load_json, 1, attr);
     define_native_function(realm, "print", print, 1, attr);
+    define_native_function(realm, "gcPauseHistogram", gc_pause_histogram, 0, attr);
 }
 
 JS_DEFINE_NATIVE_FUNCTION(ScriptObject::load_ini)
@@ -458,6 +468,11 @@ JS_DEFINE_NATIVE_FUNCTION(ScriptObject::print)
     return JS::js_undefined();
 }
 
+JS_DEFINE_NATIVE_FUNCTION(ScriptObject::gc_pause_histogram)
+{
+    return vm.heap().pause_histogram().to_object(*vm.current_realm());
+}
+
 static ErrorOr<void> repl(JS::Realm& realm)
 {
     while (!s_fail_repl) {
@@ -558,9 +573,11 @@ private:
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
-    TRY(Core::System::pledge("stdio rpath wpath cpath tty sigaction"));
+    TRY(Core::System::pledge("stdio rpath wpath cpath tty sigaction thread"));
 
     bool gc_on_every_allocation = false;
+    bool lazy_gc_sweeping = false;
+    bool parallel_gc_marking = false;
     bool disable_syntax_highlight = false;
     bool disable_debug_printing = false;
     bool use_test262_global = false;
@@ -576,6 +593,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(s_strip_ansi, "Disable ANSI colors", "disable-ansi-colors", 'i');
     args_parser.add_option(s_disable_source_location_hints, "Disable source location hints", "disable-source-location-hints", 'h');
     args_parser.add_option(gc_on_every_allocation, "GC on every allocation", "gc-on-every-allocation", 'g');
+    args_parser.add_option(lazy_gc_sweeping, "Destroy dead cells lazily after GC", "lazy-gc-sweeping", {});
+    args_parser.add_option(parallel_gc_marking, "Mark large heaps on several threads during GC", "parallel-gc-marking", {});
     args_parser.add_option(disable_syntax_highlight, "Disable live syntax highlighting", "no-syntax-highlight", 's');
     args_parser.add_option(disable_debug_printing, "Disable debug output", "disable-debug-output", {});
     args_parser.add_option(evaluate_script, "Evaluate argument as a script", "evaluate", 'c', "script");
@@ -622,6 +641,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         ReplConsoleClient console_client(console_object.console());
         console_object.console().set_client(console_client);
         g_vm->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        g_vm->heap().set_lazy_sweeping_enabled(lazy_gc_sweeping);
+        g_vm->heap().set_parallel_marking_enabled(parallel_gc_marking);
 
         auto& global_environment = realm.global_environment();
 
@@ -839,6 +860,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         ReplConsoleClient console_client(console_object.console());
         console_object.console().set_client(console_client);
         g_vm->heap().set_should_collect_on_every_allocation(gc_on_every_allocation);
+        g_vm->heap().set_lazy_sweeping_enabled(lazy_gc_sweeping);
+        g_vm->heap().set_parallel_marking_enabled(parallel_gc_marking);
 
         signal(SIGINT, [](int) {
             sigint_handler();
@@ -4,14 +4,27 @@
  * SPDX-License-Identifier: BSD-2-Clause
  */
 
+#include <AK/Atomic.h>
+#include <AK/HashMap.h>
+#include <AK/QuickSort.h>
+#include <Kernel/API/Ioctl.h>
+#include <Kernel/API/PerformanceEvent.h>
 #include <LibCore/ArgsParser.h>
 #include <LibCore/System.h>
 #include <LibMain/Main.h>
+#include <LibSymbolication/Symbolication.h>
+#include <fcntl.h>
+#include <poll.h>
 #include <serenity.h>
+#include <signal.h>
 #include <stdio.h>
 #include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <unistd.h>
 
 static Optional<pid_t> determine_pid_to_profile(StringView pid_argument, bool all_processes);
+static ErrorOr<int> stream_system_wide_profile(u64 event_mask, size_t events_per_processor, size_t top_symbol_count);
 
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
@@ -24,6 +37,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     bool enable = false;
     bool disable = false;
     bool all_processes = false;
+    bool stream = false;
+    size_t events_per_processor = 4096;
+    size_t top_symbol_count = 20;
     u64 event_mask = PERF_EVENT_MMAP | PERF_EVENT_MUNMAP | PERF_EVENT_PROCESS_CREATE
         | PERF_EVENT_PROCESS_EXEC | PERF_EVENT_PROCESS_EXIT | PERF_EVENT_THREAD_CREATE | PERF_EVENT_THREAD_EXIT
         | PERF_EVENT_SIGNPOST;
@@ -35,6 +51,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     args_parser.add_option(disable, "Disable", nullptr, 'd');
     args_parser.add_option(free, "Free the profiling buffer for the associated process(es).", nullptr, 'f');
     args_parser.add_option(wait, "Enable profiling and wait for user input to disable.", nullptr, 'w');
+    args_parser.add_option(stream, "Profile all processes (super-user only), and show the hottest symbols while profiling until user input", nullptr, 's');
+    args_parser.add_option(events_per_processor, "Size of the per-processor event rings used with -s (default: 4096)", "ring-size", 'r', "events");
+    args_parser.add_option(top_symbol_count, "Number of symbols shown with -s (default: 20)", "top", 'n', "count");
     args_parser.add_option(Core::ArgsParser::Option {
         Core::ArgsParser::OptionArgumentMode::Required,
         "Enable tracking specific event type", nullptr, 't', "event_type",
@@ -54,6 +73,8 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
                 event_mask |= PERF_EVENT_SYSCALL;
             else if (event_type == "filesystem")
                 event_mask |= PERF_EVENT_FILESYSTEM;
+            else if (event_type == "lock_contention")
+                event_mask |= PERF_EVENT_LOCK_CONTENTION;
             else {
                 warnln("Unknown event type '{}' specified.", event_type);
                 exit(1);
@@ -65,7 +86,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     auto print_types = [] {
         outln();
-        outln("Event type can be one of: sample, context_switch, page_fault, syscall, filesystem, kmalloc and kfree.");
+        outln("Event type can be one of: sample, context_switch, page_fault, syscall, filesystem, lock_contention, kmalloc and kfree.");
     };
 
     if (!args_parser.parse(arguments, Core::ArgsParser::FailureBehavior::PrintUsage)) {
@@ -73,6 +94,12 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
         exit(0);
     }
 
+    if (stream) {
+        if (!seen_event_type_arg)
+            event_mask |= PERF_EVENT_SAMPLE;
+        return stream_system_wide_profile(event_mask, events_per_processor, top_symbol_count);
+    }
+
     if (pid_argument.is_empty() && command.is_empty() && !all_processes) {
         args_parser.print_usage(stdout, arguments.strings[0]);
         print_types();
@@ -132,3 +159,156 @@ static Optional<pid_t> determine_pid_to_profile(StringView pid_argument, bool al
     // pid_argument is guaranteed to have a value
     return pid_argument.to_int();
 }
+
+static Atomic<bool> s_stop_streaming;
+
+class LiveProfile {
+public:
+    void handle_event(Kernel::PerformanceEvent const& event)
+    {
+        switch (event.type) {
+        case PERF_EVENT_SAMPLE:
+            if (event.stack_size > 0)
+                ++m_sample_counts.ensure(symbolicate(event.pid, event.stack[0]));
+            ++m_sample_count;
+            break;
+        case PERF_EVENT_MMAP:
+            handle_mmap(event.pid, event.data.mmap.ptr, event.data.mmap.size, { event.data.mmap.name, strnlen(event.data.mmap.name, sizeof(event.data.mmap.name)) });
+            break;
+        case PERF_EVENT_MUNMAP:
+            m_libraries.ensure(event.pid).remove_all_matching([&](auto& library) {
+                return library.base >= event.data.munmap.ptr && library.base < event.data.munmap.ptr + event.data.munmap.size;
+            });
+            break;
+        case PERF_EVENT_PROCESS_EXEC:
+        case PERF_EVENT_PROCESS_EXIT:
+            m_libraries.remove(event.pid);
+            break;
+        default:
+            break;
+        }
+    }
+
+    void print_top_symbols(size_t count, u64 lost_events)
+    {
+        struct SymbolCount {
+            DeprecatedString const* symbol;
+            size_t count;
+        };
+        Vector<SymbolCount> entries;
+        for (auto& it : m_sample_counts)
+            entries.append({ &it.key, it.value });
+        quick_sort(entries, [](auto& a, auto& b) { return a.count > b.count; });
+
+        outln("\033[H\033[2J{} samples, {} lost events", m_sample_count, lost_events);
+        for (size_t i = 0; i < min(count, entries.size()); ++i)
+            outln("{:>6.2}% {:>8} {}", 100.0 * entries[i].count / m_sample_count, entries[i].count, *entries[i].symbol);
+    }
+
+private:
+    struct Library {
+        FlatPtr base { 0 };
+        size_t size { 0 };
+        DeprecatedString path;
+    };
+
+    void handle_mmap(pid_t pid, FlatPtr base, size_t size, StringView name)
+    {
+        // Like the Profiler, we only care about the regions of loaded objects, which are named "<path>: <section>".
+        StringView path;
+        if (name.contains("Loader.so"sv))
+            path = "Loader.so"sv;
+        else if (auto colon = name.find(':'); colon.has_value())
+            path = name.substring_view(0, colon.value());
+        else
+            return;
+
+        auto& libraries = m_libraries.ensure(pid);
+        for (auto& library : libraries) {
+            if (library.path != path)
+                continue;
+            auto end = max(library.base + library.size, base + size);
+            library.base = min(library.base, base);
+            library.size = end - library.base;
+            return;
+        }
+        libraries.append({ base, size, path });
+    }
+
+    DeprecatedString symbolicate(pid_t pid, FlatPtr address)
+    {
+        DeprecatedString path;
+        FlatPtr base = 0;
+        if (auto kernel_base = Symbolication::kernel_base(); kernel_base.has_value() && address >= kernel_base.value()) {
+            path = "/boot/Kernel.debug";
+            base = kernel_base.value();
+        } else if (auto libraries = m_libraries.find(pid); libraries != m_libraries.end()) {
+            for (auto& library : libraries->value) {
+                if (address >= library.base && address < library.base + library.size) {
+                    path = library.path;
+                    base = library.base;
+                    break;
+                }
+            }
+        }
+        if (path.is_empty())
+            return DeprecatedString::formatted("{:p}", address);
+
+        auto cache_key = DeprecatedString::formatted("{}:{:x}", path, address - base);
+        return m_symbol_cache.ensure(cache_key, [&] {
+            auto symbol = Symbolication::symbolicate(path, address - base, Symbolication::IncludeSourcePosition::No);
+            if (!symbol.has_value() || symbol->name.is_empty())
+                return DeprecatedString::formatted("{} + {:#x}", path, address - base);
+            return DeprecatedString::formatted("{} ({})", symbol->name, path);
+        });
+    }
+
+    HashMap<pid_t, Vector<Library>> m_libraries;
+    HashMap<DeprecatedString, DeprecatedString> m_symbol_cache;
+    HashMap<DeprecatedString, size_t> m_sample_counts;
+    size_t m_sample_count { 0 };
+};
+
+static ErrorOr<int> stream_system_wide_profile(u64 event_mask, size_t events_per_processor, size_t top_symbol_count)
+{
+    auto fd = TRY(Core::System::open("/dev/profile"sv, O_RDWR));
+    TRY(Core::System::ioctl(fd, PROFILE_IOCTL_SET_RING_SIZE, events_per_processor));
+    size_t buffer_size = 0;
+    TRY(Core::System::ioctl(fd, PROFILE_IOCTL_GET_BUFFER_SIZE, &buffer_size));
+    auto* buffer = static_cast<u8*>(TRY(Core::System::mmap(nullptr, buffer_size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0)));
+
+    TRY(Core::System::signal(SIGINT, [](int) { s_stop_streaming = true; }));
+    TRY(Core::System::profiling_enable(-1, event_mask));
+    outln("Profiling enabled, waiting for user input to disable...");
+
+    LiveProfile profile;
+    auto const& first_header = *reinterpret_cast<Kernel::PerformanceEventRingHeader const*>(buffer);
+    auto processor_count = first_header.processor_count;
+    auto ring_size = first_header.ring_size;
+
+    while (!s_stop_streaming) {
+        u64 lost_events = 0;
+        for (u32 processor = 0; processor < processor_count; ++processor) {
+            auto* ring = buffer + processor * ring_size;
+            auto& header = *reinterpret_cast<Kernel::PerformanceEventRingHeader*>(ring);
+            auto const* events = reinterpret_cast<Kernel::PerformanceEvent const*>(ring + header.events_offset);
+
+            auto head = AK::atomic_load(&header.head, AK::memory_order_acquire);
+            for (auto tail = header.tail; tail != head; ++tail)
+                profile.handle_event(events[tail % header.capacity]);
+            AK::atomic_store(&header.tail, head, AK::memory_order_release);
+            lost_events += AK::atomic_load(&header.lost_events, AK::memory_order_relaxed);
+        }
+        profile.print_top_symbols(top_symbol_count, lost_events);
+
+        pollfd stdin_poll { .fd = STDIN_FILENO, .events = POLLIN, .revents = 0 };
+        if (poll(&stdin_poll, 1, 1000) > 0)
+            break;
+    }
+
+    TRY(Core::System::profiling_disable(-1));
+    TRY(Core::System::munmap(buffer, buffer_size));
+    TRY(Core::System::profiling_free_buffer(-1));
+    TRY(Core::System::close(fd));
+    return 0;
+}
@@ -6,8 +6,13 @@
 
 #include <AK/Assertions.h>
 #include <AK/Format.h>
+#include <AK/HashMap.h>
 #include <AK/HashTable.h>
 #include <AK/IPv4Address.h>
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/JsonValue.h>
+#include <AK/QuickSort.h>
 #include <AK/StdLibExtras.h>
 #include <AK/Types.h>
 #include <Kernel/API/SyscallString.h>
@@ -175,6 +180,8 @@ HANDLE(FIONREAD)
 HANDLE(KCOV_SETBUFSIZE)
 HANDLE(KCOV_ENABLE)
 HANDLE(KCOV_DISABLE)
+HANDLE(PROFILE_IOCTL_SET_RING_SIZE)
+HANDLE(PROFILE_IOCTL_GET_BUFFER_SIZE)
 HANDLE(SOUNDCARD_IOCTL_SET_SAMPLE_RATE)
 HANDLE(SOUNDCARD_IOCTL_GET_SAMPLE_RATE)
 HANDLE(STORAGE_DEVICE_GET_SIZE)
@@ -818,6 +825,128 @@ static ErrorOr<void> format_syscall(FormattedSyscallBuilder& builder, Syscall::F
     return {};
 }
 
+struct SyscallSummary {
+    DeprecatedString name;
+    u64 calls { 0 };
+    u64 errors { 0 };
+    u64 total_time_ns { 0 };
+};
+
+static ErrorOr<HashMap<DeprecatedString, SyscallSummary>> read_syscall_statistics(pid_t pid)
+{
+    auto file = TRY(Core::File::open(DeprecatedString::formatted("/proc/{}/syscall_statistics", pid), Core::File::OpenMode::Read));
+    auto json = TRY(JsonValue::from_string(TRY(file->read_until_eof())));
+    if (!json.is_array())
+        return Error::from_string_literal("Invalid syscall statistics (not a JSON array)");
+
+    HashMap<DeprecatedString, SyscallSummary> statistics;
+    for (auto const& value : json.as_array().values()) {
+        auto const& object = value.as_object();
+        auto name = object.get_deprecated_string("name"sv).value_or({});
+        TRY(statistics.try_set(name, SyscallSummary {
+                                         .name = name,
+                                         .calls = object.get_u64("calls"sv).value_or(0),
+                                         .errors = object.get_u64("errors"sv).value_or(0),
+                                         .total_time_ns = object.get_u64("total_time_ns"sv).value_or(0),
+                                     }));
+    }
+    return statistics;
+}
+
+static ErrorOr<void> print_syscall_summary(Core::File& output, Vector<SyscallSummary> syscalls)
+{
+    quick_sort(syscalls, [](auto& a, auto& b) { return a.total_time_ns > b.total_time_ns; });
+
+    SyscallSummary total { .name = "total" };
+    for (auto const& syscall : syscalls) {
+        total.calls += syscall.calls;
+        total.errors += syscall.errors;
+        total.total_time_ns += syscall.total_time_ns;
+    }
+
+    auto separator = "------ ----------- ----------- --------- --------- ----------------\n"sv;
+    TRY(output.write_formatted("{:>6} {:>11} {:>11} {:>9} {:>9} {}\n", "% time", "seconds", "usecs/call", "calls", "errors", "syscall"));
+    TRY(output.write_until_depleted(separator.bytes()));
+    for (auto const& syscall : syscalls) {
+        auto percentage = total.total_time_ns ? 100.0 * syscall.total_time_ns / total.total_time_ns : 0.0;
+        TRY(output.write_formatted("{:>6.2} {:>11.6} {:>11} {:>9} {:>9} {}\n",
+            percentage,
+            syscall.total_time_ns / 1'000'000'000.0,
+            syscall.total_time_ns / 1000 / syscall.calls,
+            syscall.calls,
+            syscall.errors,
+            syscall.name));
+    }
+    TRY(output.write_until_depleted(separator.bytes()));
+    TRY(output.write_formatted("{:>6.2} {:>11.6} {:>11} {:>9} {:>9} {}\n", 100.0, total.total_time_ns / 1'000'000'000.0, "", total.calls, total.errors, total.name));
+    return {};
+}
+
+static bool g_summary_interrupted = false;
+
+static void handle_sigint_for_summary(int)
+{
+    g_summary_interrupted = true;
+}
+
+// Instead of stopping the process at every syscall, let the kernel do the counting. For a command
+// we start ourselves, we read its counters once it has exited but before we've reaped it.
+static ErrorOr<int> summarize_syscalls(Core::File& output, Vector<StringView> const& child_argv, HashTable<StringView> const& exclude_syscalls, HashTable<StringView> const& include_syscalls)
+{
+    HashMap<DeprecatedString, SyscallSummary> statistics;
+    int exit_code = 0;
+    if (g_pid == -1) {
+        if (child_argv.is_empty())
+            return Error::from_string_literal("Expected either a pid or some arguments");
+
+        auto pid = TRY(Core::System::fork());
+        if (!pid) {
+            TRY(Core::System::exec(child_argv.first(), child_argv, Core::System::SearchInPath::Yes));
+            VERIFY_NOT_REACHED();
+        }
+
+        siginfo_t info {};
+        if (waitid(P_PID, pid, &info, WEXITED | WNOWAIT) < 0)
+            return Error::from_syscall("waitid"sv, -errno);
+        statistics = TRY(read_syscall_statistics(pid));
+        auto result = TRY(Core::System::waitpid(pid));
+        if (WIFEXITED(result.status))
+            exit_code = WEXITSTATUS(result.status);
+    } else {
+        // We can't wait for a process that isn't ours, so look at what it did until we get interrupted.
+        auto initial_statistics = TRY(read_syscall_statistics(g_pid));
+
+        struct sigaction sa = {};
+        sa.sa_handler = handle_sigint_for_summary;
+        TRY(Core::System::sigaction(SIGINT, &sa, nullptr));
+        while (!g_summary_interrupted)
+            pause();
+
+        statistics = TRY(read_syscall_statistics(g_pid));
+        for (auto& it : statistics) {
+            auto initial = initial_statistics.get(it.key);
+            if (!initial.has_value())
+                continue;
+            it.value.calls -= initial->calls;
+            it.value.errors -= initial->errors;
+            it.value.total_time_ns -= initial->total_time_ns;
+        }
+    }
+
+    Vector<SyscallSummary> syscalls;
+    for (auto& it : statistics) {
+        if (it.value.calls == 0)
+            continue;
+        if (exclude_syscalls.contains(it.key))
+            continue;
+        if (!include_syscalls.is_empty() && !include_syscalls.contains(it.key))
+            continue;
+        TRY(syscalls.try_append(it.value));
+    }
+    TRY(print_syscall_summary(output, move(syscalls)));
+    return exit_code;
+}
+
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     TRY(Core::System::pledge("stdio rpath wpath cpath proc exec ptrace sigaction"));
@@ -829,6 +958,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     StringView include_syscalls_option;
     HashTable<StringView> exclude_syscalls;
     HashTable<StringView> include_syscalls;
+    bool summary = false;
 
     Core::ArgsParser parser;
     parser.set_stop_on_first_non_option(true);
@@ -838,6 +968,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
     parser.add_option(output_filename, "Filename to write output to", "output", 'o', "output");
     parser.add_option(exclude_syscalls_option, "Comma-delimited syscalls to exclude", "exclude", 'e', "exclude");
     parser.add_option(include_syscalls_option, "Comma-delimited syscalls to include", "include", 'i', "include");
+    parser.add_option(summary, "Count time, calls and errors of each syscall and print a summary instead of tracing them", "summary", 'c');
     parser.add_positional_argument(child_argv, "Arguments to exec", "argument", Core::ArgsParser::Required::No);
 
     parser.parse(arguments);
@@ -857,6 +988,9 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     TRY(Core::System::pledge("stdio rpath proc exec ptrace sigaction"));
 
+    if (summary)
+        return summarize_syscalls(*trace_file, child_argv, exclude_syscalls, include_syscalls);
+
     int status;
     if (g_pid == -1) {
         if (child_argv.is_empty())
@@ -0,0 +1,114 @@
+/*
+ * Copyright (c) 2023, the SerenityOS developers.
+ *
+ * SPDX-License-Identifier: BSD-2-Clause
+ */
+
+#include <AK/JsonArray.h>
+#include <AK/JsonObject.h>
+#include <AK/QuickSort.h>
+#include <LibCore/ArgsParser.h>
+#include <LibCore/File.h>
+#include <LibCore/System.h>
+#include <LibMain/Main.h>
+
+static DeprecatedString format_duration(u64 nanoseconds)
+{
+    if (nanoseconds < 1000)
+        return DeprecatedString::formatted("{} ns", nanoseconds);
+    if (nanoseconds < 1'000'000)
+        return DeprecatedString::formatted("{} us", nanoseconds / 1000);
+    if (nanoseconds < 1'000'000'000)
+        return DeprecatedString::formatted("{} ms", nanoseconds / 1'000'000);
+    return DeprecatedString::formatted("{} s", nanoseconds / 1'000'000'000);
+}
+
+ErrorOr<int> serenity_main(Main::Arguments arguments)
+{
+    TRY(Core::System::pledge("stdio rpath"));
+    TRY(Core::System::unveil("/sys/kernel/syscall_statistics", "r"));
+    TRY(Core::System::unveil(nullptr, nullptr));
+
+    bool show_histograms = false;
+    Vector<StringView> syscall_names;
+
+    Core::ArgsParser args_parser;
+    args_parser.set_general_help("Show how often each syscall has been made on this system, and how long it took.");
+    args_parser.add_option(show_histograms, "Show how long the calls took as a histogram", "histogram", 'H');
+    args_parser.add_positional_argument(syscall_names, "Only show these syscalls", "syscall", Core::ArgsParser::Required::No);
+    args_parser.parse(arguments);
+
+    auto file = TRY(Core::File::open("/sys/kernel/syscall_statistics"sv, Core::File::OpenMode::Read));
+
+    TRY(Core::System::pledge("stdio"));
+
+    auto json = TRY(JsonValue::from_string(TRY(file->read_until_eof())));
+    auto const& statistics = json.as_object();
+    auto bucket_limits = statistics.get_array("histogram_bucket_limits_ns"sv).value();
+
+    Vector<JsonObject const*> syscalls;
+    u64 total_time_ns = 0;
+    u64 total_calls = 0;
+    u64 total_errors = 0;
+    statistics.get_array("syscalls"sv)->for_each([&](JsonValue const& value) {
+        auto const& syscall = value.as_object();
+        if (!syscall_names.is_empty() && !syscall_names.contains_slow(syscall.get_deprecated_string("name"sv).value_or({})))
+            return;
+        total_time_ns += syscall.get_u64("total_time_ns"sv).value_or(0);
+        total_calls += syscall.get_u64("calls"sv).value_or(0);
+        total_errors += syscall.get_u64("errors"sv).value_or(0);
+        syscalls.append(&syscall);
+    });
+    quick_sort(syscalls, [](auto* a, auto* b) { return a->get_u64("total_time_ns"sv).value_or(0) > b->get_u64("total_time_ns"sv).value_or(0); });
+
+    auto separator = "------ ----------- ----------- ----------- ----------- --------- ----------------"sv;
+    outln("{:>6} {:>11} {:>11} {:>11} {:>11} {:>9} {}", "% time", "seconds", "usecs/call", "max usecs", "calls", "errors", "syscall");
+    outln("{}", separator);
+    for (auto const* syscall : syscalls) {
+        auto time_ns = syscall->get_u64("total_time_ns"sv).value_or(0);
+        auto calls = syscall->get_u64("calls"sv).value_or(0);
+        outln("{:>6.2} {:>11.6} {:>11} {:>11} {:>11} {:>9} {}",
+            total_time_ns ? 100.0 * time_ns / total_time_ns : 0.0,
+            time_ns / 1'000'000'000.0,
+            calls ? time_ns / 1000 / calls : 0,
+            syscall->get_u64("max_time_ns"sv).value_or(0) / 1000,
+            calls,
+            syscall->get_u64("errors"sv).value_or(0),
+            syscall->get_deprecated_string("name"sv).value_or({}));
+    }
+    outln("{}", separator);
+    outln("{:>6.2} {:>11.6} {:>11} {:>11} {:>11} {:>9} {}", 100.0, total_time_ns / 1'000'000'000.0, "", "", total_calls, total_errors, "total");
+
+    if (!show_histograms)
+        return 0;
+
+    for (auto const* syscall : syscalls) {
+        outln();
+        outln("{}:", syscall->get_deprecated_string("name"sv).value_or({}));
+        auto histogram = syscall->get_array("histogram"sv).value();
+        u64 largest_count = 0;
+        for (auto const& count : histogram.values())
+            largest_count = max(largest_count, count.to_number<u64>());
+        if (largest_count == 0)
+            continue;
+
+        // Leave out the empty buckets at either end.
+        size_t first_bucket = 0;
+        while (histogram[first_bucket].to_number<u64>() == 0)
+            ++first_bucket;
+        size_t last_bucket = histogram.size() - 1;
+        while (histogram[last_bucket].to_number<u64>() == 0)
+            --last_bucket;
+
+        constexpr size_t bar_width = 40;
+        for (size_t bucket = first_bucket; bucket <= last_bucket; ++bucket) {
+            auto count = histogram[bucket].to_number<u64>();
+            auto limit = bucket < bucket_limits.size()
+                ? DeprecatedString::formatted("< {}", format_duration(bucket_limits[bucket].to_number<u64>()))
+                : DeprecatedString::formatted(">= {}", format_duration(bucket_limits[bucket_limits.size() - 1].to_number<u64>()));
+            outln("  {:>10} {:>11} {}", limit, count, DeprecatedString::repeated('#', count * bar_width / largest_count));
+        }
+    }
+
+    return 0;
+}
@@ -89,9 +89,10 @@ struct Snapshot {
     u64 total_time_scheduled_kernel { 0 };
 };
 
-static ErrorOr<Snapshot> get_snapshot(HashTable<pid_t> const& pids)
+static ErrorOr<Snapshot> get_snapshot(Core::IncrementalProcessStatisticsReader& reader, HashTable<pid_t> const& pids)
 {
-    auto all_processes = TRY(Core::ProcessStatisticsReader::get_all());
+    TRY(reader.update());
+    auto const& all_processes = reader.statistics();
 
     Snapshot snapshot;
     for (auto& process : all_processes.processes) {
@@ -233,7 +234,7 @@ static void restore_tty()
 ErrorOr<int> serenity_main(Main::Arguments arguments)
 {
     TRY(Core::System::pledge("stdio rpath tty sigaction"));
-    TRY(Core::System::unveil("/sys/kernel/processes", "r"));
+    TRY(Core::System::unveil("/sys/kernel/process_statistics", "r"));
     TRY(Core::System::unveil("/etc/passwd", "r"));
     unveil(nullptr, nullptr);
 
@@ -259,8 +260,10 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
 
     TRY(Core::System::pledge("stdio rpath tty"));
 
+    auto process_statistics_reader = TRY(Core::IncrementalProcessStatisticsReader::create());
+
     Vector<ThreadData*> threads;
-    auto prev = TRY(get_snapshot(top_option.pids_to_filter_by));
+    auto prev = TRY(get_snapshot(*process_statistics_reader, top_option.pids_to_filter_by));
     usleep(10000);
     bool should_quit = false;
     while (!should_quit) {
@@ -269,7 +272,7 @@ ErrorOr<int> serenity_main(Main::Arguments arguments)
             g_window_size_changed = false;
         }
 
-        auto current = TRY(get_snapshot(top_option.pids_to_filter_by));
+        auto current = TRY(get_snapshot(*process_statistics_reader, top_option.pids_to_filter_by));
         auto total_scheduled_diff = current.total_time_scheduled - prev.total_time_scheduled;
 
         printf("\033[3J\033[H\033[2J");